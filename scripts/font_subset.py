@@ -0,0 +1,300 @@
+# ============================================================================
+# 构建时字体子集（PlatformIO extra_scripts，编译前运行）
+# 功能：完整的 GB2312 字体（wqy12/wqy16）每个有数百 KB，界面只用到几十个汉字。
+#       扫描 src/ui_text.h 中每个 "// @font <子集名> <原字体>" 段里的字符串字面量，
+#       从 U8g2_for_Adafruit_GFX 的 u8g2_fonts.c 中取出这些字符的字形，
+#       生成 $BUILD_DIR/ui_fonts/ui_fonts.h（只由 display.cpp 包含）。
+#       以下情况构建失败：
+#         原字体中没有某个字符
+#         src/ 下的代码直接用含中文的字面量调用 drawUTF8/getUTF8Width/getCenterPos
+#           （这些文字不会进入子集，运行时会显示为空白）
+#
+# U8g2 字体格式（u8g2_font.c）：
+#   23 字节头：[0] 字形数 ... [17..18] 'A' 起始偏移 [19..20] 'a' 起始偏移
+#             [21..22] Unicode 段起始偏移（均为大端，相对头部之后）
+#   ASCII 段：encoding u8, size u8, 位图 ...（size 为整条记录长度），size=0 结束
+#   Unicode 段：查找表（每项：到下一块的偏移 u16、块内最后一个编码 u16，最后一项编码 0xFFFF），
+#              随后是各块字形：encoding u16, size u8, 位图 ...，encoding=0 结束
+#   位图自包含，子集只重排记录并重建偏移和查找表
+#
+# 单独运行（不经过 PlatformIO）：
+#   python3 scripts/font_subset.py <u8g2_fonts.c> <输出目录>
+# ============================================================================
+import os
+import re
+import sys
+
+UI_TEXT = os.path.join("src", "ui_text.h")
+FONT_SOURCE = "u8g2_fonts.c"
+LIBRARY = "olikraus/U8g2_for_Adafruit_GFX"
+HEADER_SIZE = 23
+UNICODE_BLOCK = 100  # 查找表每块字形数（与 bdfconv 相同量级）
+
+DRAW_CALL = re.compile(r"\b(drawUTF8|getUTF8Width|getCenterPos)\s*\(")
+STRING = re.compile(r'"((?:[^"\\]|\\.)*)"')
+NEXT_STRING = re.compile(r'\s*"((?:[^"\\]|\\.)*)"')
+
+
+class SubsetError(Exception):
+    pass
+
+
+def unescape(literal):
+    out = []
+    i = 0
+    while i < len(literal):
+        c = literal[i]
+        if c == "\\" and i + 1 < len(literal):
+            i += 1
+            out.append({"n": "\n", "t": "\t", "0": "\0"}.get(literal[i], literal[i]))
+        else:
+            out.append(c)
+        i += 1
+    return "".join(out)
+
+
+def read_sections(path):
+    """返回 [(子集名, 原字体, {码点: 行号})]，按文件中的顺序。"""
+    sections = []
+    with open(path, encoding="utf-8") as f:
+        for lineno, line in enumerate(f, 1):
+            stripped = line.strip()
+            m = re.match(r"//\s*@font\s+(\w+)\s+(\w+)", stripped)
+            if m:
+                sections.append((m.group(1), m.group(2), {}))
+                continue
+            if stripped.startswith("//") or not sections:
+                continue
+            for literal in STRING.findall(line):
+                for ch in unescape(literal):
+                    if ord(ch) >= 0x20:
+                        sections[-1][2].setdefault(ord(ch), lineno)
+    if not sections:
+        raise SubsetError("%s 中没有 @font 段" % path)
+    return sections
+
+
+def check_literals(src_dir):
+    """界面文字必须写在 ui_text.h 中，否则不会进入子集字体。"""
+    errors = []
+    for root, dirs, files in os.walk(src_dir):
+        dirs[:] = [d for d in dirs if d != "native"]
+        for name in sorted(files):
+            if not name.endswith((".cpp", ".h")) or name == "ui_text.h":
+                continue
+            path = os.path.join(root, name)
+            with open(path, encoding="utf-8") as f:
+                for lineno, line in enumerate(f, 1):
+                    if not DRAW_CALL.search(line):
+                        continue
+                    for literal in STRING.findall(line):
+                        if any(ord(ch) >= 0x80 for ch in literal):
+                            errors.append("%s:%d: 界面文字 \"%s\" 需要写在 ui_text.h 中"
+                                          % (path, lineno, literal))
+    if errors:
+        raise SubsetError("\n".join(errors))
+
+
+def load_font(source_text, name):
+    m = re.search(r"\b%s\s*\[[^\]]*\][^=;]*=" % re.escape(name), source_text)
+    if not m:
+        raise SubsetError("%s 中没有字体 %s" % (FONT_SOURCE, name))
+    literals = []
+    pos = m.end()
+    while True:  # 相邻字符串字面量直到 ';'（字面量中可能含有 ';'，不能直接查找）
+        lit = NEXT_STRING.match(source_text, pos)
+        if not lit:
+            break
+        literals.append(lit.group(1))
+        pos = lit.end()
+    data = bytearray()
+    for literal in literals:
+        i = 0
+        while i < len(literal):
+            c = literal[i]
+            if c != "\\":
+                data.append(ord(c))
+                i += 1
+                continue
+            nxt = literal[i + 1]
+            if nxt in "01234567":
+                j = i + 1
+                while j < len(literal) and j < i + 4 and literal[j] in "01234567":
+                    j += 1
+                data.append(int(literal[i + 1:j], 8))
+                i = j
+            elif nxt == "x":
+                j = i + 2
+                while j < len(literal) and literal[j] in "0123456789abcdefABCDEF":
+                    j += 1
+                data.append(int(literal[i + 2:j], 16) & 0xFF)
+                i = j
+            else:
+                data.append(ord({"n": "\n", "t": "\t", "r": "\r", "a": "\a", "b": "\b",
+                                 "f": "\f", "v": "\v"}.get(nxt, nxt)))
+                i += 2
+    return bytes(data)
+
+
+def word(data, pos):
+    return (data[pos] << 8) | data[pos + 1]
+
+
+def parse_glyphs(font):
+    """返回 {编码: 整条字形记录}。"""
+    glyphs = {}
+    pos = HEADER_SIZE
+    while font[pos + 1] != 0:
+        glyphs[font[pos]] = font[pos:pos + font[pos + 1]]
+        pos += font[pos + 1]
+    table = HEADER_SIZE + word(font, 21)
+    pos = table + word(font, table)
+    while word(font, pos) != 0:
+        size = font[pos + 2]
+        glyphs[word(font, pos)] = font[pos:pos + size]
+        pos += size
+    return glyphs
+
+
+def build_font(font, glyphs):
+    ascii_codes = sorted(c for c in glyphs if c < 0x100)
+    unicode_codes = sorted(c for c in glyphs if c >= 0x100)
+
+    body = bytearray()
+    upper_a = lower_a = None
+    for c in ascii_codes:
+        if upper_a is None and c >= ord("A"):
+            upper_a = len(body)
+        if lower_a is None and c >= ord("a"):
+            lower_a = len(body)
+        body += glyphs[c]
+    end_ascii = len(body)
+    body += b"\0\0"
+    upper_a = end_ascii if upper_a is None else upper_a
+    lower_a = end_ascii if lower_a is None else lower_a
+
+    unicode_start = len(body)
+    blocks = [unicode_codes[i:i + UNICODE_BLOCK] for i in range(0, len(unicode_codes), UNICODE_BLOCK)]
+    if not blocks:
+        blocks = [[]]
+    offset = 4 * len(blocks)  # 第一项从查找表开头跳到第一块
+    for i, block in enumerate(blocks):
+        last = 0xFFFF if i == len(blocks) - 1 else block[-1]
+        body += bytes([offset >> 8, offset & 0xFF, last >> 8, last & 0xFF])
+        offset = sum(len(glyphs[c]) for c in block)
+    for block in blocks:
+        for c in block:
+            body += glyphs[c]
+    body += b"\0\0"
+
+    if len(body) > 0xFFFF:
+        raise SubsetError("子集字体超过 64 KB，偏移无法表示")
+    header = bytearray(font[:HEADER_SIZE])
+    header[0] = min(len(glyphs), 0xFF)
+    for pos, value in ((17, upper_a), (19, lower_a), (21, unicode_start)):
+        header[pos] = value >> 8
+        header[pos + 1] = value & 0xFF
+    return bytes(header + body)
+
+
+def subset(sections, source_text):
+    """返回 [(子集名, 原字体名, 原字体字节数, 子集字节)]。"""
+    results = []
+    errors = []
+    for name, source, codes in sections:
+        font = load_font(source_text, source)
+        available = parse_glyphs(font)
+        missing = [c for c in sorted(codes) if c not in available]
+        for c in missing:
+            errors.append("%s:%d: %s 中没有字符 U+%04X '%s'"
+                          % (UI_TEXT, codes[c], source, c, chr(c)))
+        if not missing:
+            results.append((name, source, len(font),
+                            build_font(font, {c: available[c] for c in codes})))
+    if errors:
+        raise SubsetError("\n".join(errors))
+    return results
+
+
+def render_header(results):
+    lines = [
+        "// 由 scripts/font_subset.py 根据 src/ui_text.h 生成，不要手工修改",
+        "#pragma once",
+        "",
+        "#include <stdint.h>",
+        "",
+    ]
+    for name, source, source_size, data in results:
+        lines.append("// %s 子集：%d 个字形，%d 字节（原字体 %d 字节）"
+                     % (source, data[0], len(data), source_size))
+        lines.append("static const uint8_t %s[%d] = {" % (name, len(data)))
+        for i in range(0, len(data), 16):
+            lines.append("  " + ", ".join("0x%02x" % b for b in data[i:i + 16]) + ",")
+        lines.append("};")
+        lines.append("")
+    return "\n".join(lines)
+
+
+def generate(project_dir, font_source_path, out_dir):
+    check_literals(os.path.join(project_dir, "src"))
+    sections = read_sections(os.path.join(project_dir, UI_TEXT))
+    with open(font_source_path, encoding="latin-1") as f:
+        source_text = f.read()
+    results = subset(sections, source_text)
+
+    text = render_header(results)
+    out_path = os.path.join(out_dir, "ui_fonts.h")
+    os.makedirs(out_dir, exist_ok=True)
+    old = None
+    if os.path.exists(out_path):
+        with open(out_path, encoding="utf-8") as f:
+            old = f.read()
+    if old != text:  # 内容不变时不改写，避免 display.cpp 每次都重新编译
+        with open(out_path, "w", encoding="utf-8") as f:
+            f.write(text)
+    for name, source, source_size, data in results:
+        print("🔤 字体子集 %-15s %3d 个字形 %6d 字节（%s %d 字节）"
+              % (name, data[0], len(data), source, source_size))
+
+
+def find_font_source(libdeps_dir):
+    for root, dirs, files in os.walk(libdeps_dir):
+        if FONT_SOURCE in files and "U8g2" in root:
+            return os.path.join(root, FONT_SOURCE)
+    return None
+
+
+def pio_main(env):
+    libdeps_dir = env.subst("$PROJECT_LIBDEPS_DIR/$PIOENV")
+    font_source_path = find_font_source(libdeps_dir)
+    if font_source_path is None:
+        # 预处理脚本先于依赖库安装运行，第一次构建时在这里装好字体所在的库
+        from platformio.package.manager.library import LibraryPackageManager
+        LibraryPackageManager(libdeps_dir).install(LIBRARY)
+        font_source_path = find_font_source(libdeps_dir)
+    if font_source_path is None:
+        sys.stderr.write("❌ 找不到 %s（%s）\n" % (FONT_SOURCE, LIBRARY))
+        env.Exit(1)
+
+    out_dir = env.subst("$BUILD_DIR/ui_fonts")
+    try:
+        generate(env.subst("$PROJECT_DIR"), font_source_path, out_dir)
+    except SubsetError as e:
+        sys.stderr.write("❌ 字体子集生成失败：\n%s\n" % e)
+        env.Exit(1)
+    env.Append(CPPPATH=[out_dir])
+
+
+try:
+    Import("env")  # noqa: F821  PlatformIO/SCons 注入
+except NameError:
+    if len(sys.argv) != 3:
+        sys.stderr.write("用法：%s <u8g2_fonts.c> <输出目录>\n" % sys.argv[0])
+        sys.exit(2)
+    try:
+        generate(os.getcwd(), sys.argv[1], sys.argv[2])
+    except SubsetError as e:
+        sys.stderr.write("❌ 字体子集生成失败：\n%s\n" % e)
+        sys.exit(1)
+else:
+    pio_main(env)  # noqa: F821
@@ -14,6 +14,10 @@ const SESSION_EXPIRY = 24 * 60 * 60 * 1000; // 24小时过期
 let latestData = { temperature: 0, humidity: 0, timestamp: 0 };
 let scheduleStatus = { enabled: true, lastUpdate: 0 };
 let lastScheduleCommandTime = 0; // 记录最后发送定时空调命令的时间
+let nextAcCommandId = 1; // 空调指令编号，设备在应答中原样带回
+const AC_COMMAND_LATENCY_TARGET_MS = 200;  // 发布到红外发送的延迟目标
+const HEALTH_STACK_WARN_BYTES = 512;       // 与设备端 health_monitor.h 相同
+const HEALTH_WDT_WARN_MS = 2000;
 
 // 验证session是否有效
 function isValidSession(sessionId) {
@@ -35,16 +39,168 @@ function generateSessionId() {
 const mqtt = require('mqtt');
 const mqttClient = mqtt.connect('mqtt://175.178.158.54:1883');
 
+// 合并一批温湿度记录到 latestData，返回记录条数
+// 记录格式 {seq,t,temperature,humidity}；t 为设备端 Unix 秒，0 表示设备时间未同步，按接收时间处理
+function applySamples(samples) {
+  const now = Date.now();
+  for (const sample of samples) {
+    const timestamp = sample.t ? Math.min(sample.t * 1000, now) : now;
+    if (timestamp >= latestData.timestamp) {
+      latestData = {
+        temperature: sample.temperature,
+        humidity: sample.humidity,
+        timestamp: timestamp
+      };
+    }
+  }
+  return samples.length;
+}
+
+// ========== 紧凑二进制报文（与设备端 src/wire_codec.h 相同） ==========
+// 帧：0xE7 | 版本 1 | 类型 | 消息体 | CRC-16/CCITT-FALSE（小端）
+const WIRE_MAGIC = 0xE7;
+const WIRE_VERSION = 1;
+const WIRE_BATCH = 2;
+const WIRE_ACK = 4;
+const WIRE_SAMPLE_SIZE = 12;
+const wireDevices = new Set();  // 在 <prefix>/codec 上声明了 wire1 的设备
+
+function wireCrc16(buf) {
+  let crc = 0xFFFF;
+  for (const byte of buf) {
+    crc ^= byte << 8;
+    for (let i = 0; i < 8; i++) {
+      crc = crc & 0x8000 ? ((crc << 1) ^ 0x1021) & 0xFFFF : (crc << 1) & 0xFFFF;
+    }
+  }
+  return crc;
+}
+
+// BATCH 帧 -> [{seq,t,temperature,humidity}]；帧无效时返回 null
+function wireDecodeBatch(buf) {
+  if (buf.length < 6 || buf[0] !== WIRE_MAGIC || buf[1] !== WIRE_VERSION || buf[2] !== WIRE_BATCH) return null;
+  if (wireCrc16(buf.subarray(0, buf.length - 2)) !== buf.readUInt16LE(buf.length - 2)) return null;
+  const count = buf[3];
+  if (buf.length !== 6 + count * WIRE_SAMPLE_SIZE) return null;
+  const samples = [];
+  for (let i = 0; i < count; i++) {
+    const p = 4 + i * WIRE_SAMPLE_SIZE;
+    samples.push({
+      seq: buf.readUInt32LE(p),
+      t: buf.readUInt32LE(p + 4),
+      temperature: buf.readInt16LE(p + 8) / 10,
+      humidity: buf.readUInt16LE(p + 10) / 10
+    });
+  }
+  return samples;
+}
+
+function wireEncodeAck(seq) {
+  const buf = Buffer.alloc(9);
+  buf[0] = WIRE_MAGIC;
+  buf[1] = WIRE_VERSION;
+  buf[2] = WIRE_ACK;
+  buf.writeUInt32LE(seq >>> 0, 3);
+  buf.writeUInt16LE(wireCrc16(buf.subarray(0, 7)), 7);
+  return buf;
+}
+
 mqttClient.on('connect', () => {
   console.log('MQTT 已连接');
   mqttClient.subscribe('office/ac/schedule/status');
+  // 设备遥测：office/devices/<deviceId>/telemetry（批量）和 .../telemetry/latest（retained 最新值）
+  mqttClient.subscribe('office/devices/+/telemetry', { qos: 1 });
+  mqttClient.subscribe('office/devices/+/telemetry/latest', { qos: 1 });
+  mqttClient.subscribe('office/devices/+/status');
+  mqttClient.subscribe('office/devices/+/ac/ack');
+  mqttClient.subscribe('office/devices/+/health');
+  mqttClient.subscribe('office/devices/+/codec');
 });
 
 mqttClient.on('message', (topic, message) => {
-  if (topic === 'office/ac/schedule/status') {
+  if (/^office\/devices\/[^/]+\/telemetry$/.test(topic)) {
+    // JSON 或 BATCH 帧（首字节区分）；声明了 wire1 的设备用二进制 ACK 应答，设备收到后改发二进制
+    const deviceId = topic.split('/')[2];
+    try {
+      let samples;
+      if (message.length > 0 && message[0] === WIRE_MAGIC) {
+        samples = wireDecodeBatch(message);
+        if (samples === null) {
+          console.log('MQTT遥测二进制帧无效（长度或CRC错误）');
+          return;
+        }
+      } else {
+        const data = JSON.parse(message.toString());
+        samples = Array.isArray(data.samples) ? data.samples : [];
+      }
+      const count = applySamples(samples);
+      // 应答最后一条的序号，设备收到后才从队列中删除
+      if (count > 0) {
+        const seq = samples[count - 1].seq;
+        const ack = wireDevices.has(deviceId) ? wireEncodeAck(seq) : JSON.stringify({ seq: seq });
+        mqttClient.publish(topic + '/ack', ack, { qos: 1 });
+      }
+      console.log(`收到MQTT遥测: ${count} 条, 最新:`, latestData);
+    } catch (e) {
+      console.log('MQTT遥测解析失败:', e.message);
+    }
+  } else if (/^office\/devices\/[^/]+\/codec$/.test(topic)) {
+    // retained 能力声明，如 "json,wire1"
+    const deviceId = topic.split('/')[2];
+    if (message.toString().split(',').includes('wire1')) {
+      wireDevices.add(deviceId);
+    } else {
+      wireDevices.delete(deviceId);
+    }
+  } else if (/^office\/devices\/[^/]+\/telemetry\/latest$/.test(topic)) {
+    // retained 最新值：服务重启后立即恢复显示，不需要等设备下一次上报
+    try {
+      applySamples([JSON.parse(message.toString())]);
+    } catch (e) {
+      console.log('MQTT最新值解析失败:', e.message);
+    }
+  } else if (/^office\/devices\/[^/]+\/ac\/ack$/.test(topic)) {
+    // 空调指令应答：recv 为设备收到时间，dispatch_ms / ir_ack_ms 为收到后到红外发送 / 模块响应的耗时
+    try {
+      const ack = JSON.parse(message.toString());
+      const network = ack.sent && ack.recv ? ack.recv - ack.sent : null;
+      const total = network !== null && ack.dispatch_ms !== undefined ? network + ack.dispatch_ms : null;
+      console.log(`空调指令应答 #${ack.id}: ${ack.result}, 网络 ${network}ms, 发送 ${ack.dispatch_ms}ms, ` +
+                  `确认 ${ack.ir_ack_ms}ms, 总计 ${total}ms`);
+      if (total !== null && total > AC_COMMAND_LATENCY_TARGET_MS) {
+        console.log(`⚠️ 空调指令 #${ack.id} 延迟 ${total}ms 超过 ${AC_COMMAND_LATENCY_TARGET_MS}ms`);
+      }
+    } catch (e) {
+      console.log('空调指令应答解析失败:', e.message);
+    }
+  } else if (/^office\/devices\/[^/]+\/health$/.test(topic)) {
+    // 设备健康数据（每分钟一条）：栈余量、看门狗余量过低时告警，格式见 src/health_monitor.cpp
+    try {
+      const health = JSON.parse(message.toString());
+      for (const [name, core, priority, cpu, stackFree] of health.tasks || []) {
+        if (stackFree < HEALTH_STACK_WARN_BYTES) {
+          console.log(`⚠️ ${topic}: 任务 ${name} 栈剩余 ${stackFree} 字节`);
+        }
+      }
+      for (const [task, [windowMargin]] of Object.entries(health.wdt || {})) {
+        if (windowMargin < HEALTH_WDT_WARN_MS) {
+          console.log(`⚠️ ${topic}: ${task} 看门狗余量 ${windowMargin}ms`);
+        }
+      }
+      console.log(`设备健康 ${topic}: 运行 ${health.up}s, 内存 ${health.heap}, RSSI ${health.rssi}, 上次复位 ${health.reset}`);
+    } catch (e) {
+      console.log('设备健康数据解析失败:', e.message);
+    }
+  } else if (/^office\/devices\/[^/]+\/status$/.test(topic)) {
+    console.log(`设备在线状态 ${topic}: ${message.toString()}`);
+  } else if (topic === 'office/ac/schedule/status') {
     const data = JSON.parse(message.toString());
     const now = Date.now();
 
+    // 规则和下次事件时间只由ESP32上报（规则保存在设备NVS中）
+    if (Array.isArray(data.rules)) scheduleStatus.rules = data.rules;
+    if (data.next) scheduleStatus.next = data.next;
+
     // 如果是在用户操作后的30秒内，优先接受ESP32的确认
     if (now - lastScheduleCommandTime < 30000) {
       scheduleStatus.enabled = data.enabled;
@@ -128,15 +284,13 @@ const server = http.createServer((req, res) => {
     req.on('end', () => {
       try {
         const data = JSON.parse(body);
-        latestData = {
-          temperature: data.temperature,
-          humidity: data.humidity,
-          timestamp: Date.now()
-        };
-        console.log('收到数据:', latestData);
+        // 新固件批量上传 {samples:[{seq,t,temperature,humidity}]}，旧格式为单条 {temperature,humidity}
+        const samples = Array.isArray(data.samples) ? data.samples : [data];
+        const accepted = applySamples(samples);
+        console.log(`收到数据: ${accepted} 条, 最新:`, latestData);
         res.setHeader('Content-Type', 'application/json');
         res.writeHead(200);
-        res.end(JSON.stringify({ status: 'success' }));
+        res.end(JSON.stringify({ status: 'success', accepted: accepted }));
       } catch (e) {
         res.setHeader('Content-Type', 'application/json');
         res.writeHead(400);
@@ -153,9 +307,11 @@ const server = http.createServer((req, res) => {
         const action = data.action;
 
         // 发送MQTT消息
-        mqttClient.publish('office/ac/control', JSON.stringify({ action: action }));
+        // 指令编号和发送时间由设备原样带回应答，用于计算端到端延迟
+        const id = nextAcCommandId++;
+        mqttClient.publish('office/ac/control', JSON.stringify({ action: action, id: id, ts: Date.now() }));
 
-        console.log(`发送空调控制: ${action}`);
+        console.log(`发送空调控制 #${id}: ${action}`);
         res.setHeader('Content-Type', 'application/json');
         res.writeHead(200);
         res.end(JSON.stringify({ status: 'success', message: `空调${action === 'on' ? '开启' : '关闭'}指令已发送` }));
@@ -173,6 +329,9 @@ const server = http.createServer((req, res) => {
       try {
         const data = JSON.parse(body);
         const enabled = data.enabled;
+        const message = { enabled: enabled };
+        // 可选：同时下发定时规则 [{days:[1,2,3,4,5], at:'08:00', action:'on', below:17}, ...]
+        if (Array.isArray(data.rules)) message.rules = data.rules;
 
         // 立即更新服务器端状态
         scheduleStatus.enabled = enabled;
@@ -182,7 +341,7 @@ const server = http.createServer((req, res) => {
         lastScheduleCommandTime = Date.now();
 
         // 发送MQTT消息给ESP32
-        mqttClient.publish('office/ac/schedule/enabled', JSON.stringify({ enabled: enabled }));
+        mqttClient.publish('office/ac/schedule/enabled', JSON.stringify(message));
 
         console.log(`定时空调控制: ${enabled ? '启用' : '禁用'}`);
         res.setHeader('Content-Type', 'application/json');
@@ -752,6 +911,10 @@ const server = http.createServer((req, res) => {
   }
 });
 
+// HTTP 遥测模式下 ESP32 每30秒批量上传一次，保持连接比上传周期长，避免每批重新建立 TCP 连接
+server.keepAliveTimeout = 65000;
+server.headersTimeout = 66000;
+
 server.listen(3789, '127.0.0.1', () => {
   console.log('办公室ESP32监控服务运行在端口 3789');
 });
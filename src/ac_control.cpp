@@ -0,0 +1,307 @@
+// ============================================================================
+// 空调控制逻辑实现
+// ============================================================================
+#include "ac_control.h"
+#include <ArduinoJson.h>
+
+// ========================== 定时规则 ==========================
+static const AcScheduleRule DEFAULT_RULES[] = {
+  {AC_WEEKDAYS_WORKDAY, 8, 0, AC_ACTION_ON, 170},                       // 早上 8:00 低于 17°C 开机
+  {AC_WEEKDAYS_WORKDAY, 17, 30, AC_ACTION_OFF, AC_RULE_ANY_TEMPERATURE}, // 下午 17:30 无论是否开启都关机
+};
+
+AcSchedule::AcSchedule() : count(0) {
+  setDefaults();
+}
+
+void AcSchedule::setDefaults() {
+  setRules(DEFAULT_RULES, sizeof(DEFAULT_RULES) / sizeof(DEFAULT_RULES[0]));
+}
+
+bool AcSchedule::setRules(const AcScheduleRule* newRules, uint8_t newCount) {
+  if (newCount > AC_SCHEDULE_MAX_RULES) {
+    return false;
+  }
+  for (uint8_t i = 0; i < newCount; i++) {
+    const AcScheduleRule& r = newRules[i];
+    if (r.hour > 23 || r.minute > 59 || (r.weekdays & 0x7F) == 0 ||
+        (r.action != AC_ACTION_ON && r.action != AC_ACTION_OFF)) {
+      return false;
+    }
+  }
+  memcpy(rules, newRules, newCount * sizeof(AcScheduleRule));
+  count = newCount;
+  return true;
+}
+
+// 以 base 所在日期偏移 dayOffset 天、规则的时分构造本地时间；当天星期不匹配时返回 false
+static bool ruleTimeOnDay(const AcScheduleRule& r, const struct tm& base, int dayOffset, time_t& due) {
+  struct tm t = base;
+  t.tm_mday += dayOffset;
+  t.tm_hour = r.hour;
+  t.tm_min = r.minute;
+  t.tm_sec = 0;
+  t.tm_isdst = -1;
+  due = mktime(&t);  // 归一化日期并计算 tm_wday
+  return due != (time_t)-1 && (r.weekdays & (1 << t.tm_wday));
+}
+
+bool AcSchedule::next(time_t after, AcScheduleEvent& out) const {
+  struct tm base;
+  if (count == 0 || localtime_r(&after, &base) == nullptr) {
+    return false;
+  }
+
+  bool found = false;
+  for (int d = 0; d <= 7; d++) {
+    for (uint8_t i = 0; i < count; i++) {
+      time_t due;
+      if (ruleTimeOnDay(rules[i], base, d, due) && due > after && (!found || due < out.due)) {
+        out.due = due;
+        out.rule = i;
+        found = true;
+      }
+    }
+    if (found) {
+      break;  // 规则按天展开，当天找到的一定早于之后的天
+    }
+  }
+  return found;
+}
+
+bool AcSchedule::latestDue(time_t since, time_t now, AcScheduleEvent& out) const {
+  struct tm base;
+  if (count == 0 || localtime_r(&now, &base) == nullptr) {
+    return false;
+  }
+
+  time_t floor = max(since, now - (time_t)AC_SCHEDULE_CATCHUP_SEC);
+  bool found = false;
+  for (int d = 0; d >= -(AC_SCHEDULE_CATCHUP_SEC / 86400 + 1); d--) {
+    for (uint8_t i = 0; i < count; i++) {
+      time_t due;
+      // 同一时刻的多条规则以表中靠后的为准
+      if (ruleTimeOnDay(rules[i], base, d, due) && due > floor && due <= now &&
+          (!found || due >= out.due)) {
+        out.due = due;
+        out.rule = i;
+        found = true;
+      }
+    }
+  }
+  return found;
+}
+
+bool AcSchedule::needsTemperature(const AcScheduleEvent& event) const {
+  return rules[event.rule].belowTenths != AC_RULE_ANY_TEMPERATURE;
+}
+
+AcAction AcSchedule::actionFor(const AcScheduleEvent& event, float temperature) const {
+  const AcScheduleRule& r = rules[event.rule];
+  if (r.belowTenths != AC_RULE_ANY_TEMPERATURE && !(temperature * 10.0f < r.belowTenths)) {
+    return AC_ACTION_NONE;
+  }
+  return r.action;
+}
+
+size_t AcSchedule::statusJson(char* buf, size_t size, bool enabled, time_t nextDue) const {
+  size_t len = snprintf(buf, size, "{\"enabled\":%s,\"next\":%lu,\"rules\":[",
+                        enabled ? "true" : "false", (unsigned long)nextDue);
+  for (uint8_t i = 0; i < count && len < size; i++) {
+    const AcScheduleRule& r = rules[i];
+    len += snprintf(buf + len, size - len, "%s{\"days\":[", i ? "," : "");
+    bool first = true;
+    for (uint8_t d = 0; d < 7 && len < size; d++) {
+      if (r.weekdays & (1 << d)) {
+        len += snprintf(buf + len, size - len, first ? "%u" : ",%u", d);
+        first = false;
+      }
+    }
+    if (len < size) {
+      len += snprintf(buf + len, size - len, "],\"at\":\"%02u:%02u\",\"action\":\"%s\"",
+                      r.hour, r.minute, r.action == AC_ACTION_ON ? "on" : "off");
+    }
+    if (len < size && r.belowTenths != AC_RULE_ANY_TEMPERATURE) {
+      len += snprintf(buf + len, size - len, ",\"below\":%.1f", r.belowTenths / 10.0f);
+    }
+    if (len < size) {
+      len += snprintf(buf + len, size - len, "}");
+    }
+  }
+  if (len < size) {
+    len += snprintf(buf + len, size - len, "]}");
+  }
+  return len < size ? len : 0;
+}
+
+// ========================== 定时执行 ==========================
+uint32_t acScheduleArm(const AcSchedule& schedule, time_t now, time_t& nextDue) {
+  AcScheduleEvent next;
+  nextDue = 0;
+  if (!schedule.next(now, next)) {
+    return AC_SCHEDULE_MAX_ARM_MS;
+  }
+  nextDue = next.due;
+  uint64_t untilDue = (uint64_t)(next.due - now) * 1000 + AC_SCHEDULE_WAKE_SLACK_MS;
+  return (uint32_t)min<uint64_t>(untilDue, AC_SCHEDULE_MAX_ARM_MS);
+}
+
+AcRunResult acScheduleRun(const AcSchedule& schedule, bool enabled, time_t& lastRun, time_t now,
+                          bool hasSample, float temperature) {
+  AcRunResult result = {};
+  result.action = AC_ACTION_NONE;
+  if (now < AC_SCHEDULE_SYNCED_AFTER) {
+    result.outcome = AC_RUN_NOT_SYNCED;
+    result.wakeMs = AC_SCHEDULE_RETRY_MS;
+    return result;
+  }
+
+  if (schedule.latestDue(lastRun, now, result.event)) {
+    if (!enabled) {
+      result.outcome = AC_RUN_DISABLED;
+    } else if (schedule.needsTemperature(result.event) && !hasSample) {
+      // 补执行窗口内稍后重试，lastRun 不前移
+      result.outcome = AC_RUN_WAIT_SENSOR;
+      result.wakeMs = AC_SCHEDULE_RETRY_MS;
+      return result;
+    } else {
+      result.outcome = AC_RUN_EXECUTED;
+      result.action = schedule.actionFor(result.event, hasSample ? temperature : NAN);
+    }
+    lastRun = now;
+  } else {
+    result.outcome = AC_RUN_IDLE;
+    if (now > lastRun) {
+      lastRun = now;  // 没有事件时调用方只更新内存，不写 Flash
+    }
+  }
+
+  result.rearm = true;
+  result.wakeMs = acScheduleArm(schedule, now, result.nextDue);
+  return result;
+}
+
+bool parseACSchedule(const uint8_t* payload, size_t length, AcScheduleUpdate& out) {
+  // 规则表的文档较大（1KB），放在堆上：调用方是栈较小的 MQTT 任务，规则更新很少
+  DynamicJsonDocument doc(1024);
+  if (doc.capacity() == 0) {
+    Serial.println("❌ 定时规则解析内存不足");
+    return false;
+  }
+  DeserializationError error = deserializeJson(doc, payload, length);
+  if (error) {
+    Serial.printf("❌ JSON解析失败: %s\n", error.c_str());
+    return false;
+  }
+
+  out.hasEnabled = doc.containsKey("enabled");
+  out.enabled = doc["enabled"] | true;
+  out.hasRules = doc.containsKey("rules");
+  out.ruleCount = 0;
+  if (!out.hasRules) {
+    return true;
+  }
+
+  JsonArrayConst list = doc["rules"];
+  if (list.isNull() || list.size() > AC_SCHEDULE_MAX_RULES) {
+    Serial.println("❌ 定时规则格式错误或超过上限");
+    return false;
+  }
+  for (JsonObjectConst item : list) {
+    AcScheduleRule& r = out.rules[out.ruleCount];
+    r.weekdays = 0;
+    for (JsonVariantConst day : item["days"].as<JsonArrayConst>()) {
+      int d = day | -1;
+      if (d < 0 || d > 6) {
+        return false;
+      }
+      r.weekdays |= 1 << d;
+    }
+
+    unsigned hour, minute;
+    const char* at = item["at"] | "";
+    if (sscanf(at, "%u:%u", &hour, &minute) != 2 || hour > 23 || minute > 59) {
+      Serial.printf("❌ 定时规则时间格式错误: %s\n", at);
+      return false;
+    }
+    r.hour = hour;
+    r.minute = minute;
+
+    const char* action = item["action"] | "";
+    if (strcmp(action, "on") == 0) {
+      r.action = AC_ACTION_ON;
+    } else if (strcmp(action, "off") == 0) {
+      r.action = AC_ACTION_OFF;
+    } else {
+      return false;
+    }
+
+    r.belowTenths = item.containsKey("below")
+                        ? (int16_t)lroundf((item["below"] | 0.0f) * 10.0f)
+                        : AC_RULE_ANY_TEMPERATURE;
+    if (r.weekdays == 0) {
+      return false;
+    }
+    out.ruleCount++;
+  }
+  return true;
+}
+
+bool parseACCommand(const uint8_t* payload, size_t length, AcCommand& out) {
+  out.action = AC_ACTION_NONE;
+  StaticJsonDocument<128> doc;
+  DeserializationError error = deserializeJson(doc, payload, length);
+  if (error) {
+    Serial.printf("❌ JSON解析失败: %s\n", error.c_str());
+    return false;
+  }
+
+  const char* action = doc["action"];
+  if (action == nullptr) {
+    return false;
+  }
+  if (strcmp(action, "on") == 0) {
+    out.action = AC_ACTION_ON;
+  } else if (strcmp(action, "off") == 0) {
+    out.action = AC_ACTION_OFF;
+  } else {
+    return false;
+  }
+  out.id = doc["id"] | 0u;
+  out.sentMs = doc["ts"] | (uint64_t)0;
+  return true;
+}
+
+const char* acCommandResultName(AcCommandResult result) {
+  switch (result) {
+    case AC_RESULT_ACKED:      return "acked";
+    case AC_RESULT_NO_ACK:     return "no_ack";
+    case AC_RESULT_SUPERSEDED: return "superseded";
+    default:                   return "rejected";
+  }
+}
+
+size_t acCommandAckJson(char* buf, size_t size, const AcCommandAck& ack) {
+  size_t len = snprintf(buf, size, "{\"id\":%lu,\"action\":\"%s\",\"result\":\"%s\",\"sent\":%llu,\"recv\":%llu",
+                        (unsigned long)ack.id, ack.action == AC_ACTION_ON ? "on" : "off",
+                        acCommandResultName(ack.result),
+                        (unsigned long long)ack.sentMs, (unsigned long long)ack.receivedMs);
+  if (len < size && ack.dispatchMs != AC_ACK_TIME_NONE) {
+    len += snprintf(buf + len, size - len, ",\"dispatch_ms\":%lu", (unsigned long)ack.dispatchMs);
+  }
+  if (len < size && ack.irAckMs != AC_ACK_TIME_NONE) {
+    len += snprintf(buf + len, size - len, ",\"ir_ack_ms\":%lu", (unsigned long)ack.irAckMs);
+  }
+  if (len < size) {
+    len += snprintf(buf + len, size - len, "}");
+  }
+  return len < size ? len : 0;
+}
+
+const char* acIRCommand(AcAction action) {
+  switch (action) {
+    case AC_ACTION_ON:  return "fs00";
+    case AC_ACTION_OFF: return "fs20";
+    default:            return nullptr;
+  }
+}
@@ -0,0 +1,147 @@
+// ============================================================================
+// 空调控制逻辑
+// 功能：表驱动的定时规则（计算下一个到期事件、补执行错过的事件）和远程控制消息解析，
+//       只返回要执行的动作，由调用方负责发送红外命令、定时和持久化（主机构建可直接测试/基准）
+// ============================================================================
+#pragma once
+
+#include <Arduino.h>
+#include <time.h>
+
+#define AC_SCHEDULE_MAX_RULES    8
+#define AC_SCHEDULE_CATCHUP_SEC  3600       // 错过的事件在到期后 1 小时内补执行，更早的作废
+#define AC_RULE_ANY_TEMPERATURE  INT16_MAX  // 规则不检查温度
+#define AC_WEEKDAYS_WORKDAY      0x3E       // 周一到周五（bit n = 星期 n，0=周日）
+
+enum AcAction : uint8_t {
+  AC_ACTION_NONE = 0,
+  AC_ACTION_ON,
+  AC_ACTION_OFF,
+};
+
+struct AcScheduleRule {
+  uint8_t weekdays;      // bit n = 星期 n（0=周日）
+  uint8_t hour;
+  uint8_t minute;
+  AcAction action;
+  int16_t belowTenths;   // 只在温度低于该值（0.1°C）时执行，AC_RULE_ANY_TEMPERATURE 为无条件
+};
+
+struct AcScheduleEvent {
+  time_t due;            // 本地时间换算后的 Unix 时间
+  uint8_t rule;          // 规则下标
+};
+
+class AcSchedule {
+ public:
+  AcSchedule();
+
+  // 默认规则：工作日 8:00 低于 17°C 开机，17:30 关机
+  void setDefaults();
+  bool setRules(const AcScheduleRule* rules, uint8_t count);
+  uint8_t size() const { return count; }
+  const AcScheduleRule& rule(uint8_t index) const { return rules[index]; }
+
+  // 严格晚于 after 的第一个事件；没有规则时返回 false
+  bool next(time_t after, AcScheduleEvent& out) const;
+
+  // (since, now] 内最近到期的事件（多个错过的事件只执行最新的一个）；
+  // 早于 now - AC_SCHEDULE_CATCHUP_SEC 的事件不再执行
+  bool latestDue(time_t since, time_t now, AcScheduleEvent& out) const;
+
+  // 规则是否需要温度读数；需要时 temperature 才有意义
+  bool needsTemperature(const AcScheduleEvent& event) const;
+  // 事件在该温度下应执行的动作（条件不满足时为 AC_ACTION_NONE）
+  AcAction actionFor(const AcScheduleEvent& event, float temperature) const;
+
+  // 定时状态消息，缓冲区不足时返回 0：
+  // {"enabled":true,"next":1700000000,"rules":[{"days":[1,2,3,4,5],"at":"08:00","action":"on","below":17.0},...]}
+  size_t statusJson(char* buf, size_t size, bool enabled, time_t nextDue) const;
+
+ private:
+  AcScheduleRule rules[AC_SCHEDULE_MAX_RULES];
+  uint8_t count;
+};
+
+// ========================== 定时执行 ==========================
+// runACSchedule() 的决策部分：给定系统时间和最新读数，决定处理哪个事件、多久后再运行。
+// 不发送红外命令、不设置定时器、不写 Flash，回放程序（src/native/replay）在虚拟时钟上运行同一份代码
+#define AC_SCHEDULE_MAX_ARM_MS    3600000  // 单次定时最长 1 小时，NTP 调整系统时间后也能及时校正
+#define AC_SCHEDULE_RETRY_MS      60000    // 时间未同步或缺少温度读数时的重试间隔
+#define AC_SCHEDULE_WAKE_SLACK_MS 200      // 多等一点，保证醒来时系统时间已经到达事件时间
+#define AC_SCHEDULE_SYNCED_AFTER  1000000  // 早于该时间视为尚未同步
+
+enum AcRunOutcome : uint8_t {
+  AC_RUN_IDLE = 0,       // 没有到期的事件
+  AC_RUN_NOT_SYNCED,     // 时间未同步，稍后重试
+  AC_RUN_WAIT_SENSOR,    // 事件需要温度读数但暂无，稍后重试（不记为已处理）
+  AC_RUN_DISABLED,       // 定时已禁用：事件记为已处理，不执行
+  AC_RUN_EXECUTED,       // 事件已处理，action 为要执行的动作（温度条件不满足时为 NONE）
+};
+
+struct AcRunResult {
+  AcRunOutcome outcome;
+  AcScheduleEvent event;  // DISABLED/EXECUTED/WAIT_SENSOR 时有效
+  AcAction action;
+  bool rearm;             // true：按 nextDue 重新计算（已写入 wakeMs）；false：wakeMs 为重试间隔
+  time_t nextDue;         // 下一个事件，没有时为 0（rearm 为 true 时有效）
+  uint32_t wakeMs;        // 距下次运行的时间
+};
+
+// lastRun 为已处理到的时间点，由调用方持久化（outcome 为 DISABLED/EXECUTED 时应保存）
+AcRunResult acScheduleRun(const AcSchedule& schedule, bool enabled, time_t& lastRun, time_t now,
+                          bool hasSample, float temperature);
+// 下一个事件（没有时 nextDue 为 0）和对应的定时器延迟
+uint32_t acScheduleArm(const AcSchedule& schedule, time_t now, time_t& nextDue);
+
+// 解析定时主题的消息：{"enabled":true} 和/或 {"rules":[...]}，两者都可省略。
+// 含 "rules" 时解析到 out.rules；任何一条规则格式错误都返回 false，调用方应整体丢弃
+struct AcScheduleUpdate {
+  bool hasEnabled;
+  bool enabled;
+  bool hasRules;
+  AcScheduleRule rules[AC_SCHEDULE_MAX_RULES];
+  uint8_t ruleCount;
+};
+bool parseACSchedule(const uint8_t* payload, size_t length, AcScheduleUpdate& out);
+
+// 远程空调指令：id 和发送时间由发送方给出（可省略，为 0），设备在应答中原样带回
+struct AcCommand {
+  AcAction action;
+  uint32_t id;
+  uint64_t sentMs;       // 发送方的 Unix 时间（毫秒）
+};
+
+// 解析 {"action":"on","id":42,"ts":1700000000123}，id/ts 可省略；
+// 格式错误或未知动作返回 false（out.action 为 AC_ACTION_NONE）
+bool parseACCommand(const uint8_t* payload, size_t length, AcCommand& out);
+
+// 指令的最终结果
+enum AcCommandResult : uint8_t {
+  AC_RESULT_ACKED = 0,   // 红外模块已响应
+  AC_RESULT_NO_ACK,      // 已发送，模块超时未响应
+  AC_RESULT_SUPERSEDED,  // 被后到的指令覆盖，未发送
+  AC_RESULT_REJECTED,    // 队列已满，未执行
+};
+
+#define AC_ACK_TIME_NONE UINT32_MAX  // 该阶段没有发生（未发送 / 模块未响应）
+
+// 指令应答：设备收到指令的 Unix 时间，以及之后各阶段相对收到时刻的耗时
+struct AcCommandAck {
+  uint32_t id;
+  AcAction action;
+  AcCommandResult result;
+  uint64_t sentMs;       // 发送方时间戳（原样带回）
+  uint64_t receivedMs;   // 设备收到指令的 Unix 时间（毫秒），时间未同步时为 0
+  uint32_t dispatchMs;   // 收到 → 红外命令写入模块串口
+  uint32_t irAckMs;      // 收到 → 模块响应
+};
+
+const char* acCommandResultName(AcCommandResult result);
+
+// 应答消息，缓冲区不足时返回 0（未发生的阶段省略）：
+// {"id":42,"action":"on","result":"acked","sent":1700000000123,"recv":1700000000180,"dispatch_ms":3,"ir_ack_ms":41}
+size_t acCommandAckJson(char* buf, size_t size, const AcCommandAck& ack);
+
+// 动作对应的红外模块命令
+const char* acIRCommand(AcAction action);
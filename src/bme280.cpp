@@ -0,0 +1,152 @@
+// ============================================================================
+// BME280 实现（补偿公式见 BME280 数据手册 4.2.3 / 8.2）
+// ============================================================================
+#include "bme280.h"
+
+#define BME280_REG_CALIB_TP   0x88  // 0x88～0x9F 温度/气压校准，0xA1 为 dig_H1
+#define BME280_REG_CALIB_H1   0xA1
+#define BME280_REG_CHIP_ID    0xD0
+#define BME280_REG_RESET      0xE0
+#define BME280_REG_CALIB_H    0xE1  // 0xE1～0xE7 湿度校准
+#define BME280_REG_CTRL_HUM   0xF2
+#define BME280_REG_STATUS     0xF3
+#define BME280_REG_CTRL_MEAS  0xF4
+#define BME280_REG_CONFIG     0xF5
+#define BME280_REG_DATA       0xF7  // 0xF7～0xFE：气压、温度、湿度
+
+#define BME280_CHIP_ID        0x60
+#define BME280_RESET_WORD     0xB6
+#define BME280_STATUS_MEASURING 0x08
+#define BME280_STATUS_IM_UPDATE 0x01
+#define BME280_OSRS_X1_HUM    0x01
+#define BME280_MEAS_FORCED_X1 0x25  // osrs_t=1, osrs_p=1, mode=forced
+
+static uint16_t le16(const uint8_t* p) {
+  return p[0] | (p[1] << 8);
+}
+
+Bme280::Bme280(I2cBus& i2cBus, uint8_t i2cAddress) : bus(i2cBus), address(i2cAddress), cal{} {}
+
+bool Bme280::begin() {
+  uint8_t chipId = 0;
+  if (!bus.begin() || !bus.probe(address) ||
+      !bus.readRegisters(address, BME280_REG_CHIP_ID, &chipId, 1) || chipId != BME280_CHIP_ID) {
+    return false;  // BMP280（0x58）没有湿度，不支持
+  }
+  if (!bus.writeRegister(address, BME280_REG_RESET, BME280_RESET_WORD)) {
+    return false;
+  }
+  // 复位后等待 NVM 校准参数载入完成
+  uint8_t status = BME280_STATUS_IM_UPDATE;
+  for (int i = 0; i < 10 && (status & BME280_STATUS_IM_UPDATE); i++) {
+    delay(2);
+    if (!bus.readRegisters(address, BME280_REG_STATUS, &status, 1)) {
+      return false;
+    }
+  }
+  // ctrl_hum 只在写 ctrl_meas 之后生效，trigger() 每次都会写 ctrl_meas
+  return readCalibration() &&
+         bus.writeRegister(address, BME280_REG_CTRL_HUM, BME280_OSRS_X1_HUM) &&
+         bus.writeRegister(address, BME280_REG_CONFIG, 0x00);  // 关闭 IIR 滤波，由 SensorFilter 平滑
+}
+
+bool Bme280::readCalibration() {
+  uint8_t tp[24];
+  uint8_t h[7];
+  if (!bus.readRegisters(address, BME280_REG_CALIB_TP, tp, sizeof(tp)) ||
+      !bus.readRegisters(address, BME280_REG_CALIB_H1, &cal.h1, 1) ||
+      !bus.readRegisters(address, BME280_REG_CALIB_H, h, sizeof(h))) {
+    return false;
+  }
+  cal.t1 = le16(tp + 0);
+  cal.t2 = (int16_t)le16(tp + 2);
+  cal.t3 = (int16_t)le16(tp + 4);
+  cal.p1 = le16(tp + 6);
+  cal.p2 = (int16_t)le16(tp + 8);
+  cal.p3 = (int16_t)le16(tp + 10);
+  cal.p4 = (int16_t)le16(tp + 12);
+  cal.p5 = (int16_t)le16(tp + 14);
+  cal.p6 = (int16_t)le16(tp + 16);
+  cal.p7 = (int16_t)le16(tp + 18);
+  cal.p8 = (int16_t)le16(tp + 20);
+  cal.p9 = (int16_t)le16(tp + 22);
+  cal.h2 = (int16_t)le16(h + 0);
+  cal.h3 = h[2];
+  cal.h4 = (int16_t)(((int8_t)h[3] * 16) | (h[4] & 0x0F));  // 12 位有符号，跨两个寄存器
+  cal.h5 = (int16_t)(((int8_t)h[5] * 16) | (h[4] >> 4));
+  cal.h6 = (int8_t)h[6];
+  return cal.t1 != 0 && cal.p1 != 0;  // 全 0 说明读到的不是有效校准数据
+}
+
+SensorStatus Bme280::trigger() {
+  return bus.writeRegister(address, BME280_REG_CTRL_MEAS, BME280_MEAS_FORCED_X1) ? SENSOR_OK
+                                                                                 : SENSOR_ERR_BUS;
+}
+
+SensorStatus Bme280::collect(SensorReading& out) {
+  uint8_t status = 0;
+  if (!bus.readRegisters(address, BME280_REG_STATUS, &status, 1)) {
+    return SENSOR_ERR_BUS;
+  }
+  if (status & BME280_STATUS_MEASURING) {
+    return SENSOR_PENDING;
+  }
+
+  // 一次突发读取，保证三个量来自同一次测量
+  uint8_t d[8];
+  if (!bus.readRegisters(address, BME280_REG_DATA, d, sizeof(d))) {
+    return SENSOR_ERR_BUS;
+  }
+  int32_t adcP = ((int32_t)d[0] << 12) | ((int32_t)d[1] << 4) | (d[2] >> 4);
+  int32_t adcT = ((int32_t)d[3] << 12) | ((int32_t)d[4] << 4) | (d[5] >> 4);
+  int32_t adcH = ((int32_t)d[6] << 8) | d[7];
+  if (adcT == 0x80000 || adcH == 0x8000) {
+    return SENSOR_ERR_FRAME;  // 跳过测量时寄存器保持复位值
+  }
+
+  int32_t tFine;
+  out.temperature = compensateTemperature(adcT, tFine) / 100.0f;
+  out.pressure = compensatePressure(adcP, tFine) / 25600.0f;  // Q24.8 Pa → hPa
+  out.humidity = compensateHumidity(adcH, tFine) / 1024.0f;   // Q22.10 %RH
+  return SENSOR_OK;
+}
+
+// 0.01°C
+int32_t Bme280::compensateTemperature(int32_t adc, int32_t& tFine) const {
+  int32_t var1 = ((((adc >> 3) - ((int32_t)cal.t1 << 1))) * ((int32_t)cal.t2)) >> 11;
+  int32_t var2 = (((((adc >> 4) - ((int32_t)cal.t1)) * ((adc >> 4) - ((int32_t)cal.t1))) >> 12) *
+                  ((int32_t)cal.t3)) >> 14;
+  tFine = var1 + var2;
+  return (tFine * 5 + 128) >> 8;
+}
+
+// Q24.8 Pa
+uint32_t Bme280::compensatePressure(int32_t adc, int32_t tFine) const {
+  int64_t var1 = ((int64_t)tFine) - 128000;
+  int64_t var2 = var1 * var1 * (int64_t)cal.p6;
+  var2 = var2 + ((var1 * (int64_t)cal.p5) << 17);
+  var2 = var2 + (((int64_t)cal.p4) << 35);
+  var1 = ((var1 * var1 * (int64_t)cal.p3) >> 8) + ((var1 * (int64_t)cal.p2) << 12);
+  var1 = (((((int64_t)1) << 47) + var1)) * ((int64_t)cal.p1) >> 33;
+  if (var1 == 0) {
+    return 0;  // 避免除零
+  }
+  int64_t p = 1048576 - adc;
+  p = (((p << 31) - var2) * 3125) / var1;
+  var1 = (((int64_t)cal.p9) * (p >> 13) * (p >> 13)) >> 25;
+  var2 = (((int64_t)cal.p8) * p) >> 19;
+  p = ((p + var1 + var2) >> 8) + (((int64_t)cal.p7) << 4);
+  return (uint32_t)p;
+}
+
+// Q22.10 %RH
+uint32_t Bme280::compensateHumidity(int32_t adc, int32_t tFine) const {
+  int32_t v = tFine - ((int32_t)76800);
+  v = (((((adc << 14) - (((int32_t)cal.h4) << 20) - (((int32_t)cal.h5) * v)) + ((int32_t)16384)) >> 15) *
+       (((((((v * ((int32_t)cal.h6)) >> 10) * (((v * ((int32_t)cal.h3)) >> 11) + ((int32_t)32768))) >> 10) +
+          ((int32_t)2097152)) * ((int32_t)cal.h2) + 8192) >> 14));
+  v = v - (((((v >> 15) * (v >> 15)) >> 7) * ((int32_t)cal.h1)) >> 4);
+  v = v < 0 ? 0 : v;
+  v = v > 419430400 ? 419430400 : v;
+  return (uint32_t)(v >> 12);
+}
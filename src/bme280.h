@@ -0,0 +1,46 @@
+// ============================================================================
+// BME280 温湿度/气压传感器（I2C）
+// 功能：强制模式（每次 trigger() 测量一次后回到睡眠），温度/气压/湿度各 1 倍过采样，
+//       最长转换 9.3ms；collect() 查询 status.measuring 后一次读出 8 字节原始值，
+//       按数据手册的整数补偿公式换算（校准参数在 begin() 中读取）
+// ============================================================================
+#pragma once
+
+#include <Arduino.h>
+#include "sensor_driver.h"
+#include "i2c_bus.h"
+
+#define BME280_ADDRESS_DEFAULT 0x76  // SDO 接高电平时为 0x77
+
+class Bme280 : public SensorDriver {
+ public:
+  Bme280(I2cBus& bus, uint8_t address = BME280_ADDRESS_DEFAULT);
+
+  const char* name() const override { return "bme280"; }
+  bool begin() override;
+  uint32_t minIntervalMs() const override { return 1000; }
+  uint32_t conversionMs() const override { return 10; }
+
+  SensorStatus trigger() override;
+  SensorStatus collect(SensorReading& out) override;
+
+ private:
+  struct Calibration {
+    uint16_t t1;
+    int16_t t2, t3;
+    uint16_t p1;
+    int16_t p2, p3, p4, p5, p6, p7, p8, p9;
+    uint8_t h1, h3;
+    int16_t h2, h4, h5;
+    int8_t h6;
+  };
+
+  bool readCalibration();
+  int32_t compensateTemperature(int32_t adc, int32_t& tFine) const;
+  uint32_t compensatePressure(int32_t adc, int32_t tFine) const;
+  uint32_t compensateHumidity(int32_t adc, int32_t tFine) const;
+
+  I2cBus& bus;
+  uint8_t address;
+  Calibration cal;
+};
@@ -0,0 +1,153 @@
+// ============================================================================
+// 热启动状态实现
+// 所有函数只在 setup() 和主循环中调用，不需要加锁
+// ============================================================================
+#include "boot_state.h"
+#include <esp_attr.h>
+#include <math.h>
+#include <stddef.h>
+#include <string.h>
+
+#define RETAINED_MAGIC   0x53543739  // "ST79"
+#define RETAINED_VERSION 1
+
+#define HAS_TIME    0x01
+#define HAS_READING 0x02
+#define HAS_AC      0x04
+
+struct RetainedState {
+  uint32_t magic;
+  uint16_t version;
+  uint8_t flags;                         // HAS_*
+  uint8_t lastPhase;                     // 本次启动已到达的阶段
+  uint32_t bootCount;
+  uint32_t lastTime;                     // 最近一次时钟刷新的 Unix 时间
+  int16_t temperature;                   // 0.1°C
+  uint16_t humidity;                     // 0.1%
+  bool acOn;
+  bool scheduleEnabled;
+  uint16_t phaseMs[BOOT_PHASE_COUNT];    // 本次启动各阶段距 setup() 开始的毫秒数
+  uint32_t checksum;
+};
+
+RTC_NOINIT_ATTR static RetainedState retained;
+
+static bool warm = false;
+static BootPhase previousPhase = BOOT_PHASE_COUNT;
+static uint32_t startMs = 0;
+
+static const char* PHASE_NAMES[BOOT_PHASE_COUNT] = {
+  "start", "first_frame", "services", "wifi", "time",
+};
+
+static uint32_t checksumOf(const RetainedState& s) {
+  const uint8_t* p = (const uint8_t*)&s;
+  uint32_t h = 2166136261u;  // FNV-1a，覆盖 checksum 之前的所有字节
+  for (size_t i = 0; i < offsetof(RetainedState, checksum); i++) {
+    h = (h ^ p[i]) * 16777619u;
+  }
+  return h;
+}
+
+static void seal() {
+  retained.checksum = checksumOf(retained);
+}
+
+bool bootStateBegin() {
+  startMs = millis();
+  warm = retained.magic == RETAINED_MAGIC && retained.version == RETAINED_VERSION &&
+         retained.checksum == checksumOf(retained);
+  if (warm) {
+    previousPhase = (BootPhase)retained.lastPhase;
+  } else {
+    // 上电或固件升级后内容不可信，全部清空
+    memset(&retained, 0, sizeof(retained));
+    retained.magic = RETAINED_MAGIC;
+    retained.version = RETAINED_VERSION;
+    previousPhase = BOOT_PHASE_COUNT;
+  }
+  retained.bootCount++;
+  retained.lastPhase = BOOT_PHASE_START;
+  memset(retained.phaseMs, 0, sizeof(retained.phaseMs));
+  seal();
+  return warm;
+}
+
+bool bootStateWarm() {
+  return warm;
+}
+
+uint32_t bootStateCount() {
+  return retained.bootCount;
+}
+
+void bootPhase(BootPhase phase) {
+  if (phase == BOOT_PHASE_START || retained.phaseMs[phase] != 0) {
+    return;
+  }
+  uint32_t elapsed = millis() - startMs;
+  retained.phaseMs[phase] = elapsed > UINT16_MAX ? UINT16_MAX : (elapsed ? elapsed : 1);
+  if (phase > retained.lastPhase) {
+    retained.lastPhase = phase;
+  }
+  seal();
+  Serial.printf("⏱️ 启动阶段 %-11s %5lu ms\n", PHASE_NAMES[phase], (unsigned long)elapsed);
+}
+
+BootPhase bootLastPhaseBefore() {
+  return previousPhase;
+}
+
+const char* bootPhaseName(BootPhase phase) {
+  return phase < BOOT_PHASE_COUNT ? PHASE_NAMES[phase] : "none";
+}
+
+bool bootRestoreTime(time_t& out) {
+  if (!(retained.flags & HAS_TIME)) {
+    return false;
+  }
+  out = (time_t)retained.lastTime;
+  return true;
+}
+
+bool bootRestoreReading(SensorSample& out) {
+  if (!(retained.flags & HAS_READING)) {
+    return false;
+  }
+  out.timestampMs = 0;
+  out.temperature = retained.temperature / 10.0f;
+  out.humidity = retained.humidity / 10.0f;
+  return true;
+}
+
+bool bootRestoreAc(bool& acOn, bool& scheduleEnabled) {
+  if (!(retained.flags & HAS_AC)) {
+    return false;
+  }
+  acOn = retained.acOn;
+  scheduleEnabled = retained.scheduleEnabled;
+  return true;
+}
+
+void bootSaveTime(time_t now) {
+  if (now < 1000000) {
+    return;
+  }
+  retained.lastTime = (uint32_t)now;
+  retained.flags |= HAS_TIME;
+  seal();
+}
+
+void bootSaveReading(const SensorSample& sample) {
+  retained.temperature = (int16_t)lroundf(sample.temperature * 10.0f);
+  retained.humidity = (uint16_t)lroundf(sample.humidity * 10.0f);
+  retained.flags |= HAS_READING;
+  seal();
+}
+
+void bootSaveAc(bool acOn, bool scheduleEnabled) {
+  retained.acOn = acOn;
+  retained.scheduleEnabled = scheduleEnabled;
+  retained.flags |= HAS_AC;
+  seal();
+}
@@ -0,0 +1,43 @@
+// ============================================================================
+// 热启动状态
+// 功能：在 RTC 慢速内存（RTC_NOINIT，软件复位、看门狗和异常复位后保留，上电后无效）中保存
+//       最近的时间、温湿度读数、空调开关和定时开关，复位后第一帧直接画出这些内容，
+//       不必等 WiFi、NTP 和传感器；同时记录每次启动各阶段的耗时，
+//       启动中途复位时下次启动可以看到停在哪个阶段
+// ============================================================================
+#pragma once
+
+#include <Arduino.h>
+#include <time.h>
+#include "sensor_filter.h"
+
+enum BootPhase : uint8_t {
+  BOOT_PHASE_START = 0,     // setup() 开始
+  BOOT_PHASE_FIRST_FRAME,   // 屏幕初始化完成，第一帧已提交刷新
+  BOOT_PHASE_SERVICES,      // 后台任务（WiFi、传感器、红外、HTTP、MQTT）已全部启动
+  BOOT_PHASE_WIFI,          // 首次取得 IP
+  BOOT_PHASE_TIME,          // 首次 NTP 同步
+  BOOT_PHASE_COUNT,
+};
+
+// 在 setup() 最开始调用：校验保留的状态（无效时清空）并计数启动次数；返回是否为热启动
+bool bootStateBegin();
+bool bootStateWarm();
+uint32_t bootStateCount();
+
+// 记录阶段完成（每个阶段只记录第一次），并打印距 setup() 开始的耗时
+void bootPhase(BootPhase phase);
+
+// 上一次启动到达的最后阶段（bootStateBegin() 之前的值）；冷启动时为 BOOT_PHASE_COUNT
+BootPhase bootLastPhaseBefore();
+const char* bootPhaseName(BootPhase phase);
+
+// 恢复：没有保存过时返回 false
+bool bootRestoreTime(time_t& out);
+bool bootRestoreReading(SensorSample& out);
+bool bootRestoreAc(bool& acOn, bool& scheduleEnabled);
+
+// 保存：只写 RTC 内存，可以频繁调用
+void bootSaveTime(time_t now);
+void bootSaveReading(const SensorSample& sample);
+void bootSaveAc(bool acOn, bool scheduleEnabled);
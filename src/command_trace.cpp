@@ -0,0 +1,219 @@
+// ============================================================================
+// 远程指令延迟追踪实现
+// 应答队列有两个生产者（红外调度任务的完成回调、MQTT 任务提交失败时），使用 FreeRTOS 队列；
+// 时间线槽位只由 MQTT 任务占用，调度任务在完成回调中读取后释放
+// ============================================================================
+#include "command_trace.h"
+#include <freertos/FreeRTOS.h>
+#include <freertos/queue.h>
+#include <stdio.h>
+#include <sys/time.h>
+#include <atomic>
+#include "prom_text.h"
+
+#define STAGE_COUNT   4
+#define HIST_BUCKETS  9   // 最后一档为 +Inf
+
+enum Stage : uint8_t {
+  STAGE_NETWORK = 0,
+  STAGE_DISPATCH,
+  STAGE_IR_ACK,
+  STAGE_TOTAL,
+};
+
+static const char* STAGE_NAMES[STAGE_COUNT] = {"network", "dispatch", "ir_ack", "total"};
+
+// 直方图上界（毫秒）
+static const uint32_t LATENCY_BUCKETS_MS[HIST_BUCKETS - 1] = {
+  10, 25, 50, 100, 200, 500, 1000, 2000,
+};
+
+struct PendingAck {
+  AcCommandAck ack;
+  WireFormat format;
+};
+
+struct TraceSlot {
+  RemoteCommand command;
+  IrCompletionCallback log;
+  std::atomic<bool> inUse;  // 从提交到完成回调读完为止
+};
+
+struct TraceStats {
+  uint32_t buckets[STAGE_COUNT][HIST_BUCKETS];  // 非累计，导出时再累加
+  uint64_t sumMs[STAGE_COUNT];
+  uint32_t results[AC_RESULT_REJECTED + 1];
+  uint32_t overTarget;  // total 超过 COMMAND_TRACE_TARGET_MS 的次数
+  uint32_t dropped;     // 应答队列已满而丢弃的应答
+};
+
+static QueueHandle_t ackQueue = nullptr;
+static TraceSlot slots[COMMAND_TRACE_SLOTS];
+static uint8_t nextSlot = 0;
+static TraceStats stats;
+static portMUX_TYPE statsLock = portMUX_INITIALIZER_UNLOCKED;
+
+static uint64_t unixMillis() {
+  struct timeval tv;
+  gettimeofday(&tv, nullptr);
+  if (tv.tv_sec <= 1600000000) {
+    return 0;  // 时间未同步
+  }
+  return (uint64_t)tv.tv_sec * 1000 + tv.tv_usec / 1000;
+}
+
+static void postAck(const RemoteCommand& command, AcCommandResult result, uint32_t dispatchMs, uint32_t irAckMs) {
+  PendingAck pending;
+  pending.ack.id = command.command.id;
+  pending.ack.action = command.command.action;
+  pending.ack.result = result;
+  pending.ack.sentMs = command.command.sentMs;
+  pending.ack.receivedMs = command.receivedUnixMs;
+  pending.ack.dispatchMs = dispatchMs;
+  pending.ack.irAckMs = irAckMs;
+  pending.format = command.format;
+  if (ackQueue == nullptr || xQueueSend(ackQueue, &pending, 0) != pdTRUE) {
+    portENTER_CRITICAL(&statsLock);
+    stats.dropped++;
+    portEXIT_CRITICAL(&statsLock);
+  }
+}
+
+// 在红外调度任务中执行
+static void onIrResult(const IrResult& result, void* ctx) {
+  TraceSlot* slot = (TraceSlot*)ctx;
+  const RemoteCommand command = slot->command;
+  IrCompletionCallback log = slot->log;
+  slot->inUse = false;
+
+  if (log) {
+    log(result, nullptr);
+  }
+  if (result.superseded) {
+    postAck(command, AC_RESULT_SUPERSEDED, AC_ACK_TIME_NONE, AC_ACK_TIME_NONE);
+    return;
+  }
+  uint32_t dispatchMs = result.sentMs - command.receivedMs;
+  if (result.acked) {
+    postAck(command, AC_RESULT_ACKED, dispatchMs, result.ackMs - command.receivedMs);
+  } else {
+    postAck(command, AC_RESULT_NO_ACK, dispatchMs, AC_ACK_TIME_NONE);
+  }
+}
+
+bool commandTraceBegin() {
+  if (ackQueue == nullptr) {
+    ackQueue = xQueueCreate(COMMAND_TRACE_ACK_QUEUE, sizeof(PendingAck));
+  }
+  return ackQueue != nullptr;
+}
+
+void commandTraceReceive(RemoteCommand& out, const AcCommand& command, WireFormat format) {
+  out.receivedMs = millis();
+  out.receivedUnixMs = unixMillis();
+  out.command = command;
+  out.format = format;
+}
+
+uint32_t commandTraceSubmit(const RemoteCommand& command, const char* irCommand, IrCompletionCallback log) {
+  // 从上次分配的位置起找一个空闲槽位；全部在用（红外命令积压）时拒绝
+  TraceSlot* slot = nullptr;
+  for (uint8_t i = 0; i < COMMAND_TRACE_SLOTS && slot == nullptr; i++) {
+    uint8_t index = (nextSlot + i) % COMMAND_TRACE_SLOTS;
+    if (!slots[index].inUse) {
+      slot = &slots[index];
+      nextSlot = (index + 1) % COMMAND_TRACE_SLOTS;
+    }
+  }
+  if (slot == nullptr) {
+    postAck(command, AC_RESULT_REJECTED, AC_ACK_TIME_NONE, AC_ACK_TIME_NONE);
+    return 0;
+  }
+
+  // 完成回调可能在 irSubmit() 返回前就执行，所以先占用再提交，提交失败时归还
+  slot->command = command;
+  slot->log = log;
+  slot->inUse = true;
+  uint32_t id = irSubmit(irCommand, IR_KIND_AC_POWER, onIrResult, slot);
+  if (id == 0) {
+    slot->inUse = false;
+    postAck(command, AC_RESULT_REJECTED, AC_ACK_TIME_NONE, AC_ACK_TIME_NONE);
+  }
+  return id;
+}
+
+static void observe(Stage stage, uint32_t ms) {
+  uint8_t i = 0;
+  while (i < HIST_BUCKETS - 1 && ms > LATENCY_BUCKETS_MS[i]) {
+    i++;
+  }
+  stats.buckets[stage][i]++;
+  stats.sumMs[stage] += ms;
+}
+
+bool commandTraceNextAck(AcCommandAck& out, WireFormat& format) {
+  PendingAck pending;
+  if (ackQueue == nullptr || xQueueReceive(ackQueue, &pending, 0) != pdTRUE) {
+    return false;
+  }
+  out = pending.ack;
+  format = pending.format;
+
+  // 发送方时间戳晚于收到时刻说明两边时钟不一致，不计入网络延迟
+  bool hasNetwork = out.sentMs != 0 && out.receivedMs != 0 && out.receivedMs >= out.sentMs;
+  uint32_t networkMs = hasNetwork ? (uint32_t)(out.receivedMs - out.sentMs) : 0;
+  portENTER_CRITICAL(&statsLock);
+  stats.results[out.result]++;
+  if (hasNetwork) {
+    observe(STAGE_NETWORK, networkMs);
+  }
+  if (out.dispatchMs != AC_ACK_TIME_NONE) {
+    observe(STAGE_DISPATCH, out.dispatchMs);
+    if (hasNetwork) {
+      observe(STAGE_TOTAL, networkMs + out.dispatchMs);
+      if (networkMs + out.dispatchMs > COMMAND_TRACE_TARGET_MS) {
+        stats.overTarget++;
+      }
+    }
+  }
+  if (out.irAckMs != AC_ACK_TIME_NONE) {
+    observe(STAGE_IR_ACK, out.irAckMs);
+  }
+  portEXIT_CRITICAL(&statsLock);
+  return true;
+}
+
+// ========================== Prometheus 导出 ==========================
+
+size_t commandTraceToPrometheus(char* buf, size_t size) {
+  // 先复制快照再格式化，临界区内不做耗时操作
+  TraceStats s;
+  portENTER_CRITICAL(&statsLock);
+  s = stats;
+  portEXIT_CRITICAL(&statsLock);
+
+  size_t len = 0;
+  promHeader(buf, size, len, "ac_command_latency_seconds", "histogram",
+             "Remote AC command latency by stage "
+             "(network: publish to receive, dispatch: receive to IR send, "
+             "ir_ack: receive to module response, total: publish to IR send).");
+  char labels[24];
+  for (uint8_t st = 0; st < STAGE_COUNT; st++) {
+    snprintf(labels, sizeof(labels), "stage=\"%s\"", STAGE_NAMES[st]);
+    promHistogram(buf, size, len, "ac_command_latency_seconds", labels, s.buckets[st], HIST_BUCKETS,
+                  LATENCY_BUCKETS_MS, 1e-3, s.sumMs[st] / 1000.0);
+  }
+
+  promHeader(buf, size, len, "ac_commands_total", "counter", "Remote AC commands by result.");
+  for (uint8_t r = 0; r <= AC_RESULT_REJECTED; r++) {
+    appendf(buf, size, len, "ac_commands_total{result=\"%s\"} %lu\n", acCommandResultName((AcCommandResult)r),
+            (unsigned long)s.results[r]);
+  }
+  appendf(buf, size, len, "# HELP ac_commands_over_target_total Commands whose publish-to-IR time exceeded %d ms.\n",
+          COMMAND_TRACE_TARGET_MS);
+  promHeader(buf, size, len, "ac_commands_over_target_total", "counter");
+  appendf(buf, size, len, "ac_commands_over_target_total %lu\n", (unsigned long)s.overTarget);
+  promHeader(buf, size, len, "ac_command_acks_dropped_total", "counter");
+  appendf(buf, size, len, "ac_command_acks_dropped_total %lu\n", (unsigned long)s.dropped);
+  return len < size ? len : 0;
+}
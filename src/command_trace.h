@@ -0,0 +1,44 @@
+// ============================================================================
+// 远程指令延迟追踪
+// 功能：MQTT 任务收到空调指令时记下收到时刻，并直接把红外命令交给红外调度任务（不经过主循环）；
+//       红外命令完成（模块响应、超时或被覆盖）后在调度任务中生成应答放入队列，
+//       MQTT 任务取出发布到 <prefix>/ac/ack，同时按阶段统计延迟：
+//         network   发送方时间戳 → 设备收到（需要双方时钟同步，时间戳缺省时不统计）
+//         dispatch  设备收到 → 红外命令写入模块串口
+//         ir_ack    设备收到 → 模块响应
+//         total     发送方时间戳 → 红外命令写入模块串口（目标 200ms 以内）
+// ============================================================================
+#pragma once
+
+#include <Arduino.h>
+#include "ac_control.h"
+#include "ir_dispatcher.h"
+#include "wire_codec.h"
+
+#define COMMAND_TRACE_ACK_QUEUE 8
+#define COMMAND_TRACE_SLOTS     (IR_QUEUE_LENGTH + 2)  // 同时未完成的远程指令上限，超出时拒绝
+#define COMMAND_TRACE_TARGET_MS 200
+
+// 一条远程指令和它的收到时刻
+struct RemoteCommand {
+  AcCommand command;
+  WireFormat format;        // 应答格式跟随指令
+  uint32_t receivedMs;      // millis()
+  uint64_t receivedUnixMs;  // 时间未同步时为 0
+};
+
+bool commandTraceBegin();
+
+// 在 mqttCallback 中解析出指令后立即调用，记录收到时刻
+void commandTraceReceive(RemoteCommand& out, const AcCommand& command, WireFormat format);
+
+// 提交红外命令（只在 MQTT 任务中调用），log 在应答入队前调用；
+// 红外队列已满或没有空闲的时间线槽位时生成 rejected 应答并返回 0
+uint32_t commandTraceSubmit(const RemoteCommand& command, const char* irCommand,
+                            IrCompletionCallback log = nullptr);
+
+// 取出一条待发布的应答并计入延迟统计（只在 MQTT 任务中调用）
+bool commandTraceNextAck(AcCommandAck& out, WireFormat& format);
+
+// Prometheus 文本格式（各阶段延迟直方图、结果计数），缓冲区不足时返回 0
+size_t commandTraceToPrometheus(char* buf, size_t size);
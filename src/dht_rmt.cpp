@@ -0,0 +1,104 @@
+// ============================================================================
+// DHT22 RMT 解码实现
+// ============================================================================
+#include "dht_rmt.h"
+
+#define DHT_RMT_CLK_DIV        80   // APB 80MHz / 80 = 1us 一个计数
+#define DHT_RMT_IDLE_US        200  // 超过 200us 无跳变视为一帧结束
+#define DHT_RMT_FILTER_TICKS   100  // 滤除 <1.25us 的毛刺（APB 时钟计数）
+#define DHT_BIT_THRESHOLD_US   48   // 高电平 26-28us 为 0，70us 为 1
+#define DHT_FRAME_TIMEOUT_MS   20
+
+DhtRmt::DhtRmt(uint8_t pinNum, rmt_channel_t rmtChannel)
+    : pin(pinNum), channel(rmtChannel), ringbuf(nullptr), receiving(false), receiveStartMs(0) {}
+
+bool DhtRmt::begin() {
+  rmt_config_t config = RMT_DEFAULT_CONFIG_RX((gpio_num_t)pin, channel);
+  config.clk_div = DHT_RMT_CLK_DIV;
+  config.mem_block_num = 1;  // 64 个条目，足够一帧 43 个高低电平对
+  config.rx_config.filter_en = true;
+  config.rx_config.filter_ticks_thresh = DHT_RMT_FILTER_TICKS;
+  config.rx_config.idle_threshold = DHT_RMT_IDLE_US;
+
+  if (rmt_config(&config) != ESP_OK ||
+      rmt_driver_install(channel, 512, 0) != ESP_OK ||
+      rmt_get_ringbuf_handle(channel, &ringbuf) != ESP_OK) {
+    return false;
+  }
+
+  // rmt_config 会把引脚设为输入；改为开漏输入输出，起始信号直接在同一引脚上拉低
+  gpio_set_direction((gpio_num_t)pin, GPIO_MODE_INPUT_OUTPUT_OD);
+  gpio_set_pull_mode((gpio_num_t)pin, GPIO_PULLUP_ONLY);
+  gpio_set_level((gpio_num_t)pin, 1);
+  return true;
+}
+
+SensorStatus DhtRmt::trigger() {
+  // 起始信号：主机拉低 >1ms，由调度器在 conversionMs() 后调用 collect() 释放总线
+  gpio_set_level((gpio_num_t)pin, 0);
+  receiving = false;
+  return SENSOR_OK;
+}
+
+SensorStatus DhtRmt::collect(SensorReading& out) {
+  if (!receiving) {
+    rmt_rx_start(channel, true);
+    gpio_set_level((gpio_num_t)pin, 1);  // 释放总线，之后的时序全部由 RMT 采集
+    receiving = true;
+    receiveStartMs = millis();
+    return SENSOR_PENDING;
+  }
+
+  size_t length = 0;
+  rmt_item32_t* items = (rmt_item32_t*)xRingbufferReceive(ringbuf, &length, 0);
+  if (items == nullptr) {
+    if (millis() - receiveStartMs < DHT_FRAME_TIMEOUT_MS) {
+      return SENSOR_PENDING;
+    }
+    rmt_rx_stop(channel);
+    receiving = false;
+    return SENSOR_ERR_TIMEOUT;
+  }
+  rmt_rx_stop(channel);
+  receiving = false;
+
+  uint8_t data[5] = {0};
+  SensorStatus status = decode(items, length / sizeof(rmt_item32_t), data);
+  vRingbufferReturnItem(ringbuf, items);
+  if (status != SENSOR_OK) {
+    return status;
+  }
+
+  out.humidity = ((data[0] << 8) | data[1]) * 0.1f;
+  out.temperature = (((data[2] & 0x7F) << 8) | data[3]) * 0.1f;
+  if (data[2] & 0x80) {
+    out.temperature = -out.temperature;
+  }
+  out.pressure = NAN;
+  return SENSOR_OK;
+}
+
+// 帧结构：释放高电平 → 响应 80us 低 + 80us 高 → 40 × (50us 低 + 26/70us 高) → 结束
+// 取最后 40 个高电平脉冲作为数据位，前面的释放/响应脉冲自然被跳过
+SensorStatus DhtRmt::decode(const rmt_item32_t* items, size_t count, uint8_t data[5]) {
+  uint16_t highs[64];
+  uint8_t highCount = 0;
+  for (size_t i = 0; i < count && highCount < 64; i++) {
+    if (items[i].level0 == 1 && items[i].duration0 > 0) highs[highCount++] = items[i].duration0;
+    if (highCount < 64 && items[i].level1 == 1 && items[i].duration1 > 0) highs[highCount++] = items[i].duration1;
+  }
+  if (highCount < 40) {
+    return SENSOR_ERR_FRAME;
+  }
+
+  const uint16_t* bits = highs + (highCount - 40);
+  for (uint8_t i = 0; i < 40; i++) {
+    data[i / 8] <<= 1;
+    if (bits[i] > DHT_BIT_THRESHOLD_US) {
+      data[i / 8] |= 1;
+    }
+  }
+
+  uint8_t sum = data[0] + data[1] + data[2] + data[3];
+  return sum == data[4] ? SENSOR_OK : SENSOR_ERR_CHECKSUM;
+}
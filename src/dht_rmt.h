@@ -0,0 +1,35 @@
+// ============================================================================
+// DHT22 RMT 解码
+// 功能：用 RMT 外设采集 DHT22 的脉冲序列并在软件中解码，
+//       读数期间不关中断、不忙等时序：
+//         trigger()  主机拉低总线（起始信号，至少 1ms）
+//         collect()  第一次调用释放总线并启动 RMT 接收，之后每次只查看 RMT 环形缓冲，
+//                    一帧（约 5ms）收齐前返回 SENSOR_PENDING
+// ============================================================================
+#pragma once
+
+#include <Arduino.h>
+#include <driver/rmt.h>
+#include "sensor_driver.h"
+
+class DhtRmt : public SensorDriver {
+ public:
+  DhtRmt(uint8_t pin, rmt_channel_t channel);
+
+  const char* name() const override { return "dht22"; }
+  bool begin() override;
+  uint32_t minIntervalMs() const override { return 2000; }  // 两次读取至少间隔 2 秒
+  uint32_t conversionMs() const override { return 2; }      // 起始信号低电平时间
+
+  SensorStatus trigger() override;
+  SensorStatus collect(SensorReading& out) override;
+
+ private:
+  SensorStatus decode(const rmt_item32_t* items, size_t count, uint8_t data[5]);
+
+  uint8_t pin;
+  rmt_channel_t channel;
+  RingbufHandle_t ringbuf;
+  bool receiving;        // 已释放总线，正在等待 RMT 数据
+  uint32_t receiveStartMs;
+};
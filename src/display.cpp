@@ -0,0 +1,185 @@
+// ============================================================================
+// 界面绘制实现
+// ============================================================================
+#include "display.h"
+#include "widgets.h"
+#include "sensor_task.h"
+#include "render_stats.h"
+#include "ui_text.h"
+#include "ui_fonts.h"  // 构建时由 scripts/font_subset.py 生成的子集字体，只在本文件中使用
+
+FrameBuffer frameBuffer(240, 240);
+U8G2_FOR_ADAFRUIT_GFX u8g2;
+
+// 界面控件：区域、字体和上次绘制的内容在这里固定，刷新时只重绘内容变化的控件
+#define READING_CHARSET "0123456789.-°C%"
+static DateLineWidget dateLine(10, 10, 220, 35, ui_font_date, ST77XX_BLACK);
+static LabelWidget weekdayLine(10, 45, 220, 35, ui_font_date, ST77XX_BLACK);
+static StatusIconWidget wifiStatus(10, 10, 220, 20, ui_font_banner, UI_TEXT_WIFI_LOST,
+                                   ST77XX_RED, ST77XX_BLACK);
+static ClockWidget clockLine(10, 82, 220, 68, 130, u8g2_font_logisoso38_tn, ST77XX_WHITE, ST77XX_BLACK);
+static LabelWidget tempLabel(15, 165, 105, 25, ui_font_label, ST77XX_BLACK);
+static LabelWidget humiLabel(135, 165, 100, 25, ui_font_label, ST77XX_BLACK);
+static ValueWidget tempValue(15, 190, 105, 35, u8g2_font_helvR18_tf, READING_CHARSET, "°C", 1, ST77XX_BLACK);
+static ValueWidget humiValue(135, 190, 100, 35, u8g2_font_helvR18_tf, READING_CHARSET, "%", 1, ST77XX_BLACK);
+
+static const char* const WEEKDAY_NAMES[7] = UI_WEEKDAY_NAMES;
+
+// ========================== 绘制工具 ==========================
+void getCenterPos(U8G2_FOR_ADAFRUIT_GFX &u8g2_obj, const char* str,
+                 int area_x, int area_y, int area_w, int area_h,
+                 int &out_x, int &out_y) {
+  int str_w = u8g2_obj.getUTF8Width(str);
+  out_x = area_x + (area_w - str_w) / 2;
+  int font_ascent = u8g2_obj.getFontAscent();
+  int font_descent = u8g2_obj.getFontDescent();
+  int font_h = font_ascent - font_descent;
+  out_y = area_y + (area_h - font_h) / 2 + font_ascent;
+}
+
+void bindU8g2() {
+  u8g2.begin(frameBuffer);
+  renderNoteU8g2Begin();
+}
+
+// 绘制圆角矩形
+void drawRoundedRect(int x, int y, int w, int h, int r, uint16_t color) {
+  frameBuffer.drawRoundRect(x, y, w, h, r, color);
+}
+
+// 绘制渐变背景（纯黑背景）
+void drawGradientBackground() {
+  frameBuffer.fillScreen(ST77XX_BLACK);
+}
+
+// ========================== 4. 界面绘制（美化版） ==========================
+void drawBeautifulBorder() {
+  // 外边框（圆角）
+  drawRoundedRect(2, 2, 236, 236, 8, ST77XX_GRAY_LIGHT);
+
+  // 内装饰线
+  frameBuffer.drawRoundRect(6, 6, 228, 228, 6, ST77XX_GRAY_DARK);
+
+  // 分隔线
+  frameBuffer.drawFastHLine(8, 80, 224, ST77XX_GRAY_DARK);
+  frameBuffer.drawFastHLine(8, 160, 224, ST77XX_GRAY_DARK);
+  frameBuffer.drawFastVLine(120, 162, 76, ST77XX_GRAY_DARK);
+}
+
+// 背景、边框和温湿度标题只在这里画一次，之后的刷新不会触及
+void initTempHumiUI() {
+  drawGradientBackground();
+  drawBeautifulBorder();
+  tempLabel.set(UI_TEXT_TEMPERATURE, ST77XX_WHITE);
+  humiLabel.set(UI_TEXT_HUMIDITY, ST77XX_WHITE);
+
+  // 整屏已被背景覆盖，动态控件下次刷新时完整重绘
+  dateLine.invalidate();
+  weekdayLine.invalidate();
+  clockLine.invalidate();
+  tempValue.invalidate();
+  humiValue.invalidate();
+  wifiStatus.invalidate();
+}
+
+// 解码时钟字形并计算每个字符的固定位置（等宽数字，整串在时间区居中）
+void initGlyphCaches() {
+  if (!glyphCacheBegin()) {
+    Serial.println("⚠️ 字形解码画布分配失败，回退为U8g2直接绘制");
+    return;
+  }
+  if (!clockLine.begin()) {
+    Serial.println("⚠️ 时钟字形缓存创建失败，回退为U8g2直接绘制");
+    return;
+  }
+  Serial.printf("🔤 字形缓存已创建 (时钟单元格宽度: %d)\n", clockLine.cellWidth());
+}
+
+// ========================== 5. 时钟更新（消除闪烁版） ==========================
+void updateClock(time_t now) {
+  if (now < 1000000) {  // 时间未同步（epoch太小）
+    return;
+  }
+
+  struct tm *timeinfo = localtime(&now);
+  if (timeinfo == nullptr) {
+    return;
+  }
+
+  uint32_t frameStart = renderFrameBegin();
+  uint32_t pixelsBefore = frameBuffer.drawnPixels();
+  RenderRedraw redraw = RENDER_REDRAW_NONE;
+
+  // 日期和星期显示（分两行显示）；控件内容不变时不绘制，每秒刷新不分配堆内存
+  bool dateDrawn = dateLine.set(timeinfo->tm_year + 1900, timeinfo->tm_mon + 1, timeinfo->tm_mday,
+                                ST77XX_WHITE);
+  dateDrawn |= weekdayLine.set(WEEKDAY_NAMES[timeinfo->tm_wday % 7], ST77XX_WHITE);
+  if (dateDrawn) {
+    redraw = RENDER_REDRAW_FULL;
+    if (wifiStatus.shown()) {
+      wifiStatus.invalidate();  // 日期行盖住了断线提示，重新画在上面
+      wifiStatus.set(true);
+    }
+  }
+
+  // 时间显示：字形精灵按固定单元格贴图，只重绘变化的字符
+  uint8_t first = clockLine.set(timeinfo->tm_hour, timeinfo->tm_min, timeinfo->tm_sec);
+  if (!clockLine.cached() && first == 0) {
+    redraw = RENDER_REDRAW_FULL;
+  } else if (first < 8 && redraw != RENDER_REDRAW_FULL) {
+    redraw = (first < 6) ? RENDER_REDRAW_DIGITS : RENDER_REDRAW_SECONDS;
+  }
+
+  renderFrameEnd(RENDER_FRAME_CLOCK, frameStart, redraw, frameBuffer.drawnPixels() - pixelsBefore);
+}
+
+// ========================== 6. 温湿度更新（美化版） ==========================
+void updateTempHumi() {
+  // 只读取采集任务的最新滤波结果，不访问传感器
+  SensorSample sample;
+  drawTempHumi(sensorLatest(sample) ? &sample : nullptr);
+}
+
+void drawTempHumi(const SensorSample* reading) {
+  uint32_t frameStart = renderFrameBegin();
+  uint32_t pixelsBefore = frameBuffer.drawnPixels();
+
+  if (reading == nullptr) {
+    Serial.println("❌ DHT22无有效读数!");
+    // 提示只占温度读数的位置，标题和分隔线保持不动
+    bool drawn = tempValue.setMessage(UI_TEXT_SENSOR_ERROR, ui_font_label, ST77XX_RED);
+    drawn |= humiValue.setPlaceholder();
+    renderFrameEnd(RENDER_FRAME_TEMP_HUMI, frameStart, drawn ? RENDER_REDRAW_FULL : RENDER_REDRAW_NONE,
+                   frameBuffer.drawnPixels() - pixelsBefore);
+    return;
+  }
+
+  float temperature = reading->temperature;
+  float humidity = reading->humidity;
+
+  // 动态颜色
+  uint16_t tempColor = ST77XX_YELLOW;
+  if (temperature < 20) tempColor = ST77XX_BLUE;
+  else if (temperature > 30) tempColor = ST77XX_RED;
+
+  uint16_t humiColor = ST77XX_GREEN;
+  if (humidity < 30) humiColor = ST77XX_ORANGE;
+  else if (humidity > 80) humiColor = ST77XX_CYAN;
+
+  // 格式化后的读数和颜色都没变时不绘制
+  bool drawn = tempValue.set(temperature, tempColor);
+  drawn |= humiValue.set(humidity, humiColor);
+  renderFrameEnd(RENDER_FRAME_TEMP_HUMI, frameStart, drawn ? RENDER_REDRAW_DIGITS : RENDER_REDRAW_NONE,
+                 frameBuffer.drawnPixels() - pixelsBefore);
+
+  Serial.printf("Temp: %.1f C, Humi: %.1f %%\n", temperature, humidity);
+}
+
+// ========================== WiFi 断线提示 ==========================
+void drawWiFiBanner(bool lost) {
+  // 提示与日期行重叠：隐藏后日期行下一秒重绘
+  if (wifiStatus.set(lost) && !lost) {
+    dateLine.invalidate();
+    weekdayLine.invalidate();
+  }
+}
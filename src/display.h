@@ -0,0 +1,64 @@
+// ============================================================================
+// 界面绘制
+// 功能：日期/星期、时钟、温湿度区域的布局与刷新，全部绘制到 frameBuffer；
+//       中文字体只用构建时生成的子集（见 ui_text.h），只能在本模块中绘制中文；
+//       各区域是 widgets.h 中的控件，只在显示内容变化时重绘；
+//       不直接访问时间、网络和屏幕硬件，主机构建（env:native）可以单独运行
+// ============================================================================
+#pragma once
+
+#include <Arduino.h>
+#include <time.h>
+#include <U8g2_for_Adafruit_GFX.h>
+#include "framebuffer.h"
+#include "sensor_filter.h"
+
+// 颜色定义（部分由库提供）
+#define ST77XX_BLACK     0x0000
+#define ST77XX_WHITE     0xFFFF
+#define ST77XX_RED       0xF800
+#define ST77XX_GREEN     0x07E0
+#define ST77XX_BLUE      0x001F
+#define ST77XX_YELLOW    0xFFE0
+#ifndef ST77XX_ORANGE
+#define ST77XX_ORANGE    0xFC00  // 与 Adafruit_ST77xx.h 一致（主机构建不包含屏幕驱动库）
+#endif
+#define ST77XX_CYAN      0x07FF
+#define ST77XX_MAGENTA   0xF81F
+#define ST77XX_GRAY_LIGHT 0x5AEB
+#define ST77XX_GRAY_DARK  0x18E3
+#define ST77XX_BG_DARK    0x0808
+
+// 渐变色（深蓝到深灰背景）
+#define BG_TOP_COLOR     0x0808
+#define BG_BOTTOM_COLOR  0x0C0C
+#define DATE_BG_COLOR    0x0010
+#define TIME_BG_COLOR    0x0015
+
+// 离屏帧缓冲：所有绘制都画到这里，由 PanelDMA（主机构建中为内存屏幕）推送脏区域
+extern FrameBuffer frameBuffer;
+extern U8G2_FOR_ADAFRUIT_GFX u8g2;
+
+// 把 U8g2 绑定到帧缓冲（计入 display_u8g2_begin_total）
+void bindU8g2();
+
+void initGlyphCaches();
+void initTempHumiUI();
+void drawBeautifulBorder();
+void drawGradientBackground();
+void drawRoundedRect(int x, int y, int w, int h, int r, uint16_t color);
+void getCenterPos(U8G2_FOR_ADAFRUIT_GFX &u8g2_obj, const char* str,
+                 int area_x, int area_y, int area_w, int area_h,
+                 int &out_x, int &out_y);
+
+// 按给定时间刷新日期和时钟（只重绘变化的部分）；时间未同步时不绘制
+void updateClock(time_t now);
+
+// 读取 sensorLatest() 刷新温湿度区域
+void updateTempHumi();
+
+// 按给定读数绘制温湿度区域（nullptr 显示传感器错误）；启动时用来画出复位前的读数
+void drawTempHumi(const SensorSample* reading);
+
+// 日期区上方的 WiFi 断线提示；lost=false 时清除
+void drawWiFiBanner(bool lost);
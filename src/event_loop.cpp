@@ -0,0 +1,128 @@
+// ============================================================================
+// 事件驱动主循环实现
+// ============================================================================
+#include "event_loop.h"
+#include <esp_timer.h>
+#include <esp_pm.h>
+#include <sys/time.h>
+
+static EventGroupHandle_t loopEvents = nullptr;
+static esp_timer_handle_t timers[EVENT_LOOP_MAX_TIMERS];
+static uint8_t timerCount = 0;
+static esp_timer_handle_t secondTimer = nullptr;
+static esp_timer_handle_t oneShots[EVENT_LOOP_MAX_ONESHOT];
+static EventBits_t oneShotBits[EVENT_LOOP_MAX_ONESHOT];
+static uint8_t oneShotCount = 0;
+
+static void onTimer(void* arg) {
+  xEventGroupSetBits(loopEvents, (EventBits_t)(uintptr_t)arg);
+}
+
+// 距离下一个整秒的微秒数，加 2ms 余量保证醒来时秒数已经进位
+static uint64_t microsToNextSecond() {
+  struct timeval tv;
+  gettimeofday(&tv, NULL);
+  return 1000000 - tv.tv_usec + 2000;
+}
+
+static void onSecondTimer(void* arg) {
+  xEventGroupSetBits(loopEvents, (EventBits_t)(uintptr_t)arg);
+  // 单次定时器每次重新对齐，NTP 调整系统时间后也不会长期偏移
+  esp_timer_start_once(secondTimer, microsToNextSecond());
+}
+
+bool eventLoopBegin() {
+  loopEvents = xEventGroupCreate();
+  return loopEvents != nullptr;
+}
+
+static esp_timer_handle_t createTimer(esp_timer_cb_t callback, EventBits_t bit, const char* name) {
+  esp_timer_create_args_t args = {};
+  args.callback = callback;
+  args.arg = (void*)(uintptr_t)bit;
+  args.dispatch_method = ESP_TIMER_TASK;
+  args.name = name;
+  args.skip_unhandled_events = true;  // light sleep 期间错过的周期不补发
+  esp_timer_handle_t handle = nullptr;
+  if (esp_timer_create(&args, &handle) != ESP_OK) {
+    return nullptr;
+  }
+  return handle;
+}
+
+bool eventLoopEvery(EventBits_t bit, uint32_t periodMs, const char* name) {
+  if (timerCount >= EVENT_LOOP_MAX_TIMERS) {
+    return false;
+  }
+  esp_timer_handle_t handle = createTimer(onTimer, bit, name);
+  if (handle == nullptr || esp_timer_start_periodic(handle, (uint64_t)periodMs * 1000) != ESP_OK) {
+    Serial.printf("❌ 定时器 %s 创建失败\n", name);
+    return false;
+  }
+  timers[timerCount++] = handle;
+  return true;
+}
+
+bool eventLoopSecondTick(EventBits_t bit) {
+  secondTimer = createTimer(onSecondTimer, bit, "second");
+  if (secondTimer == nullptr) {
+    return false;
+  }
+  return esp_timer_start_once(secondTimer, microsToNextSecond()) == ESP_OK;
+}
+
+bool eventLoopAfter(EventBits_t bit, uint32_t delayMs, const char* name) {
+  esp_timer_handle_t handle = nullptr;
+  for (uint8_t i = 0; i < oneShotCount; i++) {
+    if (oneShotBits[i] == bit) {
+      handle = oneShots[i];
+      esp_timer_stop(handle);  // 未启动时返回 ESP_ERR_INVALID_STATE，可忽略
+      break;
+    }
+  }
+  if (handle == nullptr) {
+    if (oneShotCount >= EVENT_LOOP_MAX_ONESHOT) {
+      return false;
+    }
+    handle = createTimer(onTimer, bit, name);
+    if (handle == nullptr) {
+      Serial.printf("❌ 定时器 %s 创建失败\n", name);
+      return false;
+    }
+    oneShots[oneShotCount] = handle;
+    oneShotBits[oneShotCount] = bit;
+    oneShotCount++;
+  }
+  return esp_timer_start_once(handle, (uint64_t)delayMs * 1000) == ESP_OK;
+}
+
+void eventLoopSignal(EventBits_t bit) {
+  if (loopEvents != nullptr) {
+    xEventGroupSetBits(loopEvents, bit);
+  }
+}
+
+EventBits_t eventLoopWait(EventBits_t bits, uint32_t timeoutMs) {
+  return xEventGroupWaitBits(loopEvents, bits, pdTRUE, pdFALSE, pdMS_TO_TICKS(timeoutMs)) & bits;
+}
+
+void eventLoopEnablePowerSave() {
+  esp_pm_config_esp32_t pm = {};
+  pm.max_freq_mhz = 240;
+  pm.min_freq_mhz = 80;
+  pm.light_sleep_enable = true;
+
+  esp_err_t err = esp_pm_configure(&pm);
+  if (err == ESP_ERR_NOT_SUPPORTED) {
+    // 预编译的 Arduino 核心没有开启 tickless idle，只能使用动态调频
+    pm.light_sleep_enable = false;
+    err = esp_pm_configure(&pm);
+  }
+
+  if (err == ESP_OK) {
+    Serial.printf("🔋 电源管理: %d-%dMHz 动态调频%s\n", pm.min_freq_mhz, pm.max_freq_mhz,
+                  pm.light_sleep_enable ? " + 自动 light sleep" : "");
+  } else {
+    Serial.printf("⚠️ 电源管理不可用: %s\n", esp_err_to_name(err));
+  }
+}
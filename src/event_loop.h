@@ -0,0 +1,34 @@
+// ============================================================================
+// 事件驱动主循环
+// 功能：用 esp_timer 定时器和 FreeRTOS 事件组代替 loop() 中的 millis() 轮询 + delay(10)。
+//       每个定时任务对应一个事件位，定时器到期时置位，loop() 阻塞等待事件，
+//       没有任务到期时 CPU 进入空闲（支持时可自动 light sleep）
+// ============================================================================
+#pragma once
+
+#include <Arduino.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/event_groups.h>
+
+#define EVENT_LOOP_MAX_TIMERS  8
+#define EVENT_LOOP_MAX_ONESHOT 4
+
+bool eventLoopBegin();
+
+// 每隔 periodMs 置位一次 bit
+bool eventLoopEvery(EventBits_t bit, uint32_t periodMs, const char* name);
+
+// 对齐到系统时间的整秒置位 bit（时钟显示用，避免与秒边界相位漂移）
+bool eventLoopSecondTick(EventBits_t bit);
+
+// delayMs 后置位一次 bit；同一个 bit 再次调用会取消之前的定时重新计时
+bool eventLoopAfter(EventBits_t bit, uint32_t delayMs, const char* name);
+
+// 从任务或定时器回调中手动触发事件
+void eventLoopSignal(EventBits_t bit);
+
+// 等待任意事件（返回后对应位已清除），超时返回 0
+EventBits_t eventLoopWait(EventBits_t bits, uint32_t timeoutMs);
+
+// 启用动态调频；固件开启 tickless idle 时同时启用自动 light sleep
+void eventLoopEnablePowerSave();
@@ -0,0 +1,223 @@
+// ============================================================================
+// 离屏帧缓冲区实现
+// ============================================================================
+#include "framebuffer.h"
+
+// 缓冲区按屏幕字节序（大端）存放，刷新时可以整行 memcpy 到 DMA 缓冲
+static inline uint16_t toPanelOrder(uint16_t color) {
+  return (uint16_t)((color >> 8) | (color << 8));
+}
+
+static inline int32_t rectArea(const DirtyRect& r) {
+  return (int32_t)r.w * r.h;
+}
+
+static DirtyRect rectUnion(const DirtyRect& a, const DirtyRect& b) {
+  int16_t x0 = min(a.x, b.x);
+  int16_t y0 = min(a.y, b.y);
+  int16_t x1 = max(a.x + a.w, b.x + b.w);
+  int16_t y1 = max(a.y + a.h, b.y + b.h);
+  return DirtyRect{x0, y0, (int16_t)(x1 - x0), (int16_t)(y1 - y0)};
+}
+
+static bool rectTouches(const DirtyRect& a, const DirtyRect& b) {
+  return a.x <= b.x + b.w && b.x <= a.x + a.w &&
+         a.y <= b.y + b.h && b.y <= a.y + a.h;
+}
+
+// 把 rect 加入列表：与已有矩形相交/相邻则合并，合并后可能又覆盖其他矩形，继续吸收
+static void addRect(DirtyRect* list, uint8_t& count, DirtyRect rect) {
+  bool merged = true;
+  while (merged) {
+    merged = false;
+    for (uint8_t i = 0; i < count; i++) {
+      if (rectTouches(list[i], rect)) {
+        rect = rectUnion(list[i], rect);
+        list[i] = list[--count];
+        merged = true;
+        break;
+      }
+    }
+  }
+
+  if (count < FB_MAX_DIRTY_RECTS) {
+    list[count++] = rect;
+    return;
+  }
+  // 列表已满：并入面积增量最小的矩形
+  uint8_t best = 0;
+  int32_t bestGrowth = INT32_MAX;
+  for (uint8_t i = 0; i < count; i++) {
+    int32_t growth = rectArea(rectUnion(list[i], rect)) - rectArea(list[i]);
+    if (growth < bestGrowth) {
+      bestGrowth = growth;
+      best = i;
+    }
+  }
+  list[best] = rectUnion(list[best], rect);
+}
+
+FrameBuffer::FrameBuffer(int16_t w, int16_t h)
+    : Adafruit_GFX(w, h), buffer(nullptr), fallback(nullptr), dirtyCount(0), pendingCount(0),
+      drawnPixelCount(0) {
+  handoffLock = portMUX_INITIALIZER_UNLOCKED;
+}
+
+bool FrameBuffer::begin(Adafruit_GFX* fallbackTarget) {
+  fallback = fallbackTarget;
+  size_t bytes = (size_t)WIDTH * HEIGHT * sizeof(uint16_t);
+
+  if (psramFound()) {
+    buffer = (uint16_t*)ps_malloc(bytes);
+  }
+  if (buffer == nullptr) {
+    // 没有 PSRAM 时尝试内部 RAM（约115KB，WiFi 启动后可能分配失败）
+    buffer = (uint16_t*)heap_caps_malloc(bytes, MALLOC_CAP_8BIT);
+  }
+  if (buffer == nullptr) {
+    Serial.println("⚠️ 帧缓冲分配失败，回退为直接绘制");
+    return false;
+  }
+
+  memset(buffer, 0, bytes);
+  Serial.printf("🖼️  帧缓冲已分配: %u bytes (%s)\n", (unsigned)bytes,
+                psramFound() ? "PSRAM" : "内部RAM");
+  return true;
+}
+
+// ========================== 脏矩形 ==========================
+void FrameBuffer::markDirty(int16_t x, int16_t y, int16_t w, int16_t h) {
+  if (!clip(x, y, w, h)) {
+    return;
+  }
+
+  drawnPixelCount += (uint32_t)w * h;
+  addRect(dirty, dirtyCount, DirtyRect{x, y, w, h});
+}
+
+uint8_t FrameBuffer::frameEnd() {
+  portENTER_CRITICAL(&handoffLock);
+  // 上一帧的快照还没被取走时与本帧合并
+  for (uint8_t i = 0; i < dirtyCount; i++) {
+    addRect(pending, pendingCount, dirty[i]);
+  }
+  uint8_t count = pendingCount;
+  portEXIT_CRITICAL(&handoffLock);
+  dirtyCount = 0;
+  return count;
+}
+
+uint8_t FrameBuffer::takeDirtyRects(DirtyRect* out, uint8_t maxRects) {
+  portENTER_CRITICAL(&handoffLock);
+  uint8_t count = min(pendingCount, maxRects);
+  memcpy(out, pending, count * sizeof(DirtyRect));
+  pendingCount = 0;
+  portEXIT_CRITICAL(&handoffLock);
+  return count;
+}
+
+bool FrameBuffer::clip(int16_t& x, int16_t& y, int16_t& w, int16_t& h) const {
+  if (w < 0) { x += w + 1; w = -w; }
+  if (h < 0) { y += h + 1; h = -h; }
+  if (x < 0) { w += x; x = 0; }
+  if (y < 0) { h += y; y = 0; }
+  if (x + w > WIDTH) w = WIDTH - x;
+  if (y + h > HEIGHT) h = HEIGHT - y;
+  return w > 0 && h > 0;
+}
+
+// ========================== 绘制 ==========================
+void FrameBuffer::fillClipped(int16_t x, int16_t y, int16_t w, int16_t h, uint16_t color) {
+  uint16_t c = toPanelOrder(color);
+  uint16_t* row = buffer + y * WIDTH + x;
+  for (int16_t j = 0; j < h; j++, row += WIDTH) {
+    for (int16_t i = 0; i < w; i++) {
+      row[i] = c;
+    }
+  }
+  markDirty(x, y, w, h);
+}
+
+void FrameBuffer::drawPixel(int16_t x, int16_t y, uint16_t color) {
+  if (buffer == nullptr) {
+    if (fallback) fallback->drawPixel(x, y, color);
+    return;
+  }
+  if (x < 0 || y < 0 || x >= WIDTH || y >= HEIGHT) {
+    return;
+  }
+  buffer[y * WIDTH + x] = toPanelOrder(color);
+  markDirty(x, y, 1, 1);
+}
+
+void FrameBuffer::writePixel(int16_t x, int16_t y, uint16_t color) {
+  drawPixel(x, y, color);
+}
+
+void FrameBuffer::fillRect(int16_t x, int16_t y, int16_t w, int16_t h, uint16_t color) {
+  if (buffer == nullptr) {
+    if (fallback) fallback->fillRect(x, y, w, h, color);
+    return;
+  }
+  if (clip(x, y, w, h)) {
+    fillClipped(x, y, w, h, color);
+  }
+}
+
+void FrameBuffer::drawFastHLine(int16_t x, int16_t y, int16_t w, uint16_t color) {
+  if (buffer == nullptr) {
+    if (fallback) fallback->drawFastHLine(x, y, w, color);
+    return;
+  }
+  fillRect(x, y, w, 1, color);
+}
+
+void FrameBuffer::drawFastVLine(int16_t x, int16_t y, int16_t h, uint16_t color) {
+  if (buffer == nullptr) {
+    if (fallback) fallback->drawFastVLine(x, y, h, color);
+    return;
+  }
+  fillRect(x, y, 1, h, color);
+}
+
+void FrameBuffer::writeFastHLine(int16_t x, int16_t y, int16_t w, uint16_t color) {
+  drawFastHLine(x, y, w, color);
+}
+
+void FrameBuffer::writeFastVLine(int16_t x, int16_t y, int16_t h, uint16_t color) {
+  drawFastVLine(x, y, h, color);
+}
+
+void FrameBuffer::writeFillRect(int16_t x, int16_t y, int16_t w, int16_t h, uint16_t color) {
+  fillRect(x, y, w, h, color);
+}
+
+void FrameBuffer::fillScreen(uint16_t color) {
+  fillRect(0, 0, WIDTH, HEIGHT, color);
+}
+
+void FrameBuffer::blit(int16_t x, int16_t y, int16_t w, int16_t h, const uint16_t* src) {
+  if (buffer == nullptr) {
+    // 直绘回退：逐行转回主机字节序后交给屏幕
+    if (fallback == nullptr || w > 64) return;
+    uint16_t line[64];
+    for (int16_t j = 0; j < h; j++) {
+      for (int16_t i = 0; i < w; i++) {
+        line[i] = toPanelOrder(src[j * w + i]);
+      }
+      fallback->drawRGBBitmap(x, y + j, line, w, 1);
+    }
+    return;
+  }
+
+  int16_t cx = x, cy = y, cw = w, ch = h;
+  if (!clip(cx, cy, cw, ch)) {
+    return;
+  }
+  const uint16_t* srcRow = src + (cy - y) * w + (cx - x);
+  uint16_t* dstRow = buffer + cy * WIDTH + cx;
+  for (int16_t j = 0; j < ch; j++, srcRow += w, dstRow += WIDTH) {
+    memcpy(dstRow, srcRow, cw * sizeof(uint16_t));
+  }
+  markDirty(cx, cy, cw, ch);
+}
@@ -0,0 +1,67 @@
+// ============================================================================
+// 离屏帧缓冲区
+// 功能：240x240 RGB565 缓冲（优先放在 PSRAM），Adafruit_GFX/U8g2 直接绘制到内存，
+//       并记录脏矩形，由 PanelDMA 只把变化的区域推送到屏幕。
+//       脏矩形在绘制期间只由绘制任务（loop）收集，不加锁；frameEnd() 一次性交出本帧的
+//       矩形快照，刷新任务用 takeDirtyRects() 取走，两者之间只有这一次加锁交接
+// ============================================================================
+#pragma once
+
+#include <Arduino.h>
+#include <Adafruit_GFX.h>
+
+#define FB_MAX_DIRTY_RECTS 8  // 脏矩形列表上限，超出后合并到增量最小的矩形
+
+struct DirtyRect {
+  int16_t x, y, w, h;
+};
+
+class FrameBuffer : public Adafruit_GFX {
+ public:
+  FrameBuffer(int16_t w, int16_t h);
+
+  // 分配像素缓冲；失败时所有绘制直接转发到 fallback（阻塞式直绘）
+  bool begin(Adafruit_GFX* fallback);
+  bool isBuffered() const { return buffer != nullptr; }
+
+  // Adafruit_GFX 绘制接口：写入缓冲区并标记脏区域
+  void drawPixel(int16_t x, int16_t y, uint16_t color) override;
+  void writePixel(int16_t x, int16_t y, uint16_t color) override;
+  void drawFastHLine(int16_t x, int16_t y, int16_t w, uint16_t color) override;
+  void drawFastVLine(int16_t x, int16_t y, int16_t h, uint16_t color) override;
+  void writeFastHLine(int16_t x, int16_t y, int16_t w, uint16_t color) override;
+  void writeFastVLine(int16_t x, int16_t y, int16_t h, uint16_t color) override;
+  void fillRect(int16_t x, int16_t y, int16_t w, int16_t h, uint16_t color) override;
+  void writeFillRect(int16_t x, int16_t y, int16_t w, int16_t h, uint16_t color) override;
+  void fillScreen(uint16_t color) override;
+
+  // 贴图：pixels 为屏幕字节序的 w*h 像素块（如 GlyphCache 的字形精灵）
+  void blit(int16_t x, int16_t y, int16_t w, int16_t h, const uint16_t* pixels);
+
+  // 脏矩形管理（绘制任务标记，刷新任务取走）
+  void markDirty(int16_t x, int16_t y, int16_t w, int16_t h);
+  // 绘制任务：本帧画完，把收集的矩形并入待刷新快照，返回快照中的矩形数
+  uint8_t frameEnd();
+  // 刷新任务：取走待刷新快照
+  uint8_t takeDirtyRects(DirtyRect* out, uint8_t maxRects);
+  bool hasDirty() const { return dirtyCount > 0; }
+
+  // 累计写入的像素数（按标记脏区域的面积计，合并前），供刷新统计取差值
+  uint32_t drawnPixels() const { return drawnPixelCount; }
+
+  // 像素行指针（屏幕字节序，即大端 RGB565），供刷新任务拷贝
+  const uint16_t* pixels(int16_t x, int16_t y) const { return buffer + y * WIDTH + x; }
+
+ private:
+  bool clip(int16_t& x, int16_t& y, int16_t& w, int16_t& h) const;
+  void fillClipped(int16_t x, int16_t y, int16_t w, int16_t h, uint16_t color);
+
+  uint16_t* buffer;
+  Adafruit_GFX* fallback;
+  DirtyRect dirty[FB_MAX_DIRTY_RECTS];    // 当前帧，只由绘制任务访问
+  uint8_t dirtyCount;
+  DirtyRect pending[FB_MAX_DIRTY_RECTS];  // 已交出、等待刷新
+  uint8_t pendingCount;
+  uint32_t drawnPixelCount;
+  portMUX_TYPE handoffLock;
+};
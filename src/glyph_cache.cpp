@@ -0,0 +1,181 @@
+// ============================================================================
+// 字形精灵缓存实现
+// ============================================================================
+#include "glyph_cache.h"
+#include "render_stats.h"
+
+#define GLYPH_SCRATCH_SIZE 64  // 解码用临时画布边长（足够 logisoso38 数字）
+
+// 8KB 超过 PSRAM 分配阈值，有 PSRAM 时 malloc 会把它放到 PSRAM
+static GFXcanvas16* scratchCanvas = nullptr;
+
+bool glyphCacheBegin() {
+  if (scratchCanvas == nullptr) {
+    scratchCanvas = new GFXcanvas16(GLYPH_SCRATCH_SIZE, GLYPH_SCRATCH_SIZE);
+    if (scratchCanvas->getBuffer() == nullptr) {
+      delete scratchCanvas;
+      scratchCanvas = nullptr;
+    }
+  }
+  return scratchCanvas != nullptr;
+}
+
+uint16_t utf8Next(const char*& p) {
+  uint8_t c = (uint8_t)*p;
+  if (c == 0) {
+    return 0;
+  }
+  if (c < 0x80) {
+    p += 1;
+    return c;
+  }
+  if ((c & 0xE0) == 0xC0 && p[1]) {
+    uint16_t cp = ((c & 0x1F) << 6) | (p[1] & 0x3F);
+    p += 2;
+    return cp;
+  }
+  if ((c & 0xF0) == 0xE0 && p[1] && p[2]) {
+    uint16_t cp = ((c & 0x0F) << 12) | ((p[1] & 0x3F) << 6) | (p[2] & 0x3F);
+    p += 3;
+    return cp;
+  }
+  p += 1;  // 非法字节，跳过
+  return '?';
+}
+
+static void appendUtf8(char* out, uint16_t cp) {
+  if (cp < 0x80) {
+    out[0] = (char)cp;
+    out[1] = 0;
+  } else if (cp < 0x800) {
+    out[0] = (char)(0xC0 | (cp >> 6));
+    out[1] = (char)(0x80 | (cp & 0x3F));
+    out[2] = 0;
+  } else {
+    out[0] = (char)(0xE0 | (cp >> 12));
+    out[1] = (char)(0x80 | ((cp >> 6) & 0x3F));
+    out[2] = (char)(0x80 | (cp & 0x3F));
+    out[3] = 0;
+  }
+}
+
+GlyphCache::GlyphCache()
+    : count(0), fontAscent(0), spriteHeight(0), fg(0), bg(0), storage(nullptr), storageSize(0) {}
+
+bool GlyphCache::build(U8G2_FOR_ADAFRUIT_GFX& u8g2, const uint8_t* font, const char* charset,
+                       uint16_t fgColor, uint16_t bgColor, bool monoDigits) {
+  if (!glyphCacheBegin()) {
+    return false;
+  }
+  GFXcanvas16& scratch = *scratchCanvas;
+
+  u8g2.begin(scratch);
+  renderNoteU8g2Begin();
+  u8g2.setFont(font);
+  u8g2.setFontMode(0);
+  u8g2.setForegroundColor(fgColor);
+  u8g2.setBackgroundColor(bgColor);
+  fontAscent = u8g2.getFontAscent();
+  spriteHeight = min<int16_t>(fontAscent - u8g2.getFontDescent() + GLYPH_CACHE_PAD_TOP,
+                              GLYPH_SCRATCH_SIZE);
+  int16_t baseline = fontAscent + GLYPH_CACHE_PAD_TOP;
+
+  // 第一遍：记录每个字符的前进宽度，等宽数字取最大值
+  uint16_t codes[GLYPH_CACHE_MAX_GLYPHS];
+  int16_t advances[GLYPH_CACHE_MAX_GLYPHS];
+  int16_t glyphAdvances[GLYPH_CACHE_MAX_GLYPHS];
+  uint8_t n = 0;
+  int16_t digitCell = 0;
+  for (const char* p = charset; *p && n < GLYPH_CACHE_MAX_GLYPHS;) {
+    uint16_t cp = utf8Next(p);
+    char one[4];
+    appendUtf8(one, cp);
+    scratch.fillScreen(bgColor);
+    codes[n] = cp;
+    advances[n] = min<int16_t>(u8g2.drawUTF8(0, baseline, one), GLYPH_SCRATCH_SIZE);
+    glyphAdvances[n] = advances[n];
+    if (monoDigits && cp >= '0' && cp <= '9') {
+      digitCell = max(digitCell, advances[n]);
+    }
+    n++;
+  }
+  if (monoDigits) {
+    for (uint8_t i = 0; i < n; i++) {
+      if (codes[i] >= '0' && codes[i] <= '9') advances[i] = digitCell;
+    }
+  }
+
+  size_t needed = 0;
+  for (uint8_t i = 0; i < n; i++) {
+    needed += (size_t)advances[i] * spriteHeight;
+  }
+  // 同一字体和字符集只换颜色时大小不变，精灵存储只在第一次构建时分配
+  if (storage == nullptr || storageSize < needed) {
+    free(storage);
+    storage = (uint16_t*)(psramFound() ? ps_malloc(needed * 2) : malloc(needed * 2));
+    storageSize = storage ? needed : 0;
+  }
+  if (storage == nullptr) {
+    count = 0;
+    return false;
+  }
+
+  // 第二遍：字形在单元格内水平居中绘制，再按屏幕字节序拷出
+  uint16_t* out = storage;
+  for (uint8_t i = 0; i < n; i++) {
+    char one[4];
+    appendUtf8(one, codes[i]);
+    scratch.fillScreen(bgColor);
+    int16_t offset = (advances[i] - glyphAdvances[i]) / 2;
+    u8g2.drawUTF8(offset, baseline, one);
+
+    const uint16_t* src = scratch.getBuffer();
+    for (int16_t y = 0; y < spriteHeight; y++) {
+      for (int16_t x = 0; x < advances[i]; x++) {
+        uint16_t c = src[y * GLYPH_SCRATCH_SIZE + x];
+        out[y * advances[i] + x] = (uint16_t)((c >> 8) | (c << 8));
+      }
+    }
+    glyphs[i].codepoint = codes[i];
+    glyphs[i].advance = advances[i];
+    glyphs[i].pixels = out;
+    out += advances[i] * spriteHeight;
+  }
+
+  count = n;
+  fg = fgColor;
+  bg = bgColor;
+  return true;
+}
+
+const GlyphSprite* GlyphCache::find(uint16_t codepoint) const {
+  for (uint8_t i = 0; i < count; i++) {
+    if (glyphs[i].codepoint == codepoint) {
+      return &glyphs[i];
+    }
+  }
+  return nullptr;
+}
+
+int16_t GlyphCache::textWidth(const char* utf8) const {
+  int16_t width = 0;
+  for (const char* p = utf8; *p;) {
+    const GlyphSprite* g = find(utf8Next(p));
+    if (g) width += g->advance;
+  }
+  return width;
+}
+
+int16_t GlyphCache::draw(FrameBuffer& fb, int16_t x, int16_t baseline, const char* utf8) const {
+  int16_t y = top(baseline);
+  int16_t cursor = x;
+  for (const char* p = utf8; *p;) {
+    const GlyphSprite* g = find(utf8Next(p));
+    if (g == nullptr) {
+      continue;
+    }
+    fb.blit(cursor, y, g->advance, spriteHeight, g->pixels);
+    cursor += g->advance;
+  }
+  return cursor - x;
+}
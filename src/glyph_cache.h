@@ -0,0 +1,60 @@
+// ============================================================================
+// 字形精灵缓存
+// 功能：开机时用 U8g2 把时钟/读数用到的少量字符一次性解码为 RGB565 精灵，
+//       之后刷新只需按预先算好的 x 偏移贴图，不再每秒解压字体、测量字符串
+// ============================================================================
+#pragma once
+
+#include <Arduino.h>
+#include <U8g2_for_Adafruit_GFX.h>
+#include "framebuffer.h"
+
+#define GLYPH_CACHE_MAX_GLYPHS 16  // 每个缓存最多的字符数
+#define GLYPH_CACHE_PAD_TOP    2   // 精灵顶部留白，容纳略高于 ascent 的字形
+
+struct GlyphSprite {
+  uint16_t codepoint;
+  int16_t advance;          // 单元格宽度（等宽数字时为所有数字的最大前进宽度）
+  const uint16_t* pixels;   // advance * height 像素，屏幕字节序
+};
+
+class GlyphCache {
+ public:
+  GlyphCache();
+
+  // 解码 charset（UTF-8）中的每个字符；monoDigits=true 时 0-9 使用统一宽度
+  // 注意：解码期间 u8g2 绑定到临时画布，调用后需重新 u8g2.begin() 再绘制
+  bool build(U8G2_FOR_ADAFRUIT_GFX& u8g2, const uint8_t* font, const char* charset,
+             uint16_t fg, uint16_t bg, bool monoDigits);
+
+  bool isReady() const { return count > 0; }
+  bool isBuiltFor(uint16_t fgColor, uint16_t bgColor) const {
+    return count > 0 && fg == fgColor && bg == bgColor;
+  }
+
+  int16_t ascent() const { return fontAscent; }
+  int16_t height() const { return spriteHeight; }
+  int16_t top(int16_t baseline) const { return baseline - fontAscent - GLYPH_CACHE_PAD_TOP; }
+
+  // 字符串宽度（各字符单元格宽度之和），缺失的字符计为 0
+  int16_t textWidth(const char* utf8) const;
+  // 以 baseline 为基线贴图，返回绘制的总宽度
+  int16_t draw(FrameBuffer& fb, int16_t x, int16_t baseline, const char* utf8) const;
+  const GlyphSprite* find(uint16_t codepoint) const;
+
+ private:
+  GlyphSprite glyphs[GLYPH_CACHE_MAX_GLYPHS];
+  uint8_t count;
+  int16_t fontAscent;
+  int16_t spriteHeight;
+  uint16_t fg, bg;
+  uint16_t* storage;
+  size_t storageSize;
+};
+
+// 分配所有缓存共用的解码画布，开机时调用一次（build() 发现尚未分配时也会先调用）；
+// 之后颜色变化重建缓存不再分配内存
+bool glyphCacheBegin();
+
+// 解码一个 UTF-8 字符，返回码点并推进指针（仅支持 BMP，足够界面使用）
+uint16_t utf8Next(const char*& p);
@@ -0,0 +1,309 @@
+// ============================================================================
+// 运行健康监测实现
+// 喂狗和主循环计数在各自任务中更新（portMUX 保护），采集只在 MQTT 任务中进行，
+// 结果经 SeqLock 发布给 /metrics
+// ============================================================================
+#include "health_monitor.h"
+#include <WiFi.h>
+#include <Preferences.h>
+#include <esp_system.h>
+#include <esp_task_wdt.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+#include <stdio.h>
+#include <sys/time.h>
+#include "lockfree.h"
+#include "prom_text.h"
+#include "wifi_link.h"
+
+// 直方图上界（毫秒），最后一档为 +Inf
+static const uint32_t HIST_BOUNDS_MS[HEALTH_HIST_BUCKETS - 1] = {
+  1, 2, 5, 10, 20, 50, 100, 200,
+};
+
+static const char* RESET_NAMES[HEALTH_RESET_KINDS] = {
+  "unknown", "poweron", "ext", "sw", "panic", "int_wdt", "task_wdt", "wdt", "deepsleep", "brownout", "sdio",
+};
+static const char* WDT_TASK_NAMES[HEALTH_WDT_TASKS] = {"loop", "mqtt"};
+
+struct WatchdogSlot {
+  bool fed;
+  uint32_t lastFeedMs;
+  uint32_t maxGapMs;     // 开机以来
+  uint32_t windowGapMs;  // 本周期内
+};
+
+struct LoopStats {
+  uint32_t clockLateness[HEALTH_HIST_BUCKETS];
+  uint32_t loopBusy[HEALTH_HIST_BUCKETS];
+  uint64_t clockLatenessSumMs;
+  uint64_t loopBusySumUs;
+  uint32_t clockLatenessMaxMs;
+};
+
+static Preferences healthPrefs;
+static uint32_t resetCounts[HEALTH_RESET_KINDS];
+static uint8_t resetReason = 0;
+static uint32_t wdtTimeoutMs = 0;
+
+static WatchdogSlot watchdogs[HEALTH_WDT_TASKS];
+static LoopStats loopStats;
+static portMUX_TYPE healthLock = portMUX_INITIALIZER_UNLOCKED;
+
+// 上一次采集的各任务运行时间，用于计算增量（只在 MQTT 任务中使用）
+#if configUSE_TRACE_FACILITY
+static TaskStatus_t taskStatus[HEALTH_MAX_TASKS];
+static TaskHandle_t prevHandles[HEALTH_MAX_TASKS];
+static uint32_t prevRunTime[HEALTH_MAX_TASKS];
+static uint8_t prevCount = 0;
+static uint32_t prevTotalRunTime = 0;
+#endif
+
+static HealthSnapshot collected;  // 只在 MQTT 任务中使用
+static SeqLock<HealthSnapshot> latest;
+
+static uint8_t bucketFor(uint32_t valueMs) {
+  uint8_t i = 0;
+  while (i < HEALTH_HIST_BUCKETS - 1 && valueMs > HIST_BOUNDS_MS[i]) {
+    i++;
+  }
+  return i;
+}
+
+bool healthBegin(uint32_t watchdogTimeoutMs) {
+  wdtTimeoutMs = watchdogTimeoutMs;
+  resetReason = (uint8_t)esp_reset_reason();
+  if (!healthPrefs.begin("health", false)) {
+    return false;
+  }
+  if (healthPrefs.getBytes("resets", resetCounts, sizeof(resetCounts)) != sizeof(resetCounts)) {
+    memset(resetCounts, 0, sizeof(resetCounts));
+  }
+  if (resetReason < HEALTH_RESET_KINDS) {
+    resetCounts[resetReason]++;
+  }
+  healthPrefs.putBytes("resets", resetCounts, sizeof(resetCounts));
+  healthPrefs.end();
+  return true;
+}
+
+// ========================== 看门狗和主循环 ==========================
+
+void healthFeedWatchdog(HealthWatchdogTask task) {
+  esp_task_wdt_reset();
+  uint32_t now = millis();
+  portENTER_CRITICAL(&healthLock);
+  WatchdogSlot& w = watchdogs[task];
+  if (w.fed) {
+    uint32_t gap = now - w.lastFeedMs;
+    if (gap > w.maxGapMs) {
+      w.maxGapMs = gap;
+    }
+    if (gap > w.windowGapMs) {
+      w.windowGapMs = gap;
+    }
+  }
+  w.fed = true;
+  w.lastFeedMs = now;
+  portEXIT_CRITICAL(&healthLock);
+}
+
+uint32_t healthLoopBegin() {
+  return micros();
+}
+
+void healthLoopEnd(uint32_t startUs) {
+  uint32_t busyUs = micros() - startUs;
+  uint32_t busyMs = (busyUs + 999) / 1000;  // 向上取整，1ms 以内计入第一档
+  portENTER_CRITICAL(&healthLock);
+  loopStats.loopBusy[bucketFor(busyMs)]++;
+  loopStats.loopBusySumUs += busyUs;
+  portEXIT_CRITICAL(&healthLock);
+}
+
+void healthNoteClockLateness(uint32_t lateMs) {
+  portENTER_CRITICAL(&healthLock);
+  loopStats.clockLateness[bucketFor(lateMs)]++;
+  loopStats.clockLatenessSumMs += lateMs;
+  if (lateMs > loopStats.clockLatenessMaxMs) {
+    loopStats.clockLatenessMaxMs = lateMs;
+  }
+  portEXIT_CRITICAL(&healthLock);
+}
+
+// 尚未喂狗的时间也计入：卡住的任务在复位之前就能看到余量变小
+static uint32_t marginFor(uint32_t gapMs) {
+  return gapMs >= wdtTimeoutMs ? 0 : wdtTimeoutMs - gapMs;
+}
+
+// ========================== 采集 ==========================
+
+static void collectTasks(HealthSnapshot& s) {
+  s.taskCount = 0;
+#if configUSE_TRACE_FACILITY
+  uint32_t totalRunTime = 0;
+  UBaseType_t n = uxTaskGetSystemState(taskStatus, HEALTH_MAX_TASKS, &totalRunTime);
+  uint32_t totalDelta = totalRunTime - prevTotalRunTime;
+  for (UBaseType_t i = 0; i < n; i++) {
+    const TaskStatus_t& t = taskStatus[i];
+    HealthTaskStats& out = s.tasks[s.taskCount++];
+    strncpy(out.name, t.pcTaskName, sizeof(out.name) - 1);
+    out.name[sizeof(out.name) - 1] = '\0';
+#if configTASKLIST_INCLUDE_COREID
+    out.core = t.xCoreID == tskNO_AFFINITY ? -1 : (int8_t)t.xCoreID;
+#else
+    out.core = -1;
+#endif
+    out.priority = (uint8_t)t.uxCurrentPriority;
+    out.stackFreeMin = (uint32_t)t.usStackHighWaterMark;  // ESP-IDF 中以字节为单位
+    out.cpuPermille = UINT16_MAX;
+#if configGENERATE_RUN_TIME_STATS
+    // 第一次采集和新建的任务没有上一次的运行时间，本周期不计算
+    for (uint8_t j = 0; j < prevCount && prevTotalRunTime != 0 && totalDelta > 0; j++) {
+      if (prevHandles[j] == t.xHandle) {
+        uint64_t delta = (uint32_t)(t.ulRunTimeCounter - prevRunTime[j]);
+        out.cpuPermille = (uint16_t)min<uint64_t>(1000, delta * 1000 / totalDelta);
+        break;
+      }
+    }
+#endif
+  }
+  prevCount = 0;
+  for (UBaseType_t i = 0; i < n; i++) {
+    prevHandles[prevCount] = taskStatus[i].xHandle;
+    prevRunTime[prevCount] = taskStatus[i].ulRunTimeCounter;
+    prevCount++;
+  }
+  prevTotalRunTime = totalRunTime;
+#endif
+}
+
+void healthCollect() {
+  HealthSnapshot& s = collected;
+  s.uptimeSec = millis() / 1000;
+  s.heapFree = ESP.getFreeHeap();
+  s.heapMin = ESP.getMinFreeHeap();
+  s.rssi = WiFi.status() == WL_CONNECTED ? (int8_t)WiFi.RSSI() : 0;
+  s.wifiDisconnects = wifiLinkDisconnects();
+  s.wifiReconnects = wifiLinkReconnects();
+  s.lastReset = resetReason;
+  memcpy(s.resets, resetCounts, sizeof(s.resets));
+
+  uint32_t now = millis();
+  portENTER_CRITICAL(&healthLock);
+  for (uint8_t i = 0; i < HEALTH_WDT_TASKS; i++) {
+    WatchdogSlot& w = watchdogs[i];
+    uint32_t pending = w.fed ? now - w.lastFeedMs : 0;
+    s.wdtMarginMs[i] = marginFor(max(w.maxGapMs, pending));
+    s.wdtWindowMarginMs[i] = marginFor(max(w.windowGapMs, pending));
+    w.windowGapMs = 0;
+  }
+  memcpy(s.clockLateness, loopStats.clockLateness, sizeof(s.clockLateness));
+  memcpy(s.loopBusy, loopStats.loopBusy, sizeof(s.loopBusy));
+  s.clockLatenessSumMs = loopStats.clockLatenessSumMs;
+  s.loopBusySumUs = loopStats.loopBusySumUs;
+  s.clockLatenessMaxMs = loopStats.clockLatenessMaxMs;
+  loopStats.clockLatenessMaxMs = 0;
+  portEXIT_CRITICAL(&healthLock);
+
+  collectTasks(s);
+  latest.write(s);
+
+  for (uint8_t i = 0; i < s.taskCount; i++) {
+    if (s.tasks[i].stackFreeMin < HEALTH_STACK_WARN_BYTES) {
+      Serial.printf("⚠️ 任务 %s 栈剩余 %lu 字节\n", s.tasks[i].name, (unsigned long)s.tasks[i].stackFreeMin);
+    }
+  }
+  for (uint8_t i = 0; i < HEALTH_WDT_TASKS; i++) {
+    if (watchdogs[i].fed && s.wdtWindowMarginMs[i] < HEALTH_WDT_WARN_MS) {
+      Serial.printf("⚠️ %s 看门狗余量只剩 %lums\n", WDT_TASK_NAMES[i], (unsigned long)s.wdtWindowMarginMs[i]);
+    }
+  }
+}
+
+void healthSnapshot(HealthSnapshot& out) {
+  latest.read(out);
+}
+
+// ========================== 导出 ==========================
+
+// {"up":3600,"heap":151204,"heap_min":140032,"rssi":-61,"wifi":[2,2],"reset":"task_wdt",
+//  "resets":{"poweron":3,"task_wdt":1},"wdt":{"loop":[7000,6010],"mqtt":[7900,7890]},
+//  "clock_max":12,"clock":[...],"busy":[...],"tasks":[["loopTask",1,1,125,1840],...]}
+// wifi 为 [断线, 重连]；wdt 为 [本周期, 开机以来] 的最小余量（毫秒）；
+// clock / busy 为累计直方图计数，档位上界 1,2,5,10,20,50,100,200,+Inf 毫秒；
+// tasks 为 [名称, 核心, 优先级, CPU 千分比（-1 为未统计）, 栈剩余字节]
+size_t healthToJson(char* buf, size_t size) {
+  static HealthSnapshot s;  // 只在 MQTT 任务中使用
+  latest.read(s);
+
+  size_t len = 0;
+  appendf(buf, size, len, "{\"up\":%lu,\"heap\":%lu,\"heap_min\":%lu,\"rssi\":%d,\"wifi\":[%lu,%lu],\"reset\":\"%s\",\"resets\":{",
+          (unsigned long)s.uptimeSec, (unsigned long)s.heapFree, (unsigned long)s.heapMin, s.rssi,
+          (unsigned long)s.wifiDisconnects, (unsigned long)s.wifiReconnects,
+          s.lastReset < HEALTH_RESET_KINDS ? RESET_NAMES[s.lastReset] : "unknown");
+  bool first = true;
+  for (uint8_t i = 0; i < HEALTH_RESET_KINDS; i++) {
+    if (s.resets[i] > 0) {
+      appendf(buf, size, len, "%s\"%s\":%lu", first ? "" : ",", RESET_NAMES[i], (unsigned long)s.resets[i]);
+      first = false;
+    }
+  }
+  appendf(buf, size, len, "},\"wdt\":{");
+  for (uint8_t i = 0; i < HEALTH_WDT_TASKS; i++) {
+    appendf(buf, size, len, "%s\"%s\":[%lu,%lu]", i ? "," : "", WDT_TASK_NAMES[i],
+            (unsigned long)s.wdtWindowMarginMs[i], (unsigned long)s.wdtMarginMs[i]);
+  }
+  appendf(buf, size, len, "},\"clock_max\":%lu,\"clock\":[", (unsigned long)s.clockLatenessMaxMs);
+  for (uint8_t i = 0; i < HEALTH_HIST_BUCKETS; i++) {
+    appendf(buf, size, len, i ? ",%lu" : "%lu", (unsigned long)s.clockLateness[i]);
+  }
+  appendf(buf, size, len, "],\"busy\":[");
+  for (uint8_t i = 0; i < HEALTH_HIST_BUCKETS; i++) {
+    appendf(buf, size, len, i ? ",%lu" : "%lu", (unsigned long)s.loopBusy[i]);
+  }
+  appendf(buf, size, len, "],\"tasks\":[");
+  for (uint8_t i = 0; i < s.taskCount; i++) {
+    const HealthTaskStats& t = s.tasks[i];
+    appendf(buf, size, len, "%s[\"%s\",%d,%u,%d,%lu]", i ? "," : "", t.name, t.core, t.priority,
+            t.cpuPermille == UINT16_MAX ? -1 : (int)t.cpuPermille, (unsigned long)t.stackFreeMin);
+  }
+  appendf(buf, size, len, "]}");
+  return len < size ? len : 0;
+}
+
+size_t healthToPrometheus(char* buf, size_t size) {
+  static HealthSnapshot s;  // 由 async_tcp 任务调用，不放在栈上
+  latest.read(s);
+
+  size_t len = 0;
+  promHeader(buf, size, len, "task_cpu_ratio", "gauge", "Share of one core used by each task over the last health interval.");
+  for (uint8_t i = 0; i < s.taskCount; i++) {
+    if (s.tasks[i].cpuPermille != UINT16_MAX) {
+      appendf(buf, size, len, "task_cpu_ratio{task=\"%s\",core=\"%d\"} %.3f\n",
+              s.tasks[i].name, s.tasks[i].core, s.tasks[i].cpuPermille / 1000.0);
+    }
+  }
+  promHeader(buf, size, len, "task_stack_free_min_bytes", "gauge", "Lowest free stack seen for each task.");
+  for (uint8_t i = 0; i < s.taskCount; i++) {
+    appendf(buf, size, len, "task_stack_free_min_bytes{task=\"%s\"} %lu\n",
+            s.tasks[i].name, (unsigned long)s.tasks[i].stackFreeMin);
+  }
+  promHeader(buf, size, len, "watchdog_margin_seconds", "gauge", "Smallest time left before the task watchdog would fire, since boot.");
+  for (uint8_t i = 0; i < HEALTH_WDT_TASKS; i++) {
+    appendf(buf, size, len, "watchdog_margin_seconds{task=\"%s\"} %.3f\n", WDT_TASK_NAMES[i], s.wdtMarginMs[i] / 1000.0);
+  }
+  promHeader(buf, size, len, "loop_clock_lateness_seconds", "histogram", "Delay between the second boundary and the loop handling the clock tick.");
+  promHistogram(buf, size, len, "loop_clock_lateness_seconds", "", s.clockLateness, HEALTH_HIST_BUCKETS,
+                HIST_BOUNDS_MS, 1e-3, s.clockLatenessSumMs / 1000.0);
+  promHeader(buf, size, len, "loop_busy_seconds", "histogram", "Time the loop spends handling events per wakeup.");
+  promHistogram(buf, size, len, "loop_busy_seconds", "", s.loopBusy, HEALTH_HIST_BUCKETS,
+                HIST_BOUNDS_MS, 1e-3, s.loopBusySumUs / 1e6);
+  promHeader(buf, size, len, "reset_reasons_total", "counter", "Resets by esp_reset_reason(), persisted in NVS.");
+  for (uint8_t i = 0; i < HEALTH_RESET_KINDS; i++) {
+    appendf(buf, size, len, "reset_reasons_total{reason=\"%s\"} %lu\n", RESET_NAMES[i], (unsigned long)s.resets[i]);
+  }
+  promHeader(buf, size, len, "wifi_rssi_dbm", "gauge");
+  appendf(buf, size, len, "wifi_rssi_dbm %d\n", s.rssi);
+  return len < size ? len : 0;
+}
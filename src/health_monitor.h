@@ -0,0 +1,77 @@
+// ============================================================================
+// 运行健康监测
+// 功能：在现场出现 ESP_RST_TASK_WDT 之类的复位之前发现 CPU 饥饿和栈耗尽：
+//         任务      每个任务的 CPU 占用（两次采集之间的运行时间增量）和栈剩余最小值
+//         主循环    整秒时钟事件相对秒边界的处理延迟（抖动）、每次唤醒的处理耗时直方图
+//         看门狗    各受监控任务两次喂狗的最大间隔，换算成距超时的余量
+//         网络      RSSI、WiFi 断线/重连次数
+//         复位      按复位原因累计的次数（NVS 持久化，每次启动加一）
+//       MQTT 任务每 HEALTH_INTERVAL_MS 采集一次，以一条紧凑 JSON 发布到 <prefix>/health，
+//       同时供 /metrics 导出
+// ============================================================================
+#pragma once
+
+#include <Arduino.h>
+
+#define HEALTH_INTERVAL_MS     60000  // 采集并发布的周期
+#define HEALTH_MAX_TASKS       32     // 系统任务数超过该值时不统计任务（uxTaskGetSystemState 返回 0）
+#define HEALTH_HIST_BUCKETS    9      // 直方图档数，含 +Inf
+#define HEALTH_RESET_KINDS     11     // esp_reset_reason_t：ESP_RST_UNKNOWN ～ ESP_RST_SDIO
+#define HEALTH_STACK_WARN_BYTES 512   // 栈剩余低于该值时串口告警
+#define HEALTH_WDT_WARN_MS     2000   // 看门狗余量低于该值时串口告警
+
+enum HealthWatchdogTask : uint8_t {
+  HEALTH_WDT_LOOP = 0,
+  HEALTH_WDT_MQTT,
+  HEALTH_WDT_TASKS,
+};
+
+struct HealthTaskStats {
+  char name[16];
+  int8_t core;           // -1 为不绑定核心
+  uint8_t priority;
+  uint16_t cpuPermille;  // 占单个核心的千分比；固件未开启运行时间统计时为 UINT16_MAX
+  uint32_t stackFreeMin; // 栈剩余最小值（字节）
+};
+
+struct HealthSnapshot {
+  uint32_t uptimeSec;
+  uint32_t heapFree;
+  uint32_t heapMin;
+  int8_t rssi;           // 未连接时为 0
+  uint32_t wifiDisconnects;
+  uint32_t wifiReconnects;
+  uint8_t lastReset;     // esp_reset_reason_t
+  uint32_t resets[HEALTH_RESET_KINDS];
+  uint32_t wdtMarginMs[HEALTH_WDT_TASKS];      // 开机以来的最小余量
+  uint32_t wdtWindowMarginMs[HEALTH_WDT_TASKS];  // 本周期内的最小余量
+  uint32_t clockLateness[HEALTH_HIST_BUCKETS];  // 非累计
+  uint32_t loopBusy[HEALTH_HIST_BUCKETS];       // 非累计
+  uint64_t clockLatenessSumMs;                   // 开机以来的总和（Prometheus _sum）
+  uint64_t loopBusySumUs;
+  uint32_t clockLatenessMaxMs;                   // 本周期内的最大值
+  uint8_t taskCount;
+  HealthTaskStats tasks[HEALTH_MAX_TASKS];
+};
+
+// 在 setup() 中看门狗初始化之后调用：记录本次复位原因（写入 NVS）
+bool healthBegin(uint32_t watchdogTimeoutMs);
+
+// 受监控任务喂狗：重置任务看门狗并记录间隔
+void healthFeedWatchdog(HealthWatchdogTask task);
+
+// 主循环每次被唤醒时调用 begin，处理完全部事件后调用 end
+uint32_t healthLoopBegin();
+void healthLoopEnd(uint32_t startUs);
+// 整秒时钟事件的处理时刻相对秒边界的延迟（毫秒）
+void healthNoteClockLateness(uint32_t lateMs);
+
+// 采集一次快照（只在 MQTT 任务中调用），CPU 占用为与上一次采集之间的增量
+void healthCollect();
+void healthSnapshot(HealthSnapshot& out);
+
+// 最新快照的紧凑 JSON，缓冲区不足时返回 0
+size_t healthToJson(char* buf, size_t size);
+
+// Prometheus 文本格式，缓冲区不足时返回 0
+size_t healthToPrometheus(char* buf, size_t size);
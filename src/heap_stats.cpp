@@ -0,0 +1,211 @@
+// ============================================================================
+// 堆分配统计实现
+// 包装函数在任何任务（以及调度器启动前）都可能被调用：只做计数，不能再分配内存
+// ============================================================================
+#include "heap_stats.h"
+#include <esp_heap_caps.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+#include <stdio.h>
+#include <string.h>
+#include "prom_text.h"
+
+extern "C" {
+void* __real_malloc(size_t size);
+void* __real_calloc(size_t count, size_t size);
+void* __real_realloc(void* ptr, size_t size);
+void __real_free(void* ptr);
+}
+
+struct TaskSlot {
+  TaskHandle_t task;
+  HeapTaskStats stats;
+};
+
+// 0 号固定为 "boot"，最后一个固定为 "other"，中间按任务首次分配的顺序占用
+static TaskSlot slots[HEAP_STATS_MAX_TASKS + 2];
+static uint8_t slotCount = 0;
+static uint32_t frees = 0;
+static portMUX_TYPE heapLock = portMUX_INITIALIZER_UNLOCKED;
+
+#define SLOT_BOOT  0
+#define SLOT_OTHER (HEAP_STATS_MAX_TASKS + 1)
+
+static void initSlots() {
+  strcpy(slots[SLOT_BOOT].stats.name, "boot");
+  strcpy(slots[SLOT_OTHER].stats.name, "other");
+  slotCount = 1;
+}
+
+// 调用方已持有 heapLock
+static HeapTaskStats& currentSlot() {
+  if (slotCount == 0) {
+    initSlots();
+  }
+  if (xTaskGetSchedulerState() == taskSCHEDULER_NOT_STARTED) {
+    return slots[SLOT_BOOT].stats;
+  }
+  TaskHandle_t task = xTaskGetCurrentTaskHandle();
+  for (uint8_t i = 1; i < slotCount; i++) {
+    if (slots[i].task == task) {
+      return slots[i].stats;
+    }
+  }
+  if (slotCount > HEAP_STATS_MAX_TASKS) {
+    return slots[SLOT_OTHER].stats;
+  }
+  TaskSlot& slot = slots[slotCount++];
+  slot.task = task;
+  strncpy(slot.stats.name, pcTaskGetName(NULL), sizeof(slot.stats.name) - 1);
+  return slot.stats;
+}
+
+static void noteAlloc(size_t size, bool ok) {
+  portENTER_CRITICAL_SAFE(&heapLock);
+  HeapTaskStats& s = currentSlot();
+  s.allocs++;
+  s.bytes += size;
+  if (!ok) {
+    s.failures++;
+  }
+  portEXIT_CRITICAL_SAFE(&heapLock);
+}
+
+extern "C" void* __wrap_malloc(size_t size) {
+  void* p = __real_malloc(size);
+  noteAlloc(size, p != NULL || size == 0);
+  return p;
+}
+
+extern "C" void* __wrap_calloc(size_t count, size_t size) {
+  void* p = __real_calloc(count, size);
+  noteAlloc(count * size, p != NULL || count * size == 0);
+  return p;
+}
+
+extern "C" void* __wrap_realloc(void* ptr, size_t size) {
+  void* p = __real_realloc(ptr, size);
+  // realloc(p, 0) 等同于 free，不计入分配
+  if (size > 0) {
+    noteAlloc(size, p != NULL);
+  }
+  return p;
+}
+
+extern "C" void __wrap_free(void* ptr) {
+  if (ptr != NULL) {
+    portENTER_CRITICAL_SAFE(&heapLock);
+    frees++;
+    portEXIT_CRITICAL_SAFE(&heapLock);
+  }
+  __real_free(ptr);
+}
+
+// ========================== 查询 ==========================
+
+uint8_t heapStatsTasks(HeapTaskStats* out, uint8_t maxTasks) {
+  uint8_t n = 0;
+  portENTER_CRITICAL(&heapLock);
+  if (slotCount == 0) {
+    initSlots();
+  }
+  for (uint8_t i = 0; i < slotCount && n < maxTasks; i++) {
+    out[n++] = slots[i].stats;
+  }
+  if (slots[SLOT_OTHER].stats.allocs > 0 && n < maxTasks) {
+    out[n++] = slots[SLOT_OTHER].stats;
+  }
+  portEXIT_CRITICAL(&heapLock);
+  return n;
+}
+
+uint32_t heapStatsFrees() {
+  portENTER_CRITICAL(&heapLock);
+  uint32_t n = frees;
+  portEXIT_CRITICAL(&heapLock);
+  return n;
+}
+
+HeapRegionStats heapStatsRegion(bool psram) {
+  uint32_t caps = psram ? MALLOC_CAP_SPIRAM : MALLOC_CAP_INTERNAL;
+  HeapRegionStats r;
+  r.freeBytes = heap_caps_get_free_size(caps);
+  r.largestFreeBlock = heap_caps_get_largest_free_block(caps);
+  r.minimumFreeBytes = heap_caps_get_minimum_free_size(caps);
+  r.fragmentation = r.freeBytes > 0 ? 1.0f - (float)r.largestFreeBlock / r.freeBytes : 0.0f;
+  return r;
+}
+
+void heapStatsLog() {
+  HeapRegionStats internal = heapStatsRegion(false);
+  Serial.printf("🧮 内部RAM: 空闲 %lu, 最大块 %lu, 最低 %lu, 碎片率 %.1f%%\n",
+                (unsigned long)internal.freeBytes, (unsigned long)internal.largestFreeBlock,
+                (unsigned long)internal.minimumFreeBytes, internal.fragmentation * 100.0f);
+  if (heap_caps_get_free_size(MALLOC_CAP_SPIRAM) > 0) {
+    HeapRegionStats psram = heapStatsRegion(true);
+    Serial.printf("🧮 PSRAM: 空闲 %lu, 最大块 %lu, 碎片率 %.1f%%\n",
+                  (unsigned long)psram.freeBytes, (unsigned long)psram.largestFreeBlock,
+                  psram.fragmentation * 100.0f);
+  }
+
+  HeapTaskStats tasks[HEAP_STATS_MAX_TASKS + 2];
+  uint8_t n = heapStatsTasks(tasks, HEAP_STATS_MAX_TASKS + 2);
+  for (uint8_t i = 0; i < n; i++) {
+    Serial.printf("🧮   %-15s 分配 %lu 次, %llu 字节\n", tasks[i].name,
+                  (unsigned long)tasks[i].allocs, (unsigned long long)tasks[i].bytes);
+  }
+}
+
+// ========================== Prometheus 导出 ==========================
+
+size_t heapStatsToPrometheus(char* buf, size_t size) {
+  HeapTaskStats tasks[HEAP_STATS_MAX_TASKS + 2];
+  uint8_t n = heapStatsTasks(tasks, HEAP_STATS_MAX_TASKS + 2);
+  uint32_t freeCount = heapStatsFrees();
+  HeapRegionStats regions[2] = {heapStatsRegion(false), heapStatsRegion(true)};
+  static const char* REGION_NAMES[2] = {"internal", "psram"};
+  uint8_t regionCount = heap_caps_get_free_size(MALLOC_CAP_SPIRAM) > 0 ? 2 : 1;
+
+  size_t len = 0;
+
+  promHeader(buf, size, len, "heap_allocations_total", "counter", "malloc/calloc/realloc calls by calling task.");
+  for (uint8_t i = 0; i < n; i++) {
+    appendf(buf, size, len, "heap_allocations_total{task=\"%s\"} %lu\n",
+            tasks[i].name, (unsigned long)tasks[i].allocs);
+  }
+  promHeader(buf, size, len, "heap_allocated_bytes_total", "counter", "Bytes requested by calling task.");
+  for (uint8_t i = 0; i < n; i++) {
+    appendf(buf, size, len, "heap_allocated_bytes_total{task=\"%s\"} %llu\n",
+            tasks[i].name, (unsigned long long)tasks[i].bytes);
+  }
+  promHeader(buf, size, len, "heap_allocation_failures_total", "counter");
+  for (uint8_t i = 0; i < n; i++) {
+    appendf(buf, size, len, "heap_allocation_failures_total{task=\"%s\"} %lu\n",
+            tasks[i].name, (unsigned long)tasks[i].failures);
+  }
+  promHeader(buf, size, len, "heap_frees_total", "counter");
+  appendf(buf, size, len, "heap_frees_total %lu\n", (unsigned long)freeCount);
+
+  promHeader(buf, size, len, "heap_free_bytes", "gauge", "Free heap bytes.");
+  for (uint8_t i = 0; i < regionCount; i++) {
+    appendf(buf, size, len, "heap_free_bytes{region=\"%s\"} %lu\n",
+            REGION_NAMES[i], (unsigned long)regions[i].freeBytes);
+  }
+  promHeader(buf, size, len, "heap_largest_free_block_bytes", "gauge", "Largest contiguous free block.");
+  for (uint8_t i = 0; i < regionCount; i++) {
+    appendf(buf, size, len, "heap_largest_free_block_bytes{region=\"%s\"} %lu\n",
+            REGION_NAMES[i], (unsigned long)regions[i].largestFreeBlock);
+  }
+  promHeader(buf, size, len, "heap_minimum_free_bytes", "gauge", "Lowest free heap since boot.");
+  for (uint8_t i = 0; i < regionCount; i++) {
+    appendf(buf, size, len, "heap_minimum_free_bytes{region=\"%s\"} %lu\n",
+            REGION_NAMES[i], (unsigned long)regions[i].minimumFreeBytes);
+  }
+  promHeader(buf, size, len, "heap_fragmentation_ratio", "gauge", "1 - largest free block / free bytes.");
+  for (uint8_t i = 0; i < regionCount; i++) {
+    appendf(buf, size, len, "heap_fragmentation_ratio{region=\"%s\"} %.4f\n",
+            REGION_NAMES[i], regions[i].fragmentation);
+  }
+
+  return len < size ? len : 0;
+}
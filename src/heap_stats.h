@@ -0,0 +1,38 @@
+// ============================================================================
+// 堆分配统计
+// 功能：链接时包装 malloc/calloc/realloc/free（platformio.ini 中的 -Wl,--wrap），
+//       按调用任务统计分配次数和字节数，并采样内部 RAM / PSRAM 的空闲量、
+//       最大连续空闲块和碎片率，用于确认长时间运行时分配速率保持平稳
+// ============================================================================
+#pragma once
+
+#include <Arduino.h>
+
+#define HEAP_STATS_MAX_TASKS 16   // 超出后计入 "other"
+
+struct HeapTaskStats {
+  char name[16];      // 任务名（启动调度器之前的分配计入 "boot"）
+  uint32_t allocs;    // malloc/calloc/realloc 次数
+  uint64_t bytes;     // 申请的字节数
+  uint32_t failures;  // 返回 NULL 的次数
+};
+
+struct HeapRegionStats {
+  uint32_t freeBytes;
+  uint32_t largestFreeBlock;
+  uint32_t minimumFreeBytes;   // 开机以来的最低空闲量
+  float fragmentation;         // 1 - 最大空闲块 / 空闲总量
+};
+
+// 复制按任务的分配计数，返回条目数
+uint8_t heapStatsTasks(HeapTaskStats* out, uint8_t maxTasks);
+uint32_t heapStatsFrees();
+
+// 采样当前堆状态；psram 为 true 时采样 PSRAM，否则为内部 RAM
+HeapRegionStats heapStatsRegion(bool psram);
+
+// 串口打印一行摘要（主循环每小时状态日志使用）
+void heapStatsLog();
+
+// Prometheus 文本格式，缓冲区不足时返回 0
+size_t heapStatsToPrometheus(char* buf, size_t size);
@@ -0,0 +1,344 @@
+// ============================================================================
+// 设备端温湿度历史实现
+// 写入（主循环）和导出（async_tcp 任务）共用一个自旋锁；导出时只在锁内定位下一条记录
+// 并拷出它的编码字节，解码和重新编码都在锁外进行，临界区只有一次小拷贝
+// ============================================================================
+#include "history_store.h"
+#include <math.h>
+#include <string.h>
+
+// 各级容量按典型记录大小留出余量：原始约 3 字节/条，聚合约 7～8 字节/条
+#define RAW_BLOCK_SIZE     512
+#define RAW_BLOCKS         160   // 约 27000 条，24 小时需 17280 条
+#define AGG_BLOCK_SIZE     1024
+#define MINUTE_BLOCKS      384   // 约 56000 条，30 天需 43200 条
+#define HOUR_BLOCKS        96    // 约 12000 条，1 年需 8760 条
+
+static const uint8_t EXPORT_MAGIC[4] = {'S', 'T', 'H', '1'};
+
+// ========================== 编码 ==========================
+
+static uint8_t putVarint(uint8_t* out, uint32_t value) {
+  uint8_t n = 0;
+  while (value >= 0x80) {
+    out[n++] = (uint8_t)(value | 0x80);
+    value >>= 7;
+  }
+  out[n++] = (uint8_t)value;
+  return n;
+}
+
+static uint8_t getVarint(const uint8_t* in, uint32_t& value) {
+  value = 0;
+  uint8_t n = 0;
+  uint8_t shift = 0;
+  uint8_t b;
+  do {
+    b = in[n++];
+    value |= (uint32_t)(b & 0x7F) << shift;
+    shift += 7;
+  } while ((b & 0x80) && n < 5);
+  return n;
+}
+
+static uint32_t zigzag(int32_t v) { return ((uint32_t)v << 1) ^ (uint32_t)(v >> 31); }
+static int32_t unzigzag(uint32_t v) { return (int32_t)(v >> 1) ^ -(int32_t)(v & 1); }
+
+// 存储和导出使用同一种编码，prev 为全 0 时即绝对值
+static uint8_t encodePoint(uint8_t* out, const HistoryPoint& p, const HistoryPoint& prev, bool aggregated) {
+  uint8_t n = putVarint(out, p.t - prev.t);
+  n += putVarint(out + n, zigzag(p.tempAvg - prev.tempAvg));
+  n += putVarint(out + n, zigzag(p.humiAvg - prev.humiAvg));
+  if (aggregated) {
+    n += putVarint(out + n, (uint32_t)(p.tempAvg - p.tempMin));
+    n += putVarint(out + n, (uint32_t)(p.tempMax - p.tempAvg));
+    n += putVarint(out + n, (uint32_t)(p.humiAvg - p.humiMin));
+    n += putVarint(out + n, (uint32_t)(p.humiMax - p.humiAvg));
+  }
+  return n;
+}
+
+static uint8_t decodePoint(const uint8_t* in, HistoryPoint& p, const HistoryPoint& prev, bool aggregated) {
+  uint32_t v;
+  uint8_t n = getVarint(in, v);
+  p.t = prev.t + v;
+  n += getVarint(in + n, v);
+  p.tempAvg = (int16_t)(prev.tempAvg + unzigzag(v));
+  n += getVarint(in + n, v);
+  p.humiAvg = (int16_t)(prev.humiAvg + unzigzag(v));
+  if (aggregated) {
+    n += getVarint(in + n, v);
+    p.tempMin = (int16_t)(p.tempAvg - (int32_t)v);
+    n += getVarint(in + n, v);
+    p.tempMax = (int16_t)(p.tempAvg + (int32_t)v);
+    n += getVarint(in + n, v);
+    p.humiMin = (int16_t)(p.humiAvg - (int32_t)v);
+    n += getVarint(in + n, v);
+    p.humiMax = (int16_t)(p.humiAvg + (int32_t)v);
+  } else {
+    p.tempMin = p.tempMax = p.tempAvg;
+    p.humiMin = p.humiMax = p.humiAvg;
+  }
+  return n;
+}
+
+// ========================== 写入 ==========================
+
+HistoryStore::HistoryStore() : arena(nullptr) {
+  memset(tiers, 0, sizeof(tiers));
+  memset(&minuteAcc, 0, sizeof(minuteAcc));
+  memset(&hourAcc, 0, sizeof(hourAcc));
+  lock = portMUX_INITIALIZER_UNLOCKED;
+}
+
+bool HistoryStore::begin() {
+  static const struct {
+    uint16_t blockSize;
+    uint16_t blocks;
+    uint32_t retention;
+  } LAYOUT[HISTORY_RES_COUNT] = {
+    {RAW_BLOCK_SIZE, RAW_BLOCKS, HISTORY_RAW_RETENTION},
+    {AGG_BLOCK_SIZE, MINUTE_BLOCKS, HISTORY_MINUTE_RETENTION},
+    {AGG_BLOCK_SIZE, HOUR_BLOCKS, HISTORY_HOUR_RETENTION},
+  };
+
+  size_t total = 0;
+  for (uint8_t r = 0; r < HISTORY_RES_COUNT; r++) {
+    total += (size_t)LAYOUT[r].blocks * (LAYOUT[r].blockSize + sizeof(BlockInfo));
+  }
+  if (!psramFound() || (arena = (uint8_t*)ps_malloc(total)) == nullptr) {
+    Serial.println("⚠️ 没有可用的 PSRAM，设备端历史已禁用");
+    return false;
+  }
+
+  uint8_t* p = arena;
+  for (uint8_t r = 0; r < HISTORY_RES_COUNT; r++) {
+    Tier& tier = tiers[r];
+    tier.blockSize = LAYOUT[r].blockSize;
+    tier.blocks = LAYOUT[r].blocks;
+    tier.retention = LAYOUT[r].retention;
+    tier.aggregated = (r != HISTORY_RES_RAW);
+    tier.info = (BlockInfo*)p;
+    p += (size_t)tier.blocks * sizeof(BlockInfo);
+    tier.data = p;
+    p += (size_t)tier.blocks * tier.blockSize;
+  }
+  Serial.printf("🗃️  设备端历史已分配: %u bytes (PSRAM)\n", (unsigned)total);
+  return true;
+}
+
+void HistoryStore::append(uint32_t timestamp, float temperature, float humidity) {
+  if (arena == nullptr || timestamp == 0 || isnan(temperature) || isnan(humidity)) {
+    return;
+  }
+
+  HistoryPoint point;
+  point.t = timestamp;
+  point.tempAvg = point.tempMin = point.tempMax = (int16_t)lroundf(temperature * 10.0f);
+  point.humiAvg = point.humiMin = point.humiMax = (int16_t)lroundf(humidity * 10.0f);
+
+  portENTER_CRITICAL(&lock);
+  Tier& raw = tiers[HISTORY_RES_RAW];
+  // 时间被 NTP 往回校正时丢弃，保证每级时间戳单调，按时间范围查询才正确
+  if (raw.next == 0 || timestamp > raw.last.t) {
+    appendPoint(raw, point);
+
+    uint32_t minuteStart = timestamp - timestamp % 60;
+    if (minuteAcc.start != 0 && minuteAcc.start != minuteStart) {
+      flushAccumulator(minuteAcc, tiers[HISTORY_RES_MINUTE]);
+    }
+    accumulate(minuteAcc, point, minuteStart);
+
+    uint32_t hourStart = timestamp - timestamp % 3600;
+    if (hourAcc.start != 0 && hourAcc.start != hourStart) {
+      flushAccumulator(hourAcc, tiers[HISTORY_RES_HOUR]);
+    }
+    accumulate(hourAcc, point, hourStart);
+  }
+  portEXIT_CRITICAL(&lock);
+}
+
+// 调用方持有锁
+void HistoryStore::appendPoint(Tier& tier, const HistoryPoint& point) {
+  static const HistoryPoint ZERO = {};
+  uint8_t buf[HISTORY_MAX_RECORD];
+  BlockInfo* info = tier.next > 0 ? &tier.info[(tier.next - 1) % tier.blocks] : nullptr;
+  uint8_t len = 0;
+  if (info != nullptr) {
+    len = encodePoint(buf, point, tier.last, tier.aggregated);
+  }
+
+  if (info == nullptr || info->used + len > tier.blockSize) {
+    // 开新块：环形区满时覆盖最旧的块，再淘汰超出保留时间的块
+    if (tier.next - tier.oldest == tier.blocks) {
+      tier.oldest++;
+    }
+    info = &tier.info[tier.next % tier.blocks];
+    memset(info, 0, sizeof(BlockInfo));
+    tier.next++;
+    while (tier.oldest < tier.next - 1 &&
+           tier.info[tier.oldest % tier.blocks].lastT + tier.retention < point.t) {
+      tier.oldest++;
+    }
+    len = encodePoint(buf, point, ZERO, tier.aggregated);
+  }
+
+  uint8_t* block = tier.data + (size_t)((tier.next - 1) % tier.blocks) * tier.blockSize;
+  memcpy(block + info->used, buf, len);
+  info->used += len;
+  if (info->count++ == 0) {
+    info->firstT = point.t;
+  }
+  info->lastT = point.t;
+  tier.last = point;
+}
+
+void HistoryStore::accumulate(Accumulator& acc, const HistoryPoint& point, uint32_t start) {
+  if (acc.start == 0) {
+    acc.start = start;
+    acc.tempSum = acc.humiSum = 0;
+    acc.count = 0;
+    acc.tempMin = acc.tempMax = point.tempAvg;
+    acc.humiMin = acc.humiMax = point.humiAvg;
+  }
+  acc.tempSum += point.tempAvg;
+  acc.humiSum += point.humiAvg;
+  acc.count++;
+  acc.tempMin = min(acc.tempMin, point.tempAvg);
+  acc.tempMax = max(acc.tempMax, point.tempAvg);
+  acc.humiMin = min(acc.humiMin, point.humiAvg);
+  acc.humiMax = max(acc.humiMax, point.humiAvg);
+}
+
+void HistoryStore::flushAccumulator(Accumulator& acc, Tier& tier) {
+  HistoryPoint point;
+  point.t = acc.start;
+  point.tempAvg = (int16_t)lroundf((float)acc.tempSum / acc.count);
+  point.humiAvg = (int16_t)lroundf((float)acc.humiSum / acc.count);
+  point.tempMin = acc.tempMin;
+  point.tempMax = acc.tempMax;
+  point.humiMin = acc.humiMin;
+  point.humiMax = acc.humiMax;
+  appendPoint(tier, point);
+  acc.start = 0;
+}
+
+// ========================== 查询与导出 ==========================
+
+HistoryRes HistoryStore::autoRes(uint32_t from, uint32_t now) const {
+  uint32_t age = now > from ? now - from : 0;
+  if (age <= HISTORY_RAW_RETENTION) {
+    return HISTORY_RES_RAW;
+  }
+  return age <= HISTORY_MINUTE_RETENTION ? HISTORY_RES_MINUTE : HISTORY_RES_HOUR;
+}
+
+void HistoryStore::beginExport(HistoryCursor& cursor, HistoryRes res, uint32_t from, uint32_t to) {
+  memset(&cursor, 0, sizeof(cursor));
+  cursor.res = res;
+  cursor.from = from;
+  cursor.to = to;
+
+  memcpy(cursor.pending, EXPORT_MAGIC, sizeof(EXPORT_MAGIC));
+  cursor.pending[4] = (uint8_t)res;
+  cursor.pendingLen = HISTORY_EXPORT_HEADER;
+
+  // 跳过整块早于 from 的数据
+  portENTER_CRITICAL(&lock);
+  Tier& tier = tiers[res];
+  cursor.block = tier.oldest;
+  while (cursor.block < tier.next && tier.info[cursor.block % tier.blocks].lastT < from) {
+    cursor.block++;
+  }
+  portEXIT_CRITICAL(&lock);
+}
+
+// 在锁内定位下一条记录并拷出编码字节，锁外解码。块内已写入的字节不会再改动，
+// 拷出后即使该块被淘汰，解码的也是一致的数据
+bool HistoryStore::nextStored(Tier& tier, HistoryCursor& cursor, HistoryPoint& out) {
+  static const HistoryPoint ZERO = {};
+  uint8_t record[HISTORY_MAX_RECORD];
+
+  portENTER_CRITICAL(&lock);
+  while (1) {
+    if (cursor.block < tier.oldest) {
+      // 导出期间所在的块已被淘汰：从现存最旧的块继续
+      cursor.block = tier.oldest;
+      cursor.offset = 0;
+    }
+    if (cursor.block >= tier.next) {
+      portEXIT_CRITICAL(&lock);
+      return false;
+    }
+    const BlockInfo& info = tier.info[cursor.block % tier.blocks];
+    if (cursor.offset < info.used) {
+      const uint8_t* block = tier.data + (size_t)(cursor.block % tier.blocks) * tier.blockSize;
+      memcpy(record, block + cursor.offset, min<size_t>(info.used - cursor.offset, sizeof(record)));
+      break;
+    }
+    if (cursor.block + 1 >= tier.next) {
+      portEXIT_CRITICAL(&lock);
+      return false;  // 已读到正在写入的块末尾
+    }
+    cursor.block++;
+    cursor.offset = 0;
+  }
+  portEXIT_CRITICAL(&lock);
+
+  cursor.offset += decodePoint(record, out, cursor.offset == 0 ? ZERO : cursor.stored, tier.aggregated);
+  cursor.stored = out;
+  return true;
+}
+
+size_t HistoryStore::exportChunk(HistoryCursor& cursor, uint8_t* out, size_t maxLen) {
+  size_t n = 0;
+  Tier& tier = tiers[cursor.res];
+
+  while (n < maxLen) {
+    // 上一条没写完（发送窗口不足）时先写剩余部分
+    if (cursor.pendingPos < cursor.pendingLen) {
+      size_t chunk = min((size_t)(cursor.pendingLen - cursor.pendingPos), maxLen - n);
+      memcpy(out + n, cursor.pending + cursor.pendingPos, chunk);
+      cursor.pendingPos += chunk;
+      n += chunk;
+      continue;
+    }
+    if (cursor.done) {
+      break;
+    }
+    HistoryPoint point;
+    if (!nextStored(tier, cursor, point) || point.t > cursor.to) {
+      cursor.done = true;
+      break;
+    }
+    if (point.t < cursor.from) {
+      continue;
+    }
+    cursor.pendingLen = encodePoint(cursor.pending, point, cursor.exported, tier.aggregated);
+    cursor.pendingPos = 0;
+    cursor.exported = point;
+  }
+  return n;
+}
+
+uint32_t HistoryStore::records(HistoryRes res) {
+  uint32_t total = 0;
+  portENTER_CRITICAL(&lock);
+  const Tier& tier = tiers[res];
+  for (uint32_t b = tier.oldest; b < tier.next; b++) {
+    total += tier.info[b % tier.blocks].count;
+  }
+  portEXIT_CRITICAL(&lock);
+  return total;
+}
+
+uint32_t HistoryStore::bytesUsed(HistoryRes res) {
+  uint32_t total = 0;
+  portENTER_CRITICAL(&lock);
+  const Tier& tier = tiers[res];
+  for (uint32_t b = tier.oldest; b < tier.next; b++) {
+    total += tier.info[b % tier.blocks].used;
+  }
+  portEXIT_CRITICAL(&lock);
+  return total;
+}
@@ -0,0 +1,113 @@
+// ============================================================================
+// 设备端温湿度历史
+// 功能：在 PSRAM 中按三级分辨率保存历史读数，云服务器不可用时也能在本地查询趋势：
+//         原始    每 5 秒一条        保留 24 小时
+//         分钟    每分钟 最小/平均/最大  保留 30 天
+//         小时    每小时 最小/平均/最大  保留 1 年
+//       每级是定长块组成的环形区，块内第一条记录存绝对值，其余存与前一条的差值
+//       （zigzag + varint），典型记录 3～8 字节；最旧的块整块淘汰
+//
+// 导出格式（/history，application/octet-stream）：
+//   头部 8 字节："STH1"、分辨率（0=原始 1=分钟 2=小时）、3 字节保留
+//   之后每条记录（第一条的“前一条”视为全 0）：
+//     varint  t - 前一条 t（Unix 秒，区间起点）
+//     svarint 平均温度差值（0.1°C）
+//     svarint 平均湿度差值（0.1%）
+//     分钟/小时级另有 4 个 varint：平均-最低温、最高-平均温、平均-最低湿、最高-平均湿
+//   varint 为 LEB128（低 7 位在前），svarint 为 zigzag 后的 varint
+// ============================================================================
+#pragma once
+
+#include <Arduino.h>
+#include <freertos/FreeRTOS.h>
+
+#define HISTORY_RAW_RETENTION     86400UL           // 24 小时
+#define HISTORY_MINUTE_RETENTION  (30UL * 86400)    // 30 天
+#define HISTORY_HOUR_RETENTION    (365UL * 86400)   // 1 年
+#define HISTORY_MAX_RECORD        24                // 单条记录编码后的最大字节数
+#define HISTORY_EXPORT_HEADER     8
+
+enum HistoryRes : uint8_t {
+  HISTORY_RES_RAW = 0,
+  HISTORY_RES_MINUTE,
+  HISTORY_RES_HOUR,
+  HISTORY_RES_COUNT,
+};
+
+struct HistoryPoint {
+  uint32_t t;                          // 区间起点（Unix 秒）
+  int16_t tempAvg, tempMin, tempMax;   // 0.1°C；原始记录三者相同
+  int16_t humiAvg, humiMin, humiMax;   // 0.1%
+};
+
+// 分段导出的进度，由调用方保存；两次 exportChunk() 之间数据可以继续追加
+struct HistoryCursor {
+  HistoryRes res;
+  uint32_t from, to;
+  uint32_t block;          // 正在读取的块序号
+  uint16_t offset;         // 块内字节偏移
+  HistoryPoint stored;     // 块内解码的前一条
+  HistoryPoint exported;   // 已导出的前一条（导出差值的基准）
+  uint8_t pending[HISTORY_MAX_RECORD];  // 已编码、尚未写出的一条记录（或文件头）
+  uint8_t pendingLen, pendingPos;
+  bool done;
+};
+
+class HistoryStore {
+ public:
+  HistoryStore();
+
+  // 在 PSRAM 中分配全部存储（约 560KB）；没有 PSRAM 时返回 false，append() 不做任何事
+  bool begin();
+  bool ready() const { return arena != nullptr; }
+
+  // 追加一条原始读数（timestamp 为 0 表示时间未同步，忽略），同时更新分钟/小时聚合
+  void append(uint32_t timestamp, float temperature, float humidity);
+
+  // 覆盖 from 的最细分辨率
+  HistoryRes autoRes(uint32_t from, uint32_t now) const;
+
+  void beginExport(HistoryCursor& cursor, HistoryRes res, uint32_t from, uint32_t to);
+  // 写出下一段导出数据，返回字节数；0 表示导出结束
+  size_t exportChunk(HistoryCursor& cursor, uint8_t* out, size_t maxLen);
+
+  uint32_t records(HistoryRes res);
+  uint32_t bytesUsed(HistoryRes res);
+
+ private:
+  struct BlockInfo {
+    uint32_t firstT;
+    uint32_t lastT;
+    uint16_t used;
+    uint16_t count;
+  };
+
+  struct Tier {
+    uint8_t* data;
+    BlockInfo* info;
+    uint16_t blockSize;
+    uint16_t blocks;
+    uint32_t retention;
+    bool aggregated;
+    uint32_t oldest;       // 最旧块序号
+    uint32_t next;         // 下一个新块序号（当前写入块为 next - 1）
+    HistoryPoint last;     // 当前块最后一条（编码差值的基准）
+  };
+
+  struct Accumulator {
+    uint32_t start;        // 区间起点，0 表示空
+    int32_t tempSum, humiSum;
+    uint32_t count;
+    int16_t tempMin, tempMax, humiMin, humiMax;
+  };
+
+  uint8_t* arena;
+  Tier tiers[HISTORY_RES_COUNT];
+  Accumulator minuteAcc, hourAcc;
+  portMUX_TYPE lock;
+
+  void appendPoint(Tier& tier, const HistoryPoint& point);
+  void accumulate(Accumulator& acc, const HistoryPoint& point, uint32_t start);
+  void flushAccumulator(Accumulator& acc, Tier& tier);
+  bool nextStored(Tier& tier, HistoryCursor& cursor, HistoryPoint& out);
+};
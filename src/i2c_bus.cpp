@@ -0,0 +1,64 @@
+// ============================================================================
+// I2C 总线实现
+// ============================================================================
+#include "i2c_bus.h"
+
+I2cBus::I2cBus(i2c_port_t busPort, uint8_t sdaPin, uint8_t sclPin, uint32_t busFrequency)
+    : port(busPort), sda(sdaPin), scl(sclPin), frequency(busFrequency), installed(false), errors(0) {}
+
+bool I2cBus::begin() {
+  if (installed) {
+    return true;
+  }
+  i2c_config_t config = {};
+  config.mode = I2C_MODE_MASTER;
+  config.sda_io_num = sda;
+  config.scl_io_num = scl;
+  config.sda_pullup_en = GPIO_PULLUP_ENABLE;  // 模块板上一般另有 4.7k 上拉
+  config.scl_pullup_en = GPIO_PULLUP_ENABLE;
+  config.master.clk_speed = frequency;
+  if (i2c_param_config(port, &config) != ESP_OK ||
+      i2c_driver_install(port, I2C_MODE_MASTER, 0, 0, 0) != ESP_OK) {
+    return false;
+  }
+  installed = true;
+  return true;
+}
+
+bool I2cBus::check(esp_err_t err) {
+  if (err != ESP_OK) {
+    errors++;
+    return false;
+  }
+  return true;
+}
+
+bool I2cBus::probe(uint8_t address) {
+  i2c_cmd_handle_t cmd = i2c_cmd_link_create();
+  i2c_master_start(cmd);
+  i2c_master_write_byte(cmd, (address << 1) | I2C_MASTER_WRITE, true);
+  i2c_master_stop(cmd);
+  esp_err_t err = i2c_master_cmd_begin(port, cmd, pdMS_TO_TICKS(I2C_BUS_TIMEOUT_MS));
+  i2c_cmd_link_delete(cmd);
+  return err == ESP_OK;  // 探测时没有应答是正常情况，不计入错误
+}
+
+bool I2cBus::write(uint8_t address, const uint8_t* data, size_t length) {
+  return check(i2c_master_write_to_device(port, address, data, length,
+                                          pdMS_TO_TICKS(I2C_BUS_TIMEOUT_MS)));
+}
+
+bool I2cBus::read(uint8_t address, uint8_t* data, size_t length) {
+  return check(i2c_master_read_from_device(port, address, data, length,
+                                           pdMS_TO_TICKS(I2C_BUS_TIMEOUT_MS)));
+}
+
+bool I2cBus::readRegisters(uint8_t address, uint8_t reg, uint8_t* data, size_t length) {
+  return check(i2c_master_write_read_device(port, address, &reg, 1, data, length,
+                                            pdMS_TO_TICKS(I2C_BUS_TIMEOUT_MS)));
+}
+
+bool I2cBus::writeRegister(uint8_t address, uint8_t reg, uint8_t value) {
+  uint8_t data[2] = {reg, value};
+  return write(address, data, sizeof(data));
+}
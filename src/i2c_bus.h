@@ -0,0 +1,40 @@
+// ============================================================================
+// I2C 总线
+// 功能：ESP-IDF I2C 主机驱动的薄封装，供 I2C 传感器驱动共用一条总线。
+//       传输由 I2C 中断驱动，调用任务在传输期间阻塞让出 CPU（几字节的寄存器读写约 0.1～0.5ms）；
+//       传感器的转换时间由调度器等待，不占用总线。只在采集任务中使用，不加锁
+// ============================================================================
+#pragma once
+
+#include <Arduino.h>
+#include <driver/i2c.h>
+
+#define I2C_BUS_TIMEOUT_MS 10  // 单次传输超时（时钟拉伸、从机卡死）
+
+class I2cBus {
+ public:
+  I2cBus(i2c_port_t port, uint8_t sda, uint8_t scl, uint32_t frequency);
+
+  // 安装驱动；重复调用只安装一次
+  bool begin();
+
+  // 地址是否应答（探测传感器）
+  bool probe(uint8_t address);
+  bool write(uint8_t address, const uint8_t* data, size_t length);
+  bool read(uint8_t address, uint8_t* data, size_t length);
+  // 写寄存器地址后重复起始读取
+  bool readRegisters(uint8_t address, uint8_t reg, uint8_t* data, size_t length);
+  bool writeRegister(uint8_t address, uint8_t reg, uint8_t value);
+
+  uint32_t errorCount() const { return errors; }
+
+ private:
+  bool check(esp_err_t err);
+
+  i2c_port_t port;
+  uint8_t sda;
+  uint8_t scl;
+  uint32_t frequency;
+  bool installed;
+  uint32_t errors;
+};
@@ -0,0 +1,140 @@
+// ============================================================================
+// 红外命令调度实现
+// ============================================================================
+#include "ir_dispatcher.h"
+#include "task_config.h"
+
+struct IrRequest {
+  uint32_t id;
+  IrCommandKind kind;
+  char command[IR_COMMAND_MAX_LEN];
+  uint32_t queuedMs;
+  IrCompletionCallback callback;
+  void* ctx;
+};
+
+static HardwareSerial* irSerial = nullptr;
+static QueueHandle_t irQueue = nullptr;
+static TaskHandle_t irTaskHandle = nullptr;
+static uint32_t irNextId = 1;
+static uint32_t irReadyAtMs = 0;
+static portMUX_TYPE irIdLock = portMUX_INITIALIZER_UNLOCKED;
+
+// UART 接收空闲（一条响应收完）时由串口事件任务调用
+static void onIRSerialReceive() {
+  if (irTaskHandle != nullptr) {
+    xTaskNotifyGive(irTaskHandle);
+  }
+}
+
+static void completeRequest(const IrRequest& req, IrResult& result) {
+  result.id = req.id;
+  strncpy(result.command, req.command, IR_COMMAND_MAX_LEN);
+  result.queuedMs = req.queuedMs;
+  if (req.callback) {
+    req.callback(result, req.ctx);
+  }
+}
+
+static void executeRequest(const IrRequest& req) {
+  IrResult result = {};
+
+  // 丢弃上一条命令之后到达的残留字节，保证响应与本条命令对应
+  while (irSerial->available()) {
+    irSerial->read();
+  }
+  ulTaskNotifyTake(pdTRUE, 0);
+
+  irSerial->println(req.command);
+  result.sentMs = millis();
+
+  // 等待 UART 接收事件，而不是固定 delay 后轮询
+  if (ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(IR_ACK_TIMEOUT_MS)) > 0 || irSerial->available()) {
+    result.ackMs = millis();
+    size_t len = 0;
+    while (irSerial->available() && len < IR_RESPONSE_MAX_LEN - 1) {
+      char c = (char)irSerial->read();
+      if (c != '\r' && c != '\n') {
+        result.response[len++] = c;
+      }
+    }
+    result.response[len] = 0;
+    result.acked = true;
+  }
+
+  completeRequest(req, result);
+}
+
+static void irDispatcherTask(void* pvParameters) {
+  IrRequest batch[IR_QUEUE_LENGTH];
+
+  while (1) {
+    if (xQueueReceive(irQueue, &batch[0], portMAX_DELAY) != pdTRUE) {
+      continue;
+    }
+
+    // 模块上电预热期间先等待，期间到达的命令一起参与合并
+    int32_t warmup = (int32_t)(irReadyAtMs - millis());
+    if (warmup > 0) {
+      vTaskDelay(pdMS_TO_TICKS(warmup));
+    }
+
+    // 取出上一条命令执行期间积压的所有请求
+    uint8_t count = 1;
+    while (count < IR_QUEUE_LENGTH && xQueueReceive(irQueue, &batch[count], 0) == pdTRUE) {
+      count++;
+    }
+
+    // 空调开/关最新者胜：只执行最后一条，之前的报告为已覆盖
+    int8_t lastPower = -1;
+    for (uint8_t i = 0; i < count; i++) {
+      if (batch[i].kind == IR_KIND_AC_POWER) lastPower = i;
+    }
+
+    for (uint8_t i = 0; i < count; i++) {
+      if (batch[i].kind == IR_KIND_AC_POWER && i != lastPower) {
+        IrResult result = {};
+        result.superseded = true;
+        completeRequest(batch[i], result);
+      } else {
+        executeRequest(batch[i]);
+      }
+    }
+  }
+}
+
+bool irDispatcherBegin(HardwareSerial& serial, int8_t rxPin, int8_t txPin, uint32_t baud) {
+  irSerial = &serial;
+  irSerial->begin(baud, SERIAL_8N1, rxPin, txPin);
+  irSerial->onReceive(onIRSerialReceive, true);  // 只在接收超时（一帧结束）时回调
+  irReadyAtMs = millis() + IR_MODULE_WARMUP_MS;
+
+  irQueue = xQueueCreate(IR_QUEUE_LENGTH, sizeof(IrRequest));
+  if (irQueue == nullptr) {
+    return false;
+  }
+  return xTaskCreatePinnedToCore(irDispatcherTask, "IRDispatch", 3072, NULL, TASK_PRIO_IR,
+                                 &irTaskHandle, CORE_APP) == pdPASS;
+}
+
+uint32_t irSubmit(const char* command, IrCommandKind kind,
+                  IrCompletionCallback callback, void* ctx) {
+  if (irQueue == nullptr || command == nullptr || strlen(command) >= IR_COMMAND_MAX_LEN) {
+    return 0;
+  }
+
+  IrRequest req = {};
+  portENTER_CRITICAL(&irIdLock);
+  req.id = irNextId++;
+  portEXIT_CRITICAL(&irIdLock);
+  req.kind = kind;
+  strncpy(req.command, command, IR_COMMAND_MAX_LEN - 1);
+  req.queuedMs = millis();
+  req.callback = callback;
+  req.ctx = ctx;
+
+  if (xQueueSend(irQueue, &req, 0) != pdTRUE) {
+    return 0;
+  }
+  return req.id;
+}
@@ -0,0 +1,40 @@
+// ============================================================================
+// 红外命令调度
+// 功能：唯一拥有红外模块串口的调度任务，调用方把命令放入 FreeRTOS 队列后立即返回；
+//       空调开/关命令按"最新者胜"合并，模块响应由 UART 接收事件触发解析，
+//       完成后通过回调报告是否送达及确认延迟
+// ============================================================================
+#pragma once
+
+#include <Arduino.h>
+
+#define IR_QUEUE_LENGTH       8
+#define IR_COMMAND_MAX_LEN    16    // 含结尾 0，命令最多 15 个字符
+#define IR_RESPONSE_MAX_LEN   32
+#define IR_ACK_TIMEOUT_MS     1000  // 等待模块响应的最长时间
+#define IR_MODULE_WARMUP_MS   1000  // 上电后模块就绪时间（原 initIRModule 中的 delay）
+
+enum IrCommandKind : uint8_t {
+  IR_KIND_AC_POWER = 0,  // 空调开/关：队列中只保留最新的一条
+  IR_KIND_RAW,           // 串口调试等原样转发的命令：按顺序全部发送
+};
+
+struct IrResult {
+  uint32_t id;
+  char command[IR_COMMAND_MAX_LEN];
+  bool superseded;   // 被后到的同类命令覆盖，未发送
+  bool acked;        // 超时前收到模块响应
+  uint32_t queuedMs;
+  uint32_t sentMs;
+  uint32_t ackMs;
+  char response[IR_RESPONSE_MAX_LEN];
+};
+
+// 在调度任务中调用，不能阻塞
+typedef void (*IrCompletionCallback)(const IrResult& result, void* ctx);
+
+bool irDispatcherBegin(HardwareSerial& serial, int8_t rxPin, int8_t txPin, uint32_t baud);
+
+// 提交命令，立即返回命令编号；命令超长（不截断）或队列已满时返回 0
+uint32_t irSubmit(const char* command, IrCommandKind kind,
+                  IrCompletionCallback callback = nullptr, void* ctx = nullptr);
@@ -0,0 +1,186 @@
+// ============================================================================
+// 局域网数据接口实现
+// 请求处理在 async_tcp 任务中执行，响应体由推送任务生成：两者之间用 SeqLock 交换快照。
+// SSE 不使用 AsyncEventSource：它的客户端列表没有锁，不能从其他任务调用 send()。
+// 每个 /api/stream 连接是一个分块响应，由 async_tcp 在 ACK/轮询时调用填充函数，
+// 填充函数读取快照，有新读数才写出一条事件，否则返回 RESPONSE_TRY_AGAIN 等下一次轮询
+// ============================================================================
+#include "local_api.h"
+#include <esp_system.h>
+#include <memory>
+#include <time.h>
+#include "lockfree.h"
+#include "sensor_task.h"
+#include "task_config.h"
+
+struct ApiSnapshot {
+  uint32_t seq;                      // 0 表示还没有读数
+  char etag[24];                     // "<启动标识>-<序号>"，重启后不会与旧响应冲突
+  char body[LOCAL_API_BODY_MAX];
+};
+
+static SeqLock<ApiSnapshot> snapshot;
+static TaskHandle_t pushTaskHandle = nullptr;
+static uint32_t bootTag = 0;
+static HistoryStore* historyStore = nullptr;
+static uint8_t streamCount = 0;  // 只在 async_tcp 任务中修改
+
+static const char NO_DATA_BODY[] = "{\"status\":\"error\",\"message\":\"no reading yet\"}";
+
+// 在采集任务中调用：只唤醒推送任务
+static void onSample() {
+  if (pushTaskHandle != nullptr) {
+    xTaskNotifyGive(pushTaskHandle);
+  }
+}
+
+// 生成新快照（推送任务是快照的唯一写者），SSE 连接在下一次轮询时取走
+static void pushTask(void* pvParameters) {
+  static ApiSnapshot next;
+  uint32_t seq = 0;
+
+  while (1) {
+    ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+    SensorSample sample;
+    if (!sensorLatest(sample)) {
+      continue;
+    }
+
+    time_t now = time(nullptr);
+    uint32_t timestamp = now > 1600000000 ? (uint32_t)now : 0;  // 与遥测记录相同：未同步时记为 0
+    next.seq = ++seq;
+    snprintf(next.etag, sizeof(next.etag), "\"%08lx-%lu\"", (unsigned long)bootTag, (unsigned long)seq);
+    snprintf(next.body, sizeof(next.body), "{\"seq\":%lu,\"t\":%lu,\"temperature\":%.1f,\"humidity\":%.1f}",
+             (unsigned long)seq, (unsigned long)timestamp, sample.temperature, sample.humidity);
+    snapshot.write(next);
+  }
+}
+
+// GET /api/data：ETag 与客户端缓存一致时只回 304，不带响应体
+static void handleData(AsyncWebServerRequest* request) {
+  static ApiSnapshot current;  // 只在 async_tcp 任务中使用
+  snapshot.read(current);
+  if (current.seq == 0) {
+    request->send(503, "application/json", NO_DATA_BODY);
+    return;
+  }
+
+  AsyncWebHeader* cached = request->getHeader("If-None-Match");
+  AsyncWebServerResponse* response;
+  if (cached != nullptr && strstr(cached->value().c_str(), current.etag) != nullptr) {
+    response = request->beginResponse(304);
+  } else {
+    response = request->beginResponse(200, "application/json", current.body);
+  }
+  response->addHeader("ETag", current.etag);
+  response->addHeader("Cache-Control", "no-cache");  // 每次都向设备确认，未变化时由 304 省掉响应体
+  request->send(response);
+}
+
+// 一个 SSE 连接的状态，随响应对象一起释放（连接断开时在 async_tcp 任务中）
+struct StreamState {
+  uint32_t sentSeq = 0;
+  bool started = false;
+  ~StreamState() { streamCount--; }
+};
+
+// GET /api/stream：新连接先收到当前读数，之后每个新读数一条事件
+static void handleStream(AsyncWebServerRequest* request) {
+  if (streamCount >= LOCAL_API_MAX_STREAMS) {
+    request->send(503, "application/json", "{\"status\":\"error\",\"message\":\"too many streams\"}");
+    return;
+  }
+  streamCount++;
+  std::shared_ptr<StreamState> state(new StreamState());
+  AsyncWebServerResponse* response = request->beginChunkedResponse("text/event-stream",
+      [state](uint8_t* buffer, size_t maxLen, size_t index) -> size_t {
+        static ApiSnapshot current;  // 只在 async_tcp 任务中使用
+        snapshot.read(current);
+        // 第一段总是有内容（重连间隔 + 当前读数），响应头随它立即发出
+        char event[LOCAL_API_BODY_MAX + 64];
+        int len = 0;
+        if (!state->started) {
+          len = snprintf(event, sizeof(event), "retry: %u\n\n", (unsigned)LOCAL_API_RECONNECT_MS);
+        }
+        if (current.seq != 0 && current.seq != state->sentSeq) {
+          len += snprintf(event + len, sizeof(event) - len, "id: %lu\nevent: reading\ndata: %s\n\n",
+                          (unsigned long)current.seq, current.body);
+        }
+        if (len == 0 || (size_t)len > maxLen) {
+          return RESPONSE_TRY_AGAIN;  // 没有新读数或发送窗口不够，等下一次 ACK/轮询
+        }
+        memcpy(buffer, event, len);
+        state->sentSeq = current.seq;
+        state->started = true;
+        return len;
+      });
+  response->addHeader("Cache-Control", "no-cache");
+  request->send(response);
+}
+
+static uint32_t paramU32(AsyncWebServerRequest* request, const char* name, uint32_t fallback) {
+  if (!request->hasParam(name)) {
+    return fallback;
+  }
+  return strtoul(request->getParam(name)->value().c_str(), nullptr, 10);
+}
+
+// GET /history?from=&to=&res=raw|1m|1h|auto
+// 导出在 async_tcp 任务中逐段进行：每次只编码一个 TCP 发送窗口大小的数据，不在内存中拼出整个响应
+static void handleHistory(AsyncWebServerRequest* request) {
+  if (historyStore == nullptr || !historyStore->ready()) {
+    request->send(503, "application/json", "{\"status\":\"error\",\"message\":\"history unavailable\"}");
+    return;
+  }
+  time_t now = time(nullptr);
+  if (now <= 1600000000) {
+    request->send(503, "application/json", "{\"status\":\"error\",\"message\":\"time not synced\"}");
+    return;
+  }
+
+  uint32_t to = paramU32(request, "to", (uint32_t)now);
+  uint32_t from = paramU32(request, "from", to > LOCAL_API_HISTORY_SPAN ? to - LOCAL_API_HISTORY_SPAN : 0);
+  if (from > to) {
+    request->send(400, "application/json", "{\"status\":\"error\",\"message\":\"from > to\"}");
+    return;
+  }
+
+  HistoryRes res = historyStore->autoRes(from, (uint32_t)now);
+  if (request->hasParam("res")) {
+    const String& name = request->getParam("res")->value();
+    if (name == "raw") {
+      res = HISTORY_RES_RAW;
+    } else if (name == "1m") {
+      res = HISTORY_RES_MINUTE;
+    } else if (name == "1h") {
+      res = HISTORY_RES_HOUR;
+    } else if (name != "auto") {
+      request->send(400, "application/json", "{\"status\":\"error\",\"message\":\"res must be raw, 1m, 1h or auto\"}");
+      return;
+    }
+  }
+
+  // 游标随回调一起保存在响应对象中，连接断开时随响应释放
+  HistoryCursor cursor;
+  historyStore->beginExport(cursor, res, from, to);
+  AsyncWebServerResponse* response = request->beginChunkedResponse("application/octet-stream",
+      [cursor](uint8_t* buffer, size_t maxLen, size_t index) mutable -> size_t {
+        return historyStore->exportChunk(cursor, buffer, maxLen);
+      });
+  response->addHeader("Cache-Control", "no-store");
+  request->send(response);
+}
+
+bool localApiBegin(AsyncWebServer& server, HistoryStore& history) {
+  historyStore = &history;
+  bootTag = esp_random();
+  server.on("/api/data", HTTP_GET, handleData);
+  server.on("/api/stream", HTTP_GET, handleStream);
+  server.on("/history", HTTP_GET, handleHistory);
+
+  if (xTaskCreatePinnedToCore(pushTask, "LocalApi", 4096, NULL, TASK_PRIO_LOCAL_API,
+                              &pushTaskHandle, CORE_NET) != pdPASS) {
+    return false;
+  }
+  return sensorOnSample(onSample);
+}
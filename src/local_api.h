@@ -0,0 +1,22 @@
+// ============================================================================
+// 局域网数据接口
+// 功能：在异步 HTTP 服务器（ESPAsyncWebServer）上提供：
+//         GET /api/data    最新读数 JSON，带 ETag，If-None-Match 命中时返回 304
+//         GET /api/stream  Server-Sent Events，每个新读数推送一条 "reading" 事件
+//         GET /history?from=&to=&res=  设备端历史（二进制分段传输，格式见 history_store.h）
+//       响应体只在采集任务产生新读数时重新生成一次，请求处理只复制预先生成的缓冲，
+//       局域网面板高频轮询也不经过云服务器、不占用绘制循环
+// ============================================================================
+#pragma once
+
+#include <Arduino.h>
+#include <ESPAsyncWebServer.h>
+#include "history_store.h"
+
+#define LOCAL_API_BODY_MAX     128    // 单条读数 JSON 的最大长度
+#define LOCAL_API_MAX_STREAMS  4      // 同时连接的 SSE 客户端上限
+#define LOCAL_API_RECONNECT_MS 3000   // 提示浏览器断线后的重连间隔
+#define LOCAL_API_HISTORY_SPAN 86400  // /history 省略 from 时默认导出最近 24 小时
+
+// 注册接口并启动推送任务（需在 sensorTaskBegin() 之后调用）
+bool localApiBegin(AsyncWebServer& server, HistoryStore& history);
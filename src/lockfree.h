@@ -0,0 +1,104 @@
+// ============================================================================
+// 无锁任务间数据交换
+// 功能：SpscRing —— 单生产者/单消费者环形队列，用于按顺序传递消息（遥测采样、远程指令）；
+//       SeqLock   —— 单写者/多读者的快照，读者拿到的总是某一次完整写入的内容，
+//                    写者从不等待读者（最新传感器读数、空调状态）
+//       两者都不关中断、不持有互斥量，跨核心交换数据时不会因为对方被抢占而阻塞
+// 注意：T 必须可按字节复制；每个 SpscRing 只能有一个 push 任务和一个 pop 任务，
+//       每个 SeqLock 只能有一个写者任务
+// ============================================================================
+#pragma once
+
+#include <stdint.h>
+#include <atomic>
+#include <type_traits>
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+
+// 读者连续多少次读到写入中的快照后让出 CPU（同核心低优先级写者被抢占时让它先写完）
+#define SEQLOCK_SPIN_LIMIT 64
+
+template <typename T, uint32_t N>
+class SpscRing {
+  static_assert((N & (N - 1)) == 0, "SpscRing capacity must be a power of two");
+  static_assert(std::is_trivially_copyable<T>::value, "SpscRing element must be trivially copyable");
+
+ public:
+  SpscRing() : head(0), tail(0) {}
+
+  // 生产者调用；队列已满时返回 false（不覆盖未取走的数据）
+  bool push(const T& item) {
+    uint32_t t = tail.load(std::memory_order_relaxed);
+    if (t - head.load(std::memory_order_acquire) >= N) {
+      return false;
+    }
+    items[t & (N - 1)] = item;
+    tail.store(t + 1, std::memory_order_release);
+    return true;
+  }
+
+  // 消费者调用；队列为空时返回 false
+  bool pop(T& out) {
+    uint32_t h = head.load(std::memory_order_relaxed);
+    if (h == tail.load(std::memory_order_acquire)) {
+      return false;
+    }
+    out = items[h & (N - 1)];
+    head.store(h + 1, std::memory_order_release);
+    return true;
+  }
+
+  uint32_t size() const {
+    return tail.load(std::memory_order_acquire) - head.load(std::memory_order_acquire);
+  }
+  static constexpr uint32_t capacity() { return N; }
+
+ private:
+  T items[N];
+  std::atomic<uint32_t> head;  // 只由消费者写
+  std::atomic<uint32_t> tail;  // 只由生产者写
+};
+
+template <typename T>
+class SeqLock {
+  static_assert(std::is_trivially_copyable<T>::value, "SeqLock value must be trivially copyable");
+
+ public:
+  SeqLock() : seq(0), value() {}
+  explicit SeqLock(const T& initial) : seq(0), value(initial) {}
+
+  // 写者调用：序号为奇数期间读者会重试
+  void write(const T& next) {
+    uint32_t s = seq.load(std::memory_order_relaxed);
+    seq.store(s + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    value = next;
+    seq.store(s + 2, std::memory_order_release);
+  }
+
+  // 读者调用：复制一份一致的快照
+  void read(T& out) const {
+    uint32_t spins = 0;
+    while (1) {
+      uint32_t before = seq.load(std::memory_order_acquire);
+      if ((before & 1) == 0) {
+        out = value;
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (seq.load(std::memory_order_relaxed) == before) {
+          return;
+        }
+      }
+      if (++spins >= SEQLOCK_SPIN_LIMIT) {
+        vTaskDelay(1);
+        spins = 0;
+      }
+    }
+  }
+
+  // 每次写入加 2，读者可据此判断快照是否有更新
+  uint32_t version() const { return seq.load(std::memory_order_acquire); }
+
+ private:
+  std::atomic<uint32_t> seq;
+  T value;
+};
@@ -8,17 +8,44 @@
 #include <SPI.h>
 #include <WiFi.h>
 #include <time.h>  // ESP32 内置时间函数
+#include <esp_sntp.h>  // NTP 同步完成回调
 #include <Adafruit_GFX.h>
 #include <Adafruit_ST7789.h>
-#include <DHT.h>
 #include <U8g2_for_Adafruit_GFX.h>
 #include "esp_task_wdt.h"  // 看门狗
-#include <HTTPClient.h>
 #include <ArduinoJson.h>
-#include <WebServer.h>  // HTTP服务器，用于接收空调控制指令
+#include <ESPAsyncWebServer.h>  // 异步HTTP服务器：空调控制指令、局域网数据接口
 #include <PubSubClient.h>  // MQTT客户端
+#include <lwip/sockets.h>  // select()：MQTT 连接可读时唤醒
+#include <Preferences.h>  // NVS 存储（定时规则）
 #include <freertos/FreeRTOS.h>
 #include <freertos/task.h>
+#include "display.h"
+#include "render_stats.h"
+#include "heap_stats.h"
+#include "panel_dma.h"
+#include "ac_control.h"
+#include "sensor_task.h"
+#include "dht_rmt.h"
+#include "sht_sensor.h"
+#include "bme280.h"
+#include "ir_dispatcher.h"
+#include "telemetry_queue.h"
+#include "telemetry_uploader.h"
+#include "telemetry_compressor.h"
+#include "mqtt_telemetry.h"
+#include "event_loop.h"
+#include "local_api.h"
+#include "history_store.h"
+#include "wire_codec.h"
+#include "command_trace.h"
+#include "health_monitor.h"
+#include "wifi_link.h"
+#include "boot_state.h"
+#include "lockfree.h"
+#include "task_config.h"
+#include "mqtt_topics.h"
+#include "schedule_trace.h"
 
 // ========================== 1. 基础配置 ==========================
 const char* ssid = "jiajia";
@@ -26,11 +53,25 @@ const char* password = "9812061104";
 
 // 办公室数据上传配置
 const char* serverUrl = "http://175.178.158.54:7789/update";
-const unsigned long uploadInterval = 60000;  // 上传间隔60秒
-
-#define DHTPIN 14
-#define DHTTYPE DHT22
-DHT dht(DHTPIN, DHTTYPE);
+const unsigned long telemetryInterval = 5000;  // 采样入队间隔5秒，由上传任务批量发送
+// 遥测通道：1 = 复用 MQTT 长连接（服务器应答后出队），0 = HTTP 批量 POST 到 serverUrl
+#define TELEMETRY_VIA_MQTT 1
+// 变化上报：温湿度超出死区时立即上报，否则最长 TELEMETRY_HEARTBEAT_MS 上报一次（见 telemetry_compressor.h）；
+// 0 = 每个采样点都上报
+#define TELEMETRY_REPORT_ON_CHANGE 1
+
+#define DHTPIN 14  // DHT22 数据引脚（由采集任务经 RMT 读取）
+
+// I2C 温湿度传感器（可选）：启动时探测，没接的自动跳过
+#define SENSOR_I2C_SDA 21
+#define SENSOR_I2C_SCL 22
+#define SENSOR_SHT_MODEL SHT_4X  // SHT3x 与 SHT4x 默认地址相同（0x44），按实际型号选择
+
+// 温湿度传感器：按注册顺序决定优先级，精度高的 I2C 传感器在前，DHT22 作为后备
+I2cBus sensorBus(I2C_NUM_0, SENSOR_I2C_SDA, SENSOR_I2C_SCL, 400000);
+ShtSensor shtSensor(sensorBus, SENSOR_SHT_MODEL);
+Bme280 bmeSensor(sensorBus);
+DhtRmt dhtSensor(DHTPIN, RMT_CHANNEL_4);
 
 // 红外模块配置（串口型）
 #define IR_SERIAL Serial2  // 使用串口2连接红外模块
@@ -41,40 +82,40 @@ DHT dht(DHTPIN, DHTTYPE);
 #define TFT_CS    5
 #define TFT_RST   15
 #define TFT_DC    2
-Adafruit_ST7789 tft = Adafruit_ST7789(TFT_CS, TFT_DC, TFT_RST);
-U8G2_FOR_ADAFRUIT_GFX u8g2;
+#define TFT_MOSI  23  // VSPI 默认引脚
+#define TFT_SCLK  18
+ST7789Panel tft = ST7789Panel(TFT_CS, TFT_DC, TFT_RST);
+
+// DMA 刷新：界面绘制到 frameBuffer（display.cpp），再由刷新任务推送脏区域
+PanelDMA panelDMA;
+
+// 遥测队列：采样先入队（断网时落盘），后台任务批量上传
+TelemetryQueue telemetryQueue;
+
+// 变化上报：决定哪些采样点进入遥测队列（只在主循环中使用）
+TelemetryCompressor telemetryCompressor;
 
-// HTTP服务器配置
-WebServer webServer(80);
+// 设备端历史（PSRAM）：局域网 /history 接口在云服务器不可用时也能查询趋势
+HistoryStore history;
+
+// HTTP服务器配置：请求在 async_tcp 任务（核心 0）中处理，处理函数不能阻塞
+AsyncWebServer webServer(80);
 
 // MQTT配置
 const char* mqttServer = "175.178.158.54";
 const int mqttPort = 1883;
-const char* mqttTopic = "office/ac/control";
-const char* mqttScheduleTopic = "office/ac/schedule/enabled";  // 定时空调开关状态主题
-const char* mqttStatusTopic = "office/ac/schedule/status";  // 定时空调当前状态主题（ESP32反馈）
+// 设备主题命名空间：全部主题在 <mqttNamespace>/<deviceId>/ 下（见 mqtt_topics.h），deviceId 同时作为客户端ID
+const char* deviceId = "office-esp32";
+const char* mqttNamespace = "office/devices";
+MqttTopics mqttTopics;
+// 1 = 同时订阅单机部署的全局控制和定时主题（office/ac/control、office/ac/schedule/enabled），
+//     定时状态也同时发布到 office/ac/schedule/status；多台设备各自控制时改为 0
+#define MQTT_LEGACY_TOPICS 1
 WiFiClient mqttWifiClient;
 PubSubClient mqttClient(mqttWifiClient);
-
-// 颜色定义（部分由库提供）
-#define ST77XX_BLACK     0x0000
-#define ST77XX_WHITE     0xFFFF
-#define ST77XX_RED       0xF800
-#define ST77XX_GREEN     0x07E0
-#define ST77XX_BLUE      0x001F
-#define ST77XX_YELLOW    0xFFE0
-// ST77XX_ORANGE 已在库中定义
-#define ST77XX_CYAN      0x07FF
-#define ST77XX_MAGENTA   0xF81F
-#define ST77XX_GRAY_LIGHT 0x5AEB
-#define ST77XX_GRAY_DARK  0x18E3
-#define ST77XX_BG_DARK    0x0808
-
-// 渐变色（深蓝到深灰背景）
-#define BG_TOP_COLOR     0x0808
-#define BG_BOTTOM_COLOR  0x0C0C
-#define DATE_BG_COLOR    0x0010
-#define TIME_BG_COLOR    0x0015
+#define MQTT_POLL_MS          100   // 连接空闲时最长等待：应答、定时状态和遥测在这之后处理
+#define MQTT_PACKETS_PER_WAKE 8     // 每次唤醒最多处理的消息数，其余的下一轮再处理
+#define MQTT_RECONNECT_MS     5000  // WiFi 或 MQTT 未连接时的重试间隔
 
 // NTP配置 - 使用 ESP32 内置 configTime
 const char* ntpServer = "pool.ntp.org";
@@ -84,204 +125,247 @@ const int daylightOffset_sec = 0;
 // 看门狗配置
 #define WDT_TIMEOUT 8  // 看门狗超时时间(秒)
 
+// 主循环事件：每个定时任务一个事件位，由 esp_timer 到期置位，loop() 阻塞等待
+#define EV_CLOCK      BIT0  // 整秒时钟刷新
+#define EV_TEMP       BIT1  // 温湿度显示刷新
+#define EV_TELEMETRY  BIT2  // 遥测采样入队
+#define EV_WIFI       BIT3  // WiFi 连接状态变化（WiFiLink 任务通知）
+#define EV_NTP_SYNC   BIT4  // NTP 重新同步
+#define EV_STATUS     BIT5  // 运行状态日志
+#define EV_SERIAL     BIT6  // 串口调试命令到达
+#define EV_SCHEDULE   BIT7  // 定时空调事件到期，或收到新规则
+#define EV_COMMAND    BIT8  // 收到远程空调指令
+#define EV_TIME_SYNC  BIT9  // SNTP 完成一次时间同步
+#define EV_ALL        (EV_CLOCK | EV_TEMP | EV_TELEMETRY | EV_WIFI | EV_NTP_SYNC | EV_STATUS | EV_SERIAL | \
+                       EV_SCHEDULE | EV_COMMAND | EV_TIME_SYNC)
+#define LOOP_IDLE_TIMEOUT 4000  // 没有事件时最长等待，保证看门狗按时喂狗
+
 // 全局变量
 const unsigned long tempRefreshInterval = 5000;
-const unsigned long clockRefreshInterval = 1000;
 const unsigned long ntpSyncInterval = 86400000;  // NTP同步间隔：24小时（一天一次）
-const unsigned long acCheckInterval = 60000;  // 空调检查间隔：60秒（1分钟）
-unsigned long lastTempRefreshTime = 0;
-unsigned long lastClockRefreshTime = 0;
-unsigned long lastNTPSyncTime = 0;
-unsigned long lastUploadTime = 0;
-unsigned long lastACCheckTime = 0;
-unsigned long lastSeconds = 255;  // 用于检测秒数变化
-unsigned long lastWiFiCheckTime = 0;
-const unsigned long wifiCheckInterval = 30000;  // WiFi检查间隔30秒
-unsigned long bootCount = 0;
+const unsigned long statusLogInterval = 3600000;  // 每小时输出一次运行状态
 unsigned long systemUptime = 0;
 
-// 空调控制状态
+// 空调控制状态（只由主循环读写，其他任务读取 acStatus 快照）
 bool acIsOn = false;  // 空调是否开启
-bool lastACCommandSent = false;  // 上次是否发送过空调命令
 bool scheduleEnabled = true;  // 定时空调开关状态（默认启用）
 unsigned long lastScheduleStatusReport = 0;  // 上次上报定时空调状态的时间
 
-// 温度缓存（用于空调控制，避免重复读取DHT22）
-float cachedTemperature = 0;
-bool temperatureCacheValid = false;
+// 定时空调：规则表只由主循环读写，到期时由单次定时器唤醒（规则和执行决策见 ac_control.cpp）
+AcSchedule acSchedule;
+time_t acScheduleLastRun = 0;   // 已处理到的时间点（NVS 持久化，重启后据此补执行错过的事件）
+time_t acScheduleNextDue = 0;
+Preferences schedulePrefs;
+// 1 = 把时钟、读数、指令和定时运行结果记录到 LittleFS，供主机回放检查（GET /trace，见 schedule_trace.h）
+// 默认关闭，排查定时问题时用 esp32dev-trace 环境编译（platformio.ini 中 -DSCHEDULE_TRACE=1）
+#ifndef SCHEDULE_TRACE
+#define SCHEDULE_TRACE 0
+#endif
+
+// MQTT 任务（核心 0）与主循环（核心 1）之间的交接，不使用锁：
+// 远程指令的红外命令由 MQTT 任务直接提交（见 command_trace.h），开关状态和新规则经
+// 单生产者/单消费者队列交给主循环更新；
+// 空调和定时状态只由主循环写入 acStatus，MQTT 任务读取快照发布
+struct AcStatus {
+  bool acOn;
+  bool scheduleEnabled;
+  char message[640];  // 定时状态 JSON（见 AcSchedule::statusJson）
+  uint8_t wire[WIRE_SCHEDULE_STATUS_MAX];  // 同一状态的二进制帧（见 wire_codec.h）
+  uint8_t wireLen;
+};
+SpscRing<AcAction, 4> remoteCommands;
+SpscRing<AcScheduleUpdate, 2> scheduleUpdates;
+SeqLock<AcStatus> acStatus;
+std::atomic<bool> scheduleStatusDirty(false);
+// 定时状态的发布格式：跟随最近一条定时消息的格式（只在 MQTT 任务中使用）
+WireFormat scheduleStatusFormat = WIRE_FORMAT_JSON;
 
 // ========================== 2. 函数前置声明 ==========================
-void drawBeautifulBorder();
-void updateClock();
-void updateTempHumi();
-void initTempHumiUI();
-void getCenterPos(U8G2_FOR_ADAFRUIT_GFX &u8g2_obj, const char* str,
-                 int area_x, int area_y, int area_w, int area_h,
-                 int &out_x, int &out_y);
-void drawRoundedRect(int x, int y, int w, int h, int r, uint16_t color);
-void drawGradientBackground();
-void checkAndReconnectWiFi();
+void showWiFiStatus();
+void printApiEndpoints();
 void feedWatchdog();
-void uploadData(float temperature, float humidity);
+void recordTelemetry(const SensorSample& sample);
 void initIRModule();
-void sendIRCommand(const char* command);
-void handleACOn();
-void handleACOff();
-void handleNotFound();
-void checkACControl(int weekday, int hour, int minute, float temperature);
+uint32_t sendIRCommand(const char* command);
+void logIRResult(const IrResult& result, void* ctx);
+void handleACOn(AsyncWebServerRequest* request);
+void handleACOff(AsyncWebServerRequest* request);
+void handleNotFound(AsyncWebServerRequest* request);
+void handleMetrics(AsyncWebServerRequest* request);
+void applyACAction(AcAction action);
+void updateACState(AcAction action);
+void publishACStatus();
+void loadACSchedule();
+void saveACSchedule(bool rulesChanged);
+void runACSchedule();
 void mqttCallback(char* topic, byte* payload, unsigned int length);
 void mqttTask(void *pvParameters);
+bool publishScheduleStatus();
+void handleSerialCommands();
 
 // ========================== 3. 核心工具函数 ==========================
-// 喂狗函数
+// 喂狗函数（同时记录喂狗间隔，见 health_monitor.h）
 void feedWatchdog() {
-  esp_task_wdt_reset();
-}
-
-// WiFi检查和重连
-void checkAndReconnectWiFi() {
-  if (WiFi.status() != WL_CONNECTED) {
-    Serial.println("⚠️ WiFi断线，正在重连...");
-    
-    // 清除屏幕顶部显示错误信息
-    tft.fillRect(10, 10, 220, 20, ST77XX_BLACK);
-    u8g2.begin(tft);
-    u8g2.setFont(u8g2_font_wqy12_t_gb2312);
-    u8g2.setForegroundColor(ST77XX_RED);
-    u8g2.setBackgroundColor(ST77XX_BLACK);
-    u8g2.drawUTF8(15, 25, "WiFi断线重连中...");
-    
-    WiFi.disconnect();
-    delay(1000);
-    WiFi.begin(ssid, password);
-    
-    int attempts = 0;
-    while (WiFi.status() != WL_CONNECTED && attempts < 20) {
-      delay(500);
-      Serial.print(".");
-      feedWatchdog();  // 重连过程中喂狗
-      attempts++;
-    }
-    
-    if (WiFi.status() == WL_CONNECTED) {
-      Serial.println("\n✅ WiFi重连成功! IP: " + WiFi.localIP().toString());
-      tft.fillRect(10, 10, 220, 20, ST77XX_BLACK);  // 清除错误信息
-      // 不需要重新配置时间，ESP32会自动维护时间
-    } else {
-      Serial.println("\n❌ WiFi重连失败，将在30秒后重试");
-    }
-  }
+  healthFeedWatchdog(HEALTH_WDT_LOOP);
 }
 
-String formatNumber(int num) {
-  return num < 10 ? "0" + String(num) : String(num);
+// 整秒时钟事件的处理时刻相对秒边界的延迟；定时器对齐到系统时间的整秒，
+// 略早于边界到达（毫秒数过半）按 0 计
+uint32_t clockLatenessMs() {
+  struct timeval tv;
+  gettimeofday(&tv, nullptr);
+  uint32_t ms = tv.tv_usec / 1000;
+  return ms >= 500 ? 0 : ms;
 }
 
-void getCenterPos(U8G2_FOR_ADAFRUIT_GFX &u8g2_obj, const char* str,
-                 int area_x, int area_y, int area_w, int area_h,
-                 int &out_x, int &out_y) {
-  int str_w = u8g2_obj.getUTF8Width(str);
-  out_x = area_x + (area_w - str_w) / 2;
-  int font_ascent = u8g2_obj.getFontAscent();
-  int font_descent = u8g2_obj.getFontDescent();
-  int font_h = font_ascent - font_descent;
-  out_y = area_y + (area_h - font_h) / 2 + font_ascent;
-}
-
-// 绘制圆角矩形
-void drawRoundedRect(int x, int y, int w, int h, int r, uint16_t color) {
-  tft.drawRoundRect(x, y, w, h, r, color);
-}
+// WiFi 连接状态变化（主循环中调用）：重连由 WiFiLink 任务在后台完成，这里只更新提示
+void showWiFiStatus() {
+  static bool bannerShown = false;
+  static bool endpointsPrinted = false;
 
-// 绘制渐变背景（纯黑背景）
-void drawGradientBackground() {
-  tft.fillScreen(ST77XX_BLACK);
-}
-
-// ========================== 数据上传 ==========================
-void uploadData(float temperature, float humidity) {
-  if (WiFi.status() != WL_CONNECTED) {
-    Serial.println("❌ WiFi未连接，跳过上传");
+  if (!wifiLinkConnected()) {
+    drawWiFiBanner(true);
+    bannerShown = true;
     return;
   }
 
-  HTTPClient http;
-  http.setTimeout(5000);  // 5秒超时（减少阻塞时间）
-
-  // 构建JSON数据
-  StaticJsonDocument<128> doc;
-  doc["temperature"] = round(temperature * 10) / 10.0;  // 保留1位小数
-  doc["humidity"] = round(humidity * 10) / 10.0;  // 保留1位小数
-
-  String jsonData;
-  serializeJson(doc, jsonData);
-
-  Serial.println("📤 正在上传数据...");
-  Serial.println("数据: " + jsonData);
-
-  // 发送HTTP POST请求
-  http.begin(serverUrl);
-  http.addHeader("Content-Type", "application/json");
-
-  int httpResponseCode = http.POST(jsonData);
-
-  if (httpResponseCode > 0) {
-    String response = http.getString();
-    Serial.printf("✅ 上传成功! 状态码: %d, 响应: %s\n", httpResponseCode, response.c_str());
-  } else {
-    Serial.printf("❌ 上传失败! 错误码: %d, %s\n", httpResponseCode, http.errorToString(httpResponseCode).c_str());
+  if (bannerShown) {
+    drawWiFiBanner(false);  // 清除断线提示
+    bannerShown = false;
   }
+  bootPhase(BOOT_PHASE_WIFI);
+  telemetryUploaderKick();  // 断网期间积压的数据立即开始补传
+  if (!endpointsPrinted) {
+    printApiEndpoints();
+    endpointsPrinted = true;
+  }
+}
 
-  http.end();
+// ========================== 数据上传 ==========================
+// 只负责入队，不做网络操作；上传由 telemetry_uploader 后台任务完成
+void recordTelemetry(const SensorSample& sample) {
+  time_t now = time(nullptr);
+  // NTP 尚未同步时时间戳记为 0，由服务器按接收时间处理
+  uint32_t timestamp = now > 1600000000 ? (uint32_t)now : 0;
+  history.append(timestamp, sample.temperature, sample.humidity);  // 本地历史保留全部采样
+  bootSaveReading(sample);  // 复位后第一帧显示这个读数
+
+  TelemetryPoint point = {(uint32_t)millis(), timestamp, sample.temperature, sample.humidity};
+  TelemetryPoint reports[2];
+  uint8_t count = telemetryCompressor.push(point, reports);
+  for (uint8_t i = 0; i < count; i++) {
+    telemetryQueue.post(reports[i].timestamp, reports[i].temperature, reports[i].humidity);
+  }
 }
 
 // ========================== MQTT控制 ==========================
 // MQTT回调函数：收到消息
 void mqttCallback(char* topic, byte* payload, unsigned int length) {
+  if (mqttTelemetryHandleMessage(topic, payload, length)) {
+    return;
+  }
   Serial.printf("📨 收到MQTT消息: %s\n", topic);
 
-  // 处理定时空调开关状态
-  if (strcmp(topic, mqttScheduleTopic) == 0) {
-    StaticJsonDocument<64> doc;
-    DeserializationError error = deserializeJson(doc, payload, length);
-    if (error) {
-      Serial.println("❌ JSON解析失败");
+  // 处理定时空调开关和规则：交给主循环应用、保存并重新计算下次事件，
+  // 确认状态消息由主循环生成后在本任务中发布（格式与收到的消息相同）
+  // 二进制帧直接在接收缓冲区上解码，JSON 仍然兼容
+  if (strcmp(topic, mqttTopics.schedule) == 0 || strcmp(topic, MQTT_LEGACY_SCHEDULE_TOPIC) == 0) {
+    static AcScheduleUpdate update;  // 只在 MQTT 任务中使用
+    bool valid = wireIsFrame(payload, length) ? wireDecodeScheduleUpdate(payload, length, update)
+                                              : parseACSchedule(payload, length, update);
+    if (!valid) {
+      Serial.println("❌ 定时空调消息无效，已忽略");
       return;
     }
-    scheduleEnabled = doc["enabled"];
-    Serial.printf("📅 定时空调: %s\n", scheduleEnabled ? "启用" : "禁用");
-
-    // 发布确认状态消息到服务器
-    String statusMessage;
-    statusMessage += "{\"enabled\":";
-    statusMessage += scheduleEnabled ? "true" : "false";
-    statusMessage += "}";
-    mqttClient.publish(mqttStatusTopic, statusMessage.c_str());
-    Serial.println("📤 已发布状态确认消息");
-
+    scheduleStatusFormat = wireFormatOf(payload, length);
+    if (!scheduleUpdates.push(update)) {
+      Serial.println("❌ 定时规则更新过于频繁，已忽略");
+      return;
+    }
+    eventLoopSignal(EV_SCHEDULE);
     return;
   }
 
-  // 处理空调控制指令
-  StaticJsonDocument<64> doc;
-  DeserializationError error = deserializeJson(doc, payload, length);
-
-  if (error) {
-    Serial.printf("❌ JSON解析失败: %s\n", error.c_str());
+  // 处理空调控制指令：在本任务中直接提交红外命令（不等主循环），主循环只更新开关状态
+  AcCommand command;
+  bool valid = wireIsFrame(payload, length) ? wireDecodeCommand(payload, length, command)
+                                            : parseACCommand(payload, length, command);
+  if (!valid) {
     return;
   }
+  RemoteCommand remote;
+  commandTraceReceive(remote, command, wireFormatOf(payload, length));
+  if (commandTraceSubmit(remote, acIRCommand(command.action), logIRResult) == 0) {
+    Serial.println("❌ 红外命令队列已满，已忽略");
+    return;
+  }
+  Serial.printf("%s MQTT指令 #%lu：%s空调\n", command.action == AC_ACTION_ON ? "❄️" : "🔴",
+                (unsigned long)command.id, command.action == AC_ACTION_ON ? "开启" : "关闭");
+  if (!remoteCommands.push(command.action)) {
+    Serial.println("❌ 空调状态队列已满，开关状态未更新");
+    return;
+  }
+  eventLoopSignal(EV_COMMAND);
+}
 
-  const char* action = doc["action"];
+// 发布红外调度任务完成的指令应答（只在 MQTT 任务中调用），格式与指令相同
+void publishCommandAcks() {
+  AcCommandAck ack;
+  WireFormat format;
+  while (commandTraceNextAck(ack, format)) {
+    if (format == WIRE_FORMAT_BINARY) {
+      uint8_t frame[WIRE_OVERHEAD + WIRE_COMMAND_ACK_SIZE];
+      size_t len = wireEncodeCommandAck(frame, sizeof(frame), ack);
+      mqttClient.publish(mqttTopics.commandAck, frame, len);
+    } else {
+      char json[192];
+      if (acCommandAckJson(json, sizeof(json), ack) > 0) {
+        mqttClient.publish(mqttTopics.commandAck, json);
+      }
+    }
+    Serial.printf("📤 指令应答 #%lu: %s", (unsigned long)ack.id, acCommandResultName(ack.result));
+    if (ack.dispatchMs != AC_ACK_TIME_NONE) {
+      Serial.printf(" [发送 %lums", (unsigned long)ack.dispatchMs);
+      if (ack.irAckMs != AC_ACK_TIME_NONE) {
+        Serial.printf(", 确认 %lums", (unsigned long)ack.irAckMs);
+      }
+      Serial.print("]");
+    }
+    Serial.println();
+  }
+}
 
-  if (strcmp(action, "on") == 0) {
-    Serial.println("❄️ MQTT指令：开启空调");
-    sendIRCommand("fs00");
-    acIsOn = true;
-  } else if (strcmp(action, "off") == 0) {
-    Serial.println("🔴 MQTT指令：关闭空调");
-    sendIRCommand("fs20");
-    acIsOn = false;
+// 等待 MQTT 连接可读（有消息到达）或超时，消息到达后立即返回处理，不受轮询间隔限制。
+// WiFiClient 自带接收缓冲：缓冲中已有数据时 socket 不一定可读，直接返回
+static void mqttWaitReadable(uint32_t timeoutMs) {
+  int fd = mqttWifiClient.fd();
+  if (fd < 0) {
+    vTaskDelay(pdMS_TO_TICKS(timeoutMs));
+    return;
   }
+  if (mqttWifiClient.available() > 0) {
+    return;
+  }
+  fd_set readSet;
+  FD_ZERO(&readSet);
+  FD_SET(fd, &readSet);
+  struct timeval timeout = {(time_t)(timeoutMs / 1000), (suseconds_t)((timeoutMs % 1000) * 1000)};
+  select(fd + 1, &readSet, nullptr, nullptr, &timeout);
+}
+
+// 上报定时空调状态（心跳和确认共用），只在 MQTT 任务中调用；返回快照中的定时开关
+bool publishScheduleStatus() {
+  static AcStatus status;  // 只在 MQTT 任务中使用
+  scheduleStatusDirty = false;  // 先清标志：读取之后的更新会再次置位，不会漏发
+  acStatus.read(status);
+  bool binary = scheduleStatusFormat == WIRE_FORMAT_BINARY && status.wireLen > 0;
+  const uint8_t* payload = binary ? status.wire : (const uint8_t*)status.message;
+  size_t length = binary ? status.wireLen : strlen(status.message);
+  mqttClient.publish(mqttTopics.scheduleStatus, payload, length);
+#if MQTT_LEGACY_TOPICS
+  mqttClient.publish(MQTT_LEGACY_STATUS_TOPIC, payload, length);
+#endif
+  return status.scheduleEnabled;
 }
 
 // MQTT 任务函数 - 在独立任务中运行，不阻塞主循环
@@ -294,17 +378,38 @@ void mqttTask(void *pvParameters) {
   mqttClient.setServer(mqttServer, mqttPort);
   mqttClient.setCallback(mqttCallback);
   mqttClient.setSocketTimeout(5000);  // 5秒超时
+  mqttClient.setBufferSize(1536);     // 定时规则、状态和健康消息超过默认的 256 字节
+
+  if (!mqttTopicsInit(mqttTopics, mqttNamespace, deviceId)) {
+    Serial.println("❌ 设备命名空间无效，MQTT任务退出");
+    esp_task_wdt_delete(NULL);
+    vTaskDelete(NULL);
+    return;
+  }
+#if TELEMETRY_VIA_MQTT
+  mqttTelemetryBegin(mqttClient, telemetryQueue, mqttTopics);
+#endif
 
-  String clientId = "ESP32-Office-" + String(random(0xffff), HEX);
   Serial.printf("   服务器: %s:%d\n", mqttServer, mqttPort);
-  Serial.printf("   客户端ID: %s\n", clientId.c_str());
-  Serial.printf("   主题: %s\n", mqttTopic);
+  Serial.printf("   客户端ID: %s\n", deviceId);
+  Serial.printf("   设备命名空间: %s\n", mqttTopics.prefix);
 
   bool lastWiFiStatus = false;
+  unsigned long lastHealthCollect = millis();
+  bool healthPending = false;  // 已采集、等待连接后发布
 
   while (1) {
     // MQTT任务也要定期喂狗
-    esp_task_wdt_reset();
+    healthFeedWatchdog(HEALTH_WDT_MQTT);
+#if TELEMETRY_VIA_MQTT
+    telemetryQueue.drainInbox();  // 断网时也取走主循环投递的采样，积压落盘在本核心完成
+#endif
+    // 断网时也按周期采集（CPU 占用按周期计算，看门狗余量的周期最小值按周期重置）
+    if (millis() - lastHealthCollect >= HEALTH_INTERVAL_MS) {
+      lastHealthCollect = millis();
+      healthCollect();
+      healthPending = true;
+    }
 
     bool currentWiFiStatus = (WiFi.status() == WL_CONNECTED);
 
@@ -318,12 +423,24 @@ void mqttTask(void *pvParameters) {
         Serial.print("🔄 连接MQTT...");
 
         unsigned long connectStart = millis();
-        if (mqttClient.connect(clientId.c_str())) {
+        // 遗嘱消息：异常断线时由服务器代发 retained "offline"
+        if (mqttClient.connect(deviceId, mqttTopics.availability, 1, true, "offline")) {
           Serial.println(" ✅ 已连接");
-          mqttClient.subscribe(mqttTopic);
-          Serial.printf("   订阅主题: %s\n", mqttTopic);
-          mqttClient.subscribe(mqttScheduleTopic);
-          Serial.printf("   订阅主题: %s\n", mqttScheduleTopic);
+          mqttWifiClient.setNoDelay(true);  // 指令应答等小消息立即发出，不等 Nagle 合并
+          mqttClient.publish(mqttTopics.availability, "online", true);
+          mqttClient.publish(mqttTopics.codec, WIRE_CAPABILITIES, true);
+          scheduleStatusFormat = WIRE_FORMAT_JSON;  // 新连接重新协商
+          mqttClient.subscribe(mqttTopics.control);
+          mqttClient.subscribe(mqttTopics.schedule);
+          Serial.printf("   订阅主题: %s, %s\n", mqttTopics.control, mqttTopics.schedule);
+#if MQTT_LEGACY_TOPICS
+          mqttClient.subscribe(MQTT_LEGACY_CONTROL_TOPIC);
+          mqttClient.subscribe(MQTT_LEGACY_SCHEDULE_TOPIC);
+          Serial.printf("   订阅主题: %s, %s\n", MQTT_LEGACY_CONTROL_TOPIC, MQTT_LEGACY_SCHEDULE_TOPIC);
+#endif
+#if TELEMETRY_VIA_MQTT
+          mqttTelemetryOnConnect();
+#endif
         } else {
           int state = mqttClient.state();
           Serial.print(" ❌ 失败 (状态: ");
@@ -346,362 +463,331 @@ void mqttTask(void *pvParameters) {
           }
         }
       } else {
-        mqttClient.loop();  // 处理MQTT消息
-
-        // 每60秒上报一次定时空调状态
-        if (millis() - lastScheduleStatusReport > 60000) {
-          String statusMessage;
-          statusMessage += "{\"enabled\":";
-          statusMessage += scheduleEnabled ? "true" : "false";
-          statusMessage += "}";
-          mqttClient.publish(mqttStatusTopic, statusMessage.c_str());
+        // 处理已到达的MQTT消息（loop() 每次只读一条）
+        mqttClient.loop();
+        for (int i = 1; i < MQTT_PACKETS_PER_WAKE && mqttWifiClient.available() > 0; i++) {
+          mqttClient.loop();
+        }
+        publishCommandAcks();
+#if TELEMETRY_VIA_MQTT
+        mqttTelemetryService();  // 遥测批次与控制、状态共用同一条连接
+#endif
+
+        // 规则或开关变化后立即确认，否则每60秒上报一次定时空调状态
+        if (scheduleStatusDirty) {
+          publishScheduleStatus();
+          lastScheduleStatusReport = millis();
+          Serial.println("📤 已发布定时空调状态确认消息");
+        } else if (millis() - lastScheduleStatusReport > 60000) {
+          bool enabled = publishScheduleStatus();
           lastScheduleStatusReport = millis();
-          Serial.printf("📤 定期上报定时空调状态: %s\n", scheduleEnabled ? "启用" : "禁用");
+          Serial.printf("📤 定期上报定时空调状态: %s\n", enabled ? "启用" : "禁用");
+        }
+
+        if (healthPending) {
+          static char health[1280];  // 不放在 MQTT 任务栈上
+          size_t len = healthToJson(health, sizeof(health));
+          if (len > 0) {
+            mqttClient.publish(mqttTopics.health, (const uint8_t*)health, len);
+          }
+          healthPending = false;
         }
       }
     }
 
     lastWiFiStatus = currentWiFiStatus;
 
-    // 每5秒检查一次（避免看门狗超时）
-    vTaskDelay(pdMS_TO_TICKS(5000));
+    // 已连接时阻塞到有消息到达（最长 MQTT_POLL_MS），否则按重试间隔等待；两者都远短于看门狗超时
+    if (currentWiFiStatus && mqttClient.connected()) {
+      mqttWaitReadable(MQTT_POLL_MS);
+    } else {
+      vTaskDelay(pdMS_TO_TICKS(MQTT_RECONNECT_MS));
+    }
   }
 }
 
 // ========================== 红外模块控制 ==========================
-// 初始化红外模块
+// 初始化红外模块：串口交给红外调度任务独占
 void initIRModule() {
   Serial.println("📡 初始化红外模块...");
-  IR_SERIAL.begin(IR_BAUDRATE, SERIAL_8N1, IR_RX_PIN, IR_TX_PIN);
-  delay(1000);
+  if (!irDispatcherBegin(IR_SERIAL, IR_RX_PIN, IR_TX_PIN, IR_BAUDRATE)) {
+    Serial.println("❌ 红外调度任务创建失败");
+    return;
+  }
   Serial.println("✅ 红外模块已初始化");
   Serial.printf("   波特率: %d\n", IR_BAUDRATE);
   Serial.printf("   引脚: RX=%d, TX=%d\n", IR_RX_PIN, IR_TX_PIN);
 }
 
-// 发送红外命令
-void sendIRCommand(const char* command) {
-  Serial.printf("📤 发送红外命令: %s\n", command);
-  IR_SERIAL.println(command);
-
-  // 分段延时并喂狗，避免长时间阻塞
-  for (int i = 0; i < 5; i++) {
-    delay(100);
-    esp_task_wdt_reset();
+// 红外命令完成回调（在调度任务中执行）：记录送达情况和确认延迟
+void logIRResult(const IrResult& result, void* ctx) {
+  if (result.superseded) {
+    Serial.printf("⏭️ 红外命令 #%lu (%s) 已被后续命令覆盖\n",
+                  (unsigned long)result.id, result.command);
+  } else if (result.acked) {
+    Serial.printf("   模块响应 #%lu: %s [排队 %lums, 确认 %lums]\n",
+                  (unsigned long)result.id, result.response,
+                  (unsigned long)(result.sentMs - result.queuedMs),
+                  (unsigned long)(result.ackMs - result.sentMs));
+  } else {
+    Serial.printf("   红外命令 #%lu (%s) 无响应 [排队 %lums]\n",
+                  (unsigned long)result.id, result.command,
+                  (unsigned long)(result.sentMs - result.queuedMs));
   }
+}
 
-  // 读取红外模块响应
-  if (IR_SERIAL.available()) {
-    String response = IR_SERIAL.readString();
-    Serial.printf("   模块响应: %s\n", response.c_str());
+// 发送空调开/关红外命令：只入队，不等待模块响应
+uint32_t sendIRCommand(const char* command) {
+  uint32_t id = irSubmit(command, IR_KIND_AC_POWER, logIRResult, nullptr);
+  if (id != 0) {
+    Serial.printf("📤 红外命令已排队 #%lu: %s\n", (unsigned long)id, command);
   } else {
-    Serial.println("   无响应");
+    Serial.printf("❌ 红外命令队列已满，丢弃: %s\n", command);
   }
+  return id;
 }
 
 // HTTP 服务器处理函数：空调开机
-void handleACOn() {
+void handleACOn(AsyncWebServerRequest* request) {
   Serial.println("🔴 收到空调开机请求");
-  sendIRCommand("fs00");
-  
-  String response = "{\"status\":\"success\",\"action\":\"ac_on\",\"message\":\"空调开机指令已发送\"}";
-  webServer.sendHeader("Access-Control-Allow-Origin", "*");
-  webServer.send(200, "application/json", response);
+  uint32_t id = sendIRCommand("fs00");
+
+  char response[128];
+  snprintf(response, sizeof(response),
+           "{\"status\":\"%s\",\"action\":\"ac_on\",\"id\":%lu,\"message\":\"%s\"}",
+           id ? "success" : "error", (unsigned long)id,
+           id ? "空调开机指令已提交" : "红外命令队列已满");
+  request->send(id ? 200 : 503, "application/json", response);
   
   Serial.println("✅ 空调开机响应已发送");
 }
 
 // HTTP 服务器处理函数：空调关机
-void handleACOff() {
+void handleACOff(AsyncWebServerRequest* request) {
   Serial.println("🔴 收到空调关机请求");
-  sendIRCommand("fs20");
-  
-  String response = "{\"status\":\"success\",\"action\":\"ac_off\",\"message\":\"空调关机指令已发送\"}";
-  webServer.sendHeader("Access-Control-Allow-Origin", "*");
-  webServer.send(200, "application/json", response);
+  uint32_t id = sendIRCommand("fs20");
+
+  char response[128];
+  snprintf(response, sizeof(response),
+           "{\"status\":\"%s\",\"action\":\"ac_off\",\"id\":%lu,\"message\":\"%s\"}",
+           id ? "success" : "error", (unsigned long)id,
+           id ? "空调关机指令已提交" : "红外命令队列已满");
+  request->send(id ? 200 : 503, "application/json", response);
   
   Serial.println("✅ 空调关机响应已发送");
 }
 
-// HTTP 服务器处理函数：404
-void handleNotFound() {
-  String response = "{\"status\":\"error\",\"message\":\"API not found\"}";
-  webServer.sendHeader("Access-Control-Allow-Origin", "*");
-  webServer.send(404, "application/json", response);
-}
-
-// 空调自动控制逻辑
-void checkACControl(int weekday, int hour, int minute, float temperature) {
-  // 检查定时开关状态
-  if (!scheduleEnabled) {
-    // 定时空调已禁用，不执行自动控制
-    return;
+// HTTP 服务器处理函数：界面刷新统计和堆统计（Prometheus 文本格式）
+// 请求依次在 async_tcp 任务中处理，静态缓冲区不会并发使用；响应体复制到流中异步发送，
+// 下一次抓取可以立即复用缓冲区
+void handleMetrics(AsyncWebServerRequest* request) {
+  // 各部分依次格式化到同一个缓冲区再写入响应流，缓冲区只需容纳最大的一部分
+  static size_t (*const sections[])(char*, size_t) = {
+    renderStatsToPrometheus, heapStatsToPrometheus, wifiLinkToPrometheus, sensorToPrometheus,
+    commandTraceToPrometheus, healthToPrometheus,
+  };
+  static char metrics[8192];
+  AsyncResponseStream* response = request->beginResponseStream("text/plain; version=0.0.4");
+  for (size_t i = 0; i < sizeof(sections) / sizeof(sections[0]); i++) {
+    size_t len = sections[i](metrics, sizeof(metrics));
+    if (len == 0) {
+      delete response;
+      request->send(500, "text/plain", "metrics buffer too small\n");
+      return;
+    }
+    response->write((const uint8_t*)metrics, len);
   }
+  request->send(response);
+}
 
-  // weekday: 0=周日, 1=周一, ..., 6=周六
+// 首次连上 WiFi 后打印接口地址
+void printApiEndpoints() {
+  IPAddress ip = WiFi.localIP();
+  Serial.printf("   API 端点:\n");
+  Serial.printf("     - http://%u.%u.%u.%u/ac/on  (空调开机)\n", ip[0], ip[1], ip[2], ip[3]);
+  Serial.printf("     - http://%u.%u.%u.%u/ac/off (空调关机)\n", ip[0], ip[1], ip[2], ip[3]);
+  Serial.printf("     - http://%u.%u.%u.%u/api/data   (最新读数，支持 ETag)\n", ip[0], ip[1], ip[2], ip[3]);
+  Serial.printf("     - http://%u.%u.%u.%u/api/stream (SSE 实时推送)\n", ip[0], ip[1], ip[2], ip[3]);
+  Serial.printf("     - http://%u.%u.%u.%u/history    (设备端历史，二进制)\n", ip[0], ip[1], ip[2], ip[3]);
+}
 
-  // 判断是否在工作日（周一到周五）
-  bool isWorkday = (weekday >= 1 && weekday <= 5);
+// HTTP 服务器处理函数：404
+void handleNotFound(AsyncWebServerRequest* request) {
+  request->send(404, "application/json", "{\"status\":\"error\",\"message\":\"API not found\"}");
+}
 
-  if (!isWorkday) {
-    // 周末不做自动控制
+// 执行空调动作：发送红外命令并记录开关状态（只在主循环中调用）
+void applyACAction(AcAction action) {
+  const char* command = acIRCommand(action);
+  if (command == nullptr) {
     return;
   }
-
-  // 早上 8:00 检查：温度低于17度，打开空调
-  if (hour == 8 && minute == 0) {
-    if (temperature < 17.0) {
-      Serial.println("🕗 早上8点，温度低于17°C，准备开启空调...");
-      sendIRCommand("fs00");
-      acIsOn = true;
-      lastACCommandSent = true;
-    } else {
-      Serial.printf("🕗 早上8点，温度%.1f°C，不需要开启空调\n", temperature);
-    }
-  }
-
-  // 下午 17:30：无论空调是否开启，都发送关机命令
-  if (hour == 17 && minute == 30) {
-    Serial.println("🕕 下午5:30，准备关闭空调...");
-    sendIRCommand("fs20");
-    acIsOn = false;
-    lastACCommandSent = true;
-  }
+  sendIRCommand(command);
+  updateACState(action);
 }
 
-// ========================== 4. 界面绘制（美化版） ==========================
-void drawBeautifulBorder() {
-  // 外边框（圆角）
-  drawRoundedRect(2, 2, 236, 236, 8, ST77XX_GRAY_LIGHT);
-
-  // 内装饰线
-  tft.drawRoundRect(6, 6, 228, 228, 6, ST77XX_GRAY_DARK);
-
-  // 分隔线
-  tft.drawFastHLine(8, 80, 224, ST77XX_GRAY_DARK);
-  tft.drawFastHLine(8, 160, 224, ST77XX_GRAY_DARK);
-  tft.drawFastVLine(120, 162, 76, ST77XX_GRAY_DARK);
+// 更新空调开关状态并发布（远程指令的红外命令已由 MQTT 任务提交）
+void updateACState(AcAction action) {
+  acIsOn = (action == AC_ACTION_ON);
+  publishACStatus();
 }
 
-void initTempHumiUI() {
-  drawGradientBackground();
-  drawBeautifulBorder();
+// 生成空调和定时状态快照供 MQTT 任务发布（只在主循环中调用）
+void publishACStatus() {
+  static AcStatus status;  // 640 字节，不放在 loop 任务栈上
+  status.acOn = acIsOn;
+  status.scheduleEnabled = scheduleEnabled;
+  if (acSchedule.statusJson(status.message, sizeof(status.message),
+                           scheduleEnabled, acScheduleNextDue) == 0) {
+    snprintf(status.message, sizeof(status.message), "{\"enabled\":%s}",
+             scheduleEnabled ? "true" : "false");
+  }
+  status.wireLen = (uint8_t)wireEncodeScheduleStatus(status.wire, sizeof(status.wire), acSchedule,
+                                                     scheduleEnabled, acScheduleNextDue);
+  acStatus.write(status);
+  bootSaveAc(acIsOn, scheduleEnabled);
 }
 
-// ========================== 5. 时钟更新（消除闪烁版） ==========================
-void updateClock() {
-  // 使用 time() 获取时间戳，然后用 localtime() 转换
-  time_t now = time(nullptr);
-  if (now < 1000000) {  // 时间未同步（epoch太小）
-    return;
+// 从 NVS 读取定时开关、规则和已处理到的时间点；没有保存过时使用默认规则
+void loadACSchedule() {
+  schedulePrefs.begin("acsched", false);
+  scheduleEnabled = schedulePrefs.getBool("enabled", scheduleEnabled);  // 未保存过时沿用 RTC 恢复的值
+
+  AcScheduleRule rules[AC_SCHEDULE_MAX_RULES];
+  size_t bytes = schedulePrefs.getBytesLength("rules");
+  if (bytes > 0 && bytes <= sizeof(rules) && bytes % sizeof(AcScheduleRule) == 0 &&
+      schedulePrefs.getBytes("rules", rules, bytes) == bytes &&
+      acSchedule.setRules(rules, bytes / sizeof(AcScheduleRule))) {
+    Serial.printf("📅 已加载 %u 条定时规则\n", (unsigned)acSchedule.size());
+  } else {
+    acSchedule.setDefaults();
+    Serial.println("📅 使用默认定时规则");
   }
+  acScheduleLastRun = (time_t)schedulePrefs.getULong64("lastRun", 0);
+  publishACStatus();  // 时间同步之前也有可发布的状态
+  scheduleTraceState(acSchedule, scheduleEnabled, acScheduleLastRun);
+}
 
-  struct tm *timeinfo = localtime(&now);
-  if (timeinfo == nullptr) {
-    return;
+// 每次执行事件后保存时间点；规则只在更新时写入，减少 Flash 擦写
+void saveACSchedule(bool rulesChanged) {
+  if (rulesChanged) {
+    AcScheduleRule rules[AC_SCHEDULE_MAX_RULES];
+    for (uint8_t i = 0; i < acSchedule.size(); i++) {
+      rules[i] = acSchedule.rule(i);
+    }
+    schedulePrefs.putBytes("rules", rules, acSchedule.size() * sizeof(AcScheduleRule));
+    schedulePrefs.putBool("enabled", scheduleEnabled);
   }
+  schedulePrefs.putULong64("lastRun", (uint64_t)acScheduleLastRun);
+}
 
-  int year = timeinfo->tm_year + 1900;
-  int month = timeinfo->tm_mon + 1;
-  int day = timeinfo->tm_mday;
-  int weekday = timeinfo->tm_wday;
-  int hours = timeinfo->tm_hour;
-  int minutes = timeinfo->tm_min;
-  int seconds = timeinfo->tm_sec;
-
-  String weekdayStrs[] = {"周日", "周一", "周二", "周三", "周四", "周五", "周六"};
-  String weekdayStr = weekdayStrs[weekday % 7];
-
-  // 检查空调控制（每分钟检查一次）
-  // 注意：不在这里读取DHT22，避免重复读取导致超时
-  // 使用updateTempHumi中读取的值
-  if (seconds == 0 && !lastACCommandSent && temperatureCacheValid) {
-    checkACControl(weekday, hours, minutes, cachedTemperature);
+// 定时空调：EV_SCHEDULE 到期或收到新规则时运行，执行 (上次处理时间, 现在] 内最近的事件
+void runACSchedule() {
+  static AcScheduleUpdate update;  // 只在主循环中使用
+  bool hasUpdate = false;
+  while (scheduleUpdates.pop(update)) {
+    hasUpdate = true;
+    if (update.hasEnabled) {
+      scheduleEnabled = update.enabled;
+      Serial.printf("📅 定时空调: %s\n", scheduleEnabled ? "启用" : "禁用");
+    }
+    if (update.hasRules && !acSchedule.setRules(update.rules, update.ruleCount)) {
+      Serial.println("❌ 定时规则无效，保留原规则");
+    } else if (update.hasRules) {
+      Serial.printf("📅 定时规则已更新: %u 条\n", (unsigned)update.ruleCount);
+    }
   }
-
-  // 重置有效性标志（每分钟重置，强制等待新的温度读数）
-  if (seconds == 0) {
-    temperatureCacheValid = false;
+  if (hasUpdate) {
+    saveACSchedule(true);
+    publishACStatus();  // 时间未同步时下面不会重新计算，先发布新的开关和规则
+    scheduleStatusDirty = true;
+    scheduleTraceState(acSchedule, scheduleEnabled, acScheduleLastRun);
   }
 
-  // 重置命令标志（每分钟重置一次）
-  if (seconds == 0) {
-    lastACCommandSent = false;
+  // 使用采集任务的最新滤波读数，读数过期时 sensorLatest 返回 false
+  time_t now = time(nullptr);
+  SensorSample sample;
+  bool hasSample = sensorLatest(sample);
+  float temperature = hasSample ? sample.temperature : NAN;
+  AcRunResult run = acScheduleRun(acSchedule, scheduleEnabled, acScheduleLastRun, now, hasSample, temperature);
+  if (run.outcome != AC_RUN_IDLE) {
+    scheduleTraceRun(now, run, acScheduleLastRun, temperature);
   }
 
-    // 日期和星期显示（分两行显示）
-  static String lastDateNum = "";
-  static String lastWeekday = "";
-  static String lastHours = "";
-  static String lastMinutes = "";
-  String dateNum = String(year) + "-" + formatNumber(month) + "-" + formatNumber(day);
-  String hoursStr = formatNumber(hours);
-  String minutesStr = formatNumber(minutes);
-
-  if (dateNum != lastDateNum || weekdayStr != lastWeekday) {
-    u8g2.begin(tft);  // 只在日期变化时初始化
-    tft.fillRect(10, 10, 220, 70, ST77XX_BLACK); // 清除日期区
-    u8g2.setFont(u8g2_font_wqy16_t_gb2312b);   // 使用加粗16号中文字体
-    u8g2.setForegroundColor(ST77XX_WHITE);
-    u8g2.setBackgroundColor(ST77XX_BLACK);
-
-    // 第一行：日期
-    int date_x, date_y;
-    getCenterPos(u8g2, dateNum.c_str(), 10, 10, 220, 35, date_x, date_y);
-    u8g2.drawUTF8(date_x, date_y, dateNum.c_str());
-
-    // 第二行：星期
-    int weekday_x, weekday_y;
-    getCenterPos(u8g2, weekdayStr.c_str(), 10, 45, 220, 35, weekday_x, weekday_y);
-    u8g2.drawUTF8(weekday_x, weekday_y, weekdayStr.c_str());
-
-    lastDateNum = dateNum;
-    lastWeekday = weekdayStr;
+  bool handled = run.outcome == AC_RUN_DISABLED || run.outcome == AC_RUN_EXECUTED;
+  const AcScheduleRule& rule = acSchedule.rule(handled ? run.event.rule : 0);
+  long lateSec = (long)(now - run.event.due);
+  if (handled && lateSec > 60) {
+    Serial.printf("⏰ 补执行 %02d:%02d 的定时事件（延迟 %ld 秒）\n", rule.hour, rule.minute, lateSec);
   }
-
-  // 时间显示（优化：只重绘变化的部分）
-  if (seconds != lastSeconds) {
-    u8g2.begin(tft);
-    u8g2.setFont(u8g2_font_logisoso38_tn);  // 使用38号大字体
-    u8g2.setForegroundColor(ST77XX_WHITE);
-    u8g2.setBackgroundColor(ST77XX_BLACK);
-
-    String secondsStr = formatNumber(seconds);
-
-    // 如果小时或分钟变化，重绘整个时间
-    if (hoursStr != lastHours || minutesStr != lastMinutes) {
-      String timeStr = hoursStr + ":" + minutesStr + ":" + secondsStr;
-
-      // 清除整个时间区域
-      tft.fillRect(10, 82, 220, 68, ST77XX_BLACK);
-
-      // 计算时间位置（居中显示）
-      int timeStrWidth = u8g2.getUTF8Width(timeStr.c_str());
-      int totalWidth = 220;  // 时间区域总宽度
-      int timeX = 10 + (totalWidth - timeStrWidth) / 2;
-      int timeY = 130;  // 垂直居中位置
-
-      u8g2.drawUTF8(timeX, timeY, timeStr.c_str());
-
-      lastHours = hoursStr;
-      lastMinutes = minutesStr;
-    } else {
-      // 只清除和重绘秒数部分
-      // 先计算完整时间的宽度，确定秒数的位置
-      String fullTimeStr = hoursStr + ":" + minutesStr + ":" + secondsStr;
-      int fullTimeWidth = u8g2.getUTF8Width(fullTimeStr.c_str());
-      int totalWidth = 220;
-      int fullTimeX = 10 + (totalWidth - fullTimeWidth) / 2;
-
-      // 计算冒号和秒数部分的位置
-      String prefixStr = hoursStr + ":" + minutesStr + ":";
-      int prefixWidth = u8g2.getUTF8Width(prefixStr.c_str());
-      int secondsX = fullTimeX + prefixWidth;
-
-      // 计算当前秒数和上次秒数的宽度，取最大值
-      String lastSecondsStr = formatNumber(lastSeconds);
-      int currentSecondsWidth = u8g2.getUTF8Width(secondsStr.c_str());
-      int lastSecondsWidth = u8g2.getUTF8Width(lastSecondsStr.c_str());
-      int clearWidth = max(currentSecondsWidth, lastSecondsWidth) + 15;  // 增加清除宽度
-
-      // 清除更宽的秒数区域，确保完全覆盖
-      tft.fillRect(secondsX - 5, 82, clearWidth, 68, ST77XX_BLACK);
-
-      // 重绘秒数
-      u8g2.drawUTF8(secondsX, 130, secondsStr.c_str());
-    }
-
-    lastSeconds = seconds;
+  switch (run.outcome) {
+    case AC_RUN_NOT_SYNCED:  // 时间未同步，稍后重试
+      break;
+    case AC_RUN_WAIT_SENSOR:
+      // 暂无温度读数：不记为已处理，补执行窗口内稍后重试
+      Serial.println("⚠️ 定时事件需要温度读数，传感器暂无有效数据，稍后重试");
+      break;
+    case AC_RUN_DISABLED:
+      // 定时空调已禁用，不执行自动控制
+      Serial.printf("📅 定时空调已禁用，跳过 %02d:%02d 的事件\n", rule.hour, rule.minute);
+      saveACSchedule(false);
+      break;
+    case AC_RUN_EXECUTED:
+      if (run.action == AC_ACTION_ON) {
+        Serial.printf("🕗 %02d:%02d 定时开启空调\n", rule.hour, rule.minute);
+      } else if (run.action == AC_ACTION_OFF) {
+        Serial.printf("🕕 %02d:%02d 定时关闭空调\n", rule.hour, rule.minute);
+      } else {
+        Serial.printf("🕗 %02d:%02d 温度%.1f°C，不需要执行\n", rule.hour, rule.minute, temperature);
+      }
+      applyACAction(run.action);
+      saveACSchedule(false);
+      break;
+    case AC_RUN_IDLE:  // 没有事件时 lastRun 只更新内存，不写 Flash
+      break;
   }
-}
 
-// ========================== 6. 温湿度更新（美化版） ==========================
-void updateTempHumi() {
-  // 喂狗，防止传感器读取超时
-  feedWatchdog();
-
-  float humidity = dht.readHumidity();
-  float temperature = dht.readTemperature();
-
-  if (isnan(humidity) || isnan(temperature)) {
-    Serial.println("❌ DHT22读取错误!");
-    temperatureCacheValid = false;
-    // 清除整个温湿度区域（包括竖线位置）
-    tft.fillRect(10, 162, 220, 70, ST77XX_BLACK);
-    u8g2.begin(tft);
-    u8g2.setFont(u8g2_font_wqy16_t_gb2312);
-    u8g2.setForegroundColor(ST77XX_RED);
-    u8g2.setBackgroundColor(ST77XX_BLACK);
-    String errorStr = "传感器错误";
-    int error_x, error_y;
-    getCenterPos(u8g2, errorStr.c_str(), 10, 162, 220, 70, error_x, error_y);
-    u8g2.drawUTF8(error_x, error_y, errorStr.c_str());
-    return;
+  // 重试时保留原来的下一个事件；重新计算时同时刷新状态消息
+  eventLoopAfter(EV_SCHEDULE, run.wakeMs, "schedule");
+  if (run.rearm) {
+    acScheduleNextDue = run.nextDue;
+    publishACStatus();
   }
-
-  // 更新温度缓存
-  cachedTemperature = temperature;
-  temperatureCacheValid = true;
-
-  // 动态颜色
-  uint16_t tempColor = ST77XX_YELLOW;
-  if (temperature < 20) tempColor = ST77XX_BLUE;
-  else if (temperature > 30) tempColor = ST77XX_RED;
-
-  uint16_t humiColor = ST77XX_GREEN;
-  if (humidity < 30) humiColor = ST77XX_ORANGE;
-  else if (humidity > 80) humiColor = ST77XX_CYAN;
-
-  // 清除区域（包括竖线位置）
-  tft.fillRect(10, 162, 220, 70, ST77XX_BLACK);
-
-  u8g2.begin(tft);
-  u8g2.setBackgroundColor(ST77XX_BLACK);
-
-  // -------------------------- 温度区 --------------------------
-  u8g2.setFont(u8g2_font_wqy16_t_gb2312);
-  u8g2.setForegroundColor(ST77XX_WHITE);
-  int temp_text_x, temp_text_y;
-  getCenterPos(u8g2, "温度", 15, 165, 105, 25, temp_text_x, temp_text_y);
-  u8g2.drawUTF8(temp_text_x, temp_text_y, "温度");
-
-  u8g2.setFont(u8g2_font_helvR18_tf);
-  u8g2.setForegroundColor(tempColor);
-  String tempStr = String(temperature, 1) + "°C";
-  int temp_val_x, temp_val_y;
-  getCenterPos(u8g2, tempStr.c_str(), 15, 190, 105, 35, temp_val_x, temp_val_y);
-  u8g2.drawUTF8(temp_val_x, temp_val_y, tempStr.c_str());
-
-  // -------------------------- 湿度区 --------------------------
-  u8g2.setFont(u8g2_font_wqy16_t_gb2312);
-  u8g2.setForegroundColor(ST77XX_WHITE);
-  int humi_text_x, humi_text_y;
-  getCenterPos(u8g2, "湿度", 135, 165, 100, 25, humi_text_x, humi_text_y);
-  u8g2.drawUTF8(humi_text_x, humi_text_y, "湿度");
-
-  u8g2.setFont(u8g2_font_helvR18_tf);
-  u8g2.setForegroundColor(humiColor);
-  String humiStr = String(humidity, 1) + "%";
-  int humi_val_x, humi_val_y;
-  getCenterPos(u8g2, humiStr.c_str(), 135, 190, 100, 35, humi_val_x, humi_val_y);
-  u8g2.drawUTF8(humi_val_x, humi_val_y, humiStr.c_str());
-
-  // 重新绘制中间分隔竖线
-  tft.drawFastVLine(120, 162, 70, ST77XX_GRAY_DARK);
-
-  Serial.printf("Temp: %.1f C, Humi: %.1f %%\n", temperature, humidity);
 }
 
 // ========================== 7. 初始化/主循环 ==========================
 void setup() {
   Serial.begin(115200);
-  delay(1000);
-  
+  bool warmBoot = bootStateBegin();
+
+  // ---- 阶段 1：屏幕。只依赖 RTC 保留的状态，复位后立即画出最近的时间、读数 ----
+  // 热启动时恢复空调和定时开关（定时开关随后以 NVS 为准，两者只在 NVS 未写入时不同）
+  bootRestoreAc(acIsOn, scheduleEnabled);
+  time_t lastKnown;
+  if (time(nullptr) < 1000000 && bootRestoreTime(lastKnown)) {
+    // 系统时间在软件复位后通常仍然有效；无效时先用复位前的时间，NTP 同步后校正
+    struct timeval tv = {lastKnown, 0};
+    settimeofday(&tv, nullptr);
+  }
+
+  tft.init(240, 240);
+  tft.setRotation(3);
+  frameBuffer.begin(&tft);
+  panelDMA.begin(tft, frameBuffer, TFT_MOSI, TFT_SCLK, TFT_CS, TFT_DC);
+  initGlyphCaches();
+  initTempHumiUI();
+  updateClock(time(nullptr));
+  SensorSample lastReading;
+  if (bootRestoreReading(lastReading)) {
+    drawTempHumi(&lastReading);  // 采集任务的第一个读数到达后由 EV_TEMP 替换
+  }
+  panelDMA.requestFlush();
+  bootPhase(BOOT_PHASE_FIRST_FRAME);
+
   // 检查重启原因
   esp_reset_reason_t reset_reason = esp_reset_reason();
-  bootCount++;
   Serial.println("\n========================================");
-  Serial.printf("🚀 系统启动 #%lu\n", bootCount);
+  Serial.printf("🚀 系统启动 #%lu（%s）\n", (unsigned long)bootStateCount(), warmBoot ? "热启动" : "冷启动");
   Serial.print("重启原因: ");
   switch(reset_reason) {
     case ESP_RST_POWERON:   Serial.println("上电复位"); break;
@@ -714,6 +800,9 @@ void setup() {
     case ESP_RST_BROWNOUT:  Serial.println("欠压复位"); break;
     default:                Serial.println("未知原因"); break;
   }
+  if (warmBoot && bootLastPhaseBefore() < BOOT_PHASE_SERVICES) {
+    Serial.printf("⚠️ 上次启动在 %s 阶段之后复位\n", bootPhaseName(bootLastPhaseBefore()));
+  }
   Serial.println("========================================\n");
 
   // 初始化看门狗 (8秒超时)
@@ -721,161 +810,242 @@ void setup() {
   esp_task_wdt_init(WDT_TIMEOUT, true);  // 启用panic重启
   esp_task_wdt_add(NULL);                // 添加当前任务到看门狗
   feedWatchdog();
-
-  Serial.print("📡 连接WiFi: ");
-  Serial.println(ssid);
-  WiFi.begin(ssid, password);
-  int wifi_attempts = 0;
-  while (WiFi.status() != WL_CONNECTED && wifi_attempts < 20) {
-    delay(500);
-    Serial.print(".");
-    feedWatchdog();  // WiFi连接过程中喂狗
-    wifi_attempts++;
-  }
-  
-  if (WiFi.status() == WL_CONNECTED) {
-    Serial.println("\n✅ WiFi连接成功! IP: " + WiFi.localIP().toString());
-    Serial.println("📶 信号强度: " + String(WiFi.RSSI()) + " dBm");
-  } else {
-    Serial.println("\n⚠️ WiFi连接失败，将继续尝试...");
+  if (!healthBegin(WDT_TIMEOUT * 1000)) {
+    Serial.println("❌ 复位原因计数读取失败");
   }
-  feedWatchdog();
-
-  // 初始化红外模块
-  initIRModule();
 
-  dht.begin();
-  Serial.println("🌡️  DHT22传感器已初始化");
-  
-  tft.init(240, 240);
-  tft.setRotation(3);
-  Serial.println("📺 ST7789屏幕已初始化");
-  feedWatchdog();
+  // ---- 阶段 2：后台服务。下面都只创建任务或注册回调，不等待网络 ----
+  // 连接在后台进行，连上后由 EV_WIFI 通知主循环
+  Serial.printf("📡 连接WiFi: %s（后台连接）\n", ssid);
+  if (!wifiLinkBegin(ssid, password, [](bool connected) { eventLoopSignal(EV_WIFI); })) {
+    Serial.println("❌ WiFi连接任务启动失败");
+  }
 
-  // 配置 NTP 时间
+  // SNTP 在 WiFi 连上后自动同步，完成时由 EV_TIME_SYNC 通知主循环
+  sntp_set_time_sync_notification_cb([](struct timeval* tv) { eventLoopSignal(EV_TIME_SYNC); });
   configTime(gmtOffset_sec, daylightOffset_sec, ntpServer);
   Serial.println("🕒 NTP时间同步已配置");
 
-  // 尝试首次NTP同步
-  Serial.print("⏰ 正在同步网络时间...");
-  struct tm timeinfo;
-  for (int i = 0; i < 10; i++) {  // 增加尝试次数
-    feedWatchdog();
-    if (getLocalTime(&timeinfo)) {
-      Serial.println(" ✅ 成功!");
-      Serial.printf("当前时间: %04d-%02d-%02d %02d:%02d:%02d\n",
-                   timeinfo.tm_year + 1900, timeinfo.tm_mon + 1, timeinfo.tm_mday,
-                   timeinfo.tm_hour, timeinfo.tm_min, timeinfo.tm_sec);
-      lastNTPSyncTime = millis();  // 标记同步成功
-      break;
-    }
-    Serial.print(".");
-    delay(500);
+  sensorRegister(&shtSensor);
+  sensorRegister(&bmeSensor);
+  sensorRegister(&dhtSensor);
+  if (sensorTaskBegin()) {
+    Serial.printf("🌡️  采集任务已启动（%u 个传感器，主传感器 %s）\n", sensorCount(), sensorName(0));
   }
-  if (!getLocalTime(&timeinfo)) {
-    Serial.println("\n⚠️ NTP同步失败，将使用默认时间并稍后重试");
+  initIRModule();
+
+  // 遥测队列（恢复上次未上传的记录）；HTTP 模式下启动批量上传任务，MQTT 模式由 mqttTask 发送
+  telemetryQueue.begin();
+#if !TELEMETRY_REPORT_ON_CHANGE
+  telemetryCompressor.configure(TelemetryCompressorConfig{{0, 0}, {0, 0}, 0});  // 零死区 + 零心跳：逐点上报
+#endif
+  if (!history.begin()) {
+    Serial.println("⚠️ PSRAM 不可用，设备端历史已禁用");
   }
+#if !TELEMETRY_VIA_MQTT
+  telemetryUploaderBegin(telemetryQueue, serverUrl);
+#endif
+  feedWatchdog();
 
-  initTempHumiUI();
-  updateClock();
-  
-  // 启动 HTTP 服务器（空调控制 API）
+  // 启动异步 HTTP 服务器（空调控制 API、局域网数据接口），请求由 async_tcp 任务处理
   Serial.println("🌐 启动 HTTP 服务器...");
+  DefaultHeaders::Instance().addHeader("Access-Control-Allow-Origin", "*");
   webServer.on("/ac/on", HTTP_GET, handleACOn);
   webServer.on("/ac/off", HTTP_GET, handleACOff);
+  webServer.on("/metrics", HTTP_GET, handleMetrics);
+  if (!localApiBegin(webServer, history)) {
+    Serial.println("❌ 局域网数据接口启动失败");
+  }
+#if SCHEDULE_TRACE
+  if (scheduleTraceBegin(webServer)) {
+    scheduleTraceBoot(bootStateCount(), (uint8_t)reset_reason);
+  } else {
+    Serial.println("❌ 定时控制轨迹记录启动失败");
+  }
+#endif
   webServer.onNotFound(handleNotFound);
   webServer.begin();
   Serial.println("✅ HTTP 服务器已启动");
-  Serial.printf("   API 端点:\n");
-  Serial.printf("     - http://%s/ac/on  (空调开机)\n", WiFi.localIP().toString().c_str());
-  Serial.printf("     - http://%s/ac/off (空调关机)\n", WiFi.localIP().toString().c_str());
-  
-  Serial.println("✅ 系统初始化完成！");
-  Serial.println("========================================\n");
 
-  // 创建 MQTT 任务，在独立任务中运行
-  xTaskCreate(
+  // 定时空调规则（NVS），时间同步后计算下次事件并补执行停机期间错过的事件
+  loadACSchedule();
+
+  // 定时任务改为 esp_timer 事件，loop() 只在有事件时醒来
+  eventLoopBegin();
+  eventLoopSecondTick(EV_CLOCK);
+  eventLoopEvery(EV_TEMP, tempRefreshInterval, "temp");
+  eventLoopEvery(EV_TELEMETRY, telemetryInterval, "telemetry");
+  eventLoopEvery(EV_NTP_SYNC, ntpSyncInterval, "ntp");
+  eventLoopEvery(EV_STATUS, statusLogInterval, "status");
+  eventLoopSignal(EV_SCHEDULE);
+  if (wifiLinkConnected()) {
+    eventLoopSignal(EV_WIFI);  // 启动期间已经连上（事件循环创建之前的通知不会保留）
+  }
+  Serial.onReceive([]() { eventLoopSignal(EV_SERIAL); }, true);  // 一行输入结束（接收空闲）时触发
+  eventLoopEnablePowerSave();
+
+  // 创建 MQTT 任务，与 WiFi 协议栈一起固定在核心 0
+  if (!commandTraceBegin()) {
+    Serial.println("❌ 指令应答队列创建失败");
+  }
+  xTaskCreatePinnedToCore(
     mqttTask,           // 任务函数
     "MQTTTask",         // 任务名称
-    4096,              // 堆栈大小
+    TASK_STACK_MQTT,   // 堆栈大小
     NULL,              // 参数
-    1,                 // 优先级
-    NULL               // 任务句柄
+    TASK_PRIO_MQTT,    // 优先级
+    NULL,              // 任务句柄
+    CORE_NET           // 核心
   );
   Serial.println("📡 MQTT任务已创建");
+  bootPhase(BOOT_PHASE_SERVICES);
+  Serial.println("✅ 系统初始化完成！");
+  Serial.println("========================================\n");
+}
+
+// 处理串口命令（用于测试）
+// 逐字节读入静态行缓冲区，不构造 String；超过红外命令长度的行整行拒绝，不截断后发送
+void handleSerialCommands() {
+  static char line[128];
+  static size_t lineLen = 0;
+  static bool lineOverflow = false;
+  while (Serial.available()) {
+    int c = Serial.read();
+    if (c < 0) {
+      break;
+    }
+    if (c != '\n') {
+      if (lineLen < sizeof(line) - 1) {
+        line[lineLen++] = (char)c;
+      } else {
+        lineOverflow = true;
+      }
+      continue;
+    }
+
+    // 去掉首尾空白（包括 \r）
+    size_t begin = 0;
+    size_t end = lineLen;
+    while (begin < end && isspace((unsigned char)line[begin])) begin++;
+    while (end > begin && isspace((unsigned char)line[end - 1])) end--;
+    line[end] = '\0';
+    lineLen = 0;
+    bool overflow = lineOverflow;
+    lineOverflow = false;
+
+    if (overflow || end - begin >= IR_COMMAND_MAX_LEN) {
+      Serial.printf("❌ 串口命令过长（最多 %d 个字符），已忽略\n", IR_COMMAND_MAX_LEN - 1);
+    } else if (end > begin) {
+      const char* command = line + begin;
+      Serial.printf("🔤 收到串口命令: %s\n", command);
+      // 原样转发给红外模块，响应由调度任务回调打印
+      if (irSubmit(command, IR_KIND_RAW, logIRResult, nullptr) == 0) {
+        Serial.println("❌ 红外命令队列已满，串口命令未发送");
+      }
+    }
+  }
 }
 
 void loop() {
+  // 阻塞等待任意定时任务到期，期间 CPU 空闲
+  EventBits_t events = eventLoopWait(EV_ALL, LOOP_IDLE_TIMEOUT);
+  uint32_t busyStart = healthLoopBegin();
+  bool clockTick = (events & EV_CLOCK) != 0;  // 时间同步后补画的时钟不计入抖动
+
   // 首要任务：喂狗
   feedWatchdog();
 
-  // 处理 HTTP 服务器请求
-  webServer.handleClient();
-  
-  // 处理串口命令（用于测试）
-  if (Serial.available()) {
-    String command = Serial.readStringUntil('\n');
-    command.trim();
-    if (command.length() > 0) {
-      Serial.printf("🔤 收到串口命令: %s\n", command.c_str());
-      IR_SERIAL.println(command);
-      delay(500);
-      if (IR_SERIAL.available()) {
-        String response = IR_SERIAL.readString();
-        Serial.printf("📥 红外模块响应: %s\n", response.c_str());
-      }
+  // 上一帧还在刷新时先等它把像素拷走，再开始本帧绘制
+  if (events) {
+    panelDMA.frameBegin();
+  }
+
+  if (events & EV_SERIAL) {
+    handleSerialCommands();
+  }
+
+  // MQTT 远程空调指令
+  if (events & EV_COMMAND) {
+    AcAction action;
+    while (remoteCommands.pop(action)) {
+      scheduleTraceCommand(action);
+      updateACState(action);
     }
   }
-  
-  unsigned long currentTime = millis();
-  systemUptime = currentTime / 1000;  // 运行时间(秒)
-
-  // 定期检查WiFi连接状态
-  if (currentTime - lastWiFiCheckTime >= wifiCheckInterval) {
-    lastWiFiCheckTime = currentTime;
-    checkAndReconnectWiFi();
-    
-    // 每小时输出一次运行状态
-    if (systemUptime % 3600 == 0) {
-      Serial.printf("📊 系统运行时间: %lu小时 %lu分钟\n", 
-                    systemUptime / 3600, (systemUptime % 3600) / 60);
-      Serial.printf("   空闲内存: %d bytes\n", ESP.getFreeHeap());
+
+  // WiFi 断线/重连：只更新屏幕提示，不阻塞
+  if (events & EV_WIFI) {
+    showWiFiStatus();
+  }
+
+  // 每小时输出一次运行状态
+  if (events & EV_STATUS) {
+    systemUptime = millis() / 1000;  // 运行时间(秒)
+    Serial.printf("📊 系统运行时间: %lu小时 %lu分钟\n",
+                  systemUptime / 3600, (systemUptime % 3600) / 60);
+    Serial.printf("   空闲内存: %d bytes\n", ESP.getFreeHeap());
+    heapStatsLog();
+    Serial.printf("   遥测上报: 采样 %lu 条，上报 %lu 条\n",
+                  (unsigned long)telemetryCompressor.inputCount(), (unsigned long)telemetryCompressor.outputCount());
+    if (history.ready()) {
+      Serial.printf("   历史记录: 原始 %lu 条/%lu B，分钟 %lu 条/%lu B，小时 %lu 条/%lu B\n",
+                    (unsigned long)history.records(HISTORY_RES_RAW), (unsigned long)history.bytesUsed(HISTORY_RES_RAW),
+                    (unsigned long)history.records(HISTORY_RES_MINUTE), (unsigned long)history.bytesUsed(HISTORY_RES_MINUTE),
+                    (unsigned long)history.records(HISTORY_RES_HOUR), (unsigned long)history.bytesUsed(HISTORY_RES_HOUR));
     }
   }
 
   // NTP时间同步（每天同步一次）
   // 注意：ESP32在首次configTime后会自动维护系统时间
   // 定期重新调用configTime可以校正时间漂移
-  if (currentTime - lastNTPSyncTime >= ntpSyncInterval) {
+  if (events & EV_NTP_SYNC) {
     configTime(gmtOffset_sec, daylightOffset_sec, ntpServer);
-    lastNTPSyncTime = currentTime;
     Serial.println("🕒 NTP时间已重新同步");
   }
 
+  // SNTP 完成同步：系统时间可能被校正（热启动时是复位前保存的时间），重新计算定时事件
+  if (events & EV_TIME_SYNC) {
+    bootPhase(BOOT_PHASE_TIME);
+    scheduleTraceTimeSync(time(nullptr));
+    eventLoopSignal(EV_SCHEDULE);
+    events |= EV_CLOCK;
+  }
+
+  // 定时空调事件到期（或规则更新）
+  if (events & EV_SCHEDULE) {
+    runACSchedule();
+  }
+
   // 更新时钟显示
-  if (currentTime - lastClockRefreshTime >= clockRefreshInterval) {
-    lastClockRefreshTime = currentTime;
-    updateClock();
+  if (events & EV_CLOCK) {
+    if (clockTick) {
+      healthNoteClockLateness(clockLatenessMs());
+    }
+    time_t now = time(nullptr);
+    updateClock(now);
+    bootSaveTime(now);
+    scheduleTraceClock(now);
   }
 
   // 更新温湿度显示
-  if (currentTime - lastTempRefreshTime >= tempRefreshInterval) {
-    lastTempRefreshTime = currentTime;
+  if (events & EV_TEMP) {
     updateTempHumi();
+  }
 
-    // 定时上传数据到服务器
-    if (currentTime - lastUploadTime >= uploadInterval) {
-      lastUploadTime = currentTime;
-      feedWatchdog();
-      // 使用缓存的温度值，避免重复读取
-      if (temperatureCacheValid) {
-        uploadData(cachedTemperature, dht.readHumidity());
-      } else {
-        Serial.println("⚠️ 温度缓存无效，跳过上传");
-      }
+  // 定时记录遥测数据（入队即返回，不阻塞主循环）
+  if (events & EV_TELEMETRY) {
+    // 使用采集任务的最新滤波读数，避免重复读取传感器
+    SensorSample sample;
+    bool hasSample = sensorLatest(sample);
+    if (hasSample) {
+      recordTelemetry(sample);
     }
+    scheduleTraceSample(hasSample, sample.temperature, sample.humidity);
   }
 
-  // 短暂延时，避免CPU满载
-  delay(10);
-}
\ No newline at end of file
+  // 把本轮绘制的脏区域一次性交给刷新任务（非阻塞）
+  if (events) {
+    panelDMA.requestFlush();
+    healthLoopEnd(busyStart);
+  }
+}
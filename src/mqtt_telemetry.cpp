@@ -0,0 +1,147 @@
+// ============================================================================
+// MQTT 遥测通道实现
+// ============================================================================
+#include "mqtt_telemetry.h"
+#include <ArduinoJson.h>
+#include "wire_codec.h"
+
+static PubSubClient* mqtt = nullptr;
+static TelemetryQueue* telemetry = nullptr;
+
+static const MqttTopics* topics = nullptr;
+
+static TelemetryRecord batch[MQTT_TELEMETRY_BATCH_MAX];
+static char payload[MQTT_TELEMETRY_BATCH_MAX * 64 + 32];
+static WireFormat batchFormat = WIRE_FORMAT_JSON;
+
+static uint32_t inFlightSeq = 0;   // 已发送未应答批次的最后序号，0 表示没有
+static uint32_t ackDeadline = 0;
+static uint32_t lastSendMs = 0;
+static uint32_t nextSendMs = 0;    // 超时退避期间不早于该时间重发
+static uint32_t backoffMs = 0;
+static bool sendNow = false;
+
+void mqttTelemetryBegin(PubSubClient& client, TelemetryQueue& queue, const MqttTopics& deviceTopics) {
+  mqtt = &client;
+  telemetry = &queue;
+  topics = &deviceTopics;
+}
+
+void mqttTelemetryOnConnect() {
+  mqtt->subscribe(topics->telemetryAck, 1);
+  Serial.printf("   订阅主题: %s\n", topics->telemetryAck);
+
+  // 断线前未应答的批次在新连接上立即重发。服务器不按序号去重：应答在断线时丢失的批次
+  // 会被再次送达（同一 seq、同一时间戳），保存记录的接收端需要按 (设备, t) 去重
+  inFlightSeq = 0;
+  sendNow = true;
+  batchFormat = WIRE_FORMAT_JSON;
+}
+
+bool mqttTelemetryHandleMessage(const char* topic, const uint8_t* data, unsigned int length) {
+  if (topics == nullptr || strcmp(topic, topics->telemetryAck) != 0) {
+    return false;
+  }
+
+  uint32_t seq = 0;
+  if (wireIsFrame(data, length)) {
+    if (!wireDecodeAck(data, length, seq)) {
+      Serial.println("❌ 遥测应答帧无效");
+      return true;
+    }
+  } else {
+    StaticJsonDocument<64> doc;
+    if (deserializeJson(doc, data, length)) {
+      Serial.println("❌ 遥测应答解析失败");
+      return true;
+    }
+    seq = doc["seq"] | 0;
+  }
+  if (seq == 0) {
+    return true;
+  }
+  batchFormat = wireFormatOf(data, length);
+
+  telemetry->commit(seq);
+  if (inFlightSeq != 0 && seq >= inFlightSeq) {
+    inFlightSeq = 0;
+    backoffMs = 0;
+    // 还有积压时不等下一个周期，继续发送
+    sendNow = telemetry->pending() > 0;
+  }
+  return true;
+}
+
+static bool publishBatch() {
+  size_t n = telemetry->peek(batch, MQTT_TELEMETRY_BATCH_MAX);
+  if (n == 0) {
+    return true;
+  }
+  size_t len = batchFormat == WIRE_FORMAT_BINARY
+                   ? wireEncodeBatch((uint8_t*)payload, sizeof(payload), batch, n)
+                   : telemetryToJson(payload, sizeof(payload), batch, n);
+  if (len == 0) {
+    return false;
+  }
+
+  // 流式发布，不受 PubSubClient 内部缓冲区大小限制
+  if (!mqtt->beginPublish(topics->telemetry, len, false)) {
+    return false;
+  }
+  mqtt->write((const uint8_t*)payload, len);
+  if (!mqtt->endPublish()) {
+    return false;
+  }
+
+  const TelemetryRecord& last = batch[n - 1];
+  int latestLen = snprintf(payload, sizeof(payload),
+                           "{\"seq\":%lu,\"t\":%lu,\"temperature\":%.1f,\"humidity\":%.1f}",
+                           (unsigned long)last.seq, (unsigned long)last.timestamp,
+                           last.temperature / 10.0f, last.humidity / 10.0f);
+  mqtt->publish(topics->telemetryLatest, (const uint8_t*)payload, latestLen, true);
+
+  inFlightSeq = last.seq;
+  ackDeadline = millis() + MQTT_TELEMETRY_ACK_TIMEOUT;
+  return true;
+}
+
+void mqttTelemetryService() {
+  if (mqtt == nullptr || !mqtt->connected()) {
+    return;
+  }
+  uint32_t now = millis();
+
+  if (inFlightSeq != 0) {
+    if ((int32_t)(now - ackDeadline) < 0) {
+      return;
+    }
+    // 应答超时：退避后重发同一批（记录仍在队列中）
+    backoffMs = backoffMs ? backoffMs * 2 : MQTT_TELEMETRY_ACK_TIMEOUT;
+    if (backoffMs > MQTT_TELEMETRY_BACKOFF_MAX) {
+      backoffMs = MQTT_TELEMETRY_BACKOFF_MAX;
+    }
+    Serial.printf("⚠️ 遥测应答超时，积压 %u 条，%lu 秒后重发\n",
+                  (unsigned)telemetry->pending(), (unsigned long)(backoffMs / 1000));
+    inFlightSeq = 0;
+    nextSendMs = now + backoffMs;
+    return;
+  }
+
+  if ((int32_t)(now - nextSendMs) < 0) {
+    return;
+  }
+  size_t pending = telemetry->pending();
+  if (pending == 0) {
+    return;
+  }
+  if (!sendNow && pending < MQTT_TELEMETRY_BATCH_MAX && now - lastSendMs < MQTT_TELEMETRY_INTERVAL) {
+    return;
+  }
+
+  sendNow = false;
+  lastSendMs = now;
+  if (!publishBatch()) {
+    Serial.println("❌ 遥测发布失败");
+    nextSendMs = now + MQTT_TELEMETRY_ACK_TIMEOUT;
+  }
+}
@@ -0,0 +1,35 @@
+// ============================================================================
+// MQTT 遥测通道
+// 功能：复用 mqttTask 已经建立的 MQTT 长连接发送 TelemetryQueue 中的记录，
+//       不再为每批数据单独建立 HTTP 连接。主题都在设备命名空间 <prefix> 下：
+//         <prefix>/telemetry         批量数据（JSON 格式同 HTTP 上传，或二进制 BATCH 帧）
+//         <prefix>/telemetry/latest  最新一条读数（retained JSON，新订阅者无需协商即可解析）
+//         <prefix>/telemetry/ack     服务器应答 {"seq":N} 或二进制 ACK 帧，收到后才从队列删除
+//       批量数据的格式跟随服务器最近一次应答：应答为二进制帧时改发二进制（见 wire_codec.h），
+//       每次重新连接先恢复为 JSON
+//       PubSubClient 只能以 QoS 0 发布，"至少一次"由应用层应答 + 超时重发保证；
+//       服务器不去重，应答丢失后重发的记录会重复送达
+// 注意：所有函数只能在 mqttTask 中调用（PubSubClient 不是线程安全的）
+// ============================================================================
+#pragma once
+
+#include <Arduino.h>
+#include <PubSubClient.h>
+#include "mqtt_topics.h"
+#include "telemetry_queue.h"
+
+#define MQTT_TELEMETRY_BATCH_MAX     16      // 每条消息的最大记录数
+#define MQTT_TELEMETRY_INTERVAL      30000   // 正常情况下的发送周期
+#define MQTT_TELEMETRY_ACK_TIMEOUT   15000   // 等待服务器应答的时间，超时后重发
+#define MQTT_TELEMETRY_BACKOFF_MAX   300000  // 连续超时的重发间隔上限
+
+void mqttTelemetryBegin(PubSubClient& client, TelemetryQueue& queue, const MqttTopics& deviceTopics);
+
+// 每次 MQTT 连接成功后调用：订阅应答主题，并重发未应答的批次
+void mqttTelemetryOnConnect();
+
+// 在 mqttCallback 开头调用，是遥测应答时返回 true
+bool mqttTelemetryHandleMessage(const char* topic, const uint8_t* payload, unsigned int length);
+
+// 在 mqttTask 循环中 mqttClient.loop() 之后调用
+void mqttTelemetryService();
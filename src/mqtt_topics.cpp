@@ -0,0 +1,32 @@
+// ============================================================================
+// 设备 MQTT 主题布局实现
+// ============================================================================
+#include "mqtt_topics.h"
+#include <stdio.h>
+#include <string.h>
+
+static bool validSegment(const char* s) {
+  return s != nullptr && s[0] != '\0' && strpbrk(s, "+#") == nullptr;
+}
+
+static bool join(char* buf, size_t size, const char* prefix, const char* suffix) {
+  int n = snprintf(buf, size, "%s/%s", prefix, suffix);
+  return n > 0 && (size_t)n < size;
+}
+
+bool mqttTopicsInit(MqttTopics& out, const char* ns, const char* deviceId) {
+  if (!validSegment(ns) || !validSegment(deviceId) || strchr(deviceId, '/') != nullptr) {
+    return false;
+  }
+  return join(out.prefix, sizeof(out.prefix), ns, deviceId) &&
+         join(out.availability, sizeof(out.availability), out.prefix, "status") &&
+         join(out.codec, sizeof(out.codec), out.prefix, "codec") &&
+         join(out.control, sizeof(out.control), out.prefix, "ac/control") &&
+         join(out.commandAck, sizeof(out.commandAck), out.prefix, "ac/ack") &&
+         join(out.schedule, sizeof(out.schedule), out.prefix, "ac/schedule") &&
+         join(out.scheduleStatus, sizeof(out.scheduleStatus), out.prefix, "ac/schedule/status") &&
+         join(out.health, sizeof(out.health), out.prefix, "health") &&
+         join(out.telemetry, sizeof(out.telemetry), out.prefix, "telemetry") &&
+         join(out.telemetryLatest, sizeof(out.telemetryLatest), out.prefix, "telemetry/latest") &&
+         join(out.telemetryAck, sizeof(out.telemetryAck), out.prefix, "telemetry/ack");
+}
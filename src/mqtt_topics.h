@@ -0,0 +1,42 @@
+// ============================================================================
+// 设备 MQTT 主题布局
+// 功能：设备的全部主题都从 <namespace>/<deviceId> 派生，多台设备共用一个 broker 时互不干扰：
+//         status                 retained "online"/"offline"（遗嘱消息）
+//         codec                  retained 编码能力声明
+//         ac/control             空调指令
+//         ac/ack                 指令应答
+//         ac/schedule            定时空调开关和规则
+//         ac/schedule/status     定时空调状态（心跳和确认）
+//         health                 运行健康数据
+//         telemetry[/latest|/ack] 遥测批次、最新读数、服务器应答
+//       单机部署时的全局主题（office/ac/control、office/ac/schedule/*）单独定义，
+//       由固件按需同时订阅；固件和主机上的设备群模拟器共用本模块
+// ============================================================================
+#pragma once
+
+#include <stddef.h>
+
+#define MQTT_PREFIX_MAX 64
+#define MQTT_TOPIC_MAX  96
+
+// 单机部署的全局主题：所有订阅它的设备都会执行
+#define MQTT_LEGACY_CONTROL_TOPIC  "office/ac/control"
+#define MQTT_LEGACY_SCHEDULE_TOPIC "office/ac/schedule/enabled"
+#define MQTT_LEGACY_STATUS_TOPIC   "office/ac/schedule/status"
+
+struct MqttTopics {
+  char prefix[MQTT_PREFIX_MAX];
+  char availability[MQTT_TOPIC_MAX];
+  char codec[MQTT_TOPIC_MAX];
+  char control[MQTT_TOPIC_MAX];
+  char commandAck[MQTT_TOPIC_MAX];
+  char schedule[MQTT_TOPIC_MAX];
+  char scheduleStatus[MQTT_TOPIC_MAX];
+  char health[MQTT_TOPIC_MAX];
+  char telemetry[MQTT_TOPIC_MAX];
+  char telemetryLatest[MQTT_TOPIC_MAX];
+  char telemetryAck[MQTT_TOPIC_MAX];
+};
+
+// 生成 <ns>/<deviceId>/... 的全部主题；名称过长或含 MQTT 通配符时返回 false
+bool mqttTopicsInit(MqttTopics& out, const char* ns, const char* deviceId);
@@ -0,0 +1,481 @@
+// ============================================================================
+// 主机基准：界面刷新与控制/协议路径
+// 功能：在开发机上单独运行 updateClock()、updateTempHumi()、定时空调规则
+//       、JSON/二进制报文编解码、设备端历史和变化上报，报告每次耗时、每帧推送到屏幕的字节数和堆分配次数
+// 运行：pio run -e native && .pio/build/native/program [迭代次数]
+// ============================================================================
+#include <Arduino.h>
+#include <chrono>
+#include <new>
+#include "native_hal.h"
+#include "../display.h"
+#include "../ac_control.h"
+#include "../ir_dispatcher.h"
+#include "../sensor_task.h"
+#include "../telemetry_format.h"
+#include "../wire_codec.h"
+#include "../lockfree.h"
+#include "../history_store.h"
+#include "../telemetry_compressor.h"
+
+// ========================== 堆分配统计 ==========================
+// String 等 Arduino 类型都经由 operator new 分配，统计它即可反映设备上的分配次数
+static uint64_t allocCount = 0;
+static uint64_t allocBytes = 0;
+
+void* operator new(size_t size) {
+  allocCount++;
+  allocBytes += size;
+  void* p = malloc(size ? size : 1);
+  if (p == nullptr) {
+    throw std::bad_alloc();
+  }
+  return p;
+}
+void* operator new[](size_t size) { return operator new(size); }
+void operator delete(void* p) noexcept { free(p); }
+void operator delete[](void* p) noexcept { free(p); }
+void operator delete(void* p, size_t) noexcept { free(p); }
+void operator delete[](void* p, size_t) noexcept { free(p); }
+
+// ========================== 基准框架 ==========================
+static MemoryPanel panel;
+static uint32_t iterations = 2000;
+
+struct BenchResult {
+  double nsPerOp;
+  double allocsPerOp;
+  double allocBytesPerOp;
+  double spiBytesPerFrame;   // 未涉及屏幕的基准为 0
+  double rectsPerFrame;
+};
+
+static void printHeader() {
+  printf("%-28s %12s %10s %12s %14s %10s\n",
+         "benchmark", "ns/op", "allocs/op", "allocB/op", "spiB/frame", "rects");
+}
+
+static void printResult(const char* name, const BenchResult& r) {
+  printf("%-28s %12.0f %10.2f %12.1f %14.0f %10.2f\n",
+         name, r.nsPerOp, r.allocsPerOp, r.allocBytesPerOp, r.spiBytesPerFrame, r.rectsPerFrame);
+}
+
+// fn(i) 执行第 i 次操作；涉及绘制的基准每次操作后刷新一次内存屏幕
+template <typename Fn>
+static BenchResult runBench(const char* name, uint32_t n, bool flushPanel, Fn fn) {
+  // 预热：填满字形缓存、清掉初始化留下的脏区域
+  for (uint32_t i = 0; i < 8; i++) {
+    fn(i);
+  }
+  panel.flush(frameBuffer);
+  panel.resetStats();
+
+  uint64_t allocStart = allocCount;
+  uint64_t allocBytesStart = allocBytes;
+  auto start = std::chrono::steady_clock::now();
+  for (uint32_t i = 0; i < n; i++) {
+    fn(i + 8);
+    if (flushPanel) {
+      panel.flush(frameBuffer);
+    }
+  }
+  auto elapsed = std::chrono::steady_clock::now() - start;
+
+  BenchResult r;
+  r.nsPerOp = (double)std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count() / n;
+  r.allocsPerOp = (double)(allocCount - allocStart) / n;
+  r.allocBytesPerOp = (double)(allocBytes - allocBytesStart) / n;
+  r.spiBytesPerFrame = flushPanel ? (double)panel.stats().spiBytes / n : 0;
+  r.rectsPerFrame = flushPanel ? (double)panel.stats().rects / n : 0;
+  printResult(name, r);
+  return r;
+}
+
+// ========================== 场景 ==========================
+// 2026-01-05 是周一；设备时区 CST-8
+static const time_t BASE_TIME = 1767571140;  // 2026-01-05 07:59:00 +08:00
+
+static const SensorScriptStep sensorSteps[] = {
+  {0,      15.8f, 45.0f},
+  {20000,  16.1f, 46.5f},
+  {40000,  NAN,   NAN},    // 读取失败，滤波器应拒绝
+  {45000,  16.4f, 47.0f},
+  {60000,  16.0f, 46.0f},
+};
+
+static void setupDisplay() {
+  frameBuffer.begin(nullptr);
+  initGlyphCaches();
+  initTempHumiUI();
+  updateClock(BASE_TIME);
+  panel.flush(frameBuffer);
+}
+
+static void benchRender() {
+  // 逐秒走时：绝大多数帧只有秒位变化
+  runBench("updateClock/second", iterations, true, [](uint32_t i) {
+    nativeAdvanceMillis(1000);
+    updateClock(BASE_TIME + i);
+  });
+
+  // 跨日：日期、星期和全部时钟位同时变化（每次操作在 23:59:59 与次日 00:00:00 之间切换）
+  runBench("updateClock/day-rollover", iterations, true, [](uint32_t i) {
+    nativeAdvanceMillis(1000);
+    time_t midnight = BASE_TIME + 60 + 16 * 3600 + (time_t)(i / 2) * 86400;
+    updateClock(midnight - 1 + (i & 1));
+  });
+
+  // 温湿度区域：传感器每 2.5 秒出一个新读数，按设备上的 5 秒周期刷新
+  runBench("updateTempHumi", iterations, true, [](uint32_t i) {
+    nativeAdvanceMillis(5000);
+    updateTempHumi();
+  });
+
+  // 每次读数都变化（0.1°C / 0.1% 交替，宽度不变）：只重绘两个数值控件
+  runBench("drawTempHumi/changing", iterations, true, [](uint32_t i) {
+    nativeAdvanceMillis(5000);
+    SensorSample sample;
+    sample.temperature = (i & 1) ? 16.1f : 16.2f;
+    sample.humidity = (i & 1) ? 46.5f : 46.6f;
+    drawTempHumi(&sample);
+  });
+}
+
+static AcSchedule schedule;
+
+static void benchControl() {
+  // 计算下一个事件（每次设置定时器时调用一次）
+  runBench("acSchedule/next", iterations * 10, false, [](uint32_t i) {
+    AcScheduleEvent next;
+    if (!schedule.next(BASE_TIME + (time_t)i * 97, next)) {
+      printf("acSchedule.next: 没有事件\n");
+      exit(1);
+    }
+  });
+
+  // 8:00 定时器到期：找出到期事件 + 温度判断 + 经假串口发送红外命令
+  runBench("acSchedule/due+irSubmit", iterations * 10, false, [](uint32_t i) {
+    AcScheduleEvent event;
+    if (schedule.latestDue(BASE_TIME, BASE_TIME + 60, event)) {
+      SensorSample sample;
+      float temperature = sensorLatest(sample) ? sample.temperature : 15.0f;
+      const char* command = acIRCommand(schedule.actionFor(event, temperature));
+      if (command != nullptr) {
+        irSubmit(command, IR_KIND_AC_POWER);
+      }
+    }
+  });
+}
+
+// MQTT/HTTP 报文：每个 JSON 路径后紧跟对应的二进制帧（wire/*），最后汇总两者的字节数
+static void benchJson() {
+  static const char onPayload[] = "{\"action\":\"on\",\"id\":42,\"ts\":1700000000123}";
+  runBench("parseACCommand", iterations * 10, false, [](uint32_t i) {
+    AcCommand command;
+    volatile bool ok = parseACCommand((const uint8_t*)onPayload, sizeof(onPayload) - 1, command);
+    (void)ok;
+  });
+  static uint8_t onFrame[WIRE_OVERHEAD + WIRE_COMMAND_SIZE];
+  static const AcCommand onCommand = {AC_ACTION_ON, 42, 1700000000123ULL};
+  static size_t onFrameLen = wireEncodeCommand(onFrame, sizeof(onFrame), onCommand);
+  runBench("wire/decodeCommand", iterations * 10, false, [](uint32_t i) {
+    AcCommand command;
+    if (!wireDecodeCommand(onFrame, onFrameLen, command) || command.action != AC_ACTION_ON ||
+        command.id != 42 || command.sentMs != 1700000000123ULL) {
+      printf("wireDecodeCommand: 解码失败\n");
+      exit(1);
+    }
+  });
+
+  // 指令应答：JSON 与 AC_ACK 帧
+  static const AcCommandAck commandAck = {42, AC_ACTION_ON, AC_RESULT_ACKED, 1700000000123ULL, 1700000000180ULL, 3, 41};
+  static char commandAckJson[192];
+  static size_t commandAckJsonLen = 0;
+  runBench("acCommandAckJson", iterations * 10, false, [](uint32_t i) {
+    commandAckJsonLen = acCommandAckJson(commandAckJson, sizeof(commandAckJson), commandAck);
+    if (commandAckJsonLen == 0) {
+      printf("acCommandAckJson: 缓冲区不足\n");
+      exit(1);
+    }
+  });
+  static uint8_t commandAckFrame[WIRE_OVERHEAD + WIRE_COMMAND_ACK_SIZE];
+  static size_t commandAckFrameLen = 0;
+  runBench("wire/encodeCommandAck", iterations * 10, false, [](uint32_t i) {
+    commandAckFrameLen = wireEncodeCommandAck(commandAckFrame, sizeof(commandAckFrame), commandAck);
+    AcCommandAck decoded;
+    if (!wireDecodeCommandAck(commandAckFrame, commandAckFrameLen, decoded) || decoded.id != 42 ||
+        decoded.receivedMs != commandAck.receivedMs || decoded.irAckMs != 41) {
+      printf("wireDecodeCommandAck: 解码失败\n");
+      exit(1);
+    }
+  });
+
+  static const char ackPayload[] = "{\"seq\":1031}";
+  static uint8_t ackFrame[16];
+  static size_t ackFrameLen = wireEncodeAck(ackFrame, sizeof(ackFrame), 1031);
+  runBench("wire/decodeAck", iterations * 10, false, [](uint32_t i) {
+    uint32_t seq = 0;
+    if (!wireDecodeAck(ackFrame, ackFrameLen, seq) || seq != 1031) {
+      printf("wireDecodeAck: 解码失败\n");
+      exit(1);
+    }
+  });
+
+  static TelemetryRecord records[32];
+  for (uint32_t i = 0; i < 32; i++) {
+    records[i].seq = 1000 + i;
+    records[i].timestamp = (uint32_t)BASE_TIME + i * 5;
+    records[i].temperature = (int16_t)(255 + (i % 7));
+    records[i].humidity = (uint16_t)(650 - (i % 11));
+  }
+  static char json[4096];
+  static size_t batchJsonLen = 0;
+  runBench("telemetryToJson/32", iterations, false, [](uint32_t i) {
+    batchJsonLen = telemetryToJson(json, sizeof(json), records, 32);
+    if (batchJsonLen == 0) {
+      printf("telemetryToJson: 缓冲区不足\n");
+      exit(1);
+    }
+  });
+  static uint8_t frame[512];
+  static size_t batchFrameLen = 0;
+  runBench("wire/encodeBatch/32", iterations * 10, false, [](uint32_t i) {
+    batchFrameLen = wireEncodeBatch(frame, sizeof(frame), records, 32);
+    if (batchFrameLen == 0) {
+      printf("wireEncodeBatch: 缓冲区不足\n");
+      exit(1);
+    }
+  });
+  runBench("wire/decodeBatch/32", iterations * 10, false, [](uint32_t i) {
+    static TelemetryRecord decoded[32];
+    size_t count = 0;
+    if (!wireDecodeBatch(frame, batchFrameLen, decoded, 32, count) || count != 32 ||
+        decoded[31].seq != records[31].seq || decoded[31].temperature != records[31].temperature) {
+      printf("wireDecodeBatch: 数据不一致\n");
+      exit(1);
+    }
+  });
+
+  static const char rulesPayload[] =
+      "{\"enabled\":true,\"rules\":[{\"days\":[1,2,3,4,5],\"at\":\"08:00\",\"action\":\"on\",\"below\":17},"
+      "{\"days\":[1,2,3,4,5],\"at\":\"17:30\",\"action\":\"off\"}]}";
+  runBench("parseACSchedule", iterations * 10, false, [](uint32_t i) {
+    static AcScheduleUpdate update;
+    if (!parseACSchedule((const uint8_t*)rulesPayload, sizeof(rulesPayload) - 1, update)) {
+      printf("parseACSchedule: 解析失败\n");
+      exit(1);
+    }
+  });
+  // 与上面 JSON 内容相同的二进制帧
+  static uint8_t rulesFrame[64];
+  static size_t rulesFrameLen = 0;
+  {
+    AcScheduleUpdate update = {};
+    update.hasEnabled = true;
+    update.enabled = true;
+    update.hasRules = true;
+    update.ruleCount = 2;
+    update.rules[0] = {AC_WEEKDAYS_WORKDAY, 8, 0, AC_ACTION_ON, 170};
+    update.rules[1] = {AC_WEEKDAYS_WORKDAY, 17, 30, AC_ACTION_OFF, AC_RULE_ANY_TEMPERATURE};
+    rulesFrameLen = wireEncodeScheduleUpdate(rulesFrame, sizeof(rulesFrame), update);
+  }
+  runBench("wire/decodeSchedule", iterations * 10, false, [](uint32_t i) {
+    static AcScheduleUpdate update;
+    if (!wireDecodeScheduleUpdate(rulesFrame, rulesFrameLen, update) || update.ruleCount != 2) {
+      printf("wireDecodeScheduleUpdate: 解码失败\n");
+      exit(1);
+    }
+  });
+
+  // 与 main.cpp 中 armACSchedule() 生成的状态消息相同
+  static size_t statusJsonLen = 0;
+  runBench("scheduleStatus/json", iterations * 10, false, [](uint32_t i) {
+    char statusMessage[640];
+    statusJsonLen = schedule.statusJson(statusMessage, sizeof(statusMessage), (i & 1) != 0, BASE_TIME + 60);
+    if (statusJsonLen == 0) {
+      printf("statusJson: 缓冲区不足\n");
+      exit(1);
+    }
+  });
+  static size_t statusFrameLen = 0;
+  runBench("wire/scheduleStatus", iterations * 10, false, [](uint32_t i) {
+    uint8_t statusFrame[WIRE_SCHEDULE_STATUS_MAX];
+    statusFrameLen = wireEncodeScheduleStatus(statusFrame, sizeof(statusFrame), schedule, (i & 1) != 0, BASE_TIME + 60);
+    if (statusFrameLen == 0) {
+      printf("wireEncodeScheduleStatus: 缓冲区不足\n");
+      exit(1);
+    }
+  });
+
+  printf("\nwire bytes (json -> binary): command %u -> %u, command ack %u -> %u, ack %u -> %u, batch/32 %u -> %u, "
+         "schedule %u -> %u, status %u -> %u\n\n",
+         (unsigned)(sizeof(onPayload) - 1), (unsigned)onFrameLen,
+         (unsigned)commandAckJsonLen, (unsigned)commandAckFrameLen,
+         (unsigned)(sizeof(ackPayload) - 1), (unsigned)ackFrameLen,
+         (unsigned)batchJsonLen, (unsigned)batchFrameLen,
+         (unsigned)(sizeof(rulesPayload) - 1), (unsigned)rulesFrameLen,
+         (unsigned)statusJsonLen, (unsigned)statusFrameLen);
+}
+
+// 任务间交换：主机上是单线程，只衡量每次操作本身的开销（无竞争时的下限）
+static void benchExchange() {
+  static SpscRing<TelemetryRecord, 64> ring;
+  runBench("spscRing/push+pop", iterations * 10, false, [](uint32_t i) {
+    TelemetryRecord rec = {};
+    rec.seq = i;
+    TelemetryRecord out;
+    if (!ring.push(rec) || !ring.pop(out) || out.seq != i) {
+      printf("SpscRing: 数据不一致\n");
+      exit(1);
+    }
+  });
+
+  // 与 main.cpp 中的 AcStatus 快照大小相同
+  struct StatusSnapshot {
+    bool acOn;
+    bool scheduleEnabled;
+    char message[640];
+  };
+  static SeqLock<StatusSnapshot> status;
+  runBench("seqLock/write+read", iterations * 10, false, [](uint32_t i) {
+    static StatusSnapshot in, out;
+    in.acOn = (i & 1) != 0;
+    status.write(in);
+    status.read(out);
+    if (out.acOn != in.acOn) {
+      printf("SeqLock: 数据不一致\n");
+      exit(1);
+    }
+  });
+}
+
+// 设备端历史：先写入 2 天的 5 秒读数（原始级已滚动淘汰），再衡量追加与导出
+static void benchHistory() {
+  static HistoryStore store;
+  static uint32_t t = BASE_TIME;
+  store.begin();
+  auto sample = [](uint32_t i) {
+    store.append(t, 22.0f + (float)(i % 37) / 10.0f, 55.0f + (float)(i % 11) / 10.0f);
+    t += 5;
+  };
+  for (uint32_t i = 0; i < 2 * 86400 / 5; i++) {
+    sample(i);
+  }
+  runBench("history/append", iterations * 10, false, sample);
+
+  // 导出最近 1 小时原始记录，按一个 TCP 段大小分块
+  static uint32_t exportedBytes = 0;
+  runBench("history/export raw 1h", iterations, false, [](uint32_t i) {
+    static HistoryCursor cursor;
+    static uint8_t chunk[1436];
+    store.beginExport(cursor, HISTORY_RES_RAW, t - 3600, t);
+    exportedBytes = 0;
+    size_t n;
+    while ((n = store.exportChunk(cursor, chunk, sizeof(chunk))) > 0) {
+      exportedBytes += n;
+    }
+  });
+
+  printf("\nhistory: raw %lu rec %.2f B/rec, minute %lu rec %.2f B/rec, export 1h %lu B\n",
+         (unsigned long)store.records(HISTORY_RES_RAW),
+         (double)store.bytesUsed(HISTORY_RES_RAW) / store.records(HISTORY_RES_RAW),
+         (unsigned long)store.records(HISTORY_RES_MINUTE),
+         (double)store.bytesUsed(HISTORY_RES_MINUTE) / store.records(HISTORY_RES_MINUTE),
+         (unsigned long)exportedBytes);
+}
+
+// 办公室一天的 5 秒采样：夜间平稳（传感器噪声 ±0.1），早上升温，9 点开空调阶跃降温，下班后回升
+static TelemetryPoint officeDay(uint32_t i) {
+  const uint32_t perHour = 3600 / 5;
+  float hour = (float)(i % (24 * perHour)) / perHour;
+  float temperature = 16.0f;
+  if (hour >= 7.0f && hour < 9.0f) {
+    temperature += (hour - 7.0f) * 4.0f;
+  } else if (hour >= 9.0f && hour < 18.0f) {
+    temperature = 24.0f - 2.0f * fminf(hour - 9.0f, 0.5f) * 2.0f;
+  } else if (hour >= 18.0f) {
+    temperature = 22.0f - (hour - 18.0f) * 1.0f;
+  }
+  float humidity = 45.0f + (hour >= 9.0f && hour < 18.0f ? 8.0f : 0.0f);
+  // 传感器量化到 0.1，加上 ±0.1 的确定性噪声
+  temperature = roundf(temperature * 10.0f + (float)((i * 7) % 3) - 1.0f) / 10.0f;
+  humidity = roundf(humidity * 10.0f + (float)((i * 3) % 5) - 2.0f) / 10.0f;
+  return TelemetryPoint{i * 5000, (uint32_t)BASE_TIME + i * 5, temperature, humidity};
+}
+
+// 变化上报：压缩一天的采样，再用相邻上报点线性插值重建，检查每个采样时刻的误差
+static void benchCompressor() {
+  static TelemetryCompressor compressor;
+  static TelemetryPoint reports[2];
+  runBench("compressor/push", iterations * 10, false, [](uint32_t i) {
+    compressor.push(officeDay(i), reports);
+  });
+
+  const uint32_t samples = 24 * 3600 / 5;
+  static TelemetryPoint input[24 * 3600 / 5];
+  static TelemetryPoint output[24 * 3600 / 5 + 2];
+  TelemetryCompressor day;
+  uint32_t outCount = 0;
+  for (uint32_t i = 0; i < samples; i++) {
+    input[i] = officeDay(i);
+    outCount += day.push(input[i], output + outCount);
+  }
+  // 最后一个采样点之后还没有上报的段：服务器看到的是最后一个上报点，只检查已上报的区间
+  float maxTempError = 0, maxHumiError = 0;
+  uint32_t seg = 0;
+  for (uint32_t i = 0; i < samples && input[i].timestampMs <= output[outCount - 1].timestampMs; i++) {
+    while (seg + 1 < outCount && output[seg + 1].timestampMs < input[i].timestampMs) {
+      seg++;
+    }
+    const TelemetryPoint& a = output[seg];
+    const TelemetryPoint& b = output[seg + 1 < outCount ? seg + 1 : seg];
+    float f = b.timestampMs == a.timestampMs ? 0.0f
+              : (float)(input[i].timestampMs - a.timestampMs) / (float)(b.timestampMs - a.timestampMs);
+    maxTempError = fmaxf(maxTempError, fabsf(a.temperature + f * (b.temperature - a.temperature) - input[i].temperature));
+    maxHumiError = fmaxf(maxHumiError, fabsf(a.humidity + f * (b.humidity - a.humidity) - input[i].humidity));
+  }
+  const TelemetryCompressorConfig& cfg = day.config();
+  printf("\ncompressor: %lu samples -> %lu reports (%.1fx), max error temp %.3f (E %.2f) humi %.3f (E >= %.2f)\n",
+         (unsigned long)samples, (unsigned long)outCount, (double)samples / outCount,
+         maxTempError, cfg.temperature.absolute, maxHumiError, cfg.humidity.absolute);
+  if (maxTempError > cfg.temperature.absolute + 1e-3f ||
+      maxHumiError > fmaxf(cfg.humidity.absolute, cfg.humidity.relative * 100.0f) + 1e-3f) {
+    printf("TelemetryCompressor: 重建误差超出死区\n");
+    exit(1);
+  }
+}
+
+int main(int argc, char** argv) {
+  if (argc > 1) {
+    iterations = (uint32_t)strtoul(argv[1], nullptr, 10);
+    if (iterations == 0) {
+      iterations = 1;
+    }
+  }
+
+  setenv("TZ", "CST-8", 1);
+  tzset();
+
+  nativeSetMillis(0);
+  nativeSensorScript(sensorSteps, sizeof(sensorSteps) / sizeof(sensorSteps[0]));
+  sensorTaskBegin();
+  nativeAdvanceMillis(SENSOR_SAMPLE_INTERVAL * 3);
+
+  Serial2.setAutoReply("OK\r\n");
+  irDispatcherBegin(Serial2, 16, 17, 115200);
+
+  setupDisplay();
+
+  printf("ST7789 host benchmark (%lu iterations)\n", (unsigned long)iterations);
+  printHeader();
+  benchRender();
+  benchControl();
+  benchJson();
+  benchExchange();
+  benchHistory();
+  benchCompressor();
+
+  printf("\nIR: sent=%lu acked=%lu\n",
+         (unsigned long)nativeIrSentCount(), (unsigned long)nativeIrAckedCount());
+  return 0;
+}
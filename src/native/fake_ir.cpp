@@ -0,0 +1,62 @@
+// ============================================================================
+// 主机构建 HAL：同步假红外调度
+// 功能：与 ir_dispatcher 相同的接口；命令直接写入假串口，
+//       响应取自串口自动回复，完成回调在 irSubmit 返回前调用
+// ============================================================================
+#include "native_hal.h"
+#include "../ir_dispatcher.h"
+
+static HardwareSerial* irSerial = nullptr;
+static uint32_t nextId = 1;
+static uint32_t sentCount = 0;
+static uint32_t ackedCount = 0;
+
+bool irDispatcherBegin(HardwareSerial& serial, int8_t rxPin, int8_t txPin, uint32_t baud) {
+  irSerial = &serial;
+  irSerial->begin(baud, SERIAL_8N1, rxPin, txPin);
+  return true;
+}
+
+uint32_t irSubmit(const char* command, IrCommandKind kind,
+                  IrCompletionCallback callback, void* ctx) {
+  if (irSerial == nullptr || command == nullptr || strlen(command) >= IR_COMMAND_MAX_LEN) {
+    return 0;
+  }
+
+  IrResult result;
+  memset(&result, 0, sizeof(result));
+  result.id = nextId++;
+  strncpy(result.command, command, IR_COMMAND_MAX_LEN - 1);
+  result.queuedMs = millis();
+  result.sentMs = result.queuedMs;
+
+  while (irSerial->available() > 0) {
+    irSerial->read();
+  }
+  irSerial->println(command);
+  sentCount++;
+
+  size_t n = 0;
+  while (irSerial->available() > 0 && n < IR_RESPONSE_MAX_LEN - 1) {
+    result.response[n++] = (char)irSerial->read();
+  }
+  result.acked = n > 0;
+  result.ackMs = millis();
+  if (result.acked) {
+    ackedCount++;
+  }
+
+  if (callback) {
+    callback(result, ctx);
+  }
+  return result.id;
+}
+
+void nativeIrReset() {
+  nextId = 1;
+  sentCount = 0;
+  ackedCount = 0;
+}
+
+uint32_t nativeIrSentCount() { return sentCount; }
+uint32_t nativeIrAckedCount() { return ackedCount; }
@@ -0,0 +1,174 @@
+// ============================================================================
+// 设备群模拟器
+// 功能：在一台开发机上运行 N 个虚拟设备，连接本地 mosquitto 和内置的 HTTP 接收端，
+//       评估设备数量增长后 broker 和服务器需要承受的负载。每个虚拟设备使用固件自己的协议代码：
+//         主题布局      mqtt_topics（<namespace>/<deviceId>/...）
+//         指令与应答    parseACCommand / wireDecodeCommand → acCommandAckJson / wireEncodeCommandAck
+//         定时状态心跳  AcSchedule::statusJson，每 60 秒一次，规则更新后立即确认
+//         遥测          TelemetryCompressor 变化上报 + telemetryToJson 批次，
+//                       经 MQTT（等待 {"seq"} 应答）或 HTTP POST /update 上传
+//       控制端代替 server.js：按设定速率向随机设备发指令并统计发布→应答延迟，同时应答遥测批次。
+//       可在指定时刻让所有设备同时断线，按固件的固定重连间隔观察重连风暴
+// 运行：pio run -e fleet && .pio/build/fleet/program --devices 1000 --duration 120
+// ============================================================================
+#pragma once
+
+#include <Arduino.h>
+#include <netinet/in.h>
+#include <poll.h>
+#include <deque>
+#include <vector>
+#include "mqtt_conn.h"
+#include "fleet_http.h"
+#include "../../ac_control.h"
+#include "../../mqtt_topics.h"
+#include "../../telemetry_compressor.h"
+#include "../../telemetry_format.h"
+#include "../../wire_codec.h"
+
+// 与固件一致的时序（main.cpp、mqtt_telemetry.h、telemetry_uploader.h）
+#define FLEET_SAMPLE_MS            5000    // telemetryInterval
+#define FLEET_STATUS_MS            60000   // 定时状态心跳
+#define FLEET_RECONNECT_MS         5000    // MQTT_RECONNECT_MS
+#define FLEET_CONNECT_TIMEOUT_MS   5000    // PubSubClient setSocketTimeout(5000)
+#define FLEET_KEEPALIVE_SEC        15      // PubSubClient 默认保活
+#define FLEET_MQTT_BATCH_MAX       16      // MQTT_TELEMETRY_BATCH_MAX
+#define FLEET_MQTT_INTERVAL        30000   // MQTT_TELEMETRY_INTERVAL
+#define FLEET_MQTT_ACK_TIMEOUT     15000   // MQTT_TELEMETRY_ACK_TIMEOUT
+#define FLEET_HTTP_BATCH_MAX       32      // TELEMETRY_BATCH_MAX
+#define FLEET_HTTP_INTERVAL        30000   // TELEMETRY_UPLOAD_INTERVAL
+#define FLEET_HTTP_BACKOFF_MIN_MS  2000    // TELEMETRY_BACKOFF_MIN_MS
+#define FLEET_BACKOFF_MAX_MS       300000  // 两条通道的退避上限
+#define FLEET_QUEUE_MAX            4096    // 每个设备积压的遥测记录上限，超过后丢弃最旧的
+
+struct FleetConfig {
+  uint32_t devices;
+  sockaddr_in broker;
+  sockaddr_in receiver;     // HTTP 遥测的目标
+  bool httpTelemetry;       // false = 遥测走 MQTT
+  bool binary;              // 控制端使用二进制帧（指令、遥测应答），见 wire_codec.h
+  const char* ns;           // 主题命名空间
+  const char* idPrefix;     // 设备 ID 为 <idPrefix>-00001 ...
+  uint32_t durationSec;
+  uint32_t rampMs;          // 启动时把首次连接均匀分散到这段时间内
+  double commandRate;       // 控制端每秒发出的指令数（所有设备合计）
+  int32_t stormAtSec;       // 该时刻所有设备同时断线，-1 为不模拟
+  uint32_t reconnectJitterMs;  // 重连间隔额外加 [0, jitter) 的随机量（固件为 0）
+  uint32_t irDispatchMs;    // 模拟的红外调度和模块响应时间
+  uint32_t irAckMs;
+};
+
+// 延迟样本，结束时排序取百分位
+class LatencyRecorder {
+ public:
+  void add(uint32_t ms) {
+    samples.push_back(ms);
+    sorted = false;
+  }
+  size_t count() const { return samples.size(); }
+  // p 为 0～100；没有样本时返回 0
+  uint32_t percentile(double p);
+  void clear() { samples.clear(); sorted = true; }
+
+ private:
+  std::vector<uint32_t> samples;
+  bool sorted = true;
+};
+
+// 所有虚拟设备共用的计数（单线程，不需要加锁）
+struct FleetStats {
+  uint64_t connectAttempts;
+  uint64_t connectFailures;   // TCP 失败、被拒绝或 CONNACK 超时
+  uint64_t connects;
+  uint64_t connectionsLost;   // 非模拟触发的断线
+  uint64_t commandsReceived;
+  uint64_t acksPublished;
+  uint64_t statusPublished;
+  uint64_t samples;
+  uint64_t recordsQueued;     // 变化上报后进入队列的记录
+  uint64_t recordsDropped;    // 积压超过 FLEET_QUEUE_MAX 丢弃的记录
+  uint64_t batchesSent;
+  uint64_t recordsAcked;
+  uint64_t telemetryTimeouts;
+  uint64_t httpFailures;
+  LatencyRecorder connectMs;     // 发起连接 → CONNACK
+  LatencyRecorder telemetryMs;   // 批次发出 → 应答（MQTT 应答消息或 HTTP 响应）
+};
+
+extern FleetStats fleetStats;
+
+class FleetDevice {
+ public:
+  FleetDevice();
+
+  bool init(uint32_t index, const FleetConfig& config, uint64_t firstConnectMs);
+
+  // 每个设备固定占两个 pollfd（MQTT、HTTP），没有连接时 fd 为 -1
+  void addPollFds(std::vector<struct pollfd>& fds) const;
+  void service(const struct pollfd* fds, uint64_t nowMs, uint64_t unixMs);
+  void tick(uint64_t nowMs, uint64_t unixMs);
+
+  // 模拟 WiFi 掉线或 broker 重启：直接关闭连接，按固件的重连间隔重试
+  void drop(uint64_t nowMs);
+
+  bool connected() const { return mqtt.connected(); }
+  const char* id() const { return deviceId; }
+  const MqttTopics& topics() const { return deviceTopics; }
+  const MqttConnCounters& mqttCounters() const { return mqtt.counters(); }
+
+ private:
+  struct PendingIr {
+    AcCommandAck ack;
+    bool binary;
+    uint64_t dueMs;
+  };
+
+  static void onMessage(void* ctx, const char* topic, const uint8_t* payload, size_t length);
+  void handleCommand(const uint8_t* payload, size_t length);
+  void handleSchedule(const uint8_t* payload, size_t length);
+  void handleTelemetryAck(const uint8_t* payload, size_t length);
+  void onConnect(uint64_t nowMs);
+  void scheduleReconnect(uint64_t nowMs);
+  void publishStatus(uint64_t unixMs);
+  void sample(uint64_t nowMs, uint64_t unixMs);
+  void serviceTelemetry(uint64_t nowMs);
+  void publishAcks(uint64_t nowMs);
+  size_t encodeBatch(size_t max, uint32_t& lastSeq);
+  void commit(uint32_t seq, uint64_t nowMs);
+  void onHttpDone(int status, uint64_t nowMs);
+
+  const FleetConfig* cfg;
+  uint32_t index;
+  char deviceId[32];
+  MqttTopics deviceTopics;
+  MqttConn mqtt;
+  HttpPoster http;
+
+  bool connecting;
+  uint64_t connectStartMs;
+  uint64_t nextConnectMs;
+
+  AcSchedule schedule;
+  bool scheduleEnabled;
+  bool statusDirty;
+  uint64_t lastStatusMs;
+  std::vector<PendingIr> irQueue;
+  uint64_t callbackNowMs;  // 消息回调中使用的当前时间
+  uint64_t callbackUnixMs;
+
+  TelemetryCompressor compressor;
+  std::deque<TelemetryRecord> queue;
+  uint32_t nextSeq;
+  uint64_t nextSampleMs;
+  uint32_t inFlightSeq;
+  size_t inFlightCount;
+  uint64_t sendStartMs;
+  uint64_t ackDeadline;
+  uint64_t lastSendMs;
+  uint64_t nextSendMs;
+  uint32_t backoffMs;
+  bool sendNow;
+  WireFormat batchFormat;   // 跟随服务器最近一次应答的格式，每次连接先恢复为 JSON
+  float baseTemperature;
+  float baseHumidity;
+};
@@ -0,0 +1,387 @@
+// ============================================================================
+// 设备群模拟器：虚拟设备
+// 对应固件 mqttTask / mqttCallback / mqtt_telemetry / telemetry_uploader 的时序，
+// 红外模块用固定延迟代替（应答在模块"响应"后发布，与 command_trace 一致）
+// ============================================================================
+#include "fleet.h"
+#include <math.h>
+#include <algorithm>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+FleetStats fleetStats;
+
+// 单线程运行，所有设备共用编码缓冲
+static TelemetryRecord batch[FLEET_HTTP_BATCH_MAX];
+static char payload[FLEET_HTTP_BATCH_MAX * 64 + 32];
+
+uint32_t LatencyRecorder::percentile(double p) {
+  if (samples.empty()) {
+    return 0;
+  }
+  if (!sorted) {
+    std::sort(samples.begin(), samples.end());
+    sorted = true;
+  }
+  size_t rank = (size_t)ceil(p / 100.0 * samples.size());
+  return samples[rank > 0 ? rank - 1 : 0];
+}
+
+// [0, 1) 的均匀随机数
+static float uniform() {
+  return (float)rand() / ((float)RAND_MAX + 1.0f);
+}
+
+FleetDevice::FleetDevice()
+    : cfg(nullptr), index(0), deviceId{}, deviceTopics{}, connecting(false), connectStartMs(0),
+      nextConnectMs(0), scheduleEnabled(true), statusDirty(false), lastStatusMs(0),
+      callbackNowMs(0), callbackUnixMs(0), nextSeq(1), nextSampleMs(0), inFlightSeq(0), inFlightCount(0), sendStartMs(0),
+      ackDeadline(0), lastSendMs(0), nextSendMs(0), backoffMs(0), sendNow(false), batchFormat(WIRE_FORMAT_JSON),
+      baseTemperature(0), baseHumidity(0) {}
+
+bool FleetDevice::init(uint32_t deviceIndex, const FleetConfig& config, uint64_t firstConnectMs) {
+  cfg = &config;
+  index = deviceIndex;
+  snprintf(deviceId, sizeof(deviceId), "%s-%05lu", config.idPrefix, (unsigned long)(deviceIndex + 1));
+  if (!mqttTopicsInit(deviceTopics, config.ns, deviceId)) {
+    return false;
+  }
+  mqtt.setHandler(onMessage, this);
+  schedule.setDefaults();
+  nextConnectMs = firstConnectMs;
+  // 采样时刻错开，避免所有设备在同一毫秒入队和上传
+  nextSampleMs = firstConnectMs + (uint64_t)(uniform() * FLEET_SAMPLE_MS);
+  lastSendMs = firstConnectMs;
+  lastStatusMs = firstConnectMs;
+  baseTemperature = 20.0f + uniform() * 8.0f;
+  baseHumidity = 40.0f + uniform() * 30.0f;
+  return true;
+}
+
+void FleetDevice::addPollFds(std::vector<struct pollfd>& fds) const {
+  fds.push_back({mqtt.fd(), mqtt.pollEvents(), 0});
+  fds.push_back({http.fd(), http.pollEvents(), 0});
+}
+
+void FleetDevice::scheduleReconnect(uint64_t nowMs) {
+  connecting = false;
+  uint32_t jitter = cfg->reconnectJitterMs ? (uint32_t)(uniform() * cfg->reconnectJitterMs) : 0;
+  nextConnectMs = nowMs + FLEET_RECONNECT_MS + jitter;
+}
+
+void FleetDevice::drop(uint64_t nowMs) {
+  mqtt.drop();
+  http.drop();
+  inFlightSeq = 0;
+  scheduleReconnect(nowMs);
+}
+
+// ========================== 连接 ==========================
+
+void FleetDevice::onConnect(uint64_t nowMs) {
+  connecting = false;
+  fleetStats.connects++;
+  fleetStats.connectMs.add((uint32_t)(nowMs - connectStartMs));
+
+  // 与 mqttTask 连接成功后的顺序相同
+  mqtt.publish(deviceTopics.availability, "online", true);
+  mqtt.publish(deviceTopics.codec, WIRE_CAPABILITIES, true);
+  mqtt.subscribe(deviceTopics.control);
+  mqtt.subscribe(deviceTopics.schedule);
+  if (!cfg->httpTelemetry) {
+    mqtt.subscribe(deviceTopics.telemetryAck, 1);
+    inFlightSeq = 0;  // 断线前未应答的批次立即重发
+    sendNow = true;
+    batchFormat = WIRE_FORMAT_JSON;
+  }
+}
+
+void FleetDevice::service(const struct pollfd* fds, uint64_t nowMs, uint64_t unixMs) {
+  callbackNowMs = nowMs;
+  callbackUnixMs = unixMs;
+  if (fds[0].revents != 0) {
+    bool wasConnected = mqtt.connected();
+    if (!mqtt.service(fds[0].revents, nowMs)) {
+      if (wasConnected) {
+        fleetStats.connectionsLost++;
+      } else {
+        fleetStats.connectFailures++;
+      }
+      scheduleReconnect(nowMs);
+    } else if (connecting && mqtt.connected()) {
+      onConnect(nowMs);
+    }
+  }
+  if (fds[1].revents != 0) {
+    int status = 0;
+    if (http.service(fds[1].revents, status)) {
+      onHttpDone(status, nowMs);
+    }
+  }
+}
+
+void FleetDevice::tick(uint64_t nowMs, uint64_t unixMs) {
+  if (nowMs >= nextSampleMs) {
+    nextSampleMs += FLEET_SAMPLE_MS;
+    sample(nowMs, unixMs);
+  }
+
+  if (mqtt.idle()) {
+    if (nowMs >= nextConnectMs) {
+      fleetStats.connectAttempts++;
+      connectStartMs = nowMs;
+      connecting = mqtt.open(cfg->broker, deviceId, deviceTopics.availability, "offline",
+                             FLEET_KEEPALIVE_SEC, nowMs);
+      if (!connecting) {
+        fleetStats.connectFailures++;
+        scheduleReconnect(nowMs);
+      }
+    }
+  } else if (connecting && nowMs - connectStartMs >= FLEET_CONNECT_TIMEOUT_MS) {
+    mqtt.drop();
+    fleetStats.connectFailures++;
+    scheduleReconnect(nowMs);
+  }
+
+  if (cfg->httpTelemetry) {
+    serviceTelemetry(nowMs);  // HTTP 上传任务不依赖 MQTT 连接
+  }
+  if (!mqtt.connected()) {
+    return;
+  }
+  mqtt.tick(nowMs);
+  publishAcks(nowMs);
+  if (!cfg->httpTelemetry) {
+    serviceTelemetry(nowMs);
+  }
+  // 规则或开关变化后立即确认，否则每 60 秒上报一次
+  if (statusDirty || nowMs - lastStatusMs > FLEET_STATUS_MS) {
+    statusDirty = false;
+    lastStatusMs = nowMs;
+    publishStatus(unixMs);
+  }
+}
+
+// ========================== 指令与定时 ==========================
+
+void FleetDevice::onMessage(void* ctx, const char* topic, const uint8_t* data, size_t length) {
+  FleetDevice* self = (FleetDevice*)ctx;
+  if (strcmp(topic, self->deviceTopics.telemetryAck) == 0) {
+    self->handleTelemetryAck(data, length);
+  } else if (strcmp(topic, self->deviceTopics.schedule) == 0) {
+    self->handleSchedule(data, length);
+  } else {
+    self->handleCommand(data, length);
+  }
+}
+
+void FleetDevice::handleCommand(const uint8_t* data, size_t length) {
+  AcCommand command;
+  bool valid = wireIsFrame(data, length) ? wireDecodeCommand(data, length, command)
+                                         : parseACCommand(data, length, command);
+  if (!valid) {
+    return;
+  }
+  fleetStats.commandsReceived++;
+  PendingIr pending;
+  pending.ack.id = command.id;
+  pending.ack.action = command.action;
+  pending.ack.result = AC_RESULT_ACKED;
+  pending.ack.sentMs = command.sentMs;
+  pending.ack.receivedMs = callbackUnixMs;
+  pending.ack.dispatchMs = cfg->irDispatchMs;
+  pending.ack.irAckMs = cfg->irAckMs;
+  pending.binary = wireIsFrame(data, length);
+  pending.dueMs = callbackNowMs + cfg->irAckMs;
+  irQueue.push_back(pending);
+}
+
+// 红外模块"响应"后发布应答；断线期间的应答留到重新连接后发布（与 command_trace 的应答队列一致）
+void FleetDevice::publishAcks(uint64_t nowMs) {
+  size_t done = 0;
+  while (done < irQueue.size() && irQueue[done].dueMs <= nowMs) {
+    const PendingIr& pending = irQueue[done];
+    if (pending.binary) {
+      uint8_t frame[WIRE_OVERHEAD + WIRE_COMMAND_ACK_SIZE];
+      size_t len = wireEncodeCommandAck(frame, sizeof(frame), pending.ack);
+      mqtt.publish(deviceTopics.commandAck, frame, len);
+    } else {
+      char json[192];
+      if (acCommandAckJson(json, sizeof(json), pending.ack) > 0) {
+        mqtt.publish(deviceTopics.commandAck, json);
+      }
+    }
+    fleetStats.acksPublished++;
+    done++;
+  }
+  irQueue.erase(irQueue.begin(), irQueue.begin() + done);
+}
+
+void FleetDevice::handleSchedule(const uint8_t* data, size_t length) {
+  AcScheduleUpdate update;
+  bool valid = wireIsFrame(data, length) ? wireDecodeScheduleUpdate(data, length, update)
+                                         : parseACSchedule(data, length, update);
+  if (!valid) {
+    return;
+  }
+  if (update.hasRules) {
+    schedule.setRules(update.rules, update.ruleCount);
+  }
+  if (update.hasEnabled) {
+    scheduleEnabled = update.enabled;
+  }
+  statusDirty = true;
+}
+
+void FleetDevice::publishStatus(uint64_t unixMs) {
+  char status[640];
+  AcScheduleEvent next;
+  time_t nextDue = scheduleEnabled && schedule.next((time_t)(unixMs / 1000), next) ? next.due : 0;
+  size_t len = schedule.statusJson(status, sizeof(status), scheduleEnabled, nextDue);
+  if (len > 0) {
+    mqtt.publish(deviceTopics.scheduleStatus, (const uint8_t*)status, len);
+    fleetStats.statusPublished++;
+  }
+}
+
+// ========================== 遥测 ==========================
+
+// 缓慢变化的温湿度加 ±0.1 的读数噪声，经过与固件相同的变化上报
+void FleetDevice::sample(uint64_t nowMs, uint64_t unixMs) {
+  fleetStats.samples++;
+  float phase = (float)(nowMs % 1200000) / 1200000.0f * 2.0f * (float)M_PI + index;
+  float temperature = roundf((baseTemperature + 1.5f * sinf(phase) + (uniform() - 0.5f) * 0.2f) * 10) / 10;
+  float humidity = roundf((baseHumidity + 5.0f * cosf(phase) + (uniform() - 0.5f) * 0.2f) * 10) / 10;
+  TelemetryPoint point = {(uint32_t)nowMs, (uint32_t)(unixMs / 1000), temperature, humidity};
+  TelemetryPoint reports[2];
+  uint8_t count = compressor.push(point, reports);
+  for (uint8_t i = 0; i < count; i++) {
+    TelemetryRecord record;
+    record.seq = nextSeq++;
+    record.timestamp = reports[i].timestamp;
+    record.temperature = (int16_t)lroundf(reports[i].temperature * 10);
+    record.humidity = (uint16_t)lroundf(reports[i].humidity * 10);
+    queue.push_back(record);
+    fleetStats.recordsQueued++;
+    if (queue.size() > FLEET_QUEUE_MAX) {
+      queue.pop_front();
+      fleetStats.recordsDropped++;
+    }
+  }
+}
+
+size_t FleetDevice::encodeBatch(size_t max, uint32_t& lastSeq) {
+  size_t n = 0;
+  for (; n < max && n < queue.size(); n++) {
+    batch[n] = queue[n];
+  }
+  if (n == 0) {
+    return 0;
+  }
+  lastSeq = batch[n - 1].seq;
+  return batchFormat == WIRE_FORMAT_BINARY && !cfg->httpTelemetry
+             ? wireEncodeBatch((uint8_t*)payload, sizeof(payload), batch, n)
+             : telemetryToJson(payload, sizeof(payload), batch, n);
+}
+
+void FleetDevice::commit(uint32_t seq, uint64_t nowMs) {
+  while (!queue.empty() && queue.front().seq <= seq) {
+    queue.pop_front();
+    fleetStats.recordsAcked++;
+  }
+  if (inFlightSeq != 0 && seq >= inFlightSeq) {
+    fleetStats.telemetryMs.add((uint32_t)(nowMs - sendStartMs));
+    inFlightSeq = 0;
+    backoffMs = 0;
+  }
+}
+
+void FleetDevice::handleTelemetryAck(const uint8_t* data, size_t length) {
+  uint32_t seq = 0;
+  if (wireIsFrame(data, length)) {
+    if (!wireDecodeAck(data, length, seq)) {
+      return;
+    }
+  } else {
+    // {"seq":N}，控制端固定按这个格式应答，不必经过 ArduinoJson
+    const char* p = (const char*)memchr(data, ':', length);
+    seq = p ? (uint32_t)strtoul(p + 1, nullptr, 10) : 0;
+  }
+  if (seq == 0) {
+    return;
+  }
+  batchFormat = wireFormatOf(data, length);
+  commit(seq, callbackNowMs);
+  sendNow = !queue.empty();  // 还有积压时不等下一个周期
+}
+
+void FleetDevice::onHttpDone(int status, uint64_t nowMs) {
+  if (status >= 200 && status < 300) {
+    // 整批发送成功且还有积压时连续补传，与上传任务一致
+    sendNow = inFlightCount == FLEET_HTTP_BATCH_MAX && queue.size() > inFlightCount;
+    commit(inFlightSeq, nowMs);
+    return;
+  }
+  fleetStats.httpFailures++;
+  inFlightSeq = 0;
+  backoffMs = backoffMs ? backoffMs * 2 : FLEET_HTTP_BACKOFF_MIN_MS;
+  if (backoffMs > FLEET_BACKOFF_MAX_MS) {
+    backoffMs = FLEET_BACKOFF_MAX_MS;
+  }
+  nextSendMs = nowMs + backoffMs;
+}
+
+void FleetDevice::serviceTelemetry(uint64_t nowMs) {
+  bool viaHttp = cfg->httpTelemetry;
+  if (inFlightSeq != 0) {
+    if (viaHttp || nowMs < ackDeadline) {
+      return;  // HTTP 请求的结果在 onHttpDone 中处理
+    }
+    // 应答超时：退避后重发同一批（记录仍在队列中）
+    fleetStats.telemetryTimeouts++;
+    backoffMs = backoffMs ? backoffMs * 2 : FLEET_MQTT_ACK_TIMEOUT;
+    if (backoffMs > FLEET_BACKOFF_MAX_MS) {
+      backoffMs = FLEET_BACKOFF_MAX_MS;
+    }
+    inFlightSeq = 0;
+    nextSendMs = nowMs + backoffMs;
+    return;
+  }
+  if (nowMs < nextSendMs || queue.empty()) {
+    return;
+  }
+  size_t batchMax = viaHttp ? FLEET_HTTP_BATCH_MAX : FLEET_MQTT_BATCH_MAX;
+  uint32_t interval = viaHttp ? FLEET_HTTP_INTERVAL : FLEET_MQTT_INTERVAL;
+  if (!sendNow && queue.size() < batchMax && nowMs - lastSendMs < interval) {
+    return;
+  }
+
+  sendNow = false;
+  lastSendMs = nowMs;
+  uint32_t lastSeq = 0;
+  size_t len = encodeBatch(batchMax, lastSeq);
+  if (len == 0) {
+    return;
+  }
+  size_t count = std::min(batchMax, queue.size());
+  if (viaHttp) {
+    if (!http.post(cfg->receiver, "/update", payload, len, nowMs)) {
+      onHttpDone(-1, nowMs);
+      return;
+    }
+  } else {
+    mqtt.publish(deviceTopics.telemetry, (const uint8_t*)payload, len);
+    const TelemetryRecord& last = queue[count - 1];
+    int latestLen = snprintf(payload, sizeof(payload),
+                             "{\"seq\":%lu,\"t\":%lu,\"temperature\":%.1f,\"humidity\":%.1f}",
+                             (unsigned long)last.seq, (unsigned long)last.timestamp,
+                             last.temperature / 10.0f, last.humidity / 10.0f);
+    mqtt.publish(deviceTopics.telemetryLatest, (const uint8_t*)payload, latestLen, true);
+    ackDeadline = nowMs + FLEET_MQTT_ACK_TIMEOUT;
+  }
+  fleetStats.batchesSent++;
+  inFlightSeq = lastSeq;
+  inFlightCount = count;
+  sendStartMs = nowMs;
+}
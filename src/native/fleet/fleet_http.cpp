@@ -0,0 +1,294 @@
+// ============================================================================
+// 设备群模拟器：HTTP 上传通道实现
+// 只处理模拟需要的 HTTP/1.1 子集：Content-Length 定长请求体，keep-alive
+// ============================================================================
+#include "fleet_http.h"
+#include <arpa/inet.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <netinet/tcp.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#define READ_CHUNK 4096
+
+static const char RESPONSE[] =
+    "HTTP/1.1 200 OK\r\n"
+    "Content-Type: application/json\r\n"
+    "Content-Length: 20\r\n"
+    "\r\n"
+    "{\"status\":\"success\"}";
+
+static void setNonBlocking(int fd) {
+  fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_NONBLOCK);
+}
+
+// 读出 socket 中的全部数据；对方关闭或出错时返回 false
+static bool readAll(int fd, std::string& in, uint64_t* bytes) {
+  char chunk[READ_CHUNK];
+  for (;;) {
+    ssize_t n = recv(fd, chunk, sizeof(chunk), 0);
+    if (n == 0) {
+      return false;
+    }
+    if (n < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+      return errno == EAGAIN || errno == EWOULDBLOCK;
+    }
+    in.append(chunk, n);
+    if (bytes) {
+      *bytes += n;
+    }
+  }
+}
+
+// 头部中的 Content-Length，没有时为 0
+static size_t contentLength(const std::string& msg, size_t headerEnd) {
+  size_t pos = 0;
+  while (pos < headerEnd) {
+    size_t eol = msg.find("\r\n", pos);
+    if (eol == std::string::npos || eol > headerEnd) {
+      break;
+    }
+    if (eol - pos > 15 && strncasecmp(msg.c_str() + pos, "Content-Length:", 15) == 0) {
+      return strtoul(msg.c_str() + pos + 15, nullptr, 10);
+    }
+    pos = eol + 2;
+  }
+  return 0;
+}
+
+// ========================== HttpPoster ==========================
+
+HttpPoster::HttpPoster() : sock(-1), connecting(false), pending(false), startMs(0), outPos(0) {}
+
+HttpPoster::~HttpPoster() { drop(); }
+
+void HttpPoster::drop() {
+  if (sock >= 0) {
+    ::close(sock);
+  }
+  sock = -1;
+  connecting = false;
+  pending = false;
+  out.clear();
+  outPos = 0;
+  in.clear();
+}
+
+bool HttpPoster::post(const sockaddr_in& server, const char* path, const char* body, size_t length, uint64_t nowMs) {
+  if (pending) {
+    return false;
+  }
+  if (sock < 0) {
+    sock = socket(AF_INET, SOCK_STREAM, 0);
+    if (sock < 0) {
+      return false;
+    }
+    setNonBlocking(sock);
+    int one = 1;
+    setsockopt(sock, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+    if (connect(sock, (const sockaddr*)&server, sizeof(server)) != 0 && errno != EINPROGRESS) {
+      drop();
+      return false;
+    }
+    connecting = true;
+  }
+
+  // 与 telemetry_uploader 相同的请求：HTTPClient 默认带 Host、User-Agent 和 keep-alive
+  char header[192];
+  char host[INET_ADDRSTRLEN];
+  inet_ntop(AF_INET, &server.sin_addr, host, sizeof(host));
+  int n = snprintf(header, sizeof(header),
+                   "POST %s HTTP/1.1\r\nHost: %s:%u\r\nUser-Agent: ESP32HTTPClient\r\n"
+                   "Connection: keep-alive\r\nContent-Type: application/json\r\nContent-Length: %u\r\n\r\n",
+                   path, host, (unsigned)ntohs(server.sin_port), (unsigned)length);
+  out.assign(header, n);
+  out.append(body, length);
+  outPos = 0;
+  in.clear();
+  pending = true;
+  startMs = nowMs;
+  return flush();
+}
+
+short HttpPoster::pollEvents() const {
+  if (sock < 0) {
+    return 0;
+  }
+  if (connecting || outPos < out.size()) {
+    return POLLOUT | POLLIN;
+  }
+  return POLLIN;
+}
+
+bool HttpPoster::flush() {
+  if (connecting) {
+    return true;
+  }
+  while (outPos < out.size()) {
+    ssize_t n = send(sock, out.data() + outPos, out.size() - outPos, MSG_NOSIGNAL);
+    if (n < 0) {
+      return errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR;
+    }
+    outPos += n;
+  }
+  return true;
+}
+
+bool HttpPoster::service(short revents, int& status) {
+  if (sock < 0) {
+    return false;
+  }
+  if (connecting && (revents & (POLLOUT | POLLERR | POLLHUP))) {
+    int err = 0;
+    socklen_t len = sizeof(err);
+    getsockopt(sock, SOL_SOCKET, SO_ERROR, &err, &len);
+    connecting = false;
+    if (err != 0) {
+      bool wasPending = pending;
+      drop();
+      status = -1;
+      return wasPending;
+    }
+  }
+  bool ok = flush();
+  if (ok && (revents & (POLLIN | POLLERR | POLLHUP))) {
+    ok = readAll(sock, in, nullptr);
+  }
+
+  // 空闲连接被服务器关闭不算失败，下次 POST 时重新建立
+  if (pending) {
+    size_t headerEnd = in.find("\r\n\r\n");
+    if (headerEnd != std::string::npos && in.size() >= headerEnd + 4 + contentLength(in, headerEnd)) {
+      status = in.compare(0, 5, "HTTP/") == 0 && in.size() > 12 ? atoi(in.c_str() + 9) : -1;
+      pending = false;
+      in.clear();
+      if (!ok) {
+        drop();
+      }
+      return true;
+    }
+  }
+  if (!ok) {
+    bool wasPending = pending;
+    drop();
+    status = -1;
+    return wasPending;
+  }
+  return false;
+}
+
+// ========================== HttpReceiver ==========================
+
+HttpReceiver::HttpReceiver() : listener(-1), totals{} {}
+
+HttpReceiver::~HttpReceiver() {
+  for (Client& c : clients) {
+    ::close(c.fd);
+  }
+  if (listener >= 0) {
+    ::close(listener);
+  }
+}
+
+bool HttpReceiver::listen(uint16_t port) {
+  listener = socket(AF_INET, SOCK_STREAM, 0);
+  if (listener < 0) {
+    return false;
+  }
+  int one = 1;
+  setsockopt(listener, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+  sockaddr_in addr = {};
+  addr.sin_family = AF_INET;
+  addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+  addr.sin_port = htons(port);
+  if (bind(listener, (const sockaddr*)&addr, sizeof(addr)) != 0 || ::listen(listener, SOMAXCONN) != 0) {
+    ::close(listener);
+    listener = -1;
+    return false;
+  }
+  setNonBlocking(listener);
+  return true;
+}
+
+size_t HttpReceiver::addPollFds(std::vector<struct pollfd>& fds) const {
+  if (listener < 0) {
+    return 0;
+  }
+  fds.push_back({listener, POLLIN, 0});
+  for (const Client& c : clients) {
+    fds.push_back({c.fd, POLLIN, 0});
+  }
+  return clients.size() + 1;
+}
+
+void HttpReceiver::accept() {
+  for (;;) {
+    int fd = ::accept(listener, nullptr, nullptr);
+    if (fd < 0) {
+      return;
+    }
+    setNonBlocking(fd);
+    int one = 1;
+    setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+    clients.push_back({fd, std::string()});
+    totals.connections++;
+  }
+}
+
+// 处理缓冲中全部完整的请求；连接应关闭时返回 false
+bool HttpReceiver::serve(Client& client) {
+  if (!readAll(client.fd, client.in, &totals.bytes)) {
+    return false;
+  }
+  for (;;) {
+    size_t headerEnd = client.in.find("\r\n\r\n");
+    if (headerEnd == std::string::npos) {
+      return true;
+    }
+    size_t total = headerEnd + 4 + contentLength(client.in, headerEnd);
+    if (client.in.size() < total) {
+      return true;
+    }
+    client.in.erase(0, total);
+    totals.requests++;
+    // 响应很短，非阻塞写一次即可写完
+    if (send(client.fd, RESPONSE, sizeof(RESPONSE) - 1, MSG_NOSIGNAL) != (ssize_t)(sizeof(RESPONSE) - 1)) {
+      return false;
+    }
+  }
+}
+
+void HttpReceiver::service(const struct pollfd* fds, size_t count) {
+  if (count == 0) {
+    return;
+  }
+  // 先处理已有连接（下标与 addPollFds 时一致），再接受新连接
+  size_t kept = 0;
+  for (size_t i = 0; i < clients.size(); i++) {
+    bool keep = true;
+    if (i + 1 < count && (fds[i + 1].revents & (POLLIN | POLLERR | POLLHUP))) {
+      keep = serve(clients[i]);
+    }
+    if (keep) {
+      if (kept != i) {
+        clients[kept] = std::move(clients[i]);
+      }
+      kept++;
+    } else {
+      ::close(clients[i].fd);
+    }
+  }
+  clients.resize(kept);
+  if (fds[0].revents & POLLIN) {
+    accept();
+  }
+  totals.open = clients.size();
+}
@@ -0,0 +1,85 @@
+// ============================================================================
+// 设备群模拟器：HTTP 上传通道
+// 功能：HttpPoster 按 telemetry_uploader 的方式在一条 keep-alive 连接上 POST 遥测批次；
+//       HttpReceiver 代替 server.js 的 /update 接口，只计数并回复 200，
+//       用来测量接收端需要承受的请求速率和流量
+// ============================================================================
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+#include <netinet/in.h>
+#include <poll.h>
+#include <string>
+#include <vector>
+
+// ---------------------------- 设备端 ----------------------------
+
+class HttpPoster {
+ public:
+  HttpPoster();
+  ~HttpPoster();
+
+  // 发起一次 POST；连接不存在时先建立（非阻塞）。已有请求未完成时返回 false
+  bool post(const sockaddr_in& server, const char* path, const char* body, size_t length, uint64_t nowMs);
+
+  int fd() const { return sock; }
+  bool busy() const { return pending; }
+  short pollEvents() const;
+
+  // poll() 返回后调用；请求完成时返回 true，status 为 HTTP 状态码（连接失败为 -1）
+  bool service(short revents, int& status);
+  // 断开连接，未完成的请求作废
+  void drop();
+
+  uint64_t startedMs() const { return startMs; }
+
+ private:
+  bool flush();
+
+  int sock;
+  bool connecting;
+  bool pending;
+  uint64_t startMs;
+  std::string out;
+  size_t outPos;
+  std::string in;
+};
+
+// ---------------------------- 接收端 ----------------------------
+
+struct HttpReceiverStats {
+  uint64_t requests;
+  uint64_t bytes;        // 请求头 + 请求体
+  uint64_t connections;  // 累计接受的连接数
+  uint32_t open;         // 当前连接数
+};
+
+class HttpReceiver {
+ public:
+  HttpReceiver();
+  ~HttpReceiver();
+
+  bool listen(uint16_t port);
+  bool active() const { return listener >= 0; }
+
+  // 把监听 socket 和所有连接追加到 poll 列表，返回追加的个数
+  size_t addPollFds(std::vector<struct pollfd>& fds) const;
+  // 处理 addPollFds 追加的那一段 poll 结果
+  void service(const struct pollfd* fds, size_t count);
+
+  const HttpReceiverStats& stats() const { return totals; }
+
+ private:
+  struct Client {
+    int fd;
+    std::string in;
+  };
+
+  void accept();
+  bool serve(Client& client);
+
+  int listener;
+  std::vector<Client> clients;
+  HttpReceiverStats totals;
+};
@@ -0,0 +1,548 @@
+// ============================================================================
+// 设备群模拟器：主程序
+// 控制端代替 server.js（发指令、应答遥测批次），所有连接在同一个 poll() 循环中处理；
+// 结束时输出 broker / 接收端吞吐、发布→应答延迟百分位和重连风暴的恢复时间
+// ============================================================================
+#include "fleet.h"
+#include <netdb.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/resource.h>
+#include <sys/time.h>
+#include <time.h>
+#include <unordered_map>
+#include "../../wire_codec.h"
+
+#define POLL_MS          5      // 红外应答等定时动作的分辨率
+#define PROGRESS_MS      5000
+#define COMMAND_GRACE_MS 2000   // 结束前这段时间不再发指令，等待应答
+#define CONTROLLER_ID    "fleet-controller"
+
+static FleetConfig config;
+static std::vector<FleetDevice> devices;
+static HttpReceiver receiver;
+
+static uint64_t monotonicMs() {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (uint64_t)ts.tv_sec * 1000 + ts.tv_nsec / 1000000;
+}
+
+static uint64_t unixMs() {
+  struct timeval tv;
+  gettimeofday(&tv, nullptr);
+  return (uint64_t)tv.tv_sec * 1000 + tv.tv_usec / 1000;
+}
+
+static bool endsWith(const char* s, const char* suffix) {
+  size_t n = strlen(s);
+  size_t m = strlen(suffix);
+  return n >= m && strcmp(s + n - m, suffix) == 0;
+}
+
+// 控制端只需要设备消息中的几个数字字段，直接查找 "key": 而不做完整解析，
+// 避免控制端自身成为瓶颈；返回出现次数，value 为最后一次出现的值
+static size_t jsonNumber(const uint8_t* data, size_t length, const char* key, uint64_t& value) {
+  char pattern[24];
+  int n = snprintf(pattern, sizeof(pattern), "\"%s\":", key);
+  size_t found = 0;
+  const uint8_t* p = data;
+  const uint8_t* end = data + length;
+  while ((p = (const uint8_t*)memmem(p, end - p, pattern, n)) != nullptr) {
+    p += n;
+    uint64_t v = 0;
+    while (p < end && *p >= '0' && *p <= '9') {
+      v = v * 10 + (*p++ - '0');
+    }
+    value = v;
+    found++;
+  }
+  return found;
+}
+
+// ========================== 控制端 ==========================
+
+struct Controller {
+  MqttConn conn;
+  std::unordered_map<uint32_t, uint64_t> inFlight;  // 指令 id → 发布时刻
+  uint32_t nextId;
+  double credit;              // 按速率累积的待发指令数
+  uint64_t commandsSent;
+  uint64_t acksReceived;
+  uint64_t acksUnmatched;     // 未知 id 或重复应答
+  uint64_t batchesReceived;
+  uint64_t recordsReceived;
+  uint64_t statusReceived;
+  uint64_t online;
+  uint64_t offline;
+  LatencyRecorder commandMs;  // 控制端发布 → 收到应答（含模拟的红外响应时间）
+  LatencyRecorder networkMs;  // 控制端发布 → 设备收到（应答中的 sent/recv，同一台机器的时钟）
+};
+
+static Controller controller;
+
+static void controllerOnMessage(void* ctx, const char* topic, const uint8_t* data, size_t length) {
+  static TelemetryRecord records[WIRE_BATCH_MAX];
+  Controller& c = *(Controller*)ctx;
+  uint64_t now = monotonicMs();
+
+  if (endsWith(topic, "/ac/ack")) {
+    AcCommandAck ack;
+    bool valid;
+    if (wireIsFrame(data, length)) {
+      valid = wireDecodeCommandAck(data, length, ack);
+    } else {
+      uint64_t id = 0;
+      ack.sentMs = 0;
+      ack.receivedMs = 0;
+      valid = jsonNumber(data, length, "id", id) > 0;
+      ack.id = (uint32_t)id;
+      jsonNumber(data, length, "sent", ack.sentMs);
+      jsonNumber(data, length, "recv", ack.receivedMs);
+    }
+    auto it = valid ? c.inFlight.find(ack.id) : c.inFlight.end();
+    if (it == c.inFlight.end()) {
+      c.acksUnmatched++;
+      return;
+    }
+    c.acksReceived++;
+    c.commandMs.add((uint32_t)(now - it->second));
+    if (ack.sentMs != 0 && ack.receivedMs >= ack.sentMs) {
+      c.networkMs.add((uint32_t)(ack.receivedMs - ack.sentMs));
+    }
+    c.inFlight.erase(it);
+  } else if (endsWith(topic, "/telemetry")) {
+    // 与 server.js 相同：按批次最后一条的序号应答到 <topic>/ack，应答格式决定设备之后的批次格式
+    uint64_t seq = 0;
+    size_t count = 0;
+    if (wireIsFrame(data, length)) {
+      if (wireDecodeBatch(data, length, records, WIRE_BATCH_MAX, count) && count > 0) {
+        seq = records[count - 1].seq;
+      }
+    } else {
+      count = jsonNumber(data, length, "seq", seq);
+    }
+    if (count == 0 || seq == 0) {
+      return;
+    }
+    c.batchesReceived++;
+    c.recordsReceived += count;
+    char ackTopic[MQTT_TOPIC_MAX];
+    uint8_t ack[32];
+    size_t len;
+    snprintf(ackTopic, sizeof(ackTopic), "%s/ack", topic);
+    if (config.binary) {
+      len = wireEncodeAck(ack, sizeof(ack), (uint32_t)seq);
+    } else {
+      len = snprintf((char*)ack, sizeof(ack), "{\"seq\":%lu}", (unsigned long)seq);
+    }
+    c.conn.publish(ackTopic, ack, len, false, 1);
+  } else if (endsWith(topic, "/ac/schedule/status")) {
+    c.statusReceived++;
+  } else if (endsWith(topic, "/status")) {
+    if (length == 6 && memcmp(data, "online", 6) == 0) {
+      c.online++;
+    } else {
+      c.offline++;
+    }
+  }
+}
+
+static bool controllerConnect() {
+  controller.conn.setHandler(controllerOnMessage, &controller);
+  if (!controller.conn.open(config.broker, CONTROLLER_ID, nullptr, nullptr, 60, monotonicMs())) {
+    return false;
+  }
+  uint64_t deadline = monotonicMs() + FLEET_CONNECT_TIMEOUT_MS;
+  while (!controller.conn.connected() && monotonicMs() < deadline) {
+    struct pollfd pfd = {controller.conn.fd(), controller.conn.pollEvents(), 0};
+    if (poll(&pfd, 1, 50) > 0 && !controller.conn.service(pfd.revents, monotonicMs())) {
+      return false;
+    }
+  }
+  if (!controller.conn.connected()) {
+    return false;
+  }
+  static const char* SUFFIXES[] = {"ac/ack", "telemetry", "ac/schedule/status", "status"};
+  for (const char* suffix : SUFFIXES) {
+    char filter[MQTT_TOPIC_MAX];
+    snprintf(filter, sizeof(filter), "%s/+/%s", config.ns, suffix);
+    controller.conn.subscribe(filter, suffix == SUFFIXES[1] ? 1 : 0);
+  }
+  return true;
+}
+
+// 按设定速率向随机设备发指令：{"action":"on","id":N,"ts":unixMs}（与 server.js 相同）或 AC_COMMAND 帧
+static void controllerTick(uint64_t nowMs, uint64_t elapsedMs, bool sending) {
+  controller.conn.tick(nowMs);
+  if (!sending || config.commandRate <= 0 || !controller.conn.connected()) {
+    return;
+  }
+  controller.credit += config.commandRate * elapsedMs / 1000.0;
+  uint8_t message[96];
+  while (controller.credit >= 1.0) {
+    controller.credit -= 1.0;
+    const FleetDevice& device = devices[rand() % devices.size()];
+    AcCommand command;
+    command.id = controller.nextId++;
+    command.action = command.id % 2 ? AC_ACTION_ON : AC_ACTION_OFF;
+    command.sentMs = unixMs();
+    size_t len;
+    if (config.binary) {
+      len = wireEncodeCommand(message, sizeof(message), command);
+    } else {
+      len = snprintf((char*)message, sizeof(message), "{\"action\":\"%s\",\"id\":%lu,\"ts\":%llu}",
+                     command.action == AC_ACTION_ON ? "on" : "off", (unsigned long)command.id,
+                     (unsigned long long)command.sentMs);
+    }
+    uint32_t id = command.id;
+    controller.conn.publish(device.topics().control, message, len);
+    controller.inFlight[id] = nowMs;
+    controller.commandsSent++;
+  }
+}
+
+// ========================== 命令行 ==========================
+
+static void usage(const char* program) {
+  printf("用法: %s [选项]\n"
+         "  --devices N         虚拟设备数（默认 100）\n"
+         "  --broker HOST:PORT  MQTT broker（默认 127.0.0.1:1883）\n"
+         "  --mode mqtt|http    遥测通道（默认 mqtt）\n"
+         "  --codec json|wire   控制端指令和遥测应答的格式，wire 时设备随之改发二进制批次（默认 json）\n"
+         "  --http-port P       内置 HTTP 接收端端口，http 模式使用（默认 7789）\n"
+         "  --duration S        运行时长，秒（默认 120）\n"
+         "  --ramp S            首次连接分散到这段时间内，秒（默认 10）\n"
+         "  --command-rate R    每秒发出的空调指令数，所有设备合计（默认 5）\n"
+         "  --storm-at S        第 S 秒所有设备同时断线（默认不模拟）\n"
+         "  --jitter MS         重连间隔额外的随机量上限（固件为 0）\n"
+         "  --ir-ack MS         模拟的红外模块响应时间（默认 40）\n"
+         "  --namespace NS      主题命名空间（默认 sim/devices）\n"
+         "  --id-prefix P       设备 ID 前缀（默认 sim）\n",
+         program);
+}
+
+static bool resolve(const char* hostPort, uint16_t defaultPort, sockaddr_in& out) {
+  char host[128];
+  strncpy(host, hostPort, sizeof(host) - 1);
+  host[sizeof(host) - 1] = '\0';
+  uint16_t port = defaultPort;
+  char* colon = strrchr(host, ':');
+  if (colon) {
+    *colon = '\0';
+    port = (uint16_t)atoi(colon + 1);
+  }
+  struct addrinfo hints = {};
+  hints.ai_family = AF_INET;
+  hints.ai_socktype = SOCK_STREAM;
+  struct addrinfo* result = nullptr;
+  if (getaddrinfo(host, nullptr, &hints, &result) != 0 || result == nullptr) {
+    return false;
+  }
+  out = *(const sockaddr_in*)result->ai_addr;
+  out.sin_port = htons(port);
+  freeaddrinfo(result);
+  return true;
+}
+
+static bool parseArgs(int argc, char** argv) {
+  config.devices = 100;
+  config.httpTelemetry = false;
+  config.binary = false;
+  config.ns = "sim/devices";
+  config.idPrefix = "sim";
+  config.durationSec = 120;
+  config.rampMs = 10000;
+  config.commandRate = 5;
+  config.stormAtSec = -1;
+  config.reconnectJitterMs = 0;
+  config.irDispatchMs = 2;
+  config.irAckMs = 40;
+  const char* broker = "127.0.0.1:1883";
+  uint16_t httpPort = 7789;
+
+  for (int i = 1; i < argc; i++) {
+    const char* arg = argv[i];
+    const char* value = i + 1 < argc ? argv[i + 1] : nullptr;
+    if (strcmp(arg, "--help") == 0 || strcmp(arg, "-h") == 0 || value == nullptr) {
+      return false;
+    }
+    i++;
+    if (strcmp(arg, "--devices") == 0) {
+      config.devices = strtoul(value, nullptr, 10);
+    } else if (strcmp(arg, "--broker") == 0) {
+      broker = value;
+    } else if (strcmp(arg, "--mode") == 0) {
+      config.httpTelemetry = strcmp(value, "http") == 0;
+    } else if (strcmp(arg, "--codec") == 0) {
+      config.binary = strcmp(value, "wire") == 0;
+    } else if (strcmp(arg, "--http-port") == 0) {
+      httpPort = (uint16_t)atoi(value);
+    } else if (strcmp(arg, "--duration") == 0) {
+      config.durationSec = strtoul(value, nullptr, 10);
+    } else if (strcmp(arg, "--ramp") == 0) {
+      config.rampMs = (uint32_t)(atof(value) * 1000);
+    } else if (strcmp(arg, "--command-rate") == 0) {
+      config.commandRate = atof(value);
+    } else if (strcmp(arg, "--storm-at") == 0) {
+      config.stormAtSec = atoi(value);
+    } else if (strcmp(arg, "--jitter") == 0) {
+      config.reconnectJitterMs = strtoul(value, nullptr, 10);
+    } else if (strcmp(arg, "--ir-ack") == 0) {
+      config.irAckMs = strtoul(value, nullptr, 10);
+    } else if (strcmp(arg, "--namespace") == 0) {
+      config.ns = value;
+    } else if (strcmp(arg, "--id-prefix") == 0) {
+      config.idPrefix = value;
+    } else {
+      return false;
+    }
+  }
+  if (config.devices == 0) {
+    return false;
+  }
+  if (!resolve(broker, 1883, config.broker)) {
+    fprintf(stderr, "❌ 无法解析 broker 地址: %s\n", broker);
+    exit(1);
+  }
+  config.receiver = {};
+  config.receiver.sin_family = AF_INET;
+  config.receiver.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+  config.receiver.sin_port = htons(httpPort);
+  return true;
+}
+
+// 每个设备两个 socket（MQTT、HTTP），接收端每个设备再一个，另留余量
+static void raiseFileLimit() {
+  struct rlimit limit;
+  if (getrlimit(RLIMIT_NOFILE, &limit) != 0) {
+    return;
+  }
+  rlim_t needed = (rlim_t)config.devices * (config.httpTelemetry ? 3 : 1) + 64;
+  if (limit.rlim_cur < needed) {
+    limit.rlim_cur = limit.rlim_max < needed ? limit.rlim_max : needed;
+    setrlimit(RLIMIT_NOFILE, &limit);
+  }
+  if (limit.rlim_cur < needed) {
+    fprintf(stderr, "⚠️ 文件描述符上限 %lu 小于需要的 %lu，部分设备将无法连接（ulimit -n）\n",
+            (unsigned long)limit.rlim_cur, (unsigned long)needed);
+  }
+}
+
+// ========================== 统计输出 ==========================
+
+struct Traffic {
+  uint64_t publishes;
+  uint64_t deliveries;
+  uint64_t bytesOut;
+  uint64_t bytesIn;
+};
+
+static Traffic brokerTraffic() {
+  Traffic t = {};
+  for (const FleetDevice& d : devices) {
+    const MqttConnCounters& c = d.mqttCounters();
+    t.publishes += c.publishesOut;
+    t.deliveries += c.messagesIn;
+    t.bytesOut += c.bytesOut;
+    t.bytesIn += c.bytesIn;
+  }
+  const MqttConnCounters& c = controller.conn.counters();
+  t.publishes += c.publishesOut;
+  t.deliveries += c.messagesIn;
+  t.bytesOut += c.bytesOut;
+  t.bytesIn += c.bytesIn;
+  return t;
+}
+
+static uint32_t connectedCount() {
+  uint32_t n = 0;
+  for (const FleetDevice& d : devices) {
+    n += d.connected();
+  }
+  return n;
+}
+
+static void printLatency(const char* name, LatencyRecorder& r) {
+  printf("  %-24s n=%-8lu p50 %5lu  p90 %5lu  p99 %5lu  max %5lu ms\n", name, (unsigned long)r.count(),
+         (unsigned long)r.percentile(50), (unsigned long)r.percentile(90),
+         (unsigned long)r.percentile(99), (unsigned long)r.percentile(100));
+}
+
+struct StormResult {
+  bool triggered;
+  uint64_t startMs;
+  uint64_t reachedMs[3];  // 50%、90%、100% 设备重新在线的时刻，0 为未达到
+  uint64_t attemptsBefore;
+  uint64_t failuresBefore;
+};
+
+static void printSummary(uint64_t elapsedMs, StormResult& storm) {
+  double sec = elapsedMs / 1000.0;
+  Traffic t = brokerTraffic();
+  printf("\n========== 设备群模拟结果（%lu 台设备，%.0f 秒，遥测经 %s）==========\n",
+         (unsigned long)config.devices, sec, config.httpTelemetry ? "HTTP" : "MQTT");
+
+  printf("broker 吞吐（客户端视角）\n");
+  printf("  发布 %.1f 条/s，投递 %.1f 条/s，上行 %.1f KB/s，下行 %.1f KB/s\n",
+         t.publishes / sec, t.deliveries / sec, t.bytesOut / sec / 1024, t.bytesIn / sec / 1024);
+  printf("  定时状态心跳 %.2f 条/s，在线/离线消息 %lu/%lu\n", controller.statusReceived / sec,
+         (unsigned long)controller.online, (unsigned long)controller.offline);
+
+  printf("遥测\n");
+  printf("  采样 %lu，变化上报入队 %lu（%.1f%%），丢弃 %lu，已确认 %lu\n", (unsigned long)fleetStats.samples,
+         (unsigned long)fleetStats.recordsQueued,
+         fleetStats.samples ? 100.0 * fleetStats.recordsQueued / fleetStats.samples : 0.0,
+         (unsigned long)fleetStats.recordsDropped, (unsigned long)fleetStats.recordsAcked);
+  printf("  批次 %lu（%.2f 批/s），应答超时 %lu，HTTP 失败 %lu\n", (unsigned long)fleetStats.batchesSent,
+         fleetStats.batchesSent / sec, (unsigned long)fleetStats.telemetryTimeouts,
+         (unsigned long)fleetStats.httpFailures);
+  if (config.httpTelemetry) {
+    const HttpReceiverStats& r = receiver.stats();
+    printf("  接收端 %.1f 请求/s，%.1f KB/s，累计连接 %lu，当前连接 %lu\n", r.requests / sec,
+           r.bytes / sec / 1024, (unsigned long)r.connections, (unsigned long)r.open);
+  }
+  printLatency("批次发出 → 应答", fleetStats.telemetryMs);
+
+  printf("空调指令\n");
+  printf("  发出 %lu，应答 %lu，未应答 %lu，无法匹配 %lu\n", (unsigned long)controller.commandsSent,
+         (unsigned long)controller.acksReceived, (unsigned long)controller.inFlight.size(),
+         (unsigned long)controller.acksUnmatched);
+  printLatency("发布 → 应答", controller.commandMs);
+  printLatency("发布 → 设备收到", controller.networkMs);
+
+  printf("连接\n");
+  printf("  尝试 %lu，成功 %lu，失败 %lu，意外断线 %lu，结束时在线 %lu/%lu\n",
+         (unsigned long)fleetStats.connectAttempts, (unsigned long)fleetStats.connects,
+         (unsigned long)fleetStats.connectFailures, (unsigned long)fleetStats.connectionsLost,
+         (unsigned long)connectedCount(), (unsigned long)config.devices);
+
+  if (storm.triggered) {
+    static const char* LABELS[3] = {"50%", "90%", "100%"};
+    printf("重连风暴（第 %d 秒全部断线，重连间隔 %d ms + 抖动 %lu ms）\n", config.stormAtSec,
+           FLEET_RECONNECT_MS, (unsigned long)config.reconnectJitterMs);
+    for (int i = 0; i < 3; i++) {
+      if (storm.reachedMs[i]) {
+        printf("  %-5s 重新在线: %.2f s\n", LABELS[i], (storm.reachedMs[i] - storm.startMs) / 1000.0);
+      } else {
+        printf("  %-5s 重新在线: 未达到\n", LABELS[i]);
+      }
+    }
+    printf("  风暴期间连接尝试 %lu，失败 %lu\n",
+           (unsigned long)(fleetStats.connectAttempts - storm.attemptsBefore),
+           (unsigned long)(fleetStats.connectFailures - storm.failuresBefore));
+    printLatency("风暴中 连接 → CONNACK", fleetStats.connectMs);
+  } else {
+    printLatency("连接 → CONNACK", fleetStats.connectMs);
+  }
+}
+
+// ========================== 主循环 ==========================
+
+int main(int argc, char** argv) {
+  if (!parseArgs(argc, argv)) {
+    usage(argv[0]);
+    return 1;
+  }
+  srand((unsigned)time(nullptr));
+  raiseFileLimit();
+
+  if (config.httpTelemetry && !receiver.listen(ntohs(config.receiver.sin_port))) {
+    fprintf(stderr, "❌ HTTP 接收端无法监听端口 %u\n", (unsigned)ntohs(config.receiver.sin_port));
+    return 1;
+  }
+  if (!controllerConnect()) {
+    fprintf(stderr, "❌ 控制端无法连接 broker（mosquitto 是否已启动？）\n");
+    return 1;
+  }
+
+  uint64_t start = monotonicMs();
+  devices.resize(config.devices);
+  for (uint32_t i = 0; i < config.devices; i++) {
+    if (!devices[i].init(i, config, start + (uint64_t)config.rampMs * i / config.devices)) {
+      fprintf(stderr, "❌ 设备命名空间无效: %s\n", config.ns);
+      return 1;
+    }
+  }
+  printf("🚀 %lu 台虚拟设备，命名空间 %s/%s-*，遥测经 %s，运行 %lu 秒\n", (unsigned long)config.devices,
+         config.ns, config.idPrefix, config.httpTelemetry ? "HTTP" : "MQTT", (unsigned long)config.durationSec);
+
+  uint64_t end = start + (uint64_t)config.durationSec * 1000;
+  uint64_t lastMs = start;
+  uint64_t lastProgress = start;
+  StormResult storm = {};
+  Traffic lastTraffic = {};
+  std::vector<struct pollfd> fds;
+  fds.reserve(config.devices * 2 + 64);
+
+  for (;;) {
+    fds.clear();
+    fds.push_back({controller.conn.fd(), controller.conn.pollEvents(), 0});
+    size_t receiverCount = receiver.addPollFds(fds);
+    size_t devicesAt = fds.size();
+    for (const FleetDevice& d : devices) {
+      d.addPollFds(fds);
+    }
+    poll(fds.data(), fds.size(), POLL_MS);
+
+    uint64_t now = monotonicMs();
+    uint64_t unixNow = unixMs();
+    if (now >= end) {
+      break;
+    }
+    if (fds[0].revents != 0 && !controller.conn.service(fds[0].revents, now)) {
+      fprintf(stderr, "❌ 控制端与 broker 断开\n");
+      break;
+    }
+    receiver.service(fds.data() + 1, receiverCount);
+    for (size_t i = 0; i < devices.size(); i++) {
+      devices[i].service(fds.data() + devicesAt + i * 2, now, unixNow);
+    }
+
+    // 首次连接分散完成后才开始发指令，结束前留出等待应答的时间
+    controllerTick(now, now - lastMs, now >= start + config.rampMs && now + COMMAND_GRACE_MS < end);
+    for (FleetDevice& d : devices) {
+      d.tick(now, unixNow);
+    }
+    lastMs = now;
+
+    if (config.stormAtSec >= 0 && !storm.triggered && now >= start + (uint64_t)config.stormAtSec * 1000) {
+      printf("⚡ 第 %d 秒：所有设备同时断线\n", config.stormAtSec);
+      printLatency("启动时 连接 → CONNACK", fleetStats.connectMs);
+      fleetStats.connectMs.clear();
+      storm.triggered = true;
+      storm.startMs = now;
+      storm.attemptsBefore = fleetStats.connectAttempts;
+      storm.failuresBefore = fleetStats.connectFailures;
+      for (FleetDevice& d : devices) {
+        d.drop(now);
+      }
+    }
+    if (storm.triggered && storm.reachedMs[2] == 0) {
+      uint32_t online = connectedCount();
+      static const uint32_t THRESHOLDS[3] = {50, 90, 100};
+      for (int i = 0; i < 3; i++) {
+        if (storm.reachedMs[i] == 0 && online * 100 >= config.devices * THRESHOLDS[i]) {
+          storm.reachedMs[i] = now;
+        }
+      }
+    }
+
+    if (now - lastProgress >= PROGRESS_MS) {
+      Traffic t = brokerTraffic();
+      double sec = (now - lastProgress) / 1000.0;
+      printf("[%4lus] 在线 %lu/%lu  发布 %.0f/s  投递 %.0f/s  指令 %lu/%lu  遥测批次 %lu\n",
+             (unsigned long)((now - start) / 1000), (unsigned long)connectedCount(),
+             (unsigned long)config.devices, (t.publishes - lastTraffic.publishes) / sec,
+             (t.deliveries - lastTraffic.deliveries) / sec, (unsigned long)controller.acksReceived,
+             (unsigned long)controller.commandsSent, (unsigned long)fleetStats.batchesSent);
+      lastTraffic = t;
+      lastProgress = now;
+    }
+  }
+
+  printSummary(monotonicMs() - start, storm);
+  controller.conn.close();
+  return 0;
+}
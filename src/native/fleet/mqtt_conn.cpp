@@ -0,0 +1,321 @@
+// ============================================================================
+// 设备群模拟器：非阻塞 MQTT 3.1.1 客户端实现
+// ============================================================================
+#include "mqtt_conn.h"
+#include <errno.h>
+#include <fcntl.h>
+#include <netinet/tcp.h>
+#include <poll.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#define MQTT_CONNECT    0x10
+#define MQTT_CONNACK    0x20
+#define MQTT_PUBLISH    0x30
+#define MQTT_PUBACK     0x40
+#define MQTT_SUBSCRIBE  0x82
+#define MQTT_SUBACK     0x90
+#define MQTT_PINGREQ    0xC0
+#define MQTT_PINGRESP   0xD0
+#define MQTT_DISCONNECT 0xE0
+
+#define READ_CHUNK 4096
+
+static void putU16(std::vector<uint8_t>& buf, uint16_t v) {
+  buf.push_back(v >> 8);
+  buf.push_back(v & 0xFF);
+}
+
+static void putString(std::vector<uint8_t>& buf, const char* s, size_t length) {
+  putU16(buf, (uint16_t)length);
+  buf.insert(buf.end(), (const uint8_t*)s, (const uint8_t*)s + length);
+}
+
+MqttConn::MqttConn()
+    : sock(-1), state(STATE_IDLE), connack(0), keepAliveMs(0), nextPacketId(1), lastSendMs(0),
+      outPos(0), handler(nullptr), handlerCtx(nullptr), stats{} {}
+
+MqttConn::~MqttConn() { reset(); }
+
+void MqttConn::setHandler(MessageHandler fn, void* ctx) {
+  handler = fn;
+  handlerCtx = ctx;
+}
+
+void MqttConn::reset() {
+  if (sock >= 0) {
+    ::close(sock);
+  }
+  sock = -1;
+  state = STATE_IDLE;
+  out.clear();
+  outPos = 0;
+  in.clear();
+}
+
+bool MqttConn::open(const sockaddr_in& broker, const char* clientId, const char* willTopic,
+                    const char* willMessage, uint16_t keepAliveSec, uint64_t nowMs) {
+  reset();
+  sock = socket(AF_INET, SOCK_STREAM, 0);
+  if (sock < 0) {
+    return false;
+  }
+  fcntl(sock, F_SETFL, fcntl(sock, F_GETFL) | O_NONBLOCK);
+  int one = 1;
+  setsockopt(sock, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));  // 与固件 setNoDelay(true) 一致
+  if (connect(sock, (const sockaddr*)&broker, sizeof(broker)) != 0 && errno != EINPROGRESS) {
+    reset();
+    return false;
+  }
+
+  // CONNECT 先放进发送缓冲，TCP 建立后发出
+  bool will = willTopic != nullptr && willTopic[0] != '\0';
+  std::vector<uint8_t> body;
+  putString(body, "MQTT", 4);
+  body.push_back(4);  // 协议级别 3.1.1
+  body.push_back(0x02 | (will ? 0x04 | 0x08 | 0x20 : 0));  // 清除会话；遗嘱 QoS 1、retained
+  putU16(body, keepAliveSec);
+  putString(body, clientId, strlen(clientId));
+  if (will) {
+    putString(body, willTopic, strlen(willTopic));
+    putString(body, willMessage, strlen(willMessage));
+  }
+  queuePacket(MQTT_CONNECT, body.data(), body.size());
+
+  state = STATE_TCP_CONNECTING;
+  connack = 0;
+  keepAliveMs = keepAliveSec * 1000u;
+  lastSendMs = nowMs;
+  return true;
+}
+
+void MqttConn::drop() { reset(); }
+
+void MqttConn::close() {
+  if (state == STATE_CONNECTED) {
+    queuePacket(MQTT_DISCONNECT, nullptr, 0);
+    flush();
+  }
+  reset();
+}
+
+short MqttConn::pollEvents() const {
+  if (sock < 0) {
+    return 0;
+  }
+  if (state == STATE_TCP_CONNECTING) {
+    return POLLOUT;
+  }
+  return POLLIN | (outPos < out.size() ? POLLOUT : 0);
+}
+
+void MqttConn::queuePacket(uint8_t header, const uint8_t* body, size_t length) {
+  out.push_back(header);
+  size_t remaining = length;
+  do {
+    uint8_t b = remaining % 128;
+    remaining /= 128;
+    out.push_back(remaining > 0 ? b | 0x80 : b);
+  } while (remaining > 0);
+  if (length > 0) {
+    out.insert(out.end(), body, body + length);
+  }
+}
+
+// 尽量写出发送缓冲；对方关闭或出错时返回 false
+bool MqttConn::flush() {
+  if (state == STATE_TCP_CONNECTING) {
+    return true;
+  }
+  while (outPos < out.size()) {
+    ssize_t n = send(sock, out.data() + outPos, out.size() - outPos, MSG_NOSIGNAL);
+    if (n < 0) {
+      return errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR;
+    }
+    outPos += n;
+    stats.bytesOut += n;
+  }
+  out.clear();
+  outPos = 0;
+  return true;
+}
+
+bool MqttConn::service(short revents, uint64_t nowMs) {
+  if (sock < 0) {
+    return false;
+  }
+  if (state == STATE_TCP_CONNECTING) {
+    if (!(revents & (POLLOUT | POLLERR | POLLHUP))) {
+      return true;
+    }
+    int err = 0;
+    socklen_t len = sizeof(err);
+    getsockopt(sock, SOL_SOCKET, SO_ERROR, &err, &len);
+    if (err != 0) {
+      reset();
+      return false;
+    }
+    state = STATE_WAIT_CONNACK;
+    lastSendMs = nowMs;
+  }
+  if ((revents & (POLLIN | POLLERR | POLLHUP)) && !readPackets()) {
+    reset();
+    return false;
+  }
+  if (!flush()) {
+    reset();
+    return false;
+  }
+  return true;
+}
+
+bool MqttConn::readPackets() {
+  uint8_t chunk[READ_CHUNK];
+  for (;;) {
+    ssize_t n = recv(sock, chunk, sizeof(chunk), 0);
+    if (n == 0) {
+      return false;
+    }
+    if (n < 0) {
+      if (errno == EAGAIN || errno == EWOULDBLOCK) {
+        break;
+      }
+      if (errno == EINTR) {
+        continue;
+      }
+      return false;
+    }
+    stats.bytesIn += n;
+    in.insert(in.end(), chunk, chunk + n);
+    if ((size_t)n < sizeof(chunk)) {
+      break;
+    }
+  }
+
+  // 逐个取出完整的报文
+  size_t pos = 0;
+  while (in.size() - pos >= 2) {
+    size_t length = 0;
+    size_t i = pos + 1;
+    uint32_t multiplier = 1;
+    bool complete = false;
+    while (i < in.size() && i < pos + 5) {
+      uint8_t b = in[i++];
+      length += (b & 0x7F) * multiplier;
+      multiplier *= 128;
+      if (!(b & 0x80)) {
+        complete = true;
+        break;
+      }
+    }
+    if (!complete) {
+      if (i >= pos + 5) {
+        return false;  // 剩余长度超过 4 字节
+      }
+      break;
+    }
+    if (in.size() - i < length) {
+      break;
+    }
+    if (!handlePacket(in[pos], in.data() + i, length)) {
+      return false;
+    }
+    pos = i + length;
+  }
+  in.erase(in.begin(), in.begin() + pos);
+  return true;
+}
+
+bool MqttConn::handlePacket(uint8_t header, const uint8_t* body, size_t length) {
+  switch (header & 0xF0) {
+    case MQTT_CONNACK:
+      if (state != STATE_WAIT_CONNACK || length < 2) {
+        return false;
+      }
+      connack = body[1];
+      if (connack != 0) {
+        return false;  // 服务器拒绝
+      }
+      state = STATE_CONNECTED;
+      return true;
+
+    case MQTT_PUBLISH: {
+      uint8_t qos = (header >> 1) & 0x03;
+      if (length < 2) {
+        return false;
+      }
+      size_t topicLen = ((size_t)body[0] << 8) | body[1];
+      size_t offset = 2 + topicLen + (qos > 0 ? 2 : 0);
+      if (offset > length) {
+        return false;
+      }
+      topic.assign((const char*)body + 2, topicLen);
+      if (qos > 0) {
+        uint8_t id[2] = {body[2 + topicLen], body[3 + topicLen]};
+        queuePacket(MQTT_PUBACK, id, sizeof(id));
+      }
+      stats.messagesIn++;
+      if (handler) {
+        handler(handlerCtx, topic.c_str(), body + offset, length - offset);
+      }
+      return true;
+    }
+
+    case MQTT_PUBACK:
+    case MQTT_SUBACK:
+    case MQTT_PINGRESP:
+      return true;
+
+    default:
+      return false;
+  }
+}
+
+void MqttConn::tick(uint64_t nowMs) {
+  if (state != STATE_CONNECTED || keepAliveMs == 0) {
+    return;
+  }
+  if (nowMs - lastSendMs >= keepAliveMs / 2) {
+    queuePacket(MQTT_PINGREQ, nullptr, 0);
+    lastSendMs = nowMs;
+    flush();
+  }
+}
+
+bool MqttConn::publish(const char* topicName, const uint8_t* payload, size_t length, bool retained, uint8_t qos) {
+  if (state != STATE_CONNECTED) {
+    return false;
+  }
+  scratch.clear();
+  putString(scratch, topicName, strlen(topicName));
+  if (qos > 0) {
+    putU16(scratch, nextPacketId);
+    nextPacketId = nextPacketId == 0xFFFF ? 1 : nextPacketId + 1;
+  }
+  scratch.insert(scratch.end(), payload, payload + length);
+  queuePacket(MQTT_PUBLISH | (qos > 0 ? 0x02 : 0) | (retained ? 0x01 : 0), scratch.data(), scratch.size());
+  stats.publishesOut++;
+  // 立即尝试写出，不等下一轮 poll（与固件逐条 publish 的时序一致）；
+  // 可能在消息回调中调用，写失败留给下一次 service() 关闭连接
+  flush();
+  return true;
+}
+
+bool MqttConn::publish(const char* topicName, const char* payload, bool retained) {
+  return publish(topicName, (const uint8_t*)payload, strlen(payload), retained, 0);
+}
+
+bool MqttConn::subscribe(const char* topicFilter, uint8_t qos) {
+  if (state != STATE_CONNECTED) {
+    return false;
+  }
+  scratch.clear();
+  putU16(scratch, nextPacketId);
+  nextPacketId = nextPacketId == 0xFFFF ? 1 : nextPacketId + 1;
+  putString(scratch, topicFilter, strlen(topicFilter));
+  scratch.push_back(qos);
+  queuePacket(MQTT_SUBSCRIBE, scratch.data(), scratch.size());
+  flush();
+  return true;
+}
@@ -0,0 +1,85 @@
+// ============================================================================
+// 设备群模拟器：非阻塞 MQTT 3.1.1 客户端
+// 功能：一个进程内成千上万条连接共用一个 poll() 循环，因此不用 PubSubClient
+//       （它的 connect() 阻塞到 CONNACK 或超时，重连风暴时会把所有设备串行化）。
+//       只实现模拟需要的部分：CONNECT（含遗嘱）、SUBSCRIBE、QoS 0/1 PUBLISH、
+//       收到 QoS 1 消息时回 PUBACK、PINGREQ 保活；不重发、不做持久会话
+// ============================================================================
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+#include <netinet/in.h>
+#include <string>
+#include <vector>
+
+struct MqttConnCounters {
+  uint64_t publishesOut;
+  uint64_t messagesIn;
+  uint64_t bytesOut;
+  uint64_t bytesIn;
+};
+
+class MqttConn {
+ public:
+  typedef void (*MessageHandler)(void* ctx, const char* topic, const uint8_t* payload, size_t length);
+
+  MqttConn();
+  ~MqttConn();
+
+  void setHandler(MessageHandler handler, void* ctx);
+
+  // 发起非阻塞连接，CONNECT 在 TCP 建立后发出；willTopic 为空时不带遗嘱
+  bool open(const sockaddr_in& broker, const char* clientId, const char* willTopic,
+            const char* willMessage, uint16_t keepAliveSec, uint64_t nowMs);
+  // 直接关闭 socket（不发 DISCONNECT，broker 会发布遗嘱），用于模拟断线
+  void drop();
+  // 发送 DISCONNECT 后关闭
+  void close();
+
+  int fd() const { return sock; }
+  bool idle() const { return state == STATE_IDLE; }
+  bool connected() const { return state == STATE_CONNECTED; }
+  short pollEvents() const;
+
+  // poll() 返回后调用；连接断开、被拒绝或协议错误时关闭连接并返回 false
+  bool service(short revents, uint64_t nowMs);
+  // 保活：每半个保活周期发一次 PINGREQ
+  void tick(uint64_t nowMs);
+
+  bool publish(const char* topic, const uint8_t* payload, size_t length, bool retained = false, uint8_t qos = 0);
+  bool publish(const char* topic, const char* payload, bool retained = false);
+  bool subscribe(const char* topic, uint8_t qos = 0);
+
+  uint8_t connackCode() const { return connack; }
+  const MqttConnCounters& counters() const { return stats; }
+
+ private:
+  enum State : uint8_t {
+    STATE_IDLE = 0,
+    STATE_TCP_CONNECTING,
+    STATE_WAIT_CONNACK,
+    STATE_CONNECTED,
+  };
+
+  void reset();
+  void queuePacket(uint8_t header, const uint8_t* body, size_t length);
+  bool flush();
+  bool readPackets();
+  bool handlePacket(uint8_t header, const uint8_t* body, size_t length);
+
+  int sock;
+  State state;
+  uint8_t connack;
+  uint32_t keepAliveMs;
+  uint16_t nextPacketId;
+  uint64_t lastSendMs;
+  std::vector<uint8_t> out;
+  size_t outPos;
+  std::vector<uint8_t> in;
+  std::vector<uint8_t> scratch;
+  std::string topic;
+  MessageHandler handler;
+  void* handlerCtx;
+  MqttConnCounters stats;
+};
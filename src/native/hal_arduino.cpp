@@ -0,0 +1,225 @@
+// ============================================================================
+// 主机构建 HAL：模拟时钟、String、Print/Stream 与假串口实现
+// ============================================================================
+#include <Arduino.h>
+
+// ========================== 模拟时钟 ==========================
+
+static uint32_t mockMillis = 0;
+
+unsigned long millis() { return mockMillis; }
+unsigned long micros() { return (unsigned long)mockMillis * 1000UL; }
+void delay(uint32_t ms) { mockMillis += ms; }
+void nativeSetMillis(uint32_t ms) { mockMillis = ms; }
+void nativeAdvanceMillis(uint32_t ms) { mockMillis += ms; }
+
+// ========================== String ==========================
+
+void String::assign(const char* cstr, unsigned int n) {
+  char* next = nullptr;
+  if (n > 0) {
+    next = new char[n + 1];
+    memcpy(next, cstr, n);
+    next[n] = '\0';
+  }
+  delete[] buf;
+  buf = next;
+  len = n;
+}
+
+String& String::append(const char* cstr, unsigned int n) {
+  if (n == 0) {
+    return *this;
+  }
+  char* next = new char[len + n + 1];
+  if (len > 0) {
+    memcpy(next, buf, len);
+  }
+  memcpy(next + len, cstr, n);
+  next[len + n] = '\0';
+  delete[] buf;
+  buf = next;
+  len += n;
+  return *this;
+}
+
+static const char* formatInteger(char* out, size_t size, unsigned long value, bool negative, unsigned char base) {
+  char digits[34];
+  int pos = 0;
+  do {
+    int d = (int)(value % base);
+    digits[pos++] = (char)(d < 10 ? '0' + d : 'a' + d - 10);
+    value /= base;
+  } while (value > 0 && pos < (int)sizeof(digits));
+  size_t n = 0;
+  if (negative && n + 1 < size) out[n++] = '-';
+  while (pos > 0 && n + 1 < size) out[n++] = digits[--pos];
+  out[n] = '\0';
+  return out;
+}
+
+String::String(int value, unsigned char base) : String((long)value, base) {}
+String::String(unsigned int value, unsigned char base) : String((unsigned long)value, base) {}
+
+String::String(long value, unsigned char base) {
+  char tmp[36];
+  bool negative = value < 0 && base == 10;
+  unsigned long magnitude = negative ? (unsigned long)(-(value + 1)) + 1 : (unsigned long)value;
+  formatInteger(tmp, sizeof(tmp), magnitude, negative, base);
+  assign(tmp, strlen(tmp));
+}
+
+String::String(unsigned long value, unsigned char base) {
+  char tmp[36];
+  formatInteger(tmp, sizeof(tmp), value, false, base);
+  assign(tmp, strlen(tmp));
+}
+
+String::String(float value, unsigned char decimalPlaces) : String((double)value, decimalPlaces) {}
+
+String::String(double value, unsigned char decimalPlaces) {
+  char tmp[48];
+  snprintf(tmp, sizeof(tmp), "%.*f", decimalPlaces, value);
+  assign(tmp, strlen(tmp));
+}
+
+String& String::operator=(const String& other) {
+  if (this != &other) {
+    assign(other.buf, other.len);
+  }
+  return *this;
+}
+
+String& String::operator=(const char* cstr) {
+  assign(cstr, cstr ? strlen(cstr) : 0);
+  return *this;
+}
+
+void String::trim() {
+  if (len == 0) {
+    return;
+  }
+  unsigned int begin = 0;
+  unsigned int end = len;
+  while (begin < end && isspace((unsigned char)buf[begin])) begin++;
+  while (end > begin && isspace((unsigned char)buf[end - 1])) end--;
+  if (begin == 0 && end == len) {
+    return;
+  }
+  memmove(buf, buf + begin, end - begin);
+  len = end - begin;
+  buf[len] = '\0';
+}
+
+String operator+(const String& lhs, const String& rhs) {
+  String result(lhs);
+  result += rhs;
+  return result;
+}
+
+String operator+(const String& lhs, const char* rhs) {
+  String result(lhs);
+  result += rhs;
+  return result;
+}
+
+String operator+(const char* lhs, const String& rhs) {
+  String result(lhs);
+  result += rhs;
+  return result;
+}
+
+// ========================== Print / Stream ==========================
+
+size_t Print::write(const uint8_t* buffer, size_t size) {
+  size_t n = 0;
+  while (size--) {
+    n += write(*buffer++);
+  }
+  return n;
+}
+
+size_t Print::print(int value) {
+  char tmp[16];
+  snprintf(tmp, sizeof(tmp), "%d", value);
+  return write(tmp);
+}
+
+size_t Print::println(const char* str) {
+  size_t n = write(str);
+  return n + write("\r\n");
+}
+
+size_t Print::printf(const char* format, ...) {
+  char tmp[256];
+  va_list args;
+  va_start(args, format);
+  int len = vsnprintf(tmp, sizeof(tmp), format, args);
+  va_end(args);
+  if (len < 0) {
+    return 0;
+  }
+  return write((const uint8_t*)tmp, min((size_t)len, sizeof(tmp) - 1));
+}
+
+String Stream::readStringUntil(char terminator) {
+  String result;
+  while (available() > 0) {
+    int c = read();
+    if (c < 0 || c == terminator) {
+      break;
+    }
+    result += (char)c;
+  }
+  return result;
+}
+
+// ========================== 假串口 ==========================
+
+HardwareSerial Serial(0);
+HardwareSerial Serial2(2);
+
+void HardwareSerial::begin(unsigned long baud, uint32_t config, int8_t rxPin, int8_t txPin) {
+  tx.clear();
+  rxHead = 0;
+  rxCount = 0;
+  txCount = 0;
+}
+
+size_t HardwareSerial::write(uint8_t c) {
+  txCount++;
+  if (echo) {
+    fputc(c, stdout);
+  }
+  // 只保留最近的输出，避免长时间基准中无限增长
+  if (tx.size() >= 4096) {
+    tx.erase(0, 2048);
+  }
+  tx.push_back((char)c);
+
+  // 模拟模块：收到一行命令后立即回复并触发接收回调
+  if (c == '\n' && !autoReply.empty()) {
+    injectRx(autoReply.c_str());
+  }
+  return 1;
+}
+
+int HardwareSerial::read() {
+  if (rxCount == 0) {
+    return -1;
+  }
+  uint8_t c = rx[rxHead];
+  rxHead = (rxHead + 1) % sizeof(rx);
+  rxCount--;
+  return c;
+}
+
+void HardwareSerial::injectRx(const char* data) {
+  while (*data && rxCount < sizeof(rx)) {
+    rx[(rxHead + rxCount) % sizeof(rx)] = (uint8_t)*data++;
+    rxCount++;
+  }
+  if (receiveCallback != nullptr) {
+    receiveCallback();
+  }
+}
@@ -0,0 +1,33 @@
+// ============================================================================
+// 主机构建 HAL：内存屏幕实现
+// ============================================================================
+#include "native_hal.h"
+
+MemoryPanel::MemoryPanel() {
+  resetStats();
+}
+
+void MemoryPanel::resetStats() {
+  memset(&totals, 0, sizeof(totals));
+}
+
+uint32_t MemoryPanel::flush(FrameBuffer& fb) {
+  DirtyRect rects[FB_MAX_DIRTY_RECTS];
+  fb.frameEnd();
+  uint8_t n = fb.takeDirtyRects(rects, FB_MAX_DIRTY_RECTS);
+  uint32_t pixels = 0;
+
+  for (uint8_t i = 0; i < n; i++) {
+    pixels += (uint32_t)rects[i].w * rects[i].h;
+  }
+  uint32_t bytes = n * RENDER_SPI_RECT_OVERHEAD + pixels * 2;
+  if (n > 0) {
+    renderNoteFlush(n, pixels, 0);  // 内存屏幕没有传输时间
+  }
+
+  totals.flushes++;
+  totals.rects += n;
+  totals.pixels += pixels;
+  totals.spiBytes += bytes;
+  return bytes;
+}
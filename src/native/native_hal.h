@@ -0,0 +1,53 @@
+// ============================================================================
+// 主机构建 HAL：测试钩子
+// 功能：内存屏幕（统计 SPI 流量）、脚本化传感器、同步假红外模块，
+//       供基准和回归程序驱动界面与控制逻辑
+// ============================================================================
+#pragma once
+
+#include <Arduino.h>
+#include "../framebuffer.h"
+#include "../render_stats.h"
+
+// ---------------------------- 内存屏幕 ----------------------------
+// 代替 PanelDMA：取走脏矩形并按 ST7789 协议估算 SPI 字节数
+// （每个矩形 RENDER_SPI_RECT_OVERHEAD 字节窗口设置，另加每像素 2 字节）
+
+struct MemoryPanelStats {
+  uint32_t flushes;
+  uint32_t rects;
+  uint64_t pixels;
+  uint64_t spiBytes;
+};
+
+class MemoryPanel {
+ public:
+  MemoryPanel();
+
+  // 推送当前脏矩形，返回本次的 SPI 字节数
+  uint32_t flush(FrameBuffer& fb);
+
+  const MemoryPanelStats& stats() const { return totals; }
+  void resetStats();
+
+ private:
+  MemoryPanelStats totals;
+};
+
+// ---------------------------- 脚本化传感器 ----------------------------
+// sensorTaskBegin()/sensorLatest() 的主机实现：按模拟时钟依次"读出"脚本中的值，
+// 经过与设备相同的 SensorFilter
+struct SensorScriptStep {
+  uint32_t atMs;       // 模拟时钟到达该时间后生效
+  float temperature;   // NAN 表示这次读取失败
+  float humidity;
+};
+
+void nativeSensorScript(const SensorScriptStep* steps, size_t count);
+void nativeSensorReset();
+
+// ---------------------------- 假红外模块 ----------------------------
+// irSubmit() 的主机实现：同步写入 Serial2（假串口），模块回复由 setAutoReply 预置
+void nativeIrReset();
+uint32_t nativeIrSentCount();
+uint32_t nativeIrAckedCount();
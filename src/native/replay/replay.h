@@ -0,0 +1,253 @@
+// ============================================================================
+// 定时控制回放
+// 功能：在虚拟时钟上运行固件的定时决策 acScheduleRun()（与 runACSchedule() 同一份代码），
+//       按主循环的方式调度：单次定时器到期、SNTP 同步、规则更新时运行，重启后从
+//       最后保存的 lastRun 继续。输入可以是设备记录的轨迹（schedule_trace.h），
+//       也可以是合成的时间线：工作日/周末、夏令时、每小时 NTP 校正和跳变、重启、传感器断续。
+//       检查器独立于控制代码，只看设备的本地墙上时间：本地时间到达规则的时分（当天星期匹配）
+//       后，该规则当天应处理恰好一次；据此统计漏执行、重复执行和延迟，并测量每模拟日的 CPU 时间
+// 运行：pio run -e replay && .pio/build/replay/program --days 365
+//       .pio/build/replay/program --trace trace.1 --trace trace.bin
+// ============================================================================
+#pragma once
+
+#include <Arduino.h>
+#include <map>
+#include <vector>
+#include "../../ac_control.h"
+#include "../../schedule_trace.h"
+
+#define REPLAY_LATE_MS      2000    // 默认的延迟阈值：事件时间之后超过该值才处理记为延迟
+#define REPLAY_MAX_ISSUES   10000   // 保存明细的上限，计数不受限制
+#define REPLAY_NEVER        UINT64_MAX
+
+enum ReplayIssueKind : uint8_t {
+  REPLAY_MISSED = 0,    // 到期后没有处理（如关机或时间跳变超过补执行窗口）
+  REPLAY_DUPLICATE,     // 同一规则同一天处理了多次
+  REPLAY_LATE,          // 处理时间比本地时间到达规则时分晚 lateMs 以上
+  REPLAY_UNEXPECTED,    // 处理了检查器不认为到期的事件（星期或日期不对、规则更新前已过的时刻）
+  REPLAY_ISSUE_KINDS,
+};
+
+// 问题发生前后的情况，帮助定位原因
+enum ReplayCause : uint8_t {
+  REPLAY_CAUSE_NONE = 0,
+  REPLAY_CAUSE_SENSOR = 1,     // 期间因缺少温度读数重试过
+  REPLAY_CAUSE_TIME = 2,       // 期间系统时间跳变或同步过
+  REPLAY_CAUSE_BOOT = 4,       // 期间重启过
+  REPLAY_CAUSE_CATCHUP = 8,    // 检查器发现时已超过补执行窗口（AC_SCHEDULE_CATCHUP_SEC）
+};
+
+struct ReplayIssue {
+  ReplayIssueKind kind;
+  uint8_t rule;
+  uint8_t causes;     // ReplayCause 位
+  time_t wall;        // 应处理的时刻（本地时间到达规则时分时的系统时间）或实际处理时刻
+  int64_t lateMs;     // 处理时刻 - 应处理时刻（虚拟时钟）
+};
+
+// 一次处理（DISABLED/EXECUTED），用于与轨迹中记录的结果对比
+struct ReplayHandled {
+  uint64_t key;       // replayKey(事件日期, 规则)
+  uint64_t vms;
+  AcRunOutcome outcome;
+  AcAction action;
+  int64_t lateMs;     // 相对检查器的应处理时刻，不在期望中时为 -1
+};
+
+struct ReplayCounters {
+  uint64_t runs;
+  uint64_t notSynced;
+  uint64_t waitSensor;
+  uint64_t idle;
+  uint64_t disabled;
+  uint64_t executed;
+  uint64_t actionsOn;
+  uint64_t actionsOff;
+  uint64_t conditionSkipped;   // 温度条件不满足，未发送
+  uint64_t expected;           // 检查器认为应处理的次数
+  uint64_t pending;            // 结束时仍在补执行窗口内、尚未处理
+  uint64_t boots;
+  uint64_t timeEvents;         // 同步和跳变
+  uint64_t commands;           // 轨迹中的远程指令
+  uint64_t issues[REPLAY_ISSUE_KINDS];
+  uint64_t controlNs;          // acScheduleRun() 的累计耗时
+};
+
+// 事件日期（本地，yyyymmdd）和规则下标组成的键
+uint64_t replayKey(time_t due, uint8_t rule);
+
+// 模拟设备的定时部分和检查器
+class ScheduleSim {
+ public:
+  explicit ScheduleSim(uint32_t lateMs);
+
+  // 设备端（时间线调用）
+  void boot(uint64_t vms);    // 上电：lastRun 恢复为最后保存的值，setup() 末尾立即运行一次
+  void powerOff();
+  // 启动时从 NVS 加载的状态（轨迹中的 TRACE_STATE）
+  void load(const AcSchedule& rules, bool enabled, time_t lastRun, uint64_t vms, time_t now);
+  // 运行中收到的规则/开关更新：立即运行；now 之前已过的规则时刻今天不再期望
+  void update(const AcSchedule& rules, bool enabled, uint64_t vms, time_t now);
+  void timeSync(uint64_t vms);   // EV_TIME_SYNC：立即运行
+  void noteTimeJump(uint64_t vms);
+  void noteCommand() { totals.commands++; }
+
+  bool up() const { return powered; }
+  uint64_t wakeAt() const { return powered ? wakeMs : REPLAY_NEVER; }
+  void run(uint64_t vms, time_t now, bool hasSample, float temperature);
+
+  // 检查器：本地时间每到整分钟或时间跳变后调用
+  void observe(uint64_t vms, time_t now);
+  void finish(uint64_t endVms);
+
+  const AcSchedule& schedule() const { return rules; }
+  bool enabled() const { return scheduleEnabled; }
+  const ReplayCounters& counters() const { return totals; }
+  const std::vector<ReplayIssue>& issues() const { return issueLog; }
+  const std::vector<ReplayHandled>& handled() const { return handledLog; }
+
+ private:
+  struct Occurrence {
+    uint64_t expectedVms;
+    time_t expectedWall;
+    uint8_t rule;
+    bool expected;      // false：规则更新时已过，不期望处理
+    bool catchupOver;   // 检查器发现时已超过补执行窗口
+    uint32_t handled;
+  };
+
+  void addIssue(ReplayIssueKind kind, const Occurrence& o, time_t wall, int64_t lateMs, uint64_t sinceVms);
+  uint8_t causesSince(uint64_t vms) const;
+  void suppressPassed(time_t now);
+
+  uint32_t lateLimitMs;
+  AcSchedule rules;
+  bool scheduleEnabled;
+  time_t lastRun;
+  time_t savedLastRun;      // NVS 中的值：只在处理事件后保存
+  bool powered;
+  uint64_t wakeMs;
+
+  uint64_t lastSensorWaitVms;
+  uint64_t lastTimeEventVms;
+  uint64_t lastBootVms;
+
+  std::map<uint64_t, Occurrence> occurrences;
+  std::vector<ReplayIssue> issueLog;
+  std::vector<ReplayHandled> handledLog;
+  ReplayCounters totals;
+};
+
+// 虚拟时钟的输入
+class ReplayTimeline {
+ public:
+  virtual ~ReplayTimeline() {}
+  // 下一个离散事件（重启、时间跳变/同步、规则更新、读数变化……）的虚拟时间，没有时为 REPLAY_NEVER
+  virtual uint64_t nextEventMs() const = 0;
+  // 处理 nextEventMs() 时刻的一个事件
+  virtual void fire(ScheduleSim& sim) = 0;
+  // 设备在 vms 时刻的系统时间（毫秒），两次事件之间随虚拟时钟匀速前进
+  virtual int64_t systemMs(uint64_t vms) const = 0;
+  // vms 时刻 sensorLatest() 的结果
+  virtual bool sample(uint64_t vms, float& temperature) = 0;
+  virtual uint64_t endMs() const = 0;
+};
+
+// 运行到时间线结束；返回检查器观察的次数
+uint64_t replayRun(ReplayTimeline& timeline, ScheduleSim& sim);
+
+// ---------------------------- 时间线 ----------------------------
+
+struct SyntheticConfig {
+  time_t start;             // 第一天本地 0 点
+  uint32_t days;
+  double driftPpm;          // 设备晶振相对真实时间的偏差，每次同步时校正
+  uint32_t syncMinutes;     // SNTP 同步间隔（IDF 默认 1 小时）
+  double jumpsPerDay;       // NTP 服务器给出错误时间的频率，下一次同步时纠正
+  uint32_t jumpMaxSec;
+  double rebootsPerDay;     // 热启动时间继续 / 热启动从 RTC 恢复复位前的时间 / 冷启动时间未同步，各占三分之一
+  double sensorGapsPerDay;  // 传感器断续：每次 1～30 分钟没有有效读数
+  uint64_t seed;
+};
+
+// 合成时间线：事件在构造时按种子生成，同样的参数每次结果相同
+class SyntheticTimeline : public ReplayTimeline {
+ public:
+  explicit SyntheticTimeline(const SyntheticConfig& config);
+
+  uint64_t nextEventMs() const override;
+  void fire(ScheduleSim& sim) override;
+  int64_t systemMs(uint64_t vms) const override;
+  bool sample(uint64_t vms, float& temperature) override;
+  uint64_t endMs() const override { return endVms; }
+
+ private:
+  enum Kind : uint8_t {
+    SYNC = 0,      // 系统时间设为真实时间
+    JUMP,          // 系统时间偏移 value 秒
+    POWER_OFF,
+    BOOT_WARM,     // 系统时间继续
+    BOOT_RESTORE,  // 系统时间恢复为复位前保存的值（落后于停机时长）
+    BOOT_COLD,     // 系统时间从 0 开始，直到同步
+  };
+  struct Event {
+    uint64_t vms;
+    Kind kind;
+    int32_t value;
+  };
+  struct Gap {
+    uint64_t from, to;
+  };
+
+  int64_t trueMs(uint64_t vms) const;
+
+  SyntheticConfig cfg;
+  std::vector<Event> events;
+  size_t cursor;
+  std::vector<Gap> gaps;
+  size_t gapCursor;
+  uint64_t endVms;
+  int64_t offsetMs;      // 系统时间 = vms + offsetMs
+  int64_t lastKnownMs;   // 关机时的系统时间
+  uint64_t bootVms;
+};
+
+// 设备轨迹：每次启动的 millis() 接在前一次之后，停机时长按前后的系统时间估计
+class TraceTimeline : public ReplayTimeline {
+ public:
+  TraceTimeline();
+
+  // 按时间顺序读取一个或多个轨迹文件；格式错误时打印原因并返回 false
+  bool load(const std::vector<const char*>& paths);
+
+  uint64_t nextEventMs() const override;
+  void fire(ScheduleSim& sim) override;
+  int64_t systemMs(uint64_t vms) const override;
+  bool sample(uint64_t vms, float& temperature) override;
+  uint64_t endMs() const override;
+
+  size_t size() const { return trace.size(); }
+  // 设备实际的处理结果（TRACE_RUN 中的 DISABLED/EXECUTED），回放结束后对比
+  const std::vector<ReplayHandled>& recorded() const { return recordedRuns; }
+
+ private:
+  void applyState(ScheduleSim& sim, uint64_t vms, time_t now);
+
+  std::vector<TraceRecord> trace;
+  std::vector<uint64_t> vmsOf;
+  size_t cursor;
+  uint64_t anchorVms;    // 最近一次校准系统时间的位置
+  int64_t anchorMs;
+  bool sampleValid;
+  float sampleTemperature;
+  bool booting;          // 启动后尚未加载状态
+  // 正在收集的 TRACE_STATE + TRACE_RULE
+  AcScheduleRule stateRules[AC_SCHEDULE_MAX_RULES];
+  uint8_t stateExpected;
+  uint8_t stateReceived;
+  bool stateEnabled;
+  time_t stateLastRun;
+  bool statePending;
+  std::vector<ReplayHandled> recordedRuns;
+};
@@ -0,0 +1,340 @@
+// ============================================================================
+// 定时控制回放：主程序
+// 合成一段时间线或读取设备轨迹，在虚拟时钟上运行定时决策，输出漏执行、重复、延迟
+// 和每模拟日的 CPU 时间；有重复、意外或补执行窗口内的漏执行时退出码为 1，可用于 CI
+// ============================================================================
+#include "replay.h"
+#include <algorithm>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unordered_map>
+
+static const char* const ISSUE_NAMES[REPLAY_ISSUE_KINDS] = {"漏执行", "重复", "延迟", "意外"};
+
+struct Options {
+  SyntheticConfig synthetic;
+  const char* startDate;
+  const char* tz;
+  uint32_t lateMs;
+  uint32_t show;
+  std::vector<AcScheduleRule> rules;
+  std::vector<const char*> traces;
+};
+
+static Options options;
+
+static double cpuSeconds() {
+  struct timespec ts;
+  clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &ts);
+  return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static void usage(const char* program) {
+  printf("用法: %s [选项]\n"
+         "  --trace FILE          回放设备轨迹（GET /trace?prev=1 和 /trace，可重复，按时间顺序）\n"
+         "  --days N              合成时间线的天数（默认 365）\n"
+         "  --start YYYY-MM-DD    合成时间线的第一天（默认 2025-01-01）\n"
+         "  --tz TZ               POSIX 时区（默认 CST-8，与固件的 gmtOffset_sec 一致；\n"
+         "                        夏令时可用 CET-1CEST,M3.5.0,M10.5.0/3）\n"
+         "  --rule D,HH:MM,on|off[,BELOW]  定时规则，D 为星期数字（0=周日），可重复（默认固件的默认规则）\n"
+         "  --seed N              随机种子（默认 1）\n"
+         "  --drift-ppm P         晶振偏差（默认 20）\n"
+         "  --sync-min M          SNTP 同步间隔，分钟（默认 60）\n"
+         "  --jumps-per-day R     NTP 给出错误时间的频率（默认 0.05）\n"
+         "  --jump-max S          错误时间的最大偏差，秒（默认 900）\n"
+         "  --reboots-per-day R   重启频率（默认 0.1）\n"
+         "  --sensor-gaps-per-day R  传感器断续频率（默认 2）\n"
+         "  --late-ms MS          延迟阈值（默认 %u）\n"
+         "  --show N              打印的问题明细条数（默认 20）\n",
+         program, (unsigned)REPLAY_LATE_MS);
+}
+
+// D,HH:MM,on|off[,BELOW]，例如 12345,08:00,on,17
+static bool parseRule(const char* text, AcScheduleRule& rule) {
+  char days[16];
+  char action[8];
+  unsigned hour, minute;
+  float below;
+  int n = sscanf(text, "%15[0-6],%u:%u,%7[a-z],%f", days, &hour, &minute, action, &below);
+  if (n < 4 || hour > 23 || minute > 59) {
+    return false;
+  }
+  rule.weekdays = 0;
+  for (const char* d = days; *d; d++) {
+    rule.weekdays |= 1 << (*d - '0');
+  }
+  rule.hour = hour;
+  rule.minute = minute;
+  if (strcmp(action, "on") == 0) {
+    rule.action = AC_ACTION_ON;
+  } else if (strcmp(action, "off") == 0) {
+    rule.action = AC_ACTION_OFF;
+  } else {
+    return false;
+  }
+  rule.belowTenths = n == 5 ? (int16_t)lroundf(below * 10.0f) : AC_RULE_ANY_TEMPERATURE;
+  return true;
+}
+
+static bool parseArgs(int argc, char** argv) {
+  SyntheticConfig& s = options.synthetic;
+  s.days = 365;
+  s.driftPpm = 20;
+  s.syncMinutes = 60;
+  s.jumpsPerDay = 0.05;
+  s.jumpMaxSec = 900;
+  s.rebootsPerDay = 0.1;
+  s.sensorGapsPerDay = 2;
+  s.seed = 1;
+  options.startDate = "2025-01-01";
+  options.tz = "CST-8";
+  options.lateMs = REPLAY_LATE_MS;
+  options.show = 20;
+
+  for (int i = 1; i < argc; i++) {
+    const char* arg = argv[i];
+    const char* value = i + 1 < argc ? argv[i + 1] : nullptr;
+    if (strcmp(arg, "--help") == 0 || strcmp(arg, "-h") == 0 || value == nullptr) {
+      return false;
+    }
+    i++;
+    if (strcmp(arg, "--trace") == 0) {
+      options.traces.push_back(value);
+    } else if (strcmp(arg, "--days") == 0) {
+      s.days = strtoul(value, nullptr, 10);
+    } else if (strcmp(arg, "--start") == 0) {
+      options.startDate = value;
+    } else if (strcmp(arg, "--tz") == 0) {
+      options.tz = value;
+    } else if (strcmp(arg, "--rule") == 0) {
+      AcScheduleRule rule;
+      if (!parseRule(value, rule) || options.rules.size() >= AC_SCHEDULE_MAX_RULES) {
+        fprintf(stderr, "❌ 规则格式错误或超过 %d 条: %s\n", AC_SCHEDULE_MAX_RULES, value);
+        return false;
+      }
+      options.rules.push_back(rule);
+    } else if (strcmp(arg, "--seed") == 0) {
+      s.seed = strtoull(value, nullptr, 10);
+    } else if (strcmp(arg, "--drift-ppm") == 0) {
+      s.driftPpm = atof(value);
+    } else if (strcmp(arg, "--sync-min") == 0) {
+      s.syncMinutes = strtoul(value, nullptr, 10);
+    } else if (strcmp(arg, "--jumps-per-day") == 0) {
+      s.jumpsPerDay = atof(value);
+    } else if (strcmp(arg, "--jump-max") == 0) {
+      s.jumpMaxSec = strtoul(value, nullptr, 10);
+    } else if (strcmp(arg, "--reboots-per-day") == 0) {
+      s.rebootsPerDay = atof(value);
+    } else if (strcmp(arg, "--sensor-gaps-per-day") == 0) {
+      s.sensorGapsPerDay = atof(value);
+    } else if (strcmp(arg, "--late-ms") == 0) {
+      options.lateMs = strtoul(value, nullptr, 10);
+    } else if (strcmp(arg, "--show") == 0) {
+      options.show = strtoul(value, nullptr, 10);
+    } else {
+      return false;
+    }
+  }
+  return true;
+}
+
+static void formatRule(const AcScheduleRule& r, char* buf, size_t size) {
+  char days[8];
+  size_t n = 0;
+  for (uint8_t d = 0; d < 7; d++) {
+    if (r.weekdays & (1 << d)) {
+      days[n++] = (char)('0' + d);
+    }
+  }
+  days[n] = '\0';
+  int len = snprintf(buf, size, "%s,%02u:%02u,%s", days, r.hour, r.minute, r.action == AC_ACTION_ON ? "on" : "off");
+  if (r.belowTenths != AC_RULE_ANY_TEMPERATURE && len > 0 && (size_t)len < size) {
+    snprintf(buf + len, size - len, ",%.1f", r.belowTenths / 10.0f);
+  }
+}
+
+static void formatTime(time_t t, char* buf, size_t size) {
+  struct tm lt;
+  localtime_r(&t, &lt);
+  strftime(buf, size, "%Y-%m-%d %H:%M:%S %Z", &lt);
+}
+
+static void printCauses(uint8_t causes) {
+  static const char* const NAMES[] = {"读数重试", "时间跳变", "重启", "超过补执行窗口"};
+  bool first = true;
+  for (uint8_t i = 0; i < 4; i++) {
+    if (causes & (1 << i)) {
+      printf("%s%s", first ? "  [" : "、", NAMES[i]);
+      first = false;
+    }
+  }
+  if (!first) {
+    printf("]");
+  }
+}
+
+// 设备记录的处理结果与回放结果逐条对比（键为事件日期 + 规则）
+static uint64_t compareWithTrace(const std::vector<ReplayHandled>& recorded,
+                                 const std::vector<ReplayHandled>& replayed) {
+  std::unordered_map<uint64_t, const ReplayHandled*> byKey;
+  for (const ReplayHandled& h : replayed) {
+    byKey.emplace(h.key, &h);
+  }
+  uint64_t same = 0;
+  uint64_t differ = 0;
+  uint64_t onlyRecorded = 0;
+  uint32_t shown = 0;
+  for (const ReplayHandled& r : recorded) {
+    auto it = byKey.find(r.key);
+    bool match = it != byKey.end() && it->second->outcome == r.outcome && it->second->action == r.action;
+    if (match) {
+      same++;
+      byKey.erase(it);
+      continue;
+    }
+    bool missing = it == byKey.end();
+    if (missing) {
+      onlyRecorded++;
+    } else {
+      differ++;
+      byKey.erase(it);
+    }
+    if (shown++ < options.show) {
+      printf("  ≠ %08llu 规则 #%u：设备 %s/%s，回放 %s\n", (unsigned long long)(r.key >> 8),
+             (unsigned)(r.key & 0xFF), r.outcome == AC_RUN_DISABLED ? "禁用" : "执行",
+             acIRCommand(r.action) ? (r.action == AC_ACTION_ON ? "开机" : "关机") : "不动作",
+             missing ? "未处理" : "结果不同");
+    }
+  }
+  printf("与设备记录对比：一致 %llu，结果不同 %llu，只有设备处理 %llu，只有回放处理 %llu\n",
+         (unsigned long long)same, (unsigned long long)differ, (unsigned long long)onlyRecorded,
+         (unsigned long long)byKey.size());
+  return differ + onlyRecorded + byKey.size();
+}
+
+static void printReport(const ScheduleSim& sim, double simulatedDays, uint64_t observations, double cpu) {
+  const ReplayCounters& c = sim.counters();
+  printf("\n========== 定时控制回放结果（%.1f 天）==========\n", simulatedDays);
+  printf("时间线\n");
+  printf("  启动 %llu 次，时间同步/跳变 %llu 次，检查器观察 %llu 次\n", (unsigned long long)c.boots,
+         (unsigned long long)c.timeEvents, (unsigned long long)observations);
+  if (c.commands > 0) {
+    printf("  远程指令 %llu 条\n", (unsigned long long)c.commands);
+  }
+  printf("定时运行 %llu 次\n", (unsigned long long)c.runs);
+  printf("  无事件 %llu，时间未同步 %llu，等待读数 %llu，已禁用 %llu，已处理 %llu\n",
+         (unsigned long long)c.idle, (unsigned long long)c.notSynced, (unsigned long long)c.waitSensor,
+         (unsigned long long)c.disabled, (unsigned long long)c.executed);
+  printf("  红外动作：开机 %llu，关机 %llu；温度条件不满足 %llu\n", (unsigned long long)c.actionsOn,
+         (unsigned long long)c.actionsOff, (unsigned long long)c.conditionSkipped);
+
+  std::vector<int64_t> lateness;
+  for (const ReplayHandled& h : sim.handled()) {
+    if (h.lateMs >= 0) {
+      lateness.push_back(h.lateMs);
+    }
+  }
+  std::sort(lateness.begin(), lateness.end());
+  printf("检查（延迟阈值 %u ms）\n", (unsigned)options.lateMs);
+  printf("  应处理 %llu，漏执行 %llu，重复 %llu，延迟 %llu，意外 %llu，结束时仍可补执行 %llu\n",
+         (unsigned long long)c.expected, (unsigned long long)c.issues[REPLAY_MISSED],
+         (unsigned long long)c.issues[REPLAY_DUPLICATE], (unsigned long long)c.issues[REPLAY_LATE],
+         (unsigned long long)c.issues[REPLAY_UNEXPECTED], (unsigned long long)c.pending);
+  if (!lateness.empty()) {
+    auto at = [&](double p) { return lateness[(size_t)(p / 100.0 * (lateness.size() - 1))] / 1000.0; };
+    printf("  处理时刻相对应处理时刻：p50 %.1f s  p99 %.1f s  max %.1f s\n", at(50), at(99), at(100));
+  }
+
+  double days = simulatedDays > 0 ? simulatedDays : 1;
+  printf("CPU\n");
+  printf("  总计 %.2f s（%.0f 倍实时），每模拟日 %.2f ms\n", cpu, days * 86400.0 / max(cpu, 1e-9),
+         cpu * 1000.0 / days);
+  printf("  其中 acScheduleRun() 每模拟日 %.1f µs，平均 %.0f ns/次\n", c.controlNs / 1000.0 / days,
+         c.runs ? (double)c.controlNs / c.runs : 0.0);
+
+  if (!sim.issues().empty() && options.show > 0) {
+    printf("问题明细（前 %u 条）\n", (unsigned)min<size_t>(options.show, sim.issues().size()));
+    for (size_t i = 0; i < sim.issues().size() && i < options.show; i++) {
+      const ReplayIssue& issue = sim.issues()[i];
+      char when[48];
+      char rule[32] = "?";
+      formatTime(issue.wall, when, sizeof(when));
+      if (issue.rule < sim.schedule().size()) {
+        formatRule(sim.schedule().rule(issue.rule), rule, sizeof(rule));
+      }
+      printf("  %-6s %s  规则 #%u（%s）", ISSUE_NAMES[issue.kind], when, issue.rule, rule);
+      if (issue.kind == REPLAY_LATE || issue.kind == REPLAY_DUPLICATE) {
+        printf("  +%.1f s", issue.lateMs / 1000.0);
+      }
+      printCauses(issue.causes);
+      printf("\n");
+    }
+  }
+}
+
+int main(int argc, char** argv) {
+  if (!parseArgs(argc, argv)) {
+    usage(argv[0]);
+    return 2;
+  }
+  setenv("TZ", options.tz, 1);
+  tzset();
+
+  AcSchedule rules;
+  if (!options.rules.empty() && !rules.setRules(options.rules.data(), options.rules.size())) {
+    fprintf(stderr, "❌ 定时规则无效\n");
+    return 2;
+  }
+
+  ScheduleSim sim(options.lateMs);
+  ReplayTimeline* timeline = nullptr;
+  TraceTimeline trace;
+  SyntheticTimeline* synthetic = nullptr;
+  if (!options.traces.empty()) {
+    if (!trace.load(options.traces)) {
+      return 2;
+    }
+    printf("📼 回放设备轨迹：%lu 条记录，TZ=%s\n", (unsigned long)trace.size(), options.tz);
+    timeline = &trace;
+  } else {
+    struct tm start = {};
+    if (sscanf(options.startDate, "%d-%d-%d", &start.tm_year, &start.tm_mon, &start.tm_mday) != 3) {
+      fprintf(stderr, "❌ 日期格式错误: %s\n", options.startDate);
+      return 2;
+    }
+    start.tm_year -= 1900;
+    start.tm_mon -= 1;
+    start.tm_isdst = -1;
+    options.synthetic.start = mktime(&start);
+    synthetic = new SyntheticTimeline(options.synthetic);
+    timeline = synthetic;
+    printf("🕒 合成时间线：%lu 天，从 %s 开始，TZ=%s，种子 %llu\n", (unsigned long)options.synthetic.days,
+           options.startDate, options.tz, (unsigned long long)options.synthetic.seed);
+    for (uint8_t i = 0; i < rules.size(); i++) {
+      char text[32];
+      formatRule(rules.rule(i), text, sizeof(text));
+      printf("   规则 #%u: %s\n", i, text);
+    }
+    // 从第一天 0 点开始，之前的事件视为已处理
+    sim.load(rules, true, options.synthetic.start - 1, 0, options.synthetic.start - 1);
+  }
+
+  double cpuStart = cpuSeconds();
+  uint64_t observations = replayRun(*timeline, sim);
+  double cpu = cpuSeconds() - cpuStart;
+  printReport(sim, timeline->endMs() / 86400000.0, observations, cpu);
+
+  uint64_t failures = sim.counters().issues[REPLAY_DUPLICATE] + sim.counters().issues[REPLAY_UNEXPECTED];
+  for (const ReplayIssue& issue : sim.issues()) {
+    if (issue.kind == REPLAY_MISSED && !(issue.causes & REPLAY_CAUSE_CATCHUP)) {
+      failures++;
+    }
+  }
+  if (synthetic == nullptr) {
+    failures += compareWithTrace(trace.recorded(), sim.handled());
+  }
+  delete synthetic;
+  return failures > 0 ? 1 : 0;
+}
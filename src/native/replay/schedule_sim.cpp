@@ -0,0 +1,231 @@
+// ============================================================================
+// 定时控制回放：模拟设备和检查器
+// 设备部分与 main.cpp 的 runACSchedule() 一一对应：处理事件后保存 lastRun（模拟 NVS），
+// 重试时保留原定时；检查器只用 localtime_r() 判断本地时间是否到达规则时分，
+// 不调用 AcSchedule 的任何时间计算
+// ============================================================================
+#include "replay.h"
+#include <chrono>
+
+uint64_t replayKey(time_t due, uint8_t rule) {
+  struct tm t;
+  localtime_r(&due, &t);
+  uint64_t date = (uint64_t)(t.tm_year + 1900) * 10000 + (t.tm_mon + 1) * 100 + t.tm_mday;
+  return (date << 8) | rule;
+}
+
+ScheduleSim::ScheduleSim(uint32_t lateMs)
+    : lateLimitMs(lateMs), scheduleEnabled(true), lastRun(0), savedLastRun(0), powered(false),
+      wakeMs(REPLAY_NEVER), lastSensorWaitVms(0), lastTimeEventVms(0), lastBootVms(0), totals{} {}
+
+void ScheduleSim::boot(uint64_t vms) {
+  powered = true;
+  lastRun = savedLastRun;
+  wakeMs = vms;
+  lastBootVms = vms;
+  totals.boots++;
+}
+
+void ScheduleSim::powerOff() {
+  powered = false;
+  wakeMs = REPLAY_NEVER;
+}
+
+void ScheduleSim::load(const AcSchedule& newRules, bool enabled, time_t newLastRun, uint64_t vms, time_t now) {
+  if (!powered) {
+    boot(vms);
+  }
+  rules = newRules;
+  scheduleEnabled = enabled;
+  lastRun = newLastRun;
+  savedLastRun = newLastRun;
+  wakeMs = vms;
+  if (now >= AC_SCHEDULE_SYNCED_AFTER) {
+    suppressPassed(now);  // 检查器从这里开始，更早的时刻不属于本次回放
+  }
+}
+
+void ScheduleSim::update(const AcSchedule& newRules, bool enabled, uint64_t vms, time_t now) {
+  rules = newRules;
+  scheduleEnabled = enabled;
+  wakeMs = vms;
+  if (now >= AC_SCHEDULE_SYNCED_AFTER) {
+    suppressPassed(now);
+  }
+}
+
+void ScheduleSim::timeSync(uint64_t vms) {
+  lastTimeEventVms = vms;
+  totals.timeEvents++;
+  wakeMs = vms;
+}
+
+void ScheduleSim::noteTimeJump(uint64_t vms) {
+  lastTimeEventVms = vms;
+}
+
+void ScheduleSim::run(uint64_t vms, time_t now, bool hasSample, float temperature) {
+  auto start = std::chrono::steady_clock::now();
+  AcRunResult result = acScheduleRun(rules, scheduleEnabled, lastRun, now, hasSample, temperature);
+  totals.controlNs += std::chrono::duration_cast<std::chrono::nanoseconds>(
+      std::chrono::steady_clock::now() - start).count();
+  totals.runs++;
+  wakeMs = vms + result.wakeMs;
+
+  switch (result.outcome) {
+    case AC_RUN_IDLE:
+      totals.idle++;
+      return;
+    case AC_RUN_NOT_SYNCED:
+      totals.notSynced++;
+      return;
+    case AC_RUN_WAIT_SENSOR:
+      totals.waitSensor++;
+      lastSensorWaitVms = vms;
+      return;
+    case AC_RUN_DISABLED:
+      totals.disabled++;
+      break;
+    case AC_RUN_EXECUTED:
+      totals.executed++;
+      if (result.action == AC_ACTION_ON) {
+        totals.actionsOn++;
+      } else if (result.action == AC_ACTION_OFF) {
+        totals.actionsOff++;
+      } else {
+        totals.conditionSkipped++;
+      }
+      break;
+  }
+  savedLastRun = lastRun;  // saveACSchedule(false)
+
+  uint64_t key = replayKey(result.event.due, result.event.rule);
+  handledLog.push_back({key, vms, result.outcome, result.action, -1});
+  auto it = occurrences.find(key);
+  if (it == occurrences.end() || !it->second.expected) {
+    Occurrence o = {vms, now, result.event.rule, false, false, 0};
+    addIssue(REPLAY_UNEXPECTED, it == occurrences.end() ? o : it->second, now, 0, vms);
+    return;
+  }
+  Occurrence& o = it->second;
+  o.handled++;
+  int64_t late = (int64_t)(vms - o.expectedVms);
+  handledLog.back().lateMs = late;
+  if (o.handled > 1) {
+    addIssue(REPLAY_DUPLICATE, o, now, late, o.expectedVms);
+  } else if (late > (int64_t)lateLimitMs) {
+    addIssue(REPLAY_LATE, o, o.expectedWall, late, o.expectedVms);
+  }
+}
+
+void ScheduleSim::observe(uint64_t vms, time_t now) {
+  if (!powered || now < AC_SCHEDULE_SYNCED_AFTER) {
+    return;
+  }
+  struct tm t;
+  localtime_r(&now, &t);
+  int secondOfDay = t.tm_hour * 3600 + t.tm_min * 60 + t.tm_sec;
+  for (uint8_t i = 0; i < rules.size(); i++) {
+    const AcScheduleRule& r = rules.rule(i);
+    int ruleSecond = r.hour * 3600 + r.minute * 60;
+    if (!(r.weekdays & (1 << t.tm_wday)) || secondOfDay < ruleSecond) {
+      continue;
+    }
+    uint64_t key = replayKey(now, i);
+    if (occurrences.count(key)) {
+      continue;
+    }
+    Occurrence o = {vms, now, i, true, secondOfDay - ruleSecond > AC_SCHEDULE_CATCHUP_SEC, 0};
+    occurrences[key] = o;
+    totals.expected++;
+  }
+}
+
+void ScheduleSim::suppressPassed(time_t now) {
+  struct tm t;
+  localtime_r(&now, &t);
+  int secondOfDay = t.tm_hour * 3600 + t.tm_min * 60 + t.tm_sec;
+  for (uint8_t i = 0; i < rules.size(); i++) {
+    const AcScheduleRule& r = rules.rule(i);
+    uint64_t key = replayKey(now, i);
+    if (secondOfDay >= r.hour * 3600 + r.minute * 60 && !occurrences.count(key)) {
+      occurrences[key] = Occurrence{0, now, i, false, false, 0};
+    }
+  }
+}
+
+void ScheduleSim::finish(uint64_t endVms) {
+  for (const auto& entry : occurrences) {
+    const Occurrence& o = entry.second;
+    if (!o.expected || o.handled > 0) {
+      continue;
+    }
+    if (endVms - o.expectedVms < (uint64_t)AC_SCHEDULE_CATCHUP_SEC * 1000) {
+      totals.pending++;
+    } else {
+      addIssue(REPLAY_MISSED, o, o.expectedWall, 0, o.expectedVms);
+    }
+  }
+}
+
+uint8_t ScheduleSim::causesSince(uint64_t vms) const {
+  uint8_t causes = REPLAY_CAUSE_NONE;
+  if (lastSensorWaitVms >= vms && lastSensorWaitVms > 0) {
+    causes |= REPLAY_CAUSE_SENSOR;
+  }
+  if (lastTimeEventVms >= vms && lastTimeEventVms > 0) {
+    causes |= REPLAY_CAUSE_TIME;
+  }
+  if (lastBootVms >= vms && lastBootVms > 0) {
+    causes |= REPLAY_CAUSE_BOOT;
+  }
+  return causes;
+}
+
+void ScheduleSim::addIssue(ReplayIssueKind kind, const Occurrence& o, time_t wall, int64_t lateMs, uint64_t sinceVms) {
+  totals.issues[kind]++;
+  if (issueLog.size() >= REPLAY_MAX_ISSUES) {
+    return;
+  }
+  uint8_t causes = causesSince(sinceVms);
+  if (o.catchupOver) {
+    causes |= REPLAY_CAUSE_CATCHUP;
+  }
+  issueLog.push_back({kind, o.rule, causes, wall, lateMs});
+}
+
+uint64_t replayRun(ReplayTimeline& timeline, ScheduleSim& sim) {
+  uint64_t end = timeline.endMs();
+  uint64_t nextObserve = 0;
+  uint64_t observations = 0;
+
+  for (;;) {
+    uint64_t vms = min(min(timeline.nextEventMs(), sim.wakeAt()), min(nextObserve, end));
+
+    while (timeline.nextEventMs() == vms) {
+      timeline.fire(sim);
+      nextObserve = vms;  // 事件可能改变了系统时间，立即检查一次
+    }
+    if (nextObserve == vms) {
+      if (sim.up()) {
+        int64_t now = timeline.systemMs(vms);
+        sim.observe(vms, (time_t)(now / 1000));
+        observations++;
+        int64_t intoMinute = ((now % 60000) + 60000) % 60000;
+        nextObserve = vms + (uint64_t)(60000 - intoMinute);
+      } else {
+        nextObserve = REPLAY_NEVER;  // 关机期间由开机事件恢复
+      }
+    }
+    if (sim.wakeAt() <= vms) {
+      float temperature = NAN;
+      bool hasSample = timeline.sample(vms, temperature);
+      sim.run(vms, (time_t)(timeline.systemMs(vms) / 1000), hasSample, temperature);
+    }
+    if (vms >= end) {
+      break;
+    }
+  }
+  sim.finish(end);
+  return observations;
+}
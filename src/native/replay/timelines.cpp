@@ -0,0 +1,317 @@
+// ============================================================================
+// 定时控制回放：合成时间线和设备轨迹
+// ============================================================================
+#include "replay.h"
+#include <algorithm>
+#include <math.h>
+#include <stdio.h>
+
+#define DAY_MS            86400000ULL
+#define SENSOR_WARMUP_MS  3000     // 启动后第一个有效读数之前
+#define REBOOT_DOWN_MIN   5000     // 停机（复位 + 启动）时长范围
+#define REBOOT_DOWN_MAX   120000
+#define FIRST_SYNC_MIN    3000     // 启动后 WiFi 连上、首次 SNTP 同步的时间范围
+#define FIRST_SYNC_MAX    30000
+#define GAP_MIN_MS        60000    // 传感器断续时长范围
+#define GAP_MAX_MS        1800000
+
+// xorshift64*：合成结果只取决于种子
+static uint64_t nextRandom(uint64_t& state) {
+  state ^= state >> 12;
+  state ^= state << 25;
+  state ^= state >> 27;
+  return state * 2685821657736338717ULL;
+}
+
+static double uniform(uint64_t& state) {
+  return (nextRandom(state) >> 11) * (1.0 / 9007199254740992.0);
+}
+
+// [lo, hi)
+static uint64_t randomRange(uint64_t& state, uint64_t lo, uint64_t hi) {
+  return lo + nextRandom(state) % (hi - lo);
+}
+
+// 平均每天 rate 次：整数部分必定发生，小数部分按概率
+static uint32_t countForDay(uint64_t& state, double rate) {
+  uint32_t n = (uint32_t)rate;
+  return n + (uniform(state) < rate - n ? 1 : 0);
+}
+
+// ========================== SyntheticTimeline ==========================
+
+SyntheticTimeline::SyntheticTimeline(const SyntheticConfig& config)
+    : cfg(config), cursor(0), gapCursor(0), endVms((uint64_t)config.days * DAY_MS),
+      offsetMs((int64_t)config.start * 1000), lastKnownMs(0), bootVms(0) {
+  uint64_t rng = config.seed ? config.seed : 1;
+  std::vector<uint64_t> reboots;
+  std::vector<uint64_t> jumps;
+  for (uint32_t d = 0; d < config.days; d++) {
+    uint64_t dayStart = d * DAY_MS;
+    for (uint32_t n = countForDay(rng, config.rebootsPerDay); n > 0; n--) {
+      reboots.push_back(dayStart + randomRange(rng, 0, DAY_MS));
+    }
+    for (uint32_t n = countForDay(rng, config.jumpsPerDay); n > 0; n--) {
+      jumps.push_back(dayStart + randomRange(rng, 0, DAY_MS));
+    }
+    for (uint32_t n = countForDay(rng, config.sensorGapsPerDay); n > 0; n--) {
+      uint64_t from = dayStart + randomRange(rng, 0, DAY_MS);
+      gaps.push_back({from, from + randomRange(rng, GAP_MIN_MS, GAP_MAX_MS)});
+    }
+  }
+  std::sort(reboots.begin(), reboots.end());
+  std::sort(jumps.begin(), jumps.end());
+  std::sort(gaps.begin(), gaps.end(), [](const Gap& a, const Gap& b) { return a.from < b.from; });
+  // 合并重叠的断续，sample() 只需要向前移动游标
+  size_t kept = 0;
+  for (size_t i = 0; i < gaps.size(); i++) {
+    if (kept > 0 && gaps[i].from <= gaps[kept - 1].to) {
+      gaps[kept - 1].to = max(gaps[kept - 1].to, gaps[i].to);
+    } else {
+      gaps[kept++] = gaps[i];
+    }
+  }
+  gaps.resize(kept);
+
+  // 与周期同步合并成一条有序的事件序列；停机期间的跳变和重启不会发生
+  uint64_t syncPeriod = (uint64_t)max<uint32_t>(config.syncMinutes, 1) * 60000;
+  uint64_t nextSync = syncPeriod;
+  size_t ri = 0;
+  size_t ji = 0;
+  for (;;) {
+    uint64_t reboot = ri < reboots.size() ? reboots[ri] : REPLAY_NEVER;
+    uint64_t jump = ji < jumps.size() ? jumps[ji] : REPLAY_NEVER;
+    uint64_t t = min(min(reboot, jump), nextSync);
+    if (t >= endVms) {
+      break;
+    }
+    if (t == reboot) {
+      uint64_t up = t + randomRange(rng, REBOOT_DOWN_MIN, REBOOT_DOWN_MAX);
+      events.push_back({t, POWER_OFF, 0});
+      events.push_back({up, (Kind)(BOOT_WARM + randomRange(rng, 0, 3)), 0});
+      nextSync = up + randomRange(rng, FIRST_SYNC_MIN, FIRST_SYNC_MAX);  // SNTP 随启动重新开始
+      while (ri < reboots.size() && reboots[ri] < up) ri++;
+      while (ji < jumps.size() && jumps[ji] < up) ji++;
+    } else if (t == jump) {
+      int32_t sec = (int32_t)randomRange(rng, 1, max<uint32_t>(config.jumpMaxSec, 1) + 1);
+      events.push_back({t, JUMP, uniform(rng) < 0.5 ? -sec : sec});
+      ji++;
+    } else {
+      events.push_back({t, SYNC, 0});
+      nextSync += syncPeriod;
+    }
+  }
+}
+
+int64_t SyntheticTimeline::trueMs(uint64_t vms) const {
+  // 设备晶振快 driftPpm：同一段 millis() 对应的真实时间更短
+  return (int64_t)cfg.start * 1000 + (int64_t)vms - (int64_t)llround(vms * cfg.driftPpm * 1e-6);
+}
+
+uint64_t SyntheticTimeline::nextEventMs() const {
+  return cursor < events.size() ? events[cursor].vms : REPLAY_NEVER;
+}
+
+int64_t SyntheticTimeline::systemMs(uint64_t vms) const {
+  return (int64_t)vms + offsetMs;
+}
+
+void SyntheticTimeline::fire(ScheduleSim& sim) {
+  const Event& e = events[cursor++];
+  switch (e.kind) {
+    case SYNC:
+      offsetMs = trueMs(e.vms) - (int64_t)e.vms;
+      sim.timeSync(e.vms);
+      break;
+    case JUMP:
+      offsetMs += (int64_t)e.value * 1000;
+      sim.timeSync(e.vms);  // 错误的同步结果同样触发 EV_TIME_SYNC
+      break;
+    case POWER_OFF:
+      lastKnownMs = systemMs(e.vms);
+      sim.powerOff();
+      break;
+    case BOOT_WARM:
+    case BOOT_RESTORE:
+    case BOOT_COLD:
+      if (e.kind == BOOT_RESTORE) {
+        offsetMs = lastKnownMs - (int64_t)e.vms;
+      } else if (e.kind == BOOT_COLD) {
+        offsetMs = -(int64_t)e.vms;  // 系统时间从 1970 年开始
+      }
+      bootVms = e.vms;
+      sim.boot(e.vms);
+      break;
+  }
+}
+
+bool SyntheticTimeline::sample(uint64_t vms, float& temperature) {
+  if (vms - bootVms < SENSOR_WARMUP_MS) {
+    return false;
+  }
+  while (gapCursor < gaps.size() && gaps[gapCursor].to <= vms) {
+    gapCursor++;
+  }
+  if (gapCursor < gaps.size() && gaps[gapCursor].from <= vms) {
+    return false;
+  }
+
+  // 室内温度：冬季（1 月下旬）约 15°C、夏季约 25°C，每天清晨最低，另加 ±0.3°C 噪声；
+  // 冬天和春秋的早晨会低于默认规则的 17°C
+  time_t now = (time_t)(trueMs(vms) / 1000);
+  struct tm t;
+  localtime_r(&now, &t);
+  double hour = t.tm_hour + t.tm_min / 60.0;
+  double seasonal = 20.0 - 5.0 * cos(2 * M_PI * (t.tm_yday - 20) / 365.0);
+  double daily = -1.5 * cos(2 * M_PI * (hour - 5.0) / 24.0);
+  uint64_t noiseState = (uint64_t)(now / 300) * 0x9E3779B97F4A7C15ULL + cfg.seed + 1;
+  double noise = (uniform(noiseState) - 0.5) * 0.6;
+  temperature = (float)(seasonal + daily + noise);
+  return true;
+}
+
+// ========================== TraceTimeline ==========================
+
+TraceTimeline::TraceTimeline()
+    : cursor(0), anchorVms(REPLAY_NEVER), anchorMs(0), sampleValid(false), sampleTemperature(NAN),
+      booting(true), stateExpected(0), stateReceived(0), stateEnabled(true), stateLastRun(0),
+      statePending(false) {}
+
+bool TraceTimeline::load(const std::vector<const char*>& paths) {
+  for (const char* path : paths) {
+    FILE* file = fopen(path, "rb");
+    if (file == nullptr) {
+      fprintf(stderr, "❌ 无法打开轨迹文件: %s\n", path);
+      return false;
+    }
+    uint8_t header[TRACE_HEADER_SIZE];
+    if (fread(header, 1, sizeof(header), file) != sizeof(header) || memcmp(header, "STR1", 4) != 0) {
+      fprintf(stderr, "❌ 不是定时控制轨迹（缺少 STR1 头部）: %s\n", path);
+      fclose(file);
+      return false;
+    }
+    TraceRecord r;
+    while (fread(&r, 1, sizeof(r), file) == sizeof(r)) {
+      trace.push_back(r);
+    }
+    fclose(file);
+  }
+
+  // 每次启动 millis() 从 0 开始：接在上一条记录之后，间隔按两边的系统时间估计
+  int64_t base = 0;
+  uint64_t prevVms = 0;
+  const TraceRecord* prev = nullptr;
+  for (const TraceRecord& r : trace) {
+    if (prev != nullptr && r.type == TRACE_BOOT) {
+      uint64_t gap = 1000;
+      if (prev->timestamp >= AC_SCHEDULE_SYNCED_AFTER && r.timestamp > prev->timestamp) {
+        gap = max<uint64_t>(gap, (uint64_t)(r.timestamp - prev->timestamp) * 1000);
+      }
+      base = (int64_t)(prevVms + gap) - (int64_t)r.ms;
+    } else if (prev != nullptr && r.ms < prev->ms) {
+      base += 1LL << 32;  // millis() 约 49.7 天回绕一次
+    }
+    uint64_t vms = (uint64_t)max<int64_t>(base + (int64_t)r.ms, (int64_t)prevVms);
+    vmsOf.push_back(vms);
+    prevVms = vms;
+    prev = &r;
+  }
+  return true;
+}
+
+uint64_t TraceTimeline::nextEventMs() const {
+  return cursor < trace.size() ? vmsOf[cursor] : REPLAY_NEVER;
+}
+
+uint64_t TraceTimeline::endMs() const {
+  return vmsOf.empty() ? 0 : vmsOf.back();
+}
+
+int64_t TraceTimeline::systemMs(uint64_t vms) const {
+  return anchorVms == REPLAY_NEVER ? 0 : anchorMs + (int64_t)(vms - anchorVms);
+}
+
+bool TraceTimeline::sample(uint64_t vms, float& temperature) {
+  temperature = sampleTemperature;
+  return sampleValid;
+}
+
+void TraceTimeline::applyState(ScheduleSim& sim, uint64_t vms, time_t now) {
+  AcSchedule rules;
+  rules.setRules(stateRules, stateExpected);
+  statePending = false;
+  if (booting || !sim.up()) {
+    sim.load(rules, stateEnabled, stateLastRun, vms, now);
+    booting = false;
+    return;
+  }
+  // 文件轮换后的快照与当前状态相同，不是规则更新
+  bool same = rules.size() == sim.schedule().size() && stateEnabled == sim.enabled();
+  for (uint8_t i = 0; same && i < rules.size(); i++) {
+    same = memcmp(&rules.rule(i), &sim.schedule().rule(i), sizeof(AcScheduleRule)) == 0;
+  }
+  if (!same) {
+    sim.update(rules, stateEnabled, vms, now);
+  }
+}
+
+void TraceTimeline::fire(ScheduleSim& sim) {
+  const TraceRecord& r = trace[cursor];
+  uint64_t vms = vmsOf[cursor];
+  cursor++;
+
+  // 记录只有整秒：外推的系统时间与记录不在同一秒时才重新校准，避免来回跳动
+  if (anchorVms == REPLAY_NEVER || r.type == TRACE_BOOT || systemMs(vms) / 1000 != (int64_t)r.timestamp) {
+    anchorVms = vms;
+    anchorMs = (int64_t)r.timestamp * 1000;
+  }
+  time_t now = (time_t)r.timestamp;
+
+  switch (r.type) {
+    case TRACE_BOOT:
+      sim.powerOff();  // 加载状态（TRACE_STATE）后开始运行
+      booting = true;
+      statePending = false;
+      sampleValid = false;
+      break;
+    case TRACE_STATE:
+      stateEnabled = r.arg != 0;
+      stateLastRun = (time_t)traceU32(r, 0);
+      stateExpected = min<uint8_t>(r.data[4], AC_SCHEDULE_MAX_RULES);
+      stateReceived = 0;
+      statePending = true;
+      if (stateExpected == 0) {
+        applyState(sim, vms, now);
+      }
+      break;
+    case TRACE_RULE:
+      if (statePending && r.arg == stateReceived) {
+        stateRules[stateReceived++] = traceDecodeRule(r);
+        if (stateReceived == stateExpected) {
+          applyState(sim, vms, now);
+        }
+      }
+      break;
+    case TRACE_CLOCK:
+      if (r.arg) {
+        sim.noteTimeJump(vms);
+      }
+      break;
+    case TRACE_TIME_SYNC:
+      sim.timeSync(vms);
+      break;
+    case TRACE_SAMPLE:
+      sampleValid = r.arg != 0;
+      sampleTemperature = sampleValid ? (int16_t)traceU16(r, 0) / 10.0f : NAN;
+      break;
+    case TRACE_COMMAND:
+      sim.noteCommand();
+      break;
+    case TRACE_RUN:
+      if (r.arg == AC_RUN_DISABLED || r.arg == AC_RUN_EXECUTED) {
+        time_t due = now - traceU16(r, 4);
+        recordedRuns.push_back({replayKey(due, r.data[0]), vms, (AcRunOutcome)r.arg, (AcAction)r.data[1], -1});
+      }
+      break;
+  }
+}
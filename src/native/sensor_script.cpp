@@ -0,0 +1,71 @@
+// ============================================================================
+// 主机构建 HAL：脚本化温湿度传感器
+// ============================================================================
+#include "native_hal.h"
+#include "../sensor_task.h"
+
+static const SensorScriptStep* script = nullptr;
+static size_t scriptCount = 0;
+static size_t scriptIndex = 0;
+static uint32_t lastReadMs = 0;
+static bool started = false;
+static SensorFilter sensorFilter;
+static SensorSample latestSample;
+static bool latestValid = false;
+static SensorSampleCallback listeners[SENSOR_MAX_LISTENERS];
+static uint8_t listenerCount = 0;
+
+void nativeSensorScript(const SensorScriptStep* steps, size_t count) {
+  script = steps;
+  scriptCount = count;
+  scriptIndex = 0;
+}
+
+void nativeSensorReset() {
+  sensorFilter = SensorFilter();
+  latestValid = false;
+  scriptIndex = 0;
+  lastReadMs = 0;
+}
+
+bool sensorTaskBegin() {
+  started = true;
+  lastReadMs = millis();
+  return true;
+}
+
+// 设备上由采集任务每 SENSOR_SAMPLE_INTERVAL 读取一次；这里在查询时补上
+// 自上次查询以来应发生的读取，效果与独立任务一致
+static void catchUp() {
+  while (started && millis() - lastReadMs >= SENSOR_SAMPLE_INTERVAL) {
+    lastReadMs += SENSOR_SAMPLE_INTERVAL;
+    while (scriptIndex + 1 < scriptCount && script[scriptIndex + 1].atMs <= lastReadMs) {
+      scriptIndex++;
+    }
+    if (scriptCount == 0 || script[scriptIndex].atMs > lastReadMs) {
+      continue;
+    }
+    const SensorScriptStep& step = script[scriptIndex];
+    if (sensorFilter.push(lastReadMs, step.temperature, step.humidity)) {
+      latestSample = sensorFilter.filtered();
+      latestValid = true;
+      for (uint8_t i = 0; i < listenerCount; i++) {
+        listeners[i]();
+      }
+    }
+  }
+}
+
+bool sensorOnSample(SensorSampleCallback callback) {
+  if (listenerCount >= SENSOR_MAX_LISTENERS) {
+    return false;
+  }
+  listeners[listenerCount++] = callback;
+  return true;
+}
+
+bool sensorLatest(SensorSample& out) {
+  catchUp();
+  out = latestSample;
+  return latestValid && (millis() - out.timestampMs) < SENSOR_STALE_MS;
+}
@@ -0,0 +1,149 @@
+// ============================================================================
+// 主机构建 HAL：Arduino 核心的最小替代
+// 功能：只提供界面、滤波、控制逻辑等可移植模块用到的接口；
+//       millis() 由模拟时钟驱动，Serial 默认静默，HardwareSerial 为可编程的假串口
+// ============================================================================
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <ctype.h>
+#include <algorithm>
+#include <string>
+#include "freertos/FreeRTOS.h"
+#include "esp_heap_caps.h"
+
+using std::max;
+using std::min;
+
+typedef uint8_t byte;
+typedef bool boolean;
+
+#define PROGMEM
+#define pgm_read_byte(addr) (*(const uint8_t*)(addr))
+#define HEX 16
+#define DEC 10
+#define SERIAL_8N1 0x800001c
+
+#define BIT0 (1u << 0)
+#define BIT1 (1u << 1)
+#define BIT2 (1u << 2)
+#define BIT3 (1u << 3)
+#define BIT4 (1u << 4)
+#define BIT5 (1u << 5)
+#define BIT6 (1u << 6)
+#define BIT7 (1u << 7)
+
+// ========================== 模拟时钟 ==========================
+unsigned long millis();
+unsigned long micros();
+void delay(uint32_t ms);            // 只推进模拟时钟，不真正休眠
+void nativeSetMillis(uint32_t ms);
+void nativeAdvanceMillis(uint32_t ms);
+
+// PSRAM：主机上直接用普通堆
+inline bool psramFound() { return true; }
+inline void* ps_malloc(size_t size) { return malloc(size); }
+
+// ========================== String ==========================
+// 与 Arduino String 一样每个非空字符串单独占一块堆内存（不做短字符串优化），
+// 基准中统计到的分配次数与设备上的行为一致
+class String {
+ public:
+  String(const char* cstr = "") { assign(cstr, cstr ? strlen(cstr) : 0); }
+  String(const String& other) { assign(other.buf, other.len); }
+  explicit String(int value, unsigned char base = 10);
+  explicit String(unsigned int value, unsigned char base = 10);
+  explicit String(long value, unsigned char base = 10);
+  explicit String(unsigned long value, unsigned char base = 10);
+  explicit String(float value, unsigned char decimalPlaces = 2);
+  explicit String(double value, unsigned char decimalPlaces = 2);
+  ~String() { delete[] buf; }
+
+  String& operator=(const String& other);
+  String& operator=(const char* cstr);
+  String& operator+=(const String& other) { return append(other.buf, other.len); }
+  String& operator+=(const char* cstr) { return append(cstr, strlen(cstr)); }
+  String& operator+=(char c) { return append(&c, 1); }
+
+  bool operator==(const String& other) const { return len == other.len && memcmp(c_str(), other.c_str(), len) == 0; }
+  bool operator!=(const String& other) const { return !(*this == other); }
+  bool operator==(const char* cstr) const { return strcmp(c_str(), cstr) == 0; }
+
+  const char* c_str() const { return buf ? buf : ""; }
+  unsigned int length() const { return len; }
+  void trim();
+
+ private:
+  char* buf = nullptr;
+  unsigned int len = 0;
+
+  void assign(const char* cstr, unsigned int n);
+  String& append(const char* cstr, unsigned int n);
+};
+
+String operator+(const String& lhs, const String& rhs);
+String operator+(const String& lhs, const char* rhs);
+String operator+(const char* lhs, const String& rhs);
+
+// ========================== 串口 ==========================
+class Print {
+ public:
+  virtual ~Print() {}
+  virtual size_t write(uint8_t c) = 0;
+  virtual size_t write(const uint8_t* buffer, size_t size);
+  size_t write(const char* str) { return write((const uint8_t*)str, strlen(str)); }
+  size_t print(const char* str) { return write(str); }
+  size_t print(const String& str) { return write(str.c_str()); }
+  size_t print(int value);
+  size_t println(const char* str = "");
+  size_t println(const String& str) { return println(str.c_str()); }
+  size_t printf(const char* format, ...) __attribute__((format(printf, 2, 3)));
+};
+
+class Stream : public Print {
+ public:
+  virtual int available() = 0;
+  virtual int read() = 0;
+  String readStringUntil(char terminator);
+};
+
+// 假串口：写出的字节保存在 tx 中；可预置每收到一行命令后"模块"回复的内容
+class HardwareSerial : public Stream {
+ public:
+  explicit HardwareSerial(int uartNum) : uart(uartNum) { tx.reserve(4096); }  // 预留输出日志，避免计入基准的分配次数
+  void begin(unsigned long baud, uint32_t config = SERIAL_8N1, int8_t rxPin = -1, int8_t txPin = -1);
+  void onReceive(void (*callback)(void), bool onlyOnTimeout = false) { receiveCallback = callback; }
+
+  size_t write(uint8_t c) override;
+  using Print::write;
+  int available() override { return (int)rxCount; }
+  int read() override;
+
+  // 测试接口
+  void setEcho(bool enabled) { echo = enabled; }                 // 把输出打印到 stdout（调试用）
+  void setAutoReply(const char* reply) { autoReply = reply ? reply : ""; }
+  void injectRx(const char* data);
+  const std::string& txLog() const { return tx; }
+  void clearTx() { tx.clear(); }
+  uint32_t txBytes() const { return txCount; }
+
+ private:
+  int uart;
+  bool echo = false;
+  std::string tx;
+  uint32_t txCount = 0;
+  uint8_t rx[256];  // 固定大小的接收环形缓冲（与设备 UART 缓冲一样不分配堆内存）
+  uint16_t rxHead = 0;
+  uint16_t rxCount = 0;
+  std::string autoReply;
+  void (*receiveCallback)(void) = nullptr;
+};
+
+extern HardwareSerial Serial;
+extern HardwareSerial Serial2;
@@ -0,0 +1,14 @@
+// ============================================================================
+// 主机构建 HAL：heap_caps 分配器映射到普通堆
+// ============================================================================
+#pragma once
+
+#include <stdint.h>
+#include <stdlib.h>
+
+#define MALLOC_CAP_8BIT   (1 << 2)
+#define MALLOC_CAP_DMA    (1 << 3)
+#define MALLOC_CAP_SPIRAM (1 << 10)
+
+inline void* heap_caps_malloc(size_t size, uint32_t caps) { return malloc(size); }
+inline void heap_caps_free(void* ptr) { free(ptr); }
@@ -0,0 +1,11 @@
+// ============================================================================
+// 主机构建 HAL：FreeRTOS 临界区的单线程替代
+// ============================================================================
+#pragma once
+
+#include <stdint.h>
+
+typedef int portMUX_TYPE;
+#define portMUX_INITIALIZER_UNLOCKED 0
+#define portENTER_CRITICAL(mux) ((void)(mux))
+#define portEXIT_CRITICAL(mux)  ((void)(mux))
@@ -0,0 +1,10 @@
+// ============================================================================
+// 主机构建 HAL：FreeRTOS 任务接口的单线程替代（SeqLock 让出 CPU 时使用）
+// ============================================================================
+#pragma once
+
+#include "FreeRTOS.h"
+
+typedef uint32_t TickType_t;
+
+inline void vTaskDelay(TickType_t ticks) { (void)ticks; }
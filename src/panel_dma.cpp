@@ -0,0 +1,225 @@
+// ============================================================================
+// ST7789 DMA 刷新实现
+// ============================================================================
+#include "panel_dma.h"
+#include "render_stats.h"
+#include "task_config.h"
+#include <driver/gpio.h>
+
+static int8_t dmaDcPin = -1;
+
+// 每个 SPI 事务开始前由驱动在中断里调用：user 字段携带 DC 电平（0=命令，1=数据）
+static void IRAM_ATTR panelPreTransfer(spi_transaction_t* t) {
+  gpio_set_level((gpio_num_t)dmaDcPin, (uint32_t)(uintptr_t)t->user);
+}
+
+PanelDMA::PanelDMA()
+    : panel(nullptr), fb(nullptr), spi(nullptr), taskHandle(nullptr), idle(nullptr),
+      dmaReady(false),
+      transHead(0), inflight(0), nextChunk(0) {
+  chunks[0] = chunks[1] = nullptr;
+  chunkBusy[0] = chunkBusy[1] = false;
+}
+
+bool PanelDMA::begin(ST7789Panel& panelRef, FrameBuffer& fbRef,
+                     int8_t mosiPin, int8_t sclkPin, int8_t csPin, int8_t dcPin) {
+  panel = &panelRef;
+  fb = &fbRef;
+
+  if (!fb->isBuffered()) {
+    // 没有帧缓冲时 FrameBuffer 已直接绘制到屏幕，无需刷新任务
+    return false;
+  }
+
+  chunks[0] = (uint16_t*)heap_caps_malloc(PANEL_DMA_CHUNK_PIXELS * 2, MALLOC_CAP_DMA);
+  chunks[1] = (uint16_t*)heap_caps_malloc(PANEL_DMA_CHUNK_PIXELS * 2, MALLOC_CAP_DMA);
+
+  // 接管 Adafruit 库已初始化好的 VSPI 总线（与 TFT_eSPI 的 DMA 模式做法相同）
+  spi_bus_config_t bus = {};
+  bus.mosi_io_num = mosiPin;
+  bus.miso_io_num = -1;
+  bus.sclk_io_num = sclkPin;
+  bus.quadwp_io_num = -1;
+  bus.quadhd_io_num = -1;
+  bus.max_transfer_sz = PANEL_DMA_CHUNK_PIXELS * 2;
+
+  spi_device_interface_config_t dev = {};
+  dev.clock_speed_hz = PANEL_SPI_FREQ;
+  dev.mode = 0;
+  dev.spics_io_num = csPin;
+  dev.queue_size = PANEL_DMA_QUEUE_DEPTH;
+  dev.pre_cb = panelPreTransfer;
+  dev.flags = SPI_DEVICE_NO_DUMMY;
+
+  dmaDcPin = dcPin;
+  esp_err_t err = ESP_ERR_NO_MEM;
+  if (chunks[0] && chunks[1]) {
+    err = spi_bus_initialize(SPI3_HOST, &bus, SPI_DMA_CH_AUTO);
+    if (err == ESP_OK) {
+      err = spi_bus_add_device(SPI3_HOST, &dev, &spi);
+    }
+  }
+  dmaReady = (err == ESP_OK);
+  if (!dmaReady) {
+    Serial.printf("⚠️ SPI DMA 初始化失败 (%s)，刷新任务改用阻塞传输\n", esp_err_to_name(err));
+  }
+
+  idle = xSemaphoreCreateBinary();
+  xSemaphoreGive(idle);
+  xTaskCreatePinnedToCore(flushTask, "PanelFlush", 3072, this, TASK_PRIO_PANEL_FLUSH, &taskHandle, CORE_APP);
+  Serial.printf("📺 屏幕刷新任务已启动 (%s)\n", dmaReady ? "DMA" : "阻塞SPI");
+  return dmaReady;
+}
+
+void PanelDMA::frameBegin() {
+  if (taskHandle == nullptr) {
+    return;
+  }
+  xSemaphoreTake(idle, portMAX_DELAY);
+  xSemaphoreGive(idle);
+}
+
+void PanelDMA::requestFlush() {
+  if (taskHandle == nullptr) {
+    return;
+  }
+  // 刷新完成前由刷新任务持有 idle，下一帧的 frameBegin() 会在这里等待
+  xSemaphoreTake(idle, portMAX_DELAY);
+  if (fb->frameEnd() > 0) {
+    xTaskNotifyGive(taskHandle);
+  } else {
+    xSemaphoreGive(idle);
+  }
+}
+
+void PanelDMA::flushTask(void* arg) {
+  PanelDMA* self = (PanelDMA*)arg;
+  while (1) {
+    ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+    self->flushDirty();
+    xSemaphoreGive(self->idle);
+  }
+}
+
+void PanelDMA::flushDirty() {
+  DirtyRect rects[FB_MAX_DIRTY_RECTS];
+  uint8_t count = fb->takeDirtyRects(rects, FB_MAX_DIRTY_RECTS);
+  if (count == 0) {
+    return;
+  }
+
+  uint32_t start = micros();
+  uint32_t pixels = 0;
+  for (uint8_t i = 0; i < count; i++) {
+    pixels += (uint32_t)rects[i].w * rects[i].h;
+    if (dmaReady) {
+      pushRect(rects[i]);
+    } else {
+      pushRectBlocking(rects[i]);
+    }
+  }
+  if (dmaReady) {
+    waitIdle();
+  }
+  renderNoteFlush(count, pixels, micros() - start);
+}
+
+// ========================== DMA 传输 ==========================
+void PanelDMA::pushRect(const DirtyRect& r) {
+  uint16_t x0 = r.x + panel->xOffset();
+  uint16_t x1 = x0 + r.w - 1;
+  uint16_t y0 = r.y + panel->yOffset();
+  uint16_t y1 = y0 + r.h - 1;
+
+  uint8_t caset[4] = {(uint8_t)(x0 >> 8), (uint8_t)x0, (uint8_t)(x1 >> 8), (uint8_t)x1};
+  uint8_t raset[4] = {(uint8_t)(y0 >> 8), (uint8_t)y0, (uint8_t)(y1 >> 8), (uint8_t)y1};
+  queueCommand(ST77XX_CASET);
+  queueData(caset, 4);
+  queueCommand(ST77XX_RASET);
+  queueData(raset, 4);
+  queueCommand(ST77XX_RAMWR);
+
+  int16_t rowsPerChunk = max(1, PANEL_DMA_CHUNK_PIXELS / r.w);
+  for (int16_t y = r.y; y < r.y + r.h; y += rowsPerChunk) {
+    int16_t rows = min<int16_t>(rowsPerChunk, r.y + r.h - y);
+    uint16_t* chunk = acquireChunk();
+    for (int16_t k = 0; k < rows; k++) {
+      memcpy(chunk + k * r.w, fb->pixels(r.x, y + k), r.w * sizeof(uint16_t));
+    }
+
+    spi_transaction_t* t = nextTransaction();
+    t->length = (size_t)r.w * rows * 16;
+    t->tx_buffer = chunk;
+    t->user = (void*)1;
+    spi_device_queue_trans(spi, t, portMAX_DELAY);
+  }
+}
+
+spi_transaction_t* PanelDMA::nextTransaction() {
+  // 事务按 FIFO 完成，队列满时回收最早的一个即可复用其槽位
+  if (inflight == PANEL_DMA_QUEUE_DEPTH) {
+    reapOne();
+  }
+  spi_transaction_t* t = &transactions[transHead];
+  transHead = (transHead + 1) % PANEL_DMA_QUEUE_DEPTH;
+  inflight++;
+  memset(t, 0, sizeof(*t));
+  return t;
+}
+
+void PanelDMA::queueCommand(uint8_t cmd) {
+  spi_transaction_t* t = nextTransaction();
+  t->flags = SPI_TRANS_USE_TXDATA;
+  t->length = 8;
+  t->tx_data[0] = cmd;
+  t->user = (void*)0;
+  spi_device_queue_trans(spi, t, portMAX_DELAY);
+}
+
+void PanelDMA::queueData(const uint8_t* data, uint8_t len) {
+  spi_transaction_t* t = nextTransaction();
+  t->flags = SPI_TRANS_USE_TXDATA;
+  t->length = len * 8;
+  memcpy(t->tx_data, data, len);
+  t->user = (void*)1;
+  spi_device_queue_trans(spi, t, portMAX_DELAY);
+}
+
+uint16_t* PanelDMA::acquireChunk() {
+  uint8_t k = nextChunk;
+  while (chunkBusy[k]) {
+    reapOne();
+  }
+  chunkBusy[k] = true;
+  nextChunk ^= 1;
+  return chunks[k];
+}
+
+void PanelDMA::reapOne() {
+  spi_transaction_t* done = nullptr;
+  if (spi_device_get_trans_result(spi, &done, portMAX_DELAY) != ESP_OK) {
+    return;
+  }
+  inflight--;
+  for (uint8_t k = 0; k < 2; k++) {
+    if (!(done->flags & SPI_TRANS_USE_TXDATA) && done->tx_buffer == chunks[k]) {
+      chunkBusy[k] = false;
+    }
+  }
+}
+
+void PanelDMA::waitIdle() {
+  while (inflight > 0) {
+    reapOne();
+  }
+}
+
+// ========================== 阻塞回退 ==========================
+void PanelDMA::pushRectBlocking(const DirtyRect& r) {
+  panel->startWrite();
+  panel->setAddrWindow(r.x, r.y, r.w, r.h);
+  for (int16_t k = 0; k < r.h; k++) {
+    panel->writePixels((uint16_t*)fb->pixels(r.x, r.y + k), r.w, true, true);
+  }
+  panel->endWrite();
+}
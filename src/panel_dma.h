@@ -0,0 +1,66 @@
+// ============================================================================
+// ST7789 DMA 刷新
+// 功能：独立任务取走帧缓冲的脏矩形，经内部 RAM 的双缓冲分块，
+//       以排队的 SPI DMA 传输推送到屏幕，绘制任务不再阻塞在像素传输上。
+//       刷新任务拷贝像素期间绘制任务不能改动帧缓冲：每帧绘制前先 frameBegin() 等上一帧刷完
+// ============================================================================
+#pragma once
+
+#include <Arduino.h>
+#include <Adafruit_ST7789.h>
+#include <driver/spi_master.h>
+#include "framebuffer.h"
+
+#define PANEL_SPI_FREQ          40000000  // SPI 时钟 40MHz
+#define PANEL_DMA_QUEUE_DEPTH   8         // 排队的 SPI 事务数
+#define PANEL_DMA_CHUNK_PIXELS  (240 * 16) // 每个 DMA 分块的像素数（16行）
+
+// 暴露 Adafruit 库内部的 GRAM 偏移（随 rotation 变化），DMA 设置窗口时需要
+class ST7789Panel : public Adafruit_ST7789 {
+ public:
+  ST7789Panel(int8_t cs, int8_t dc, int8_t rst) : Adafruit_ST7789(cs, dc, rst) {}
+  int16_t xOffset() const { return _xstart; }
+  int16_t yOffset() const { return _ystart; }
+};
+
+class PanelDMA {
+ public:
+  PanelDMA();
+
+  // 在 tft.init()/setRotation() 之后调用；此后屏幕只能经由本类访问
+  bool begin(ST7789Panel& panel, FrameBuffer& fb,
+             int8_t mosiPin, int8_t sclkPin, int8_t csPin, int8_t dcPin);
+
+  // 绘制任务在每帧绘制前调用：上一帧还在刷新时等待其完成，避免画面撕裂
+  void frameBegin();
+  // 非阻塞：交出本帧脏矩形并通知刷新任务推送
+  void requestFlush();
+
+ private:
+  static void flushTask(void* arg);
+  void flushDirty();
+  void pushRect(const DirtyRect& r);
+  void pushRectBlocking(const DirtyRect& r);
+
+  spi_transaction_t* nextTransaction();
+  void queueCommand(uint8_t cmd);
+  void queueData(const uint8_t* data, uint8_t len);
+  uint16_t* acquireChunk();
+  void reapOne();
+  void waitIdle();
+
+  ST7789Panel* panel;
+  FrameBuffer* fb;
+  spi_device_handle_t spi;
+  TaskHandle_t taskHandle;
+  SemaphoreHandle_t idle;  // 没有正在进行的刷新时可取得
+  bool dmaReady;
+
+  spi_transaction_t transactions[PANEL_DMA_QUEUE_DEPTH];
+  uint8_t transHead;
+  uint8_t inflight;
+
+  uint16_t* chunks[2];  // DMA 可访问的内部 RAM（PSRAM 不能直接做 SPI DMA 源）
+  bool chunkBusy[2];
+  uint8_t nextChunk;
+};
@@ -0,0 +1,45 @@
+// ============================================================================
+// Prometheus 文本格式输出实现
+// ============================================================================
+#include "prom_text.h"
+#include <stdarg.h>
+#include <stdio.h>
+
+void appendf(char* buf, size_t size, size_t& len, const char* format, ...) {
+  if (len >= size) {
+    return;
+  }
+  va_list args;
+  va_start(args, format);
+  int n = vsnprintf(buf + len, size - len, format, args);
+  va_end(args);
+  len = (n < 0 || (size_t)n >= size - len) ? size : len + n;
+}
+
+void promHeader(char* buf, size_t size, size_t& len, const char* name, const char* type, const char* help) {
+  if (help != nullptr) {
+    appendf(buf, size, len, "# HELP %s %s\n", name, help);
+  }
+  appendf(buf, size, len, "# TYPE %s %s\n", name, type);
+}
+
+void promHistogram(char* buf, size_t size, size_t& len, const char* name, const char* labels,
+                   const uint32_t* buckets, uint8_t count, const uint32_t* bounds, double scale,
+                   double sum) {
+  const char* sep = labels[0] ? "," : "";
+  uint32_t cumulative = 0;
+  for (uint8_t i = 0; i < count; i++) {
+    cumulative += buckets[i];
+    if (i < count - 1) {
+      appendf(buf, size, len, "%s_bucket{%s%sle=\"%g\"} %lu\n",
+              name, labels, sep, bounds[i] * scale, (unsigned long)cumulative);
+    } else {
+      appendf(buf, size, len, "%s_bucket{%s%sle=\"+Inf\"} %lu\n",
+              name, labels, sep, (unsigned long)cumulative);
+    }
+  }
+  const char* open = labels[0] ? "{" : "";
+  const char* close = labels[0] ? "}" : "";
+  appendf(buf, size, len, "%s_sum%s%s%s %.6f\n", name, open, labels, close, sum);
+  appendf(buf, size, len, "%s_count%s%s%s %lu\n", name, open, labels, close, (unsigned long)cumulative);
+}
@@ -0,0 +1,24 @@
+// ============================================================================
+// Prometheus 文本格式输出
+// 功能：各模块的 xxxToPrometheus() 共用的追加函数。全部写入调用方提供的定长缓冲区，
+//       不分配内存；缓冲区不足时 len 置为 size，之后的追加不再写入，
+//       调用方最后以 len < size 判断输出是否完整
+// ============================================================================
+#pragma once
+
+#include <Arduino.h>
+
+// 追加 printf 格式的文本
+void appendf(char* buf, size_t size, size_t& len, const char* format, ...)
+    __attribute__((format(printf, 4, 5)));
+
+// "# HELP"（help 为 nullptr 时省略）和 "# TYPE" 两行
+void promHeader(char* buf, size_t size, size_t& len, const char* name, const char* type,
+                const char* help = nullptr);
+
+// 一组直方图样本：_bucket（累计）、_sum、_count。
+// buckets 为 count 档非累计计数，最后一档为 +Inf；bounds 为前 count-1 档上界，
+// 乘以 scale 换算到导出单位；sum 已是导出单位；labels 为 "" 或不带花括号的标签列表
+void promHistogram(char* buf, size_t size, size_t& len, const char* name, const char* labels,
+                   const uint32_t* buckets, uint8_t count, const uint32_t* bounds, double scale,
+                   double sum);
@@ -0,0 +1,143 @@
+// ============================================================================
+// 界面刷新统计实现
+// ============================================================================
+#include "render_stats.h"
+#include <stdio.h>
+#include "prom_text.h"
+
+// 直方图上界（微秒 / 字节），最后一档为 +Inf
+static const uint32_t TIME_BUCKETS_US[RENDER_HIST_BUCKETS - 1] = {
+  250, 500, 1000, 2000, 5000, 10000, 20000, 50000, 100000,
+};
+static const uint32_t BYTE_BUCKETS[RENDER_HIST_BUCKETS - 1] = {
+  64, 256, 1024, 2048, 4096, 8192, 16384, 32768, 65536,
+};
+
+struct Histogram {
+  uint32_t buckets[RENDER_HIST_BUCKETS];  // 非累计，导出时再累加
+  uint64_t sum;
+};
+
+struct RenderStats {
+  Histogram frameTime[RENDER_FRAME_KINDS];
+  uint32_t lastFrameUs[RENDER_FRAME_KINDS];
+  uint32_t redraws[RENDER_FRAME_KINDS][RENDER_REDRAW_KINDS];
+  uint64_t pixelsDrawn[RENDER_FRAME_KINDS];
+  uint32_t u8g2Begins;
+
+  Histogram flushTime;
+  Histogram flushBytes;
+  uint32_t flushRects;
+  uint64_t flushPixels;
+  uint64_t spiBytes;
+};
+
+static RenderStats stats;
+static portMUX_TYPE statsLock = portMUX_INITIALIZER_UNLOCKED;
+
+static const char* FRAME_NAMES[RENDER_FRAME_KINDS] = {"clock", "temp_humi"};
+static const char* REDRAW_NAMES[RENDER_REDRAW_KINDS] = {"none", "seconds", "digits", "full"};
+
+static void observe(Histogram& h, const uint32_t* bounds, uint32_t value) {
+  uint8_t i = 0;
+  while (i < RENDER_HIST_BUCKETS - 1 && value > bounds[i]) {
+    i++;
+  }
+  h.buckets[i]++;
+  h.sum += value;
+}
+
+uint32_t renderFrameBegin() {
+  return micros();
+}
+
+void renderFrameEnd(RenderFrameKind kind, uint32_t startUs, RenderRedraw redraw, uint32_t pixelsDrawn) {
+  uint32_t elapsed = micros() - startUs;
+  portENTER_CRITICAL(&statsLock);
+  observe(stats.frameTime[kind], TIME_BUCKETS_US, elapsed);
+  stats.lastFrameUs[kind] = elapsed;
+  stats.redraws[kind][redraw]++;
+  stats.pixelsDrawn[kind] += pixelsDrawn;
+  portEXIT_CRITICAL(&statsLock);
+}
+
+void renderNoteU8g2Begin() {
+  portENTER_CRITICAL(&statsLock);
+  stats.u8g2Begins++;
+  portEXIT_CRITICAL(&statsLock);
+}
+
+void renderNoteFlush(uint8_t rects, uint32_t pixels, uint32_t durationUs) {
+  uint32_t bytes = rects * RENDER_SPI_RECT_OVERHEAD + pixels * 2;
+  portENTER_CRITICAL(&statsLock);
+  observe(stats.flushTime, TIME_BUCKETS_US, durationUs);
+  observe(stats.flushBytes, BYTE_BUCKETS, bytes);
+  stats.flushRects += rects;
+  stats.flushPixels += pixels;
+  stats.spiBytes += bytes;
+  portEXIT_CRITICAL(&statsLock);
+}
+
+// ========================== Prometheus 导出 ==========================
+
+// scale: 观测值换算到导出单位（微秒 -> 秒为 1e-6，字节为 1）
+static void appendHistogram(char* buf, size_t size, size_t& len, const char* name,
+                            const char* labels, const Histogram& h,
+                            const uint32_t* bounds, double scale) {
+  promHistogram(buf, size, len, name, labels, h.buckets, RENDER_HIST_BUCKETS, bounds, scale, h.sum * scale);
+}
+
+size_t renderStatsToPrometheus(char* buf, size_t size) {
+  // 先复制快照再格式化，临界区内不做耗时操作
+  RenderStats s;
+  portENTER_CRITICAL(&statsLock);
+  s = stats;
+  portEXIT_CRITICAL(&statsLock);
+
+  size_t len = 0;
+  char labels[32];
+
+  promHeader(buf, size, len, "display_frame_seconds", "histogram", "Time spent drawing one update into the frame buffer.");
+  for (uint8_t k = 0; k < RENDER_FRAME_KINDS; k++) {
+    snprintf(labels, sizeof(labels), "frame=\"%s\"", FRAME_NAMES[k]);
+    appendHistogram(buf, size, len, "display_frame_seconds", labels, s.frameTime[k], TIME_BUCKETS_US, 1e-6);
+  }
+
+  promHeader(buf, size, len, "display_last_frame_seconds", "gauge", "Duration of the most recent update.");
+  for (uint8_t k = 0; k < RENDER_FRAME_KINDS; k++) {
+    appendf(buf, size, len, "display_last_frame_seconds{frame=\"%s\"} %.6f\n",
+            FRAME_NAMES[k], s.lastFrameUs[k] * 1e-6);
+  }
+
+  promHeader(buf, size, len, "display_redraws_total", "counter", "Updates by redraw type (seconds-only partial vs full).");
+  for (uint8_t k = 0; k < RENDER_FRAME_KINDS; k++) {
+    for (uint8_t r = 0; r < RENDER_REDRAW_KINDS; r++) {
+      appendf(buf, size, len, "display_redraws_total{frame=\"%s\",type=\"%s\"} %lu\n",
+              FRAME_NAMES[k], REDRAW_NAMES[r], (unsigned long)s.redraws[k][r]);
+    }
+  }
+
+  promHeader(buf, size, len, "display_drawn_pixels_total", "counter", "Pixels written into the frame buffer.");
+  for (uint8_t k = 0; k < RENDER_FRAME_KINDS; k++) {
+    appendf(buf, size, len, "display_drawn_pixels_total{frame=\"%s\"} %llu\n",
+            FRAME_NAMES[k], (unsigned long long)s.pixelsDrawn[k]);
+  }
+
+  promHeader(buf, size, len, "display_u8g2_begin_total", "counter", "Calls to u8g2.begin().");
+  appendf(buf, size, len, "display_u8g2_begin_total %lu\n", (unsigned long)s.u8g2Begins);
+
+  promHeader(buf, size, len, "display_flush_seconds", "histogram", "Time to push one batch of dirty rects to the panel.");
+  appendHistogram(buf, size, len, "display_flush_seconds", "", s.flushTime, TIME_BUCKETS_US, 1e-6);
+
+  promHeader(buf, size, len, "display_flush_bytes", "histogram", "SPI bytes pushed per flush.");
+  appendHistogram(buf, size, len, "display_flush_bytes", "", s.flushBytes, BYTE_BUCKETS, 1);
+
+  promHeader(buf, size, len, "display_flush_rects_total", "counter");
+  appendf(buf, size, len, "display_flush_rects_total %lu\n", (unsigned long)s.flushRects);
+  promHeader(buf, size, len, "display_flush_pixels_total", "counter");
+  appendf(buf, size, len, "display_flush_pixels_total %llu\n", (unsigned long long)s.flushPixels);
+  promHeader(buf, size, len, "display_spi_bytes_total", "counter");
+  appendf(buf, size, len, "display_spi_bytes_total %llu\n", (unsigned long long)s.spiBytes);
+
+  return len < size ? len : 0;
+}
@@ -0,0 +1,40 @@
+// ============================================================================
+// 界面刷新统计
+// 功能：记录每次 updateClock()/updateTempHumi() 的耗时、重绘类型和绘制像素，
+//       以及刷新任务推送到屏幕的矩形/像素/SPI 字节数，
+//       以 Prometheus 文本格式导出（HTTP 服务器的 /metrics）
+// ============================================================================
+#pragma once
+
+#include <Arduino.h>
+
+// ST7789 每个矩形的窗口设置开销：CASET/RASET/RAMWR 三条命令 + 8 字节参数
+#define RENDER_SPI_RECT_OVERHEAD 11
+#define RENDER_HIST_BUCKETS      10   // 含 +Inf
+
+enum RenderFrameKind : uint8_t {
+  RENDER_FRAME_CLOCK = 0,   // updateClock()
+  RENDER_FRAME_TEMP_HUMI,   // updateTempHumi()
+  RENDER_FRAME_KINDS,
+};
+
+enum RenderRedraw : uint8_t {
+  RENDER_REDRAW_NONE = 0,   // 没有需要重绘的内容
+  RENDER_REDRAW_SECONDS,    // 只重绘秒位（最常见的局部刷新）
+  RENDER_REDRAW_DIGITS,     // 时/分位也有变化，或温湿度读数变化
+  RENDER_REDRAW_FULL,       // 文字重绘（日期变化、传感器错误提示、无字形缓存时）
+  RENDER_REDRAW_KINDS,
+};
+
+// 绘制计时：begin 返回起始时间（微秒），end 记录耗时、重绘类型和本次写入帧缓冲的像素数
+uint32_t renderFrameBegin();
+void renderFrameEnd(RenderFrameKind kind, uint32_t startUs, RenderRedraw redraw, uint32_t pixelsDrawn);
+
+// u8g2.begin() 调用计数（每次都会重新绑定绘制目标）
+void renderNoteU8g2Begin();
+
+// 刷新任务每推送完一批脏矩形调用一次
+void renderNoteFlush(uint8_t rects, uint32_t pixels, uint32_t durationUs);
+
+// Prometheus 文本格式，缓冲区不足时返回 0
+size_t renderStatsToPrometheus(char* buf, size_t size);
@@ -0,0 +1,228 @@
+// ============================================================================
+// 定时控制轨迹实现
+// 主循环把记录追加到内存缓冲，满了或整分钟时在锁内写入文件；/trace 请求先在锁内
+// 写出缓冲，再分段读取文件。文件轮换后正在进行的下载提前结束
+// ============================================================================
+#include "schedule_trace.h"
+#include <ESPAsyncWebServer.h>
+#include <LittleFS.h>
+#include <freertos/semphr.h>
+
+static SemaphoreHandle_t traceLock = nullptr;
+static TraceRecord buffer[TRACE_BUFFER_RECORDS];
+static uint8_t buffered = 0;
+static uint32_t fileSize = 0;
+static uint32_t generation = 0;  // 每次轮换加一，下载中途发现变化时结束
+
+// 新文件开头的状态快照
+static AcSchedule lastSchedule;
+static bool lastEnabled = true;
+static time_t lastRunAt = 0;
+
+// 时钟跳变检测和读数去重
+static time_t lastClockUnix = 0;
+static uint32_t lastClockMs = 0;
+static bool lastSampleValid = false;
+static int16_t lastSampleTenths = TRACE_NO_TEMPERATURE;
+
+static void emit(const TraceRecord& r);
+
+static TraceRecord makeRecord(TraceType type, uint8_t arg, time_t now) {
+  TraceRecord r = {};
+  r.ms = millis();
+  r.timestamp = (uint32_t)now;
+  r.type = type;
+  r.arg = arg;
+  return r;
+}
+
+static void emitState() {
+  TraceRecord r = makeRecord(TRACE_STATE, lastEnabled, time(nullptr));
+  traceSetU32(r, 0, (uint32_t)lastRunAt);
+  r.data[4] = lastSchedule.size();
+  emit(r);
+  for (uint8_t i = 0; i < lastSchedule.size(); i++) {
+    traceEncodeRule(r, i, lastSchedule.rule(i));
+    emit(r);
+  }
+}
+
+// 调用方持有 traceLock
+static bool startFile() {
+  File file = LittleFS.open(TRACE_PATH, FILE_WRITE);
+  if (!file) {
+    return false;
+  }
+  static const uint8_t header[TRACE_HEADER_SIZE] = {'S', 'T', 'R', '1', 0, 0, 0, 0};
+  file.write(header, sizeof(header));
+  file.close();
+  fileSize = TRACE_HEADER_SIZE;
+  return true;
+}
+
+// 把缓冲写入文件，调用方持有 traceLock；返回 true 表示文件已轮换，需要补写状态快照
+static bool writeBuffered() {
+  if (buffered == 0) {
+    return false;
+  }
+  File file = LittleFS.open(TRACE_PATH, FILE_APPEND);
+  if (file) {
+    file.write((const uint8_t*)buffer, buffered * sizeof(TraceRecord));
+    file.close();
+    fileSize += buffered * sizeof(TraceRecord);
+  }
+  buffered = 0;
+  if (fileSize < TRACE_FILE_MAX) {
+    return false;
+  }
+  LittleFS.remove(TRACE_PREV_PATH);
+  LittleFS.rename(TRACE_PATH, TRACE_PREV_PATH);
+  generation++;
+  startFile();
+  return true;
+}
+
+static void flush() {
+  if (traceLock == nullptr) {
+    return;
+  }
+  xSemaphoreTake(traceLock, portMAX_DELAY);
+  bool rotated = writeBuffered();
+  xSemaphoreGive(traceLock);
+  if (rotated) {
+    emitState();
+  }
+}
+
+static void emit(const TraceRecord& r) {
+  if (traceLock == nullptr) {
+    return;
+  }
+  xSemaphoreTake(traceLock, portMAX_DELAY);
+  buffer[buffered++] = r;
+  bool full = buffered == TRACE_BUFFER_RECORDS;
+  xSemaphoreGive(traceLock);
+  if (full) {
+    flush();
+  }
+}
+
+// GET /trace[?prev=1]：先写出缓冲，再按发送窗口分段读取文件
+static void handleTrace(AsyncWebServerRequest* request) {
+  const char* path = request->hasParam("prev") ? TRACE_PREV_PATH : TRACE_PATH;
+  xSemaphoreTake(traceLock, portMAX_DELAY);
+  writeBuffered();  // 轮换后的状态快照由主循环下一次写入时补上
+  uint32_t startGeneration = generation;
+  bool exists = LittleFS.exists(path);
+  xSemaphoreGive(traceLock);
+  if (!exists) {
+    request->send(404, "application/json", "{\"status\":\"error\",\"message\":\"no trace\"}");
+    return;
+  }
+
+  AsyncWebServerResponse* response = request->beginChunkedResponse("application/octet-stream",
+      [path, startGeneration](uint8_t* out, size_t maxLen, size_t index) -> size_t {
+        size_t n = 0;
+        xSemaphoreTake(traceLock, portMAX_DELAY);
+        if (generation == startGeneration) {
+          File file = LittleFS.open(path, FILE_READ);
+          if (file && file.seek(index)) {
+            n = file.read(out, maxLen);
+          }
+          file.close();
+        }
+        xSemaphoreGive(traceLock);
+        return n;
+      });
+  response->addHeader("Cache-Control", "no-store");
+  request->send(response);
+}
+
+bool scheduleTraceBegin(AsyncWebServer& server) {
+  if (!LittleFS.begin(true)) {
+    return false;
+  }
+  File file = LittleFS.open(TRACE_PATH, FILE_READ);
+  size_t size = file ? file.size() : 0;
+  file.close();
+  // 掉电时可能留下半条记录：截掉之前的部分无法对齐，直接换新文件
+  if (size < TRACE_HEADER_SIZE || (size - TRACE_HEADER_SIZE) % TRACE_RECORD_SIZE != 0 ||
+      size >= TRACE_FILE_MAX) {
+    LittleFS.remove(TRACE_PREV_PATH);
+    if (size >= TRACE_HEADER_SIZE) {
+      LittleFS.rename(TRACE_PATH, TRACE_PREV_PATH);
+    }
+    if (!startFile()) {
+      return false;
+    }
+  } else {
+    fileSize = size;
+  }
+  traceLock = xSemaphoreCreateMutex();
+  if (traceLock == nullptr) {
+    return false;
+  }
+  server.on("/trace", HTTP_GET, handleTrace);
+  return true;
+}
+
+void scheduleTraceBoot(uint32_t bootCount, uint8_t resetReason) {
+  TraceRecord r = makeRecord(TRACE_BOOT, resetReason, time(nullptr));
+  traceSetU32(r, 0, bootCount);
+  emit(r);
+}
+
+void scheduleTraceState(const AcSchedule& schedule, bool enabled, time_t lastRun) {
+  lastSchedule = schedule;
+  lastEnabled = enabled;
+  lastRunAt = lastRun;
+  emitState();
+}
+
+void scheduleTraceClock(time_t now) {
+  uint32_t ms = millis();
+  bool first = lastClockMs == 0 && lastClockUnix == 0;
+  long expected = (long)lastClockUnix + (long)((ms - lastClockMs + 500) / 1000);
+  bool jump = !first && labs((long)now - expected) >= TRACE_JUMP_SEC;
+  lastClockUnix = now;
+  lastClockMs = ms;
+  if (first || jump || now % 60 == 0) {
+    emit(makeRecord(TRACE_CLOCK, jump, now));
+  }
+  if (now % 60 == 0) {
+    flush();
+  }
+}
+
+void scheduleTraceTimeSync(time_t now) {
+  emit(makeRecord(TRACE_TIME_SYNC, 0, now));
+}
+
+void scheduleTraceSample(bool valid, float temperature, float humidity) {
+  int16_t tenths = valid ? traceTenths(temperature) : TRACE_NO_TEMPERATURE;
+  if (valid == lastSampleValid && tenths == lastSampleTenths) {
+    return;
+  }
+  lastSampleValid = valid;
+  lastSampleTenths = tenths;
+  TraceRecord r = makeRecord(TRACE_SAMPLE, valid, time(nullptr));
+  traceSetU16(r, 0, (uint16_t)tenths);
+  traceSetU16(r, 2, valid ? (uint16_t)lroundf(humidity * 10.0f) : 0);
+  emit(r);
+}
+
+void scheduleTraceCommand(AcAction action) {
+  emit(makeRecord(TRACE_COMMAND, action, time(nullptr)));
+}
+
+void scheduleTraceRun(time_t now, const AcRunResult& run, time_t lastRun, float temperature) {
+  lastRunAt = lastRun;
+  TraceRecord r = makeRecord(TRACE_RUN, run.outcome, now);
+  bool hasEvent = run.outcome == AC_RUN_DISABLED || run.outcome == AC_RUN_EXECUTED ||
+                  run.outcome == AC_RUN_WAIT_SENSOR;
+  r.data[0] = hasEvent ? run.event.rule : 0xFF;
+  r.data[1] = run.action;
+  traceSetU16(r, 2, (uint16_t)traceTenths(temperature));
+  traceSetU16(r, 4, hasEvent ? (uint16_t)min<long>((long)(now - run.event.due), UINT16_MAX) : 0);
+  emit(r);
+}
@@ -0,0 +1,100 @@
+// ============================================================================
+// 定时控制轨迹
+// 功能：把主循环看到的时钟、温度读数、远程指令、定时开关/规则和每次定时运行的结果
+//       追加到 LittleFS 上的定长记录文件；下载后由主机上的回放程序（src/native/replay）
+//       在虚拟时钟上重新运行 acScheduleRun()，检查定时事件是否漏执行、重复执行或延迟，
+//       不必在设备旁等到 8:00 或 17:30。
+//       时钟只在整分钟和时间跳变（NTP 校正、重启后恢复）时记录，读数只在温度变化或
+//       有效性变化时记录；记录先攒在内存里，满 TRACE_BUFFER_RECORDS 条或每分钟写一次。
+//       文件达到 TRACE_FILE_MAX 后改名为 TRACE_PREV_PATH 重新开始，新文件以一份状态快照开头
+//
+// 文件格式（GET /trace，?prev=1 为上一个文件）：
+//   头部 8 字节："STR1"、4 字节保留
+//   之后每条记录 16 字节（小端）：
+//     uint32 ms         millis()，每次启动从 0 开始
+//     uint32 timestamp  time(nullptr)，未同步时小于 AC_SCHEDULE_SYNCED_AFTER
+//     uint8  type       TraceType
+//     uint8  arg        见各类型
+//     uint8  data[6]
+// ============================================================================
+#pragma once
+
+#include <Arduino.h>
+#include <time.h>
+#include "ac_control.h"
+
+#define TRACE_PATH            "/trace.bin"
+#define TRACE_PREV_PATH       "/trace.1"
+#define TRACE_FILE_MAX        (192 * 1024)  // 约 12000 条，正常运行时可保存几天
+#define TRACE_BUFFER_RECORDS  32
+#define TRACE_JUMP_SEC        2             // 相邻时钟事件的系统时间与 millis() 相差超过该值视为跳变
+#define TRACE_HEADER_SIZE     8
+#define TRACE_RECORD_SIZE     16
+#define TRACE_NO_TEMPERATURE  INT16_MIN
+
+enum TraceType : uint8_t {
+  TRACE_BOOT = 1,    // arg = esp_reset_reason()，data = uint32 启动次数
+  TRACE_STATE,       // arg = 定时开关，data = uint32 lastRun、uint8 规则数；随后是同样数量的 TRACE_RULE
+  TRACE_RULE,        // arg = 规则下标，data = weekdays、hour、minute、action、int16 belowTenths
+  TRACE_CLOCK,       // arg = 1 时间跳变 / 0 整分钟
+  TRACE_TIME_SYNC,   // SNTP 完成一次同步（之后立即运行定时）
+  TRACE_SAMPLE,      // arg = 1 有效 / 0 无读数，data = int16 温度 0.1°C、uint16 湿度 0.1%
+  TRACE_COMMAND,     // 远程指令，arg = AcAction
+  TRACE_RUN,         // 定时运行一次，arg = AcRunOutcome，data = 规则、动作、int16 温度 0.1°C、uint16 距事件时间（秒）
+};
+
+struct TraceRecord {
+  uint32_t ms;
+  uint32_t timestamp;
+  uint8_t type;
+  uint8_t arg;
+  uint8_t data[6];
+};
+
+// 主机和设备都是小端，记录直接按内存布局读写
+static_assert(sizeof(TraceRecord) == TRACE_RECORD_SIZE, "TraceRecord layout");
+
+inline void traceSetU16(TraceRecord& r, uint8_t offset, uint16_t value) { memcpy(r.data + offset, &value, 2); }
+inline void traceSetU32(TraceRecord& r, uint8_t offset, uint32_t value) { memcpy(r.data + offset, &value, 4); }
+inline uint16_t traceU16(const TraceRecord& r, uint8_t offset) { uint16_t v; memcpy(&v, r.data + offset, 2); return v; }
+inline uint32_t traceU32(const TraceRecord& r, uint8_t offset) { uint32_t v; memcpy(&v, r.data + offset, 4); return v; }
+
+// 温度换算为 0.1°C（NAN 为 TRACE_NO_TEMPERATURE）
+inline int16_t traceTenths(float value) {
+  return isnan(value) ? TRACE_NO_TEMPERATURE : (int16_t)lroundf(value * 10.0f);
+}
+
+inline void traceEncodeRule(TraceRecord& r, uint8_t index, const AcScheduleRule& rule) {
+  r.type = TRACE_RULE;
+  r.arg = index;
+  r.data[0] = rule.weekdays;
+  r.data[1] = rule.hour;
+  r.data[2] = rule.minute;
+  r.data[3] = rule.action;
+  traceSetU16(r, 4, (uint16_t)rule.belowTenths);
+}
+
+inline AcScheduleRule traceDecodeRule(const TraceRecord& r) {
+  AcScheduleRule rule;
+  rule.weekdays = r.data[0];
+  rule.hour = r.data[1];
+  rule.minute = r.data[2];
+  rule.action = (AcAction)r.data[3];
+  rule.belowTenths = (int16_t)traceU16(r, 4);
+  return rule;
+}
+
+// ---------------------------- 设备端记录 ----------------------------
+// 以下函数只在主循环中调用；/trace 在 async_tcp 任务中读取文件，两者用互斥锁隔开
+class AsyncWebServer;
+
+// 挂载 LittleFS（遥测队列已挂载时直接使用）并注册 GET /trace；失败时记录函数不做任何事
+bool scheduleTraceBegin(AsyncWebServer& server);
+void scheduleTraceBoot(uint32_t bootCount, uint8_t resetReason);
+// 定时开关、规则和已处理到的时间点：启动加载后、规则或开关更新后调用
+void scheduleTraceState(const AcSchedule& schedule, bool enabled, time_t lastRun);
+void scheduleTraceClock(time_t now);    // 每个 EV_CLOCK
+void scheduleTraceTimeSync(time_t now);
+void scheduleTraceSample(bool valid, float temperature, float humidity);
+void scheduleTraceCommand(AcAction action);
+void scheduleTraceRun(time_t now, const AcRunResult& run, time_t lastRun, float temperature);
@@ -0,0 +1,47 @@
+// ============================================================================
+// 传感器驱动接口
+// 功能：每种温湿度传感器实现同一个两段式接口，由采集任务（sensor_task）统一调度：
+//         trigger()  开始一次测量，立即返回
+//         collect()  转换时间到后取结果；还没好时返回 SENSOR_PENDING，稍后再取
+//       驱动声明自己的最小采样间隔和转换时间，调度器据此让多个传感器的转换重叠进行，
+//       等待期间采集任务休眠，不忙等
+// ============================================================================
+#pragma once
+
+#include <Arduino.h>
+
+#define SENSOR_POLL_RETRY_MS 2  // collect() 返回 SENSOR_PENDING 后再次调用的间隔
+
+enum SensorStatus : uint8_t {
+  SENSOR_OK = 0,
+  SENSOR_PENDING,       // 转换未完成（只由 collect 返回）
+  SENSOR_ERR_TIMEOUT,   // 没有响应（未接、地址错误或超时）
+  SENSOR_ERR_FRAME,     // 数据不完整
+  SENSOR_ERR_CHECKSUM,  // 校验错误
+  SENSOR_ERR_BUS,       // 总线错误（I2C NACK、仲裁丢失等）
+};
+
+// 一次测量的结果；传感器不测的量为 NAN
+struct SensorReading {
+  float temperature;  // °C
+  float humidity;     // %RH
+  float pressure;     // hPa
+};
+
+class SensorDriver {
+ public:
+  virtual ~SensorDriver() {}
+
+  virtual const char* name() const = 0;
+  // 初始化并探测传感器（在 setup() 中调用，可以阻塞）；不存在时返回 false
+  virtual bool begin() = 0;
+  // 两次 trigger() 之间的最小间隔
+  virtual uint32_t minIntervalMs() const = 0;
+  // trigger() 之后至少等待多久再调用 collect()
+  virtual uint32_t conversionMs() const = 0;
+
+  virtual SensorStatus trigger() = 0;
+  virtual SensorStatus collect(SensorReading& out) = 0;
+};
+
+const char* sensorStatusName(SensorStatus status);
@@ -0,0 +1,64 @@
+// ============================================================================
+// 温湿度采样环形缓冲与滤波实现
+// ============================================================================
+#include "sensor_filter.h"
+#include <math.h>
+
+// DHT22 量程
+#define SENSOR_TEMP_MIN  -40.0f
+#define SENSOR_TEMP_MAX   80.0f
+#define SENSOR_HUMI_MIN    0.0f
+#define SENSOR_HUMI_MAX  100.0f
+
+SensorFilter::SensorFilter()
+    : head(0), count(0), emaValid(false), output{0, 0, 0}, rejected(0) {}
+
+bool SensorFilter::push(uint32_t timestampMs, float temperature, float humidity) {
+  if (isnan(temperature) || isnan(humidity) ||
+      temperature < SENSOR_TEMP_MIN || temperature > SENSOR_TEMP_MAX ||
+      humidity < SENSOR_HUMI_MIN || humidity > SENSOR_HUMI_MAX) {
+    rejected++;
+    return false;
+  }
+
+  ring[head] = SensorSample{timestampMs, temperature, humidity};
+  head = (head + 1) % SENSOR_RING_SIZE;
+  if (count < SENSOR_RING_SIZE) {
+    count++;
+  }
+
+  float medTemp = median(true);
+  float medHumi = median(false);
+  if (!emaValid) {
+    output.temperature = medTemp;
+    output.humidity = medHumi;
+    emaValid = true;
+  } else {
+    output.temperature += SENSOR_EMA_ALPHA * (medTemp - output.temperature);
+    output.humidity += SENSOR_EMA_ALPHA * (medHumi - output.humidity);
+  }
+  output.timestampMs = timestampMs;
+  return true;
+}
+
+const SensorSample& SensorFilter::raw(uint8_t index) const {
+  return ring[(head + SENSOR_RING_SIZE - 1 - index) % SENSOR_RING_SIZE];
+}
+
+// 最近 SENSOR_MEDIAN_WINDOW 个读数的中值（不足时用现有的）
+float SensorFilter::median(bool temperatureChannel) const {
+  float window[SENSOR_MEDIAN_WINDOW];
+  uint8_t n = count < SENSOR_MEDIAN_WINDOW ? count : SENSOR_MEDIAN_WINDOW;
+  for (uint8_t i = 0; i < n; i++) {
+    const SensorSample& s = raw(i);
+    float v = temperatureChannel ? s.temperature : s.humidity;
+    // 插入排序，窗口很小
+    uint8_t j = i;
+    while (j > 0 && window[j - 1] > v) {
+      window[j] = window[j - 1];
+      j--;
+    }
+    window[j] = v;
+  }
+  return (n % 2) ? window[n / 2] : (window[n / 2 - 1] + window[n / 2]) * 0.5f;
+}
@@ -0,0 +1,44 @@
+// ============================================================================
+// 温湿度采样环形缓冲与滤波
+// 功能：保存最近的带时间戳原始读数，拒绝 NaN/越界值，
+//       先做中值滤波去除尖峰，再做指数滑动平均（EMA）平滑
+// ============================================================================
+#pragma once
+
+#include <stdint.h>
+
+#define SENSOR_RING_SIZE      32     // 原始读数环形缓冲长度
+#define SENSOR_MEDIAN_WINDOW  5      // 中值滤波窗口
+#define SENSOR_EMA_ALPHA      0.3f   // EMA 系数（越大越跟手）
+
+struct SensorSample {
+  uint32_t timestampMs;  // millis() 时间戳
+  float temperature;
+  float humidity;
+};
+
+class SensorFilter {
+ public:
+  SensorFilter();
+
+  // 推入一次原始读数；NaN 或超出 DHT22 量程的值被拒绝，返回是否接受
+  bool push(uint32_t timestampMs, float temperature, float humidity);
+
+  bool hasValue() const { return emaValid; }
+  SensorSample filtered() const { return output; }
+
+  // 原始读数：index 0 为最新
+  uint8_t size() const { return count; }
+  const SensorSample& raw(uint8_t index) const;
+  uint32_t rejectedCount() const { return rejected; }
+
+ private:
+  float median(bool temperatureChannel) const;
+
+  SensorSample ring[SENSOR_RING_SIZE];
+  uint8_t head;   // 下一个写入位置
+  uint8_t count;
+  bool emaValid;
+  SensorSample output;
+  uint32_t rejected;
+};
@@ -0,0 +1,298 @@
+// ============================================================================
+// 温湿度采集任务实现
+// ============================================================================
+#include "sensor_task.h"
+#include "lockfree.h"
+#include "prom_text.h"
+#include "task_config.h"
+
+struct LatestSample {
+  SensorSample sample;
+  bool valid;
+};
+
+enum SlotState : uint8_t {
+  SLOT_IDLE = 0,     // 等待下次 trigger
+  SLOT_CONVERTING,   // 已 trigger，等待 collect
+};
+
+// 指标快照：采集任务写，async_tcp 读（在 statsLock 内复制）
+struct SensorStats {
+  uint32_t reads;
+  uint32_t errors[SENSOR_ERR_BUS + 1];  // 按 SensorStatus 计数
+  uint32_t rejected;                    // 被滤波器拒绝的读数（NaN/越界）
+  uint32_t conversionSumMs;             // trigger 到取得结果的耗时
+  float pressure;                       // 最近一次原始气压（不测气压为 NAN）
+};
+
+struct SensorSlot {
+  SensorDriver* driver;
+  uint32_t intervalMs;
+  SensorFilter filter;           // 只在采集任务中使用
+  SeqLock<LatestSample> latest;  // 采集任务写，loop 等读者各自复制快照
+  SlotState state;
+  uint32_t dueMs;                // IDLE：下次 trigger 的时间；CONVERTING：下次 collect 的时间
+  uint32_t triggerMs;
+  SensorStatus lastStatus;
+  SensorStats stats;
+};
+
+static SensorSlot slots[SENSOR_MAX_DRIVERS];
+static uint8_t slotCount = 0;  // 只在 setup() 中增加，采集任务启动后不变
+static portMUX_TYPE statsLock = portMUX_INITIALIZER_UNLOCKED;
+static SensorSampleCallback listeners[SENSOR_MAX_LISTENERS];
+static volatile uint8_t listenerCount = 0;
+
+static const char* STATUS_NAMES[SENSOR_ERR_BUS + 1] = {
+  "ok", "pending", "timeout", "frame", "checksum", "bus",
+};
+
+const char* sensorStatusName(SensorStatus status) {
+  switch (status) {
+    case SENSOR_OK:           return "正常";
+    case SENSOR_PENDING:      return "转换中";
+    case SENSOR_ERR_TIMEOUT:  return "无响应";
+    case SENSOR_ERR_FRAME:    return "数据不完整";
+    case SENSOR_ERR_CHECKSUM: return "校验错误";
+    case SENSOR_ERR_BUS:      return "总线错误";
+    default:                  return "未知错误";
+  }
+}
+
+// 采集任务中判断：该传感器当前是否有未过期的滤波读数
+static bool slotFresh(const SensorSlot& slot, uint32_t now) {
+  return slot.filter.hasValue() && (now - slot.filter.filtered().timestampMs) < SENSOR_STALE_MS;
+}
+
+// 一次测量结束（成功或失败）：更新滤波和指标，安排下次 trigger
+static void finishMeasurement(uint8_t index, SensorStatus status, const SensorReading& reading,
+                              uint32_t now) {
+  SensorSlot& slot = slots[index];
+  slot.state = SLOT_IDLE;
+  slot.dueMs = slot.triggerMs + slot.intervalMs;
+
+  bool accepted = false;
+  if (status == SENSOR_OK) {
+    accepted = slot.filter.push(now, reading.temperature, reading.humidity);
+  }
+  portENTER_CRITICAL(&statsLock);
+  if (status == SENSOR_OK) {
+    slot.stats.reads++;
+    slot.stats.conversionSumMs += now - slot.triggerMs;
+    slot.stats.pressure = reading.pressure;
+    slot.stats.rejected = slot.filter.rejectedCount();
+  } else {
+    slot.stats.errors[status]++;
+  }
+  portEXIT_CRITICAL(&statsLock);
+
+  if (accepted) {
+    LatestSample next;
+    next.sample = slot.filter.filtered();
+    next.valid = true;
+    slot.latest.write(next);
+
+    // 只有主传感器（第一个有有效读数的）的新读数才通知
+    bool primary = true;
+    for (uint8_t i = 0; i < index; i++) {
+      if (slotFresh(slots[i], now)) {
+        primary = false;
+        break;
+      }
+    }
+    if (primary) {
+      for (uint8_t i = 0; i < listenerCount; i++) {
+        listeners[i]();
+      }
+    }
+  }
+
+  // 只在状态变化时打印，避免传感器掉线时刷屏
+  if (status != slot.lastStatus) {
+    Serial.printf("%s %s: %s\n", status == SENSOR_OK ? "✅" : "❌", slot.driver->name(),
+                  sensorStatusName(status));
+    slot.lastStatus = status;
+  }
+}
+
+static void runSlot(uint8_t index, uint32_t now) {
+  SensorSlot& slot = slots[index];
+  if ((int32_t)(now - slot.dueMs) < 0) {
+    return;
+  }
+
+  SensorReading reading = {NAN, NAN, NAN};
+  if (slot.state == SLOT_IDLE) {
+    slot.triggerMs = now;
+    SensorStatus status = slot.driver->trigger();
+    if (status == SENSOR_OK) {
+      slot.state = SLOT_CONVERTING;
+      slot.dueMs = now + slot.driver->conversionMs();
+    } else {
+      finishMeasurement(index, status, reading, now);
+    }
+    return;
+  }
+
+  SensorStatus status = slot.driver->collect(reading);
+  if (status == SENSOR_PENDING) {
+    if (now - slot.triggerMs < slot.driver->conversionMs() + SENSOR_COLLECT_TIMEOUT_MS) {
+      slot.dueMs = now + SENSOR_POLL_RETRY_MS;
+      return;
+    }
+    status = SENSOR_ERR_TIMEOUT;
+  }
+  finishMeasurement(index, status, reading, now);
+}
+
+static void sensorTask(void* pvParameters) {
+  while (1) {
+    uint32_t now = millis();
+    for (uint8_t i = 0; i < slotCount; i++) {
+      runSlot(i, now);
+    }
+
+    // 休眠到最早的到期时间（下次 trigger 或转换完成）
+    now = millis();
+    int32_t wait = INT32_MAX;
+    for (uint8_t i = 0; i < slotCount; i++) {
+      int32_t remaining = (int32_t)(slots[i].dueMs - now);
+      if (remaining < wait) {
+        wait = remaining;
+      }
+    }
+    if (wait > 0) {
+      vTaskDelay(pdMS_TO_TICKS(wait) > 0 ? pdMS_TO_TICKS(wait) : 1);
+    }
+  }
+}
+
+bool sensorRegister(SensorDriver* driver, uint32_t intervalMs) {
+  if (slotCount >= SENSOR_MAX_DRIVERS) {
+    return false;
+  }
+  if (!driver->begin()) {
+    Serial.printf("⚪ 未检测到传感器 %s\n", driver->name());
+    return false;
+  }
+  SensorSlot& slot = slots[slotCount];
+  slot.driver = driver;
+  slot.intervalMs = max(intervalMs, driver->minIntervalMs());
+  slot.state = SLOT_IDLE;
+  slot.dueMs = millis();
+  slot.lastStatus = SENSOR_OK;
+  slot.stats.pressure = NAN;
+  slotCount++;
+  Serial.printf("🌡️  传感器 %s 已注册（间隔 %lu ms，转换 %lu ms）\n", driver->name(),
+                (unsigned long)slot.intervalMs, (unsigned long)driver->conversionMs());
+  return true;
+}
+
+bool sensorTaskBegin() {
+  if (slotCount == 0) {
+    Serial.println("❌ 没有可用的温湿度传感器");
+    return false;
+  }
+  xTaskCreatePinnedToCore(sensorTask, "SensorTask", 3072, NULL, TASK_PRIO_SENSOR, NULL, CORE_APP);
+  return true;
+}
+
+uint8_t sensorCount() {
+  return slotCount;
+}
+
+const char* sensorName(uint8_t index) {
+  return index < slotCount ? slots[index].driver->name() : "";
+}
+
+// 在 setup() 中注册；先写入回调再增加计数，采集任务不会看到未初始化的条目
+bool sensorOnSample(SensorSampleCallback callback) {
+  if (listenerCount >= SENSOR_MAX_LISTENERS) {
+    return false;
+  }
+  listeners[listenerCount] = callback;
+  listenerCount = listenerCount + 1;
+  return true;
+}
+
+bool sensorLatestFrom(uint8_t index, SensorSample& out) {
+  if (index >= slotCount) {
+    return false;
+  }
+  LatestSample snapshot;
+  slots[index].latest.read(snapshot);
+  out = snapshot.sample;
+  return snapshot.valid && (millis() - out.timestampMs) < SENSOR_STALE_MS;
+}
+
+bool sensorLatest(SensorSample& out) {
+  for (uint8_t i = 0; i < slotCount; i++) {
+    if (sensorLatestFrom(i, out)) {
+      return true;
+    }
+  }
+  sensorLatestFrom(0, out);  // 都已过期：返回主传感器最后的读数
+  return false;
+}
+
+size_t sensorToPrometheus(char* buf, size_t size) {
+  SensorStats stats[SENSOR_MAX_DRIVERS];
+  portENTER_CRITICAL(&statsLock);
+  for (uint8_t i = 0; i < slotCount; i++) {
+    stats[i] = slots[i].stats;
+  }
+  portEXIT_CRITICAL(&statsLock);
+
+  size_t len = 0;
+  promHeader(buf, size, len, "sensor_reads_total", "counter", "Successful measurements per sensor driver.");
+  for (uint8_t i = 0; i < slotCount; i++) {
+    appendf(buf, size, len, "sensor_reads_total{sensor=\"%s\"} %lu\n",
+            slots[i].driver->name(), (unsigned long)stats[i].reads);
+  }
+  promHeader(buf, size, len, "sensor_errors_total", "counter");
+  for (uint8_t i = 0; i < slotCount; i++) {
+    for (uint8_t s = SENSOR_ERR_TIMEOUT; s <= SENSOR_ERR_BUS; s++) {
+      appendf(buf, size, len, "sensor_errors_total{sensor=\"%s\",reason=\"%s\"} %lu\n",
+              slots[i].driver->name(), STATUS_NAMES[s], (unsigned long)stats[i].errors[s]);
+    }
+  }
+  promHeader(buf, size, len, "sensor_rejected_total", "counter", "Readings rejected by the filter (NaN or out of range).");
+  for (uint8_t i = 0; i < slotCount; i++) {
+    appendf(buf, size, len, "sensor_rejected_total{sensor=\"%s\"} %lu\n",
+            slots[i].driver->name(), (unsigned long)stats[i].rejected);
+  }
+  promHeader(buf, size, len, "sensor_conversion_seconds_avg", "gauge", "Mean time from trigger to result.");
+  for (uint8_t i = 0; i < slotCount; i++) {
+    appendf(buf, size, len, "sensor_conversion_seconds_avg{sensor=\"%s\"} %.4f\n", slots[i].driver->name(),
+            stats[i].reads ? stats[i].conversionSumMs / 1000.0 / stats[i].reads : 0.0);
+  }
+
+  // 同一指标的样本必须连续，先取快照再分两段输出
+  SensorSample samples[SENSOR_MAX_DRIVERS];
+  bool fresh[SENSOR_MAX_DRIVERS];
+  for (uint8_t i = 0; i < slotCount; i++) {
+    fresh[i] = sensorLatestFrom(i, samples[i]);
+  }
+  promHeader(buf, size, len, "sensor_temperature_celsius", "gauge");
+  for (uint8_t i = 0; i < slotCount; i++) {
+    if (fresh[i]) {
+      appendf(buf, size, len, "sensor_temperature_celsius{sensor=\"%s\"} %.2f\n",
+              slots[i].driver->name(), samples[i].temperature);
+    }
+  }
+  promHeader(buf, size, len, "sensor_humidity_percent", "gauge");
+  for (uint8_t i = 0; i < slotCount; i++) {
+    if (fresh[i]) {
+      appendf(buf, size, len, "sensor_humidity_percent{sensor=\"%s\"} %.2f\n",
+              slots[i].driver->name(), samples[i].humidity);
+    }
+  }
+  promHeader(buf, size, len, "sensor_pressure_hpa", "gauge");
+  for (uint8_t i = 0; i < slotCount; i++) {
+    if (!isnan(stats[i].pressure)) {
+      appendf(buf, size, len, "sensor_pressure_hpa{sensor=\"%s\"} %.2f\n",
+              slots[i].driver->name(), stats[i].pressure);
+    }
+  }
+  return len < size ? len : 0;
+}
@@ -0,0 +1,40 @@
+// ============================================================================
+// 温湿度采集任务
+// 功能：传感器驱动（sensor_driver.h）在 setup() 中注册，采集任务按各自的间隔调度：
+//       到期的传感器先 trigger()，转换期间任务休眠到最早的到期时间，
+//       多个传感器的转换互相重叠；每个传感器的读数进入各自的 SensorFilter。
+//       显示、上传和空调控制都只读取最新的滤波结果，不直接访问传感器
+// ============================================================================
+#pragma once
+
+#include <Arduino.h>
+#include "sensor_filter.h"
+#include "sensor_driver.h"
+
+#define SENSOR_SAMPLE_INTERVAL 2500   // 默认采样周期（不小于驱动的 minIntervalMs）
+#define SENSOR_STALE_MS        15000  // 超过该时间没有有效读数视为传感器故障
+#define SENSOR_MAX_LISTENERS   4
+#define SENSOR_MAX_DRIVERS     4
+#define SENSOR_COLLECT_TIMEOUT_MS 100 // 转换时间之后仍然 SENSOR_PENDING 多久算超时
+
+// 在 sensorTaskBegin() 之前调用：驱动 begin() 成功（传感器存在）才加入。
+// 注册顺序即优先级，sensorLatest() 返回第一个有有效读数的传感器
+bool sensorRegister(SensorDriver* driver, uint32_t intervalMs = SENSOR_SAMPLE_INTERVAL);
+
+// 启动采集任务；没有注册任何传感器时返回 false
+bool sensorTaskBegin();
+
+uint8_t sensorCount();
+const char* sensorName(uint8_t index);
+
+// 最新滤波读数（主传感器）；尚无有效读数或读数已过期时返回 false
+bool sensorLatest(SensorSample& out);
+// 指定传感器的最新滤波读数
+bool sensorLatestFrom(uint8_t index, SensorSample& out);
+
+// 主传感器每出一个新的滤波读数回调一次（在采集任务中执行，只能做通知之类的轻量操作）
+typedef void (*SensorSampleCallback)();
+bool sensorOnSample(SensorSampleCallback callback);
+
+// Prometheus 文本格式（各传感器的读数、次数、错误），缓冲区不足时返回 0
+size_t sensorToPrometheus(char* buf, size_t size);
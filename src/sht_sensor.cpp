@@ -0,0 +1,72 @@
+// ============================================================================
+// SHT3x / SHT4x 实现
+// ============================================================================
+#include "sht_sensor.h"
+
+#define SHT3X_CMD_SOFT_RESET  0x30A2
+#define SHT3X_CMD_MEASURE     0x2400
+#define SHT4X_CMD_SOFT_RESET  0x94
+#define SHT4X_CMD_MEASURE     0xFD
+#define SHT_RESET_MS          2
+
+// CRC-8，多项式 0x31，初值 0xFF（两种型号相同）
+static uint8_t shtCrc(const uint8_t* data, size_t length) {
+  uint8_t crc = 0xFF;
+  for (size_t i = 0; i < length; i++) {
+    crc ^= data[i];
+    for (uint8_t bit = 0; bit < 8; bit++) {
+      crc = (crc & 0x80) ? (uint8_t)((crc << 1) ^ 0x31) : (uint8_t)(crc << 1);
+    }
+  }
+  return crc;
+}
+
+ShtSensor::ShtSensor(I2cBus& i2cBus, ShtModel shtModel, uint8_t i2cAddress)
+    : bus(i2cBus), model(shtModel), address(i2cAddress) {}
+
+// SHT3x 命令为 16 位，SHT4x 为 8 位
+bool ShtSensor::command(uint16_t code) {
+  if (model == SHT_4X) {
+    uint8_t byte = (uint8_t)code;
+    return bus.write(address, &byte, 1);
+  }
+  uint8_t bytes[2] = {(uint8_t)(code >> 8), (uint8_t)code};
+  return bus.write(address, bytes, sizeof(bytes));
+}
+
+bool ShtSensor::begin() {
+  if (!bus.begin() || !bus.probe(address)) {
+    return false;
+  }
+  if (!command(model == SHT_4X ? SHT4X_CMD_SOFT_RESET : SHT3X_CMD_SOFT_RESET)) {
+    return false;
+  }
+  delay(SHT_RESET_MS);
+  return true;
+}
+
+SensorStatus ShtSensor::trigger() {
+  return command(model == SHT_4X ? SHT4X_CMD_MEASURE : SHT3X_CMD_MEASURE) ? SENSOR_OK
+                                                                           : SENSOR_ERR_BUS;
+}
+
+SensorStatus ShtSensor::collect(SensorReading& out) {
+  uint8_t data[6];
+  if (!bus.read(address, data, sizeof(data))) {
+    return SENSOR_ERR_BUS;
+  }
+  if (shtCrc(data, 2) != data[2] || shtCrc(data + 3, 2) != data[5]) {
+    return SENSOR_ERR_CHECKSUM;
+  }
+  uint16_t rawTemp = (data[0] << 8) | data[1];
+  uint16_t rawHumi = (data[3] << 8) | data[4];
+  out.temperature = -45.0f + 175.0f * rawTemp / 65535.0f;
+  if (model == SHT_4X) {
+    // SHT4x 的湿度换算可能略超出 0～100%，按数据手册截断
+    out.humidity = constrain(-6.0f + 125.0f * rawHumi / 65535.0f, 0.0f, 100.0f);
+  } else {
+    out.humidity = 100.0f * rawHumi / 65535.0f;
+  }
+  out.pressure = NAN;
+  return SENSOR_OK;
+}
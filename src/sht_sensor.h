@@ -0,0 +1,39 @@
+// ============================================================================
+// SHT3x / SHT4x 温湿度传感器（I2C）
+// 功能：单次测量模式，trigger() 发送测量命令后立即返回，
+//       collect() 在转换时间后读出 6 字节结果并校验 CRC-8
+//         SHT3x：命令 0x2400（高重复性，不拉伸时钟），最长 15ms，±0.2°C
+//         SHT4x：命令 0xFD（高精度），最长 8.3ms，±0.2°C
+// ============================================================================
+#pragma once
+
+#include <Arduino.h>
+#include "sensor_driver.h"
+#include "i2c_bus.h"
+
+#define SHT_ADDRESS_DEFAULT 0x44
+
+enum ShtModel : uint8_t {
+  SHT_3X = 0,
+  SHT_4X,
+};
+
+class ShtSensor : public SensorDriver {
+ public:
+  ShtSensor(I2cBus& bus, ShtModel model, uint8_t address = SHT_ADDRESS_DEFAULT);
+
+  const char* name() const override { return model == SHT_4X ? "sht4x" : "sht3x"; }
+  bool begin() override;
+  uint32_t minIntervalMs() const override { return 1000; }  // 更快采样会让芯片自热
+  uint32_t conversionMs() const override { return model == SHT_4X ? 9 : 16; }
+
+  SensorStatus trigger() override;
+  SensorStatus collect(SensorReading& out) override;
+
+ private:
+  bool command(uint16_t code);
+
+  I2cBus& bus;
+  ShtModel model;
+  uint8_t address;
+};
@@ -0,0 +1,30 @@
+// ============================================================================
+// 任务划分
+// 功能：所有 FreeRTOS 任务的核心和优先级集中在这里。
+//       核心 0（PRO_CPU）：WiFi/lwIP 协议栈和 esp_timer 本来就在这里，网络相关任务
+//                          （WiFi 连接状态机、MQTT、异步 HTTP 服务器、局域网推送、遥测上传）一起固定到核心 0；
+//       核心 1（APP_CPU）：Arduino loop（绘制）、屏幕刷新、传感器采集和红外串口，
+//                          WiFi 突发流量不再推迟屏幕更新
+// 同一核心上，SeqLock 的写者优先级不低于读者（采集任务 > loop），读者不会等一个被抢占的写者
+// ============================================================================
+#pragma once
+
+#define CORE_NET 0
+#define CORE_APP 1  // 与 Arduino loopTask 相同（ARDUINO_RUNNING_CORE）
+
+// 核心 0：协议栈任务优先级都在 18 以上，这些任务只在协议栈空闲时运行
+// 异步 HTTP 服务器的 async_tcp 任务（优先级 3）由 platformio.ini 的
+// CONFIG_ASYNC_TCP_RUNNING_CORE 固定到核心 0
+#define TASK_PRIO_WIFI_LINK   2   // 大部分时间阻塞在任务通知上
+#define TASK_PRIO_MQTT        2
+#define TASK_PRIO_LOCAL_API   3   // 不低于读取其快照的 async_tcp
+#define TASK_PRIO_UPLOAD      1
+
+// 核心 1：loopTask 优先级为 1
+#define TASK_PRIO_PANEL_FLUSH 2
+#define TASK_PRIO_SENSOR      3
+#define TASK_PRIO_IR          3
+
+// 任务栈（字节）：MQTT 任务除了收发消息，还在这里做遥测队列的 LittleFS 追加/溢出、
+// 发送前分块读取（TelemetryRecord[16]）、健康数据采集和定时规则解析，4KB 不够
+#define TASK_STACK_MQTT       8192
@@ -0,0 +1,86 @@
+// ============================================================================
+// 遥测变化上报实现
+// ============================================================================
+#include "telemetry_compressor.h"
+#include <math.h>
+
+// 读数量化到 0.1，噪声峰峰值恰好等于死区时，浮点舍入会让旋转门提前关闭；
+// 给死区加一个远小于分辨率的容差
+#define DEADBAND_EPSILON 1e-4f
+
+TelemetryCompressor::TelemetryCompressor()
+    : cfg{{TELEMETRY_TEMP_DEADBAND_ABS, TELEMETRY_TEMP_DEADBAND_REL},
+          {TELEMETRY_HUMI_DEADBAND_ABS, TELEMETRY_HUMI_DEADBAND_REL},
+          TELEMETRY_HEARTBEAT_MS},
+      hasPivot(false), hasHeld(false), pivot{}, held{},
+      tempDoor{-INFINITY, INFINITY}, humiDoor{-INFINITY, INFINITY}, inputs(0), outputs(0) {}
+
+void TelemetryCompressor::configure(const TelemetryCompressorConfig& config) {
+  cfg = config;
+  hasPivot = false;
+  hasHeld = false;
+}
+
+float TelemetryCompressor::deadband(const TelemetryDeadband& band, float value) {
+  return fmaxf(band.absolute, band.relative * fabsf(value)) + DEADBAND_EPSILON;
+}
+
+// 每毫秒的变化量；同一毫秒内的两个点按相隔 1ms 处理
+float TelemetryCompressor::slope(float fromValue, uint32_t fromMs, float toValue, uint32_t toMs) {
+  uint32_t dt = toMs - fromMs;
+  return (toValue - fromValue) / (float)(dt ? dt : 1);
+}
+
+// 以该点为终点的直线（支点 → 该点）是否对之前所有采样点都在误差内
+bool TelemetryCompressor::admits(const TelemetryPoint& point) const {
+  float st = slope(pivot.temperature, pivot.timestampMs, point.temperature, point.timestampMs);
+  float sh = slope(pivot.humidity, pivot.timestampMs, point.humidity, point.timestampMs);
+  return st >= tempDoor.low && st <= tempDoor.high && sh >= humiDoor.low && sh <= humiDoor.high;
+}
+
+// 把该点加入约束：之后的终点与支点的连线也必须经过该点 ±E
+void TelemetryCompressor::narrow(const TelemetryPoint& point) {
+  float et = deadband(cfg.temperature, point.temperature);
+  float eh = deadband(cfg.humidity, point.humidity);
+  tempDoor.low = fmaxf(tempDoor.low, slope(pivot.temperature, pivot.timestampMs,
+                                           point.temperature - et, point.timestampMs));
+  tempDoor.high = fminf(tempDoor.high, slope(pivot.temperature, pivot.timestampMs,
+                                             point.temperature + et, point.timestampMs));
+  humiDoor.low = fmaxf(humiDoor.low, slope(pivot.humidity, pivot.timestampMs,
+                                           point.humidity - eh, point.timestampMs));
+  humiDoor.high = fminf(humiDoor.high, slope(pivot.humidity, pivot.timestampMs,
+                                             point.humidity + eh, point.timestampMs));
+}
+
+void TelemetryCompressor::restart(const TelemetryPoint& point) {
+  pivot = point;
+  hasPivot = true;
+  hasHeld = false;
+  tempDoor = Door{-INFINITY, INFINITY};
+  humiDoor = Door{-INFINITY, INFINITY};
+}
+
+uint8_t TelemetryCompressor::push(const TelemetryPoint& point, TelemetryPoint out[2]) {
+  inputs++;
+  uint8_t count = 0;
+  if (!hasPivot) {
+    out[count++] = point;
+  } else {
+    bool fits = admits(point);
+    bool heartbeat = point.timestampMs - pivot.timestampMs >= cfg.heartbeatMs;
+    if (fits && !heartbeat) {
+      narrow(point);
+      held = point;
+      hasHeld = true;
+      return 0;
+    }
+    // 旋转门关闭：上一个采样点是上一段的终点（它之前的点都在误差内），再上报显著变化的新点
+    if (!fits && hasHeld) {
+      out[count++] = held;
+    }
+    out[count++] = point;
+  }
+  restart(point);
+  outputs += count;
+  return count;
+}
@@ -0,0 +1,77 @@
+// ============================================================================
+// 遥测变化上报（旋转门压缩）
+// 功能：每个采样点都经过这里，只有需要上报的点才进入遥测队列：
+//         温度、湿度各自有死区 E = max(绝对死区, 相对死区 × |读数|)；
+//         从上一个上报点（支点）出发，只要存在一条直线与其后所有采样点的偏差都不超过 E，
+//         就继续等待（旋转门未关闭）；
+//         新点使旋转门关闭（显著变化）时，立即上报上一个采样点（上一段的终点）和这个新点；
+//         距上次上报超过心跳间隔时，无论是否变化都上报当前点
+//       服务器在相邻上报点之间线性插值，即可在每个采样时刻把误差控制在 E 以内。
+//       不依赖网络和队列，主机构建可直接基准
+// ============================================================================
+#pragma once
+
+#include <stdint.h>
+
+// 默认参数：DHT22/SHT 的分辨率为 0.1，死区不应小于分辨率
+#define TELEMETRY_TEMP_DEADBAND_ABS  0.2f    // °C
+#define TELEMETRY_TEMP_DEADBAND_REL  0.0f
+#define TELEMETRY_HUMI_DEADBAND_ABS  1.0f    // %RH
+#define TELEMETRY_HUMI_DEADBAND_REL  0.02f   // 读数的 2%
+#define TELEMETRY_HEARTBEAT_MS       60000   // 最长上报间隔（服务器 90 秒无数据判为离线）
+
+struct TelemetryDeadband {
+  float absolute;
+  float relative;
+};
+
+struct TelemetryCompressorConfig {
+  TelemetryDeadband temperature;
+  TelemetryDeadband humidity;
+  uint32_t heartbeatMs;
+};
+
+struct TelemetryPoint {
+  uint32_t timestampMs;  // millis()，用于计算斜率（单调）
+  uint32_t timestamp;    // Unix 时间（秒），随上报点一起入队
+  float temperature;
+  float humidity;
+};
+
+class TelemetryCompressor {
+ public:
+  TelemetryCompressor();
+
+  // 修改参数后从下一个点重新开始（下一个点立即上报）
+  void configure(const TelemetryCompressorConfig& config);
+  const TelemetryCompressorConfig& config() const { return cfg; }
+
+  // 输入一个采样点，返回需要上报的点数（0～2），按时间顺序写入 out
+  uint8_t push(const TelemetryPoint& point, TelemetryPoint out[2]);
+
+  uint32_t inputCount() const { return inputs; }
+  uint32_t outputCount() const { return outputs; }
+
+ private:
+  // 单个通道的旋转门：从支点出发、误差不超过 E 的直线斜率区间
+  struct Door {
+    float low;
+    float high;
+  };
+
+  static float deadband(const TelemetryDeadband& band, float value);
+  static float slope(float fromValue, uint32_t fromMs, float toValue, uint32_t toMs);
+  bool admits(const TelemetryPoint& point) const;
+  void narrow(const TelemetryPoint& point);
+  void restart(const TelemetryPoint& pivot);
+
+  TelemetryCompressorConfig cfg;
+  bool hasPivot;
+  bool hasHeld;
+  TelemetryPoint pivot;  // 上一个上报点
+  TelemetryPoint held;   // 最近一个未上报的采样点（当前段的候选终点）
+  Door tempDoor;
+  Door humiDoor;
+  uint32_t inputs;
+  uint32_t outputs;
+};
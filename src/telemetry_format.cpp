@@ -0,0 +1,20 @@
+// ============================================================================
+// 遥测记录格式实现
+// ============================================================================
+#include "telemetry_format.h"
+#include <stdio.h>
+
+size_t telemetryToJson(char* buf, size_t size, const TelemetryRecord* records, size_t count) {
+  size_t len = snprintf(buf, size, "{\"samples\":[");
+  for (size_t i = 0; i < count && len < size; i++) {
+    const TelemetryRecord& r = records[i];
+    len += snprintf(buf + len, size - len,
+                    "%s{\"seq\":%lu,\"t\":%lu,\"temperature\":%.1f,\"humidity\":%.1f}",
+                    i ? "," : "", (unsigned long)r.seq, (unsigned long)r.timestamp,
+                    r.temperature / 10.0f, r.humidity / 10.0f);
+  }
+  if (len < size) {
+    len += snprintf(buf + len, size - len, "]}");
+  }
+  return len < size ? len : 0;
+}
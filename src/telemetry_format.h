@@ -0,0 +1,22 @@
+// ============================================================================
+// 遥测记录格式
+// 功能：Flash 队列中的定长记录，以及上传用的 JSON 编码（HTTP 和 MQTT 共用）；
+//       不依赖文件系统和网络，主机构建可直接基准
+// ============================================================================
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+
+// Flash 上的记录格式，12 字节定长
+struct TelemetryRecord {
+  uint32_t seq;          // 单调递增序号，用于确认和断电后续号
+  uint32_t timestamp;    // Unix 时间（秒），NTP 未同步时为 0，由服务器按接收时间处理
+  int16_t temperature;   // 0.1°C
+  uint16_t humidity;     // 0.1%
+};
+static_assert(sizeof(TelemetryRecord) == 12, "TelemetryRecord 必须是 12 字节");
+
+// 批量记录编码为 JSON（HTTP 和 MQTT 上传共用），缓冲区不足时返回 0
+// {"samples":[{"seq":1,"t":1700000000,"temperature":26.5,"humidity":65.2},...]}
+size_t telemetryToJson(char* buf, size_t size, const TelemetryRecord* records, size_t count);
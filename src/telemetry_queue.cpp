@@ -0,0 +1,289 @@
+// ============================================================================
+// 遥测存储转发队列实现
+// 文件布局：/telemetry.bin 顺序追加 TelemetryRecord，/telemetry.head 保存第一条
+//           未确认记录的偏移；全部确认后两个文件一起删除，避免文件无限增长
+// ============================================================================
+#include "telemetry_queue.h"
+#include <LittleFS.h>
+#include <math.h>
+
+#define TQ_DATA_PATH  "/telemetry.bin"
+#define TQ_HEAD_PATH  "/telemetry.head"
+#define TQ_TEMP_PATH  "/telemetry.tmp"
+#define TQ_RECORD     sizeof(TelemetryRecord)
+#define TQ_IO_RECORDS 16  // 读文件/压缩时每次搬运的记录数
+
+TelemetryQueue::TelemetryQueue()
+    : flashReady(false), lock(nullptr), inboxDropped(0), ramHead(0), ramCount(0),
+      nextSeq(1), dropped(0), fileHead(0), fileSize(0) {}
+
+bool TelemetryQueue::begin() {
+  lock = xSemaphoreCreateMutex();
+
+  if (!LittleFS.begin(true)) {
+    Serial.println("❌ LittleFS 挂载失败，遥测队列仅使用内存");
+    return false;
+  }
+  flashReady = true;
+
+  File data = LittleFS.open(TQ_DATA_PATH, FILE_READ);
+  if (data) {
+    fileSize = data.size();
+    data.close();
+  }
+  File head = LittleFS.open(TQ_HEAD_PATH, FILE_READ);
+  if (head) {
+    if (head.read((uint8_t*)&fileHead, sizeof(fileHead)) != sizeof(fileHead)) {
+      fileHead = 0;
+    }
+    head.close();
+  }
+
+  // 掉电时可能留下半条记录或损坏的偏移
+  bool torn = (fileSize % TQ_RECORD) != 0;
+  fileSize -= fileSize % TQ_RECORD;
+  if (fileHead > fileSize || (fileHead % TQ_RECORD) != 0) {
+    fileHead = 0;
+  }
+
+  if (fileHead == fileSize) {
+    resetFile();
+  } else {
+    if (torn && !compactFile()) {
+      // 半条记录留在文件末尾，继续追加会错位：只读出已有记录，新记录留在内存
+      flashReady = false;
+      Serial.println("⚠️ 遥测队列文件修复失败，新记录只保存在内存");
+    }
+    TelemetryRecord last;
+    if (readFile(fileSize - TQ_RECORD, &last, 1) == 1) {
+      nextSeq = last.seq + 1;
+    }
+    Serial.printf("💾 遥测队列恢复 %lu 条未上传记录\n",
+                  (unsigned long)((fileSize - fileHead) / TQ_RECORD));
+  }
+  return true;
+}
+
+bool TelemetryQueue::post(uint32_t timestamp, float temperature, float humidity) {
+  InboxSample sample = {timestamp, temperature, humidity};
+  if (!inbox.push(sample)) {
+    inboxDropped = inboxDropped + 1;
+    return false;
+  }
+  return true;
+}
+
+void TelemetryQueue::drainInbox() {
+  InboxSample sample;
+  while (inbox.pop(sample)) {
+    append(sample.timestamp, sample.temperature, sample.humidity);
+  }
+}
+
+void TelemetryQueue::append(uint32_t timestamp, float temperature, float humidity) {
+  TelemetryRecord rec;
+  rec.timestamp = timestamp;
+  rec.temperature = (int16_t)lroundf(temperature * 10.0f);
+  rec.humidity = (uint16_t)lroundf(humidity * 10.0f);
+
+  xSemaphoreTake(lock, portMAX_DELAY);
+  rec.seq = nextSeq++;
+
+  // 内存已满（Flash 不可用或写入失败）时只能丢弃最旧的一条
+  if (ramCount == TELEMETRY_RAM_RECORDS) {
+    ramHead = (ramHead + 1) % TELEMETRY_RAM_RECORDS;
+    ramCount--;
+    dropped++;
+  }
+  ram[(ramHead + ramCount) % TELEMETRY_RAM_RECORDS] = rec;
+  ramCount++;
+
+  // 正常联网时上传任务会在达到阈值前取走数据，只有积压时才写 Flash，
+  // 并且一次写一整批，减少擦写次数
+  if (flashReady && ramCount >= TELEMETRY_SPILL_AT) {
+    spillOldest(ramCount);
+  }
+  xSemaphoreGive(lock);
+}
+
+size_t TelemetryQueue::peek(TelemetryRecord* out, size_t maxCount) {
+  drainInbox();
+  xSemaphoreTake(lock, portMAX_DELAY);
+  size_t n = 0;
+
+  // Flash 中的记录总是早于内存中的记录
+  if (fileHead < fileSize) {
+    size_t onFlash = (fileSize - fileHead) / TQ_RECORD;
+    n = readFile(fileHead, out, onFlash < maxCount ? onFlash : maxCount);
+  }
+  for (uint8_t i = 0; i < ramCount && n < maxCount; i++) {
+    out[n++] = ram[(ramHead + i) % TELEMETRY_RAM_RECORDS];
+  }
+
+  xSemaphoreGive(lock);
+  return n;
+}
+
+void TelemetryQueue::commit(uint32_t lastSeq) {
+  xSemaphoreTake(lock, portMAX_DELAY);
+
+  // 上传期间可能有记录从内存溢出到文件，所以按序号而不是按条数删除
+  if (fileHead < fileSize) {
+    TelemetryRecord chunk[TQ_IO_RECORDS];
+    bool done = false;
+    while (!done && fileHead < fileSize) {
+      size_t n = readFile(fileHead, chunk, TQ_IO_RECORDS);
+      if (n == 0) {
+        break;
+      }
+      for (size_t i = 0; i < n; i++) {
+        if (chunk[i].seq > lastSeq) {
+          done = true;
+          break;
+        }
+        fileHead += TQ_RECORD;
+      }
+    }
+    if (fileHead >= fileSize) {
+      resetFile();
+    } else {
+      saveHead();
+    }
+  }
+
+  while (ramCount > 0 && ram[ramHead].seq <= lastSeq) {
+    ramHead = (ramHead + 1) % TELEMETRY_RAM_RECORDS;
+    ramCount--;
+  }
+
+  xSemaphoreGive(lock);
+}
+
+size_t TelemetryQueue::pending() {
+  drainInbox();
+  xSemaphoreTake(lock, portMAX_DELAY);
+  size_t n = (fileSize - fileHead) / TQ_RECORD + ramCount;
+  xSemaphoreGive(lock);
+  return n;
+}
+
+// 把内存中最旧的 count 条追加到文件（调用方持有锁）
+void TelemetryQueue::spillOldest(uint8_t count) {
+  uint32_t bytes = count * TQ_RECORD;
+
+  if (fileSize + bytes > TELEMETRY_MAX_FILE_BYTES && fileHead > 0) {
+    compactFile();
+  }
+  if (fileSize + bytes > TELEMETRY_MAX_FILE_BYTES) {
+    // 文件已满：丢弃最旧的一批，保证最近的数据一定能保存
+    uint32_t overflow = fileSize + bytes - TELEMETRY_MAX_FILE_BYTES;
+    uint32_t skip = ((overflow + TQ_RECORD - 1) / TQ_RECORD) * TQ_RECORD;
+    fileHead += skip;
+    dropped += skip / TQ_RECORD;
+    if (!compactFile()) {
+      saveHead();
+    }
+  }
+  if (fileSize + bytes > TELEMETRY_MAX_FILE_BYTES) {
+    return;  // 压缩失败，文件没有空间：记录留在内存
+  }
+
+  File data = LittleFS.open(TQ_DATA_PATH, FILE_APPEND);
+  if (!data) {
+    return;
+  }
+  uint8_t written = 0;
+  bool shortWrite = false;
+  while (written < count) {
+    const TelemetryRecord& rec = ram[(ramHead + written) % TELEMETRY_RAM_RECORDS];
+    if (data.write((const uint8_t*)&rec, TQ_RECORD) != TQ_RECORD) {
+      shortWrite = true;
+      break;
+    }
+    written++;
+  }
+  data.close();
+
+  fileSize += written * TQ_RECORD;
+  if (shortWrite) {
+    // 文件末尾可能留下半条记录，之后的追加和按 fileSize 计算的偏移都会错位：
+    // 压缩回 fileSize；仍然失败时停止写 Flash，未写入的记录留在内存
+    Serial.printf("⚠️ 遥测队列写入 Flash 失败（已写 %u/%u 条）\n", written, count);
+    if (!compactFile()) {
+      flashReady = false;
+      Serial.println("❌ 遥测队列文件无法修复，新记录只保存在内存");
+    }
+  }
+  ramHead = (ramHead + written) % TELEMETRY_RAM_RECORDS;
+  ramCount -= written;
+  if (fileHead == 0) {
+    saveHead();
+  }
+}
+
+void TelemetryQueue::saveHead() {
+  File head = LittleFS.open(TQ_HEAD_PATH, FILE_WRITE);
+  if (head) {
+    head.write((const uint8_t*)&fileHead, sizeof(fileHead));
+    head.close();
+  }
+}
+
+// 把 [fileHead, fileSize) 复制到新文件，回收已确认记录占用的空间；
+// 只有完整复制后才替换原文件，失败时删除临时文件，原文件和偏移保持不变
+bool TelemetryQueue::compactFile() {
+  File src = LittleFS.open(TQ_DATA_PATH, FILE_READ);
+  File dst = LittleFS.open(TQ_TEMP_PATH, FILE_WRITE);
+  if (!src || !dst) {
+    if (src) src.close();
+    if (dst) dst.close();
+    LittleFS.remove(TQ_TEMP_PATH);
+    Serial.println("⚠️ 遥测队列压缩失败：无法打开文件");
+    return false;
+  }
+
+  TelemetryRecord chunk[TQ_IO_RECORDS];
+  uint32_t offset = fileHead;
+  src.seek(offset);
+  while (offset < fileSize) {
+    uint32_t want = fileSize - offset;
+    if (want > sizeof(chunk)) want = sizeof(chunk);
+    size_t got = src.read((uint8_t*)chunk, want);
+    if (got == 0 || dst.write((const uint8_t*)chunk, got) != got) {
+      break;
+    }
+    offset += got;
+  }
+  src.close();
+  dst.close();
+
+  // LittleFS 的 rename 直接替换目标文件，不需要先删除原文件
+  if (offset != fileSize || !LittleFS.rename(TQ_TEMP_PATH, TQ_DATA_PATH)) {
+    LittleFS.remove(TQ_TEMP_PATH);
+    Serial.printf("⚠️ 遥测队列压缩失败（复制 %lu/%lu 字节），保留原文件\n",
+                  (unsigned long)(offset - fileHead), (unsigned long)(fileSize - fileHead));
+    return false;
+  }
+  fileSize -= fileHead;
+  fileHead = 0;
+  saveHead();
+  return true;
+}
+
+void TelemetryQueue::resetFile() {
+  LittleFS.remove(TQ_DATA_PATH);
+  LittleFS.remove(TQ_HEAD_PATH);
+  fileHead = 0;
+  fileSize = 0;
+}
+
+size_t TelemetryQueue::readFile(uint32_t offset, TelemetryRecord* out, size_t maxCount) {
+  File data = LittleFS.open(TQ_DATA_PATH, FILE_READ);
+  if (!data) {
+    return 0;
+  }
+  data.seek(offset);
+  size_t got = data.read((uint8_t*)out, maxCount * TQ_RECORD);
+  data.close();
+  return got / TQ_RECORD;
+}
@@ -0,0 +1,75 @@
+// ============================================================================
+// 遥测存储转发队列
+// 功能：每个温湿度采样先进入内存暂存区，积压超过阈值（断网、服务器故障）时
+//       溢出到 LittleFS 上的定长记录文件；上传任务按序号批量取出、确认后删除，
+//       断网期间的数据不会丢失，重启后从文件中继续补传。
+//       主循环只通过 post() 把采样放进无锁收件箱，落盘和上传都在网络核心的消费任务里完成，
+//       绘制循环不会等待正在读写 Flash 的上传任务持有的互斥量
+// ============================================================================
+#pragma once
+
+#include <Arduino.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/semphr.h>
+#include "telemetry_format.h"
+#include "lockfree.h"
+
+#define TELEMETRY_RAM_RECORDS     32          // 内存暂存区容量
+#define TELEMETRY_SPILL_AT        12          // 暂存超过该数量就把最旧的写入 Flash
+#define TELEMETRY_MAX_FILE_BYTES  (96 * 1024) // 队列文件上限，约 8000 条（5 秒一条约 11 小时）
+#define TELEMETRY_INBOX_RECORDS   64          // 收件箱容量：5 秒一条可覆盖上传任务最长 5 分钟的退避等待
+
+class TelemetryQueue {
+ public:
+  TelemetryQueue();
+
+  // 挂载 LittleFS 并恢复上次未上传的记录；失败时退化为纯内存队列
+  bool begin();
+
+  // 生产者（主循环）调用，不加锁；收件箱已满时丢弃并返回 false
+  bool post(uint32_t timestamp, float temperature, float humidity);
+
+  // 以下只由消费者（上传任务或 mqttTask，二者只有一个）调用
+  // 把收件箱中的采样移入队列；peek()/pending() 会先自动调用
+  void drainInbox();
+
+  void append(uint32_t timestamp, float temperature, float humidity);
+
+  // 按时间顺序取出最早的最多 maxCount 条（不删除），返回实际条数
+  size_t peek(TelemetryRecord* out, size_t maxCount);
+
+  // 上传成功后删除序号不大于 lastSeq 的记录
+  void commit(uint32_t lastSeq);
+
+  size_t pending();
+  uint32_t droppedCount() const { return dropped + inboxDropped; }
+  bool persistent() const { return flashReady; }
+
+ private:
+  bool flashReady;
+  SemaphoreHandle_t lock;
+
+  struct InboxSample {
+    uint32_t timestamp;
+    float temperature;
+    float humidity;
+  };
+  SpscRing<InboxSample, TELEMETRY_INBOX_RECORDS> inbox;
+  volatile uint32_t inboxDropped;  // 只由生产者写
+
+  TelemetryRecord ram[TELEMETRY_RAM_RECORDS];
+  uint8_t ramHead;
+  uint8_t ramCount;
+  uint32_t nextSeq;
+  uint32_t dropped;
+
+  uint32_t fileHead;   // 文件中第一条未确认记录的偏移
+  uint32_t fileSize;
+
+  void spillOldest(uint8_t count);
+  void saveHead();
+  bool compactFile();
+  void resetFile();
+  size_t readFile(uint32_t offset, TelemetryRecord* out, size_t maxCount);
+};
+
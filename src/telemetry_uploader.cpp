@@ -0,0 +1,109 @@
+// ============================================================================
+// 遥测批量上传任务实现
+// ============================================================================
+#include "telemetry_uploader.h"
+#include "task_config.h"
+#include <WiFi.h>
+#include <HTTPClient.h>
+
+static TelemetryQueue* uploadQueue = nullptr;
+static const char* uploadUrl = nullptr;
+static TaskHandle_t uploaderHandle = nullptr;
+
+// 任务独占，跨批次复用同一条 TCP 连接
+static WiFiClient uploadClient;
+static HTTPClient uploadHttp;
+static TelemetryRecord batch[TELEMETRY_BATCH_MAX];
+static char body[TELEMETRY_BATCH_MAX * 64 + 32];
+
+static int postBatch(size_t count) {
+  size_t len = telemetryToJson(body, sizeof(body), batch, count);
+  if (len == 0) {
+    return -1;
+  }
+  uploadHttp.begin(uploadClient, uploadUrl);
+  uploadHttp.addHeader("Content-Type", "application/json");
+  int code = uploadHttp.POST((uint8_t*)body, len);
+  uploadHttp.end();  // setReuse(true)：服务器支持 keep-alive 时连接保持打开
+  return code;
+}
+
+// HTTPClient::errorToString() 返回 String，断网重试期间会反复分配堆内存，这里用常量表
+static const char* httpErrorName(int code) {
+  switch (code) {
+    case HTTPC_ERROR_CONNECTION_REFUSED:  return "connection refused";
+    case HTTPC_ERROR_SEND_HEADER_FAILED:  return "send header failed";
+    case HTTPC_ERROR_SEND_PAYLOAD_FAILED: return "send payload failed";
+    case HTTPC_ERROR_NOT_CONNECTED:       return "not connected";
+    case HTTPC_ERROR_CONNECTION_LOST:     return "connection lost";
+    case HTTPC_ERROR_NO_HTTP_SERVER:      return "no HTTP server";
+    case HTTPC_ERROR_TOO_LESS_RAM:        return "too less ram";
+    case HTTPC_ERROR_READ_TIMEOUT:        return "read Timeout";
+    default:                              return code < 0 ? "error" : "HTTP";
+  }
+}
+
+static void telemetryUploaderTask(void* pvParameters) {
+  uint32_t backoffMs = 0;
+  uint32_t waitMs = TELEMETRY_UPLOAD_INTERVAL;
+
+  while (1) {
+    ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(waitMs));
+    uploadQueue->drainInbox();  // 断网期间也要取走主循环投递的采样，Flash 写入留在本核心
+
+    if (WiFi.status() != WL_CONNECTED) {
+      // 断网期间数据留在队列里，等 WiFi 恢复后由 telemetryUploaderKick() 唤醒
+      waitMs = TELEMETRY_UPLOAD_INTERVAL;
+      continue;
+    }
+
+    // 连续发送整批，直到积压清空或出错
+    size_t sent = 0;
+    int code = 0;
+    size_t n;
+    while ((n = uploadQueue->peek(batch, TELEMETRY_BATCH_MAX)) > 0) {
+      code = postBatch(n);
+      if (code < 200 || code >= 300) {
+        break;
+      }
+      uploadQueue->commit(batch[n - 1].seq);
+      sent += n;
+      if (n < TELEMETRY_BATCH_MAX) {
+        break;
+      }
+    }
+
+    if (n == 0 || (code >= 200 && code < 300)) {
+      if (sent > 0) {
+        Serial.printf("📤 遥测上传 %u 条%s\n", (unsigned)sent, backoffMs ? "（积压已补传）" : "");
+      }
+      backoffMs = 0;
+      waitMs = TELEMETRY_UPLOAD_INTERVAL;
+    } else {
+      backoffMs = backoffMs ? backoffMs * 2 : TELEMETRY_BACKOFF_MIN_MS;
+      if (backoffMs > TELEMETRY_BACKOFF_MAX_MS) {
+        backoffMs = TELEMETRY_BACKOFF_MAX_MS;
+      }
+      waitMs = backoffMs;
+      Serial.printf("❌ 遥测上传失败（%d %s），积压 %u 条，%lu 秒后重试\n",
+                    code, httpErrorName(code),
+                    (unsigned)uploadQueue->pending(), (unsigned long)(backoffMs / 1000));
+    }
+  }
+}
+
+bool telemetryUploaderBegin(TelemetryQueue& queue, const char* url) {
+  uploadQueue = &queue;
+  uploadUrl = url;
+  uploadHttp.setReuse(true);
+  uploadHttp.setTimeout(TELEMETRY_HTTP_TIMEOUT);
+  uploadHttp.setConnectTimeout(TELEMETRY_HTTP_TIMEOUT);
+  return xTaskCreatePinnedToCore(telemetryUploaderTask, "TelemetryUp", 6144, NULL, TASK_PRIO_UPLOAD,
+                                 &uploaderHandle, CORE_NET) == pdPASS;
+}
+
+void telemetryUploaderKick() {
+  if (uploaderHandle != nullptr) {
+    xTaskNotifyGive(uploaderHandle);
+  }
+}
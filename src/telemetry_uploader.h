@@ -0,0 +1,20 @@
+// ============================================================================
+// 遥测批量上传任务
+// 功能：后台任务定期从 TelemetryQueue 取出一批记录，在同一条 HTTP keep-alive
+//       连接上 POST 到服务器；失败时指数退避，积压数据按批连续补传
+// ============================================================================
+#pragma once
+
+#include <Arduino.h>
+#include "telemetry_queue.h"
+
+#define TELEMETRY_BATCH_MAX        32      // 每次 POST 的最大记录数
+#define TELEMETRY_UPLOAD_INTERVAL  30000   // 正常情况下的上传周期
+#define TELEMETRY_BACKOFF_MIN_MS   2000    // 首次失败后的重试间隔
+#define TELEMETRY_BACKOFF_MAX_MS   300000  // 退避上限 5 分钟
+#define TELEMETRY_HTTP_TIMEOUT     5000
+
+bool telemetryUploaderBegin(TelemetryQueue& queue, const char* url);
+
+// 立即唤醒上传任务，例如 WiFi 刚恢复时不必等到下一个上传周期
+void telemetryUploaderKick();
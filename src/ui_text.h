@@ -0,0 +1,23 @@
+// ============================================================================
+// 界面文字
+// 功能：所有用 GB2312 中文字体绘制的文字集中在这里。构建时 scripts/font_subset.py
+//       扫描本文件，为每个 @font 段生成只含该段字符的子集字体（ui_fonts.h），
+//       字符不在原字体中、或 .cpp 中直接用中文字面量绘制时构建失败。
+//       新增界面文字：写在对应 @font 段中，然后通过这里的宏引用
+// ============================================================================
+#pragma once
+
+// @font ui_font_date u8g2_font_wqy16_t_gb2312b
+// 日期行 "%04u-%02u-%02u" 和星期行
+#define UI_DATE_CHARSET      "0123456789-"
+#define UI_WEEKDAY_NAMES     {"周日", "周一", "周二", "周三", "周四", "周五", "周六"}
+
+// @font ui_font_label u8g2_font_wqy16_t_gb2312
+// 温湿度区标题和传感器错误提示
+#define UI_TEXT_TEMPERATURE  "温度"
+#define UI_TEXT_HUMIDITY     "湿度"
+#define UI_TEXT_SENSOR_ERROR "传感器错误"
+
+// @font ui_font_banner u8g2_font_wqy12_t_gb2312
+// 日期区上方的 WiFi 断线提示
+#define UI_TEXT_WIFI_LOST    "WiFi断线重连中..."
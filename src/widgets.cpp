@@ -0,0 +1,254 @@
+// ============================================================================
+// 界面控件实现
+// 所有控件绘制到 display 模块的 frameBuffer；U8g2 只在内容变化时绑定（字形缓存重建会改绑）
+// ============================================================================
+#include "widgets.h"
+#include "display.h"
+
+// ========================== 基类 ==========================
+Widget::Widget(int16_t x, int16_t y, int16_t w, int16_t h, uint16_t bg)
+    : areaX(x), areaY(y), areaW(w), areaH(h), bgColor(bg), dirty(true),
+      drawnX(0), drawnY(0), drawnW(0), drawnH(0) {}
+
+void Widget::setDrawn(int16_t x, int16_t y, int16_t w, int16_t h) {
+  drawnX = x;
+  drawnY = y;
+  drawnW = w;
+  drawnH = h;
+}
+
+void Widget::clearDrawnExcept(int16_t x, int16_t y, int16_t w, int16_t h) {
+  if (drawnW <= 0 || drawnH <= 0) {
+    return;
+  }
+  int right = drawnX + drawnW;
+  int bottom = drawnY + drawnH;
+  int keepLeft = max((int)drawnX, (int)x);
+  int keepTop = max((int)drawnY, (int)y);
+  int keepRight = min(right, x + w);
+  int keepBottom = min(bottom, y + h);
+  if (w <= 0 || h <= 0 || keepLeft >= keepRight || keepTop >= keepBottom) {
+    frameBuffer.fillRect(drawnX, drawnY, drawnW, drawnH, bgColor);
+    return;
+  }
+  // 旧矩形减去保留部分：上、下两条整宽，中间左、右两块
+  if (keepTop > drawnY) {
+    frameBuffer.fillRect(drawnX, drawnY, drawnW, keepTop - drawnY, bgColor);
+  }
+  if (keepBottom < bottom) {
+    frameBuffer.fillRect(drawnX, keepBottom, drawnW, bottom - keepBottom, bgColor);
+  }
+  if (keepLeft > drawnX) {
+    frameBuffer.fillRect(drawnX, keepTop, keepLeft - drawnX, keepBottom - keepTop, bgColor);
+  }
+  if (keepRight < right) {
+    frameBuffer.fillRect(keepRight, keepTop, right - keepRight, keepBottom - keepTop, bgColor);
+  }
+}
+
+// 擦除旧内容后用 U8g2 在区域内居中绘制，记录占用的矩形
+static void drawCenteredText(int16_t areaX, int16_t areaY, int16_t areaW, int16_t areaH,
+                             const uint8_t* font, const char* text, uint16_t color, uint16_t bg,
+                             int16_t& outX, int16_t& outY, int16_t& outW, int16_t& outH) {
+  bindU8g2();
+  u8g2.setFont(font);
+  u8g2.setForegroundColor(color);
+  u8g2.setBackgroundColor(bg);
+  int x, y;
+  getCenterPos(u8g2, text, areaX, areaY, areaW, areaH, x, y);
+  // 个别字形会超出 ascent/descent，占用高度按整个区域记录
+  outX = x;
+  outY = areaY;
+  outW = u8g2.getUTF8Width(text);
+  outH = areaH;
+  u8g2.drawUTF8(x, y, text);
+}
+
+// ========================== 文字标签 ==========================
+LabelWidget::LabelWidget(int16_t x, int16_t y, int16_t w, int16_t h, const uint8_t* font, uint16_t bg)
+    : Widget(x, y, w, h, bg), font(font), color(bg) {
+  text[0] = 0;
+}
+
+bool LabelWidget::set(const char* newText, uint16_t newColor) {
+  if (newText == nullptr) {
+    newText = "";
+  }
+  if (!dirty && newColor == color && strncmp(newText, text, sizeof(text)) == 0) {
+    return false;
+  }
+  snprintf(text, sizeof(text), "%s", newText);
+  color = newColor;
+  dirty = false;
+
+  clearDrawnExcept(0, 0, 0, 0);  // U8g2 文字不一定覆盖整个字符单元，先擦除旧文字
+  if (text[0] == 0) {
+    setDrawn(0, 0, 0, 0);
+    return true;
+  }
+  int16_t x, y, w, h;
+  drawCenteredText(areaX, areaY, areaW, areaH, font, text, color, bgColor, x, y, w, h);
+  setDrawn(x, y, w, h);
+  return true;
+}
+
+bool DateLineWidget::set(int year, int month, int day, uint16_t color) {
+  char line[12];
+  snprintf(line, sizeof(line), "%04u-%02u-%02u",
+           (unsigned)year % 10000u, (unsigned)month % 100u, (unsigned)day % 100u);
+  return LabelWidget::set(line, color);
+}
+
+// ========================== 数值 + 单位 ==========================
+ValueWidget::ValueWidget(int16_t x, int16_t y, int16_t w, int16_t h, const uint8_t* glyphFont,
+                         const char* charset, const char* unit, uint8_t decimals, uint16_t bg)
+    : Widget(x, y, w, h, bg), glyphFont(glyphFont), charset(charset), unit(unit),
+      decimals(decimals), color(0xFFFF), message(false) {
+  text[0] = 0;
+}
+
+bool ValueWidget::set(float value, uint16_t newColor) {
+  char str[WIDGET_TEXT_MAX];
+  snprintf(str, sizeof(str), "%.*f%s", decimals, value, unit);
+  return drawGlyphs(str, newColor);
+}
+
+bool ValueWidget::setPlaceholder() {
+  return drawGlyphs("--", color);
+}
+
+bool ValueWidget::drawGlyphs(const char* str, uint16_t newColor) {
+  if (!dirty && !message && newColor == color && strcmp(str, text) == 0) {
+    return false;
+  }
+  // 字形按颜色缓存，颜色区间变化时才重新解码（会改绑 U8g2）
+  bool cached = glyphs.isBuiltFor(newColor, bgColor) ||
+                glyphs.build(u8g2, glyphFont, charset, newColor, bgColor, true);
+  snprintf(text, sizeof(text), "%s", str);
+  color = newColor;
+  message = false;
+  dirty = false;
+
+  if (!cached) {
+    // 字形缓存不可用：用同一字体经 U8g2 直接绘制
+    clearDrawnExcept(0, 0, 0, 0);
+    int16_t x, y, w, h;
+    drawCenteredText(areaX, areaY, areaW, areaH, glyphFont, text, color, bgColor, x, y, w, h);
+    setDrawn(x, y, w, h);
+    return true;
+  }
+
+  // 与 getCenterPos 的居中方式一致；精灵不透明，只需擦除旧内容露出的部分
+  int16_t w = glyphs.textWidth(text);
+  int16_t x = areaX + (areaW - w) / 2;
+  int16_t baseline = areaY + (areaH - (glyphs.height() - GLYPH_CACHE_PAD_TOP)) / 2 + glyphs.ascent();
+  int16_t top = glyphs.top(baseline);
+  clearDrawnExcept(x, top, w, glyphs.height());
+  glyphs.draw(frameBuffer, x, baseline, text);
+  setDrawn(x, top, w, glyphs.height());
+  return true;
+}
+
+bool ValueWidget::setMessage(const char* str, const uint8_t* font, uint16_t newColor) {
+  if (!dirty && message && newColor == color && strncmp(str, text, sizeof(text)) == 0) {
+    return false;
+  }
+  snprintf(text, sizeof(text), "%s", str);
+  color = newColor;
+  message = true;
+  dirty = false;
+
+  clearDrawnExcept(0, 0, 0, 0);
+  int16_t x, y, w, h;
+  drawCenteredText(areaX, areaY, areaW, areaH, font, text, color, bgColor, x, y, w, h);
+  setDrawn(x, y, w, h);
+  return true;
+}
+
+// ========================== 时钟 ==========================
+ClockWidget::ClockWidget(int16_t x, int16_t y, int16_t w, int16_t h, int16_t baseline,
+                         const uint8_t* font, uint16_t fg, uint16_t bg)
+    : Widget(x, y, w, h, bg), font(font), fgColor(fg), baseline(baseline) {
+  text[0] = 0;
+}
+
+bool ClockWidget::begin() {
+  if (!glyphs.build(u8g2, font, "0123456789:", fgColor, bgColor, true)) {
+    return false;
+  }
+  const char* layout = "00:00:00";
+  int16_t x = areaX + (areaW - glyphs.textWidth(layout)) / 2;
+  for (int i = 0; i < 8; i++) {
+    cellX[i] = x;
+    x += glyphs.find(layout[i])->advance;
+  }
+  dirty = true;
+  return true;
+}
+
+uint8_t ClockWidget::set(int hours, int minutes, int seconds) {
+  char str[9];
+  snprintf(str, sizeof(str), "%02d:%02d:%02d", hours, minutes, seconds);
+  uint8_t first = 8;
+
+  if (cached()) {
+    for (int i = 0; i < 8; i++) {
+      if (dirty || str[i] != text[i]) {
+        char cell[2] = {str[i], 0};
+        glyphs.draw(frameBuffer, cellX[i], baseline, cell);
+        first = min<uint8_t>(first, i);
+      }
+    }
+  } else if (dirty || strcmp(str, text) != 0) {
+    // 字形缓存不可用：整行用U8g2重绘
+    bindU8g2();
+    u8g2.setFont(font);
+    u8g2.setForegroundColor(fgColor);
+    u8g2.setBackgroundColor(bgColor);
+    frameBuffer.fillRect(areaX, areaY, areaW, areaH, bgColor);
+    u8g2.drawUTF8(areaX + (areaW - u8g2.getUTF8Width(str)) / 2, baseline, str);
+    first = 0;
+  }
+
+  memcpy(text, str, sizeof(text));
+  dirty = false;
+  return first;
+}
+
+// ========================== 状态图标 ==========================
+StatusIconWidget::StatusIconWidget(int16_t x, int16_t y, int16_t w, int16_t h, const uint8_t* font,
+                                   const char* text, uint16_t color, uint16_t bg)
+    : Widget(x, y, w, h, bg), font(font), text(text), color(color), visible(false) {
+  dirty = false;  // 开机时不显示，区域本来就是背景色
+}
+
+bool StatusIconWidget::set(bool shown) {
+  if (!dirty && shown == visible) {
+    return false;
+  }
+  visible = shown;
+  dirty = false;
+  clearDrawnExcept(0, 0, 0, 0);
+  setDrawn(0, 0, 0, 0);
+  if (!shown) {
+    return true;
+  }
+
+  // 圆形底 + 感叹号
+  int16_t r = areaH / 2 - 3;
+  int16_t cx = areaX + 5 + r;
+  int16_t cy = areaY + areaH / 2;
+  frameBuffer.fillCircle(cx, cy, r, color);
+  frameBuffer.drawFastVLine(cx, cy - r + 2, r, bgColor);
+  frameBuffer.drawPixel(cx, cy + r - 3, bgColor);
+
+  bindU8g2();
+  u8g2.setFont(font);
+  u8g2.setForegroundColor(color);
+  u8g2.setBackgroundColor(bgColor);
+  int16_t textX = cx + r + 4;
+  int16_t baselineY = areaY + (areaH + u8g2.getFontAscent()) / 2;
+  int16_t right = textX + u8g2.drawUTF8(textX, baselineY, text);
+  setDrawn(areaX, areaY, min<int16_t>(right - areaX, areaW), areaH);
+  return true;
+}
@@ -0,0 +1,119 @@
+// ============================================================================
+// 界面控件（保留模式）
+// 功能：日期行、时钟、文字标签、数值+单位、状态图标。每个控件在构造时确定自己的区域和字体，
+//       记住上次绘制的内容和位置；set() 只在格式化后的内容或颜色变化时重绘，
+//       且只擦除/绘制自己区域内上次和本次实际占用的部分。
+//       边框、分隔线等静态元素不属于任何控件，开机画一次后不再重绘
+// ============================================================================
+#pragma once
+
+#include <Arduino.h>
+#include <U8g2_for_Adafruit_GFX.h>
+#include "framebuffer.h"
+#include "glyph_cache.h"
+
+#define WIDGET_TEXT_MAX 24  // 控件缓存的文字长度上限（UTF-8 字节，含结尾 0）
+
+class Widget {
+ public:
+  Widget(int16_t x, int16_t y, int16_t w, int16_t h, uint16_t bg);
+
+  // 区域被控件以外的绘制覆盖或擦除后调用：下次 set() 无条件重绘
+  void invalidate() { dirty = true; }
+
+ protected:
+  // 擦除上次绘制占用的矩形中，不被 (x, y, w, h) 覆盖的部分；w=0 时全部擦除
+  void clearDrawnExcept(int16_t x, int16_t y, int16_t w, int16_t h);
+  void setDrawn(int16_t x, int16_t y, int16_t w, int16_t h);
+
+  int16_t areaX, areaY, areaW, areaH;
+  uint16_t bgColor;
+  bool dirty;
+  int16_t drawnX, drawnY, drawnW, drawnH;  // 上次绘制实际占用的矩形，w=0 表示空
+};
+
+// 文字标签：U8g2 字体（可含中文子集字体），文字在区域内居中
+class LabelWidget : public Widget {
+ public:
+  LabelWidget(int16_t x, int16_t y, int16_t w, int16_t h, const uint8_t* font, uint16_t bg);
+
+  // 文字或颜色变化时重绘，返回是否绘制；text 为 nullptr 或空串时清空
+  bool set(const char* text, uint16_t color);
+
+ private:
+  const uint8_t* font;
+  char text[WIDGET_TEXT_MAX];
+  uint16_t color;
+};
+
+// 日期行 "YYYY-MM-DD"
+class DateLineWidget : public LabelWidget {
+ public:
+  using LabelWidget::LabelWidget;
+  bool set(int year, int month, int day, uint16_t color);
+};
+
+// 数值 + 单位：用字形精灵绘制（颜色变化时重建缓存，重建失败时改用 U8g2 绘制），新内容直接覆盖，
+// 只擦除旧内容超出新内容的部分；setMessage() 在同一区域改用 U8g2 字体显示一条提示
+class ValueWidget : public Widget {
+ public:
+  ValueWidget(int16_t x, int16_t y, int16_t w, int16_t h, const uint8_t* glyphFont,
+              const char* charset, const char* unit, uint8_t decimals, uint16_t bg);
+
+  bool set(float value, uint16_t color);
+  // 无读数时的占位符（"--"，沿用当前颜色）
+  bool setPlaceholder();
+  bool setMessage(const char* message, const uint8_t* font, uint16_t color);
+
+ private:
+  bool drawGlyphs(const char* str, uint16_t color);
+
+  GlyphCache glyphs;
+  const uint8_t* glyphFont;
+  const char* charset;
+  const char* unit;
+  uint8_t decimals;
+  char text[WIDGET_TEXT_MAX];
+  uint16_t color;
+  bool message;  // 当前显示的是 setMessage() 的提示
+};
+
+// 时钟 "HH:MM:SS"：字形缓存可用时按固定单元格只重绘变化的字符，否则整行用 U8g2 重绘
+class ClockWidget : public Widget {
+ public:
+  ClockWidget(int16_t x, int16_t y, int16_t w, int16_t h, int16_t baseline,
+              const uint8_t* font, uint16_t fg, uint16_t bg);
+
+  // 解码数字字形并计算每个字符的固定位置（等宽数字，整串在区域内居中）
+  bool begin();
+  bool cached() const { return glyphs.isReady(); }
+  int16_t cellWidth() const { return cached() ? glyphs.find('0')->advance : 0; }
+
+  // 返回第一个重绘的字符下标，没有变化时为 8（整行重绘时为 0）
+  uint8_t set(int hours, int minutes, int seconds);
+
+ private:
+  GlyphCache glyphs;
+  const uint8_t* font;
+  uint16_t fgColor;
+  int16_t baseline;
+  int16_t cellX[8];
+  char text[9];
+};
+
+// 状态图标：圆形图标 + 一行说明，只有“显示/隐藏”两种状态；
+// 隐藏时擦除占用的部分，调用方需让被盖住的控件 invalidate()
+class StatusIconWidget : public Widget {
+ public:
+  StatusIconWidget(int16_t x, int16_t y, int16_t w, int16_t h, const uint8_t* font,
+                   const char* text, uint16_t color, uint16_t bg);
+
+  bool set(bool shown);
+  bool shown() const { return visible; }
+
+ private:
+  const uint8_t* font;
+  const char* text;
+  uint16_t color;
+  bool visible;
+};
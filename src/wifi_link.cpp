@@ -0,0 +1,395 @@
+// ============================================================================
+// WiFi 连接状态机实现
+// 状态只由 WiFiLink 任务读写；事件回调（Arduino 事件任务）只置位任务通知
+// ============================================================================
+#include "wifi_link.h"
+#include <WiFi.h>
+#include <Preferences.h>
+#include <esp_attr.h>
+#include <stdio.h>
+#include <time.h>
+#include <atomic>
+#include "prom_text.h"
+#include "task_config.h"
+
+#define NOTIFY_GOT_IP       BIT0
+#define NOTIFY_DISCONNECTED BIT1
+
+#define CACHE_MAGIC 0x57494649  // "WIFI"
+
+enum LinkState : uint8_t {
+  LINK_WAIT = 0,     // 等待下一次连接（nextAttemptMs）
+  LINK_CONNECTING,
+  LINK_CONNECTED,
+};
+
+enum LinkPath : uint8_t {
+  PATH_FAST = 0,     // 缓存的 BSSID/信道
+  PATH_SCAN,         // 扫描 + DHCP
+  PATH_COUNT,
+};
+
+// 上次成功连接的 AP 和 DHCP 租约
+struct LinkCache {
+  uint32_t magic;
+  uint32_t ssidHash;   // 修改 WiFi 配置后旧缓存自动失效
+  uint8_t bssid[6];
+  uint8_t channel;
+  uint8_t reserved;
+  uint32_t ip, gateway, mask, dns;
+  uint32_t leaseTime;  // 取得租约时的 Unix 时间，时间未同步时为 0（不沿用地址）
+};
+
+struct LinkStats {
+  uint32_t attempts[PATH_COUNT];
+  uint32_t connects[PATH_COUNT];
+  uint32_t disconnects;
+  uint32_t leaseReuses;
+  uint32_t lastReason;
+  uint32_t bootConnectMs;
+  uint32_t lastReconnectMs;
+  uint32_t reconnectBuckets[WIFI_HIST_BUCKETS];  // 非累计，导出时再累加
+  uint64_t reconnectSumMs;
+  uint32_t reconnectCount;
+};
+
+static const uint32_t RECONNECT_BUCKETS_MS[WIFI_HIST_BUCKETS - 1] = {
+  500, 1000, 2000, 5000, 10000, 30000, 60000,
+};
+static const char* PATH_NAMES[PATH_COUNT] = {"fast", "scan"};
+
+RTC_NOINIT_ATTR static LinkCache rtcCache;  // 复位后保留；上电后内容随机，由 magic 和 SSID 校验
+static LinkCache cache;                    // 当前使用的缓存
+static LinkCache nvsCache;                 // NVS 中已保存的内容，相同时不再写入
+
+static const char* linkSsid = nullptr;
+static const char* linkPassword = nullptr;
+static WifiLinkCallback changeCallback = nullptr;
+static TaskHandle_t linkTask = nullptr;
+static Preferences linkPrefs;
+
+static LinkState state = LINK_WAIT;
+static LinkPath attemptPath = PATH_SCAN;
+static bool fastFailed = false;       // 本轮重连中快速重连已失败，直到下次连上都走完整连接
+static bool usingLease = false;       // 本次连接沿用了缓存的地址（不是 DHCP 新分配的）
+static bool everConnected = false;
+static uint32_t attemptStartMs = 0;
+static uint32_t nextAttemptMs = 0;
+static uint32_t lostAtMs = 0;         // 断线时刻（首次连接时为启动连接的时刻）
+static uint32_t backoffMs = 0;
+static std::atomic<uint32_t> pendingReason(0);
+
+static std::atomic<bool> connected(false);
+static LinkStats stats;
+static portMUX_TYPE statsLock = portMUX_INITIALIZER_UNLOCKED;
+
+// ========================== 缓存 ==========================
+
+static uint32_t hashSsid(const char* s) {
+  uint32_t h = 2166136261u;  // FNV-1a
+  while (*s) {
+    h = (h ^ (uint8_t)*s++) * 16777619u;
+  }
+  return h;
+}
+
+static bool cacheValid(const LinkCache& c) {
+  return c.magic == CACHE_MAGIC && c.ssidHash == hashSsid(linkSsid) && c.channel != 0;
+}
+
+static void loadCache() {
+  linkPrefs.begin("wifilink", false);
+  if (linkPrefs.getBytes("cache", &nvsCache, sizeof(nvsCache)) != sizeof(nvsCache)) {
+    memset(&nvsCache, 0, sizeof(nvsCache));
+  }
+  if (cacheValid(rtcCache)) {
+    cache = rtcCache;
+  } else if (cacheValid(nvsCache)) {
+    cache = nvsCache;
+  } else {
+    memset(&cache, 0, sizeof(cache));
+  }
+}
+
+// 只在 DHCP 新分配地址后调用；AP 和地址都没有变化时不写 NVS
+static void saveCache() {
+  time_t now = time(nullptr);
+  cache.magic = CACHE_MAGIC;
+  cache.ssidHash = hashSsid(linkSsid);
+  memcpy(cache.bssid, WiFi.BSSID(), sizeof(cache.bssid));
+  cache.channel = (uint8_t)WiFi.channel();
+  cache.reserved = 0;
+  cache.ip = (uint32_t)WiFi.localIP();
+  cache.gateway = (uint32_t)WiFi.gatewayIP();
+  cache.mask = (uint32_t)WiFi.subnetMask();
+  cache.dns = (uint32_t)WiFi.dnsIP();
+  cache.leaseTime = now > 1600000000 ? (uint32_t)now : 0;
+  rtcCache = cache;
+
+  if (nvsCache.magic != cache.magic || nvsCache.ssidHash != cache.ssidHash ||
+      memcmp(nvsCache.bssid, cache.bssid, sizeof(cache.bssid)) != 0 ||
+      nvsCache.channel != cache.channel || nvsCache.ip != cache.ip) {
+    nvsCache = cache;
+    linkPrefs.putBytes("cache", &nvsCache, sizeof(nvsCache));
+  }
+}
+
+static bool leaseUsable() {
+  time_t now = time(nullptr);
+  return cache.ip != 0 && cache.leaseTime != 0 && now > 1600000000 &&
+         (uint32_t)now - cache.leaseTime < WIFI_LEASE_REUSE_SEC;
+}
+
+// 沿用地址连接时静态配置会停掉 DHCP 客户端，租约不会续期；
+// 到沿用期限后必须切回 DHCP。返回距期限的毫秒数，0 表示已到期
+static uint32_t leaseRemainingMs() {
+  time_t now = time(nullptr);
+  uint32_t end = cache.leaseTime + WIFI_LEASE_REUSE_SEC;
+  if ((uint32_t)now >= end) {
+    return 0;
+  }
+  return min<uint32_t>(end - (uint32_t)now, WIFI_LEASE_REUSE_SEC) * 1000;  // 时间被往回校正时不超过沿用期限
+}
+
+// ========================== 状态机 ==========================
+
+static void startAttempt(uint32_t now) {
+  bool fast = cacheValid(cache) && !fastFailed;
+  usingLease = fast && leaseUsable();
+  if (usingLease) {
+    WiFi.config(IPAddress(cache.ip), IPAddress(cache.gateway), IPAddress(cache.mask), IPAddress(cache.dns));
+  } else {
+    WiFi.config(IPAddress((uint32_t)0), IPAddress((uint32_t)0), IPAddress((uint32_t)0));  // 恢复 DHCP
+  }
+  if (fast) {
+    WiFi.begin(linkSsid, linkPassword, cache.channel, cache.bssid, true);
+  } else {
+    WiFi.begin(linkSsid, linkPassword);
+  }
+
+  attemptPath = fast ? PATH_FAST : PATH_SCAN;
+  attemptStartMs = now;
+  state = LINK_CONNECTING;
+  portENTER_CRITICAL(&statsLock);
+  stats.attempts[attemptPath]++;
+  portEXIT_CRITICAL(&statsLock);
+}
+
+static void attemptFailed(uint32_t now) {
+  if (attemptPath == PATH_FAST) {
+    // AP 更换或信道变化：立即改为扫描，不计入退避
+    fastFailed = true;
+    nextAttemptMs = now;
+  } else {
+    backoffMs = backoffMs ? backoffMs * 2 : WIFI_BACKOFF_MIN_MS;
+    if (backoffMs > WIFI_BACKOFF_MAX_MS) {
+      backoffMs = WIFI_BACKOFF_MAX_MS;
+    }
+    nextAttemptMs = now + backoffMs;
+  }
+  state = LINK_WAIT;
+}
+
+static void onGotIp(uint32_t now) {
+  uint32_t elapsed = now - lostAtMs;
+  bool reconnect = everConnected;
+  state = LINK_CONNECTED;
+  fastFailed = false;
+  backoffMs = 0;
+  everConnected = true;
+  if (!usingLease) {
+    saveCache();
+  }
+
+  portENTER_CRITICAL(&statsLock);
+  stats.connects[attemptPath]++;
+  if (usingLease) {
+    stats.leaseReuses++;
+  }
+  if (reconnect) {
+    uint8_t i = 0;
+    while (i < WIFI_HIST_BUCKETS - 1 && elapsed > RECONNECT_BUCKETS_MS[i]) {
+      i++;
+    }
+    stats.reconnectBuckets[i]++;
+    stats.reconnectSumMs += elapsed;
+    stats.reconnectCount++;
+    stats.lastReconnectMs = elapsed;
+  } else {
+    stats.bootConnectMs = elapsed;
+  }
+  portEXIT_CRITICAL(&statsLock);
+
+  connected = true;
+  IPAddress ip = WiFi.localIP();
+  Serial.printf("✅ WiFi已连接（%s%s，%lu ms）IP: %u.%u.%u.%u\n", PATH_NAMES[attemptPath],
+                usingLease ? "，沿用地址" : "", (unsigned long)elapsed, ip[0], ip[1], ip[2], ip[3]);
+  if (changeCallback != nullptr) {
+    changeCallback(true);
+  }
+}
+
+static void onDisconnected(uint32_t now, uint32_t reason) {
+  portENTER_CRITICAL(&statsLock);
+  stats.lastReason = reason;
+  portEXIT_CRITICAL(&statsLock);
+
+  if (state == LINK_CONNECTED) {
+    portENTER_CRITICAL(&statsLock);
+    stats.disconnects++;
+    portEXIT_CRITICAL(&statsLock);
+    connected = false;
+    lostAtMs = now;
+    nextAttemptMs = now;  // 立即快速重连
+    state = LINK_WAIT;
+    Serial.printf("⚠️ WiFi断线（原因 %lu），后台重连\n", (unsigned long)reason);
+    if (changeCallback != nullptr) {
+      changeCallback(false);
+    }
+  } else if (state == LINK_CONNECTING && reason != WIFI_REASON_ASSOC_LEAVE) {
+    // ASSOC_LEAVE 是本机 WiFi.begin()/disconnect() 自己断开旧连接，不算失败
+    attemptFailed(now);
+  }
+}
+
+static void linkTaskMain(void* pvParameters) {
+  while (1) {
+    uint32_t now = millis();
+    TickType_t wait = portMAX_DELAY;
+    if (state == LINK_WAIT) {
+      int32_t remaining = (int32_t)(nextAttemptMs - now);
+      wait = remaining > 0 ? pdMS_TO_TICKS(remaining) : 0;
+    } else if (state == LINK_CONNECTING) {
+      uint32_t timeout = attemptPath == PATH_FAST ? WIFI_FAST_TIMEOUT_MS : WIFI_SCAN_TIMEOUT_MS;
+      int32_t remaining = (int32_t)(attemptStartMs + timeout - now);
+      wait = remaining > 0 ? pdMS_TO_TICKS(remaining) : 0;
+    } else if (usingLease) {
+      wait = pdMS_TO_TICKS(leaseRemainingMs());
+    }
+
+    uint32_t events = 0;
+    xTaskNotifyWait(0, UINT32_MAX, &events, wait);
+    now = millis();
+
+    if (events & NOTIFY_DISCONNECTED) {
+      onDisconnected(now, pendingReason.load());
+    }
+    if ((events & NOTIFY_GOT_IP) && state != LINK_CONNECTED) {
+      onGotIp(now);
+    } else if ((events & NOTIFY_GOT_IP) && !usingLease) {
+      saveCache();  // 连接中切回 DHCP 后取得的新租约
+    }
+
+    if (state == LINK_CONNECTED && usingLease && leaseRemainingMs() == 0) {
+      // 重新启动 DHCP 客户端（地址会短暂清空，多数情况下服务器分配回同一地址）
+      usingLease = false;
+      WiFi.config(IPAddress((uint32_t)0), IPAddress((uint32_t)0), IPAddress((uint32_t)0));
+      Serial.println("🔄 沿用的地址到期，切回 DHCP");
+    }
+
+    if (state == LINK_CONNECTING) {
+      uint32_t timeout = attemptPath == PATH_FAST ? WIFI_FAST_TIMEOUT_MS : WIFI_SCAN_TIMEOUT_MS;
+      if (now - attemptStartMs >= timeout) {
+        WiFi.disconnect();
+        attemptFailed(now);
+      }
+    }
+    if (state == LINK_WAIT && (int32_t)(now - nextAttemptMs) >= 0) {
+      startAttempt(now);
+    }
+  }
+}
+
+// Arduino 事件任务中调用：只转交给 WiFiLink 任务
+static void onWiFiEvent(WiFiEvent_t event, WiFiEventInfo_t info) {
+  if (linkTask == nullptr) {
+    return;
+  }
+  if (event == ARDUINO_EVENT_WIFI_STA_GOT_IP) {
+    xTaskNotify(linkTask, NOTIFY_GOT_IP, eSetBits);
+  } else if (event == ARDUINO_EVENT_WIFI_STA_DISCONNECTED) {
+    pendingReason = info.wifi_sta_disconnected.reason;
+    xTaskNotify(linkTask, NOTIFY_DISCONNECTED, eSetBits);
+  }
+}
+
+bool wifiLinkBegin(const char* ssid, const char* password, WifiLinkCallback onChange) {
+  linkSsid = ssid;
+  linkPassword = password;
+  changeCallback = onChange;
+  loadCache();
+
+  WiFi.persistent(false);        // 连接参数由本模块保存，不在每次 begin() 时写 Flash
+  WiFi.setAutoReconnect(false);  // 重连只由状态机发起
+  WiFi.mode(WIFI_STA);
+  WiFi.onEvent(onWiFiEvent);
+
+  lostAtMs = millis();
+  nextAttemptMs = lostAtMs;
+  state = LINK_WAIT;
+  return xTaskCreatePinnedToCore(linkTaskMain, "WiFiLink", 4096, NULL, TASK_PRIO_WIFI_LINK,
+                                 &linkTask, CORE_NET) == pdPASS;
+}
+
+bool wifiLinkConnected() {
+  return connected;
+}
+
+uint32_t wifiLinkLastReconnectMs() {
+  portENTER_CRITICAL(&statsLock);
+  uint32_t ms = stats.lastReconnectMs;
+  portEXIT_CRITICAL(&statsLock);
+  return ms;
+}
+
+uint32_t wifiLinkDisconnects() {
+  portENTER_CRITICAL(&statsLock);
+  uint32_t n = stats.disconnects;
+  portEXIT_CRITICAL(&statsLock);
+  return n;
+}
+
+uint32_t wifiLinkReconnects() {
+  portENTER_CRITICAL(&statsLock);
+  uint32_t n = stats.reconnectCount;
+  portEXIT_CRITICAL(&statsLock);
+  return n;
+}
+
+// ========================== Prometheus 导出 ==========================
+
+size_t wifiLinkToPrometheus(char* buf, size_t size) {
+  // 先复制快照再格式化，临界区内不做耗时操作
+  LinkStats s;
+  portENTER_CRITICAL(&statsLock);
+  s = stats;
+  portEXIT_CRITICAL(&statsLock);
+
+  size_t len = 0;
+  promHeader(buf, size, len, "wifi_connected", "gauge", "Whether the station currently has an IP address.");
+  appendf(buf, size, len, "wifi_connected %d\n", wifiLinkConnected() ? 1 : 0);
+
+  promHeader(buf, size, len, "wifi_connect_attempts_total", "counter", "Connection attempts by path (fast = cached BSSID/channel).");
+  for (uint8_t p = 0; p < PATH_COUNT; p++) {
+    appendf(buf, size, len, "wifi_connect_attempts_total{path=\"%s\"} %lu\n",
+            PATH_NAMES[p], (unsigned long)s.attempts[p]);
+  }
+  promHeader(buf, size, len, "wifi_connects_total", "counter");
+  for (uint8_t p = 0; p < PATH_COUNT; p++) {
+    appendf(buf, size, len, "wifi_connects_total{path=\"%s\"} %lu\n",
+            PATH_NAMES[p], (unsigned long)s.connects[p]);
+  }
+  promHeader(buf, size, len, "wifi_lease_reuses_total", "counter", "Connections that reused the cached address instead of DHCP.");
+  appendf(buf, size, len, "wifi_lease_reuses_total %lu\n", (unsigned long)s.leaseReuses);
+  promHeader(buf, size, len, "wifi_disconnects_total", "counter");
+  appendf(buf, size, len, "wifi_disconnects_total %lu\n", (unsigned long)s.disconnects);
+  promHeader(buf, size, len, "wifi_last_disconnect_reason", "gauge", "Last wifi_err_reason_t reported by the driver.");
+  appendf(buf, size, len, "wifi_last_disconnect_reason %lu\n", (unsigned long)s.lastReason);
+  promHeader(buf, size, len, "wifi_boot_connect_seconds", "gauge", "Time from boot to the first IP address.");
+  appendf(buf, size, len, "wifi_boot_connect_seconds %.3f\n", s.bootConnectMs / 1000.0);
+
+  promHeader(buf, size, len, "wifi_reconnect_seconds", "histogram", "Time from losing the link to getting an IP address again.");
+  promHistogram(buf, size, len, "wifi_reconnect_seconds", "", s.reconnectBuckets, WIFI_HIST_BUCKETS,
+                RECONNECT_BUCKETS_MS, 1e-3, s.reconnectSumMs / 1000.0);
+  return len < size ? len : 0;
+}
@@ -0,0 +1,39 @@
+// ============================================================================
+// WiFi 连接状态机
+// 功能：代替 setup()/loop() 中 WiFi.begin() + delay(500) 轮询的阻塞重连。
+//       WiFi.onEvent 只把事件转交给核心 0 上的 WiFiLink 任务，任务按状态机发起连接：
+//         快速重连：使用上次成功连接的 BSSID 和信道（跳过扫描），
+//                   租约未过期时直接沿用上次 DHCP 分配的地址（跳过 DHCP），
+//                   到 WIFI_LEASE_REUSE_SEC 期限后重新启动 DHCP 客户端续租
+//         完整连接：快速重连失败（AP 更换、信道变化）后扫描 + DHCP，失败按 1～30 秒指数退避
+//       连接信息保存在 RTC 内存（软件复位后仍有效）和 NVS（上电后仍有效，只在变化时写入）。
+//       主循环只收到“连接状态变化”通知，断网期间时钟和 HTTP 服务器照常运行
+// ============================================================================
+#pragma once
+
+#include <Arduino.h>
+
+#define WIFI_FAST_TIMEOUT_MS   3000     // 快速重连等待时间，超时后改为完整连接
+#define WIFI_SCAN_TIMEOUT_MS   15000    // 完整连接等待时间
+#define WIFI_BACKOFF_MIN_MS    1000
+#define WIFI_BACKOFF_MAX_MS    30000
+#define WIFI_LEASE_REUSE_SEC   3600     // DHCP 分配后多久内重连可以沿用该地址（远小于常见的 24 小时租期）
+#define WIFI_HIST_BUCKETS      8        // 重连耗时直方图档数，含 +Inf
+
+// 连接状态变化时在 WiFiLink 任务中调用，不能阻塞
+typedef void (*WifiLinkCallback)(bool connected);
+
+// 启动 WiFiLink 任务并立即开始第一次连接（不等待结果）
+bool wifiLinkBegin(const char* ssid, const char* password, WifiLinkCallback onChange);
+
+bool wifiLinkConnected();
+
+// 最近一次从断线到取得 IP 的耗时（毫秒），还没有重连过时为 0
+uint32_t wifiLinkLastReconnectMs();
+
+// 开机以来的断线次数和断线后重新取得 IP 的次数
+uint32_t wifiLinkDisconnects();
+uint32_t wifiLinkReconnects();
+
+// Prometheus 文本格式，缓冲区不足时返回 0
+size_t wifiLinkToPrometheus(char* buf, size_t size);
@@ -0,0 +1,292 @@
+// ============================================================================
+// 紧凑二进制报文实现
+// 按字节读写小端字段，不依赖结构体布局和对齐，MQTT 缓冲区中的任意偏移都能直接解码
+// ============================================================================
+#include "wire_codec.h"
+
+#define WIRE_HEADER 3
+
+// ========================== 字段读写 ==========================
+
+static inline void putU16(uint8_t* p, uint16_t v) {
+  p[0] = (uint8_t)v;
+  p[1] = (uint8_t)(v >> 8);
+}
+
+static inline void putU32(uint8_t* p, uint32_t v) {
+  p[0] = (uint8_t)v;
+  p[1] = (uint8_t)(v >> 8);
+  p[2] = (uint8_t)(v >> 16);
+  p[3] = (uint8_t)(v >> 24);
+}
+
+static inline void putU64(uint8_t* p, uint64_t v) {
+  putU32(p, (uint32_t)v);
+  putU32(p + 4, (uint32_t)(v >> 32));
+}
+
+static inline uint16_t getU16(const uint8_t* p) {
+  return (uint16_t)(p[0] | (p[1] << 8));
+}
+
+static inline uint32_t getU32(const uint8_t* p) {
+  return (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+static inline uint64_t getU64(const uint8_t* p) {
+  return (uint64_t)getU32(p) | ((uint64_t)getU32(p + 4) << 32);
+}
+
+// CRC-16/CCITT-FALSE（多项式 0x1021，初值 0xFFFF），半字节查表：表只有 32 字节
+static uint16_t crc16(const uint8_t* data, size_t length) {
+  static const uint16_t table[16] = {
+    0x0000, 0x1021, 0x2042, 0x3063, 0x4084, 0x50A5, 0x60C6, 0x70E7,
+    0x8108, 0x9129, 0xA14A, 0xB16B, 0xC18C, 0xD1AD, 0xE1CE, 0xF1EF,
+  };
+  uint16_t crc = 0xFFFF;
+  for (size_t i = 0; i < length; i++) {
+    crc = (uint16_t)((crc << 4) ^ table[(crc >> 12) ^ (data[i] >> 4)]);
+    crc = (uint16_t)((crc << 4) ^ table[(crc >> 12) ^ (data[i] & 0x0F)]);
+  }
+  return crc;
+}
+
+// ========================== 帧 ==========================
+
+// 写帧头，返回消息体起点；缓冲区放不下 bodyLen 字节的消息体时返回 nullptr
+static uint8_t* beginFrame(uint8_t* buf, size_t size, WireType type, size_t bodyLen) {
+  if (size < WIRE_OVERHEAD + bodyLen) {
+    return nullptr;
+  }
+  buf[0] = WIRE_MAGIC;
+  buf[1] = WIRE_VERSION;
+  buf[2] = type;
+  return buf + WIRE_HEADER;
+}
+
+static size_t endFrame(uint8_t* buf, size_t bodyLen) {
+  size_t len = WIRE_HEADER + bodyLen;
+  putU16(buf + len, crc16(buf, len));
+  return len + 2;
+}
+
+// 检查帧头、类型和 CRC，返回消息体（bodyLen 为其长度）；无效时返回 nullptr
+static const uint8_t* openFrame(const uint8_t* payload, size_t length, WireType type, size_t& bodyLen) {
+  if (length < WIRE_OVERHEAD || payload[0] != WIRE_MAGIC || payload[2] != type) {
+    return nullptr;
+  }
+  if (payload[1] != WIRE_VERSION) {
+    return nullptr;
+  }
+  if (crc16(payload, length - 2) != getU16(payload + length - 2)) {
+    return nullptr;
+  }
+  bodyLen = length - WIRE_OVERHEAD;
+  return payload + WIRE_HEADER;
+}
+
+// ========================== 消息体 ==========================
+
+static void putSample(uint8_t* p, const TelemetryRecord& r) {
+  putU32(p, r.seq);
+  putU32(p + 4, r.timestamp);
+  putU16(p + 8, (uint16_t)r.temperature);
+  putU16(p + 10, r.humidity);
+}
+
+static void putRule(uint8_t* p, const AcScheduleRule& r) {
+  p[0] = r.weekdays;
+  p[1] = r.hour;
+  p[2] = r.minute;
+  p[3] = r.action;
+  putU16(p + 4, (uint16_t)r.belowTenths);
+}
+
+// 与 parseACSchedule() 相同的规则检查
+static bool getRule(const uint8_t* p, AcScheduleRule& r) {
+  r.weekdays = p[0];
+  r.hour = p[1];
+  r.minute = p[2];
+  r.action = (AcAction)p[3];
+  r.belowTenths = (int16_t)getU16(p + 4);
+  return r.weekdays != 0 && r.weekdays < 0x80 && r.hour <= 23 && r.minute <= 59 &&
+         (r.action == AC_ACTION_ON || r.action == AC_ACTION_OFF);
+}
+
+// ========================== 编码 ==========================
+
+size_t wireEncodeSample(uint8_t* buf, size_t size, const TelemetryRecord& record) {
+  uint8_t* body = beginFrame(buf, size, WIRE_SAMPLE, WIRE_SAMPLE_SIZE);
+  if (body == nullptr) {
+    return 0;
+  }
+  putSample(body, record);
+  return endFrame(buf, WIRE_SAMPLE_SIZE);
+}
+
+size_t wireEncodeBatch(uint8_t* buf, size_t size, const TelemetryRecord* records, size_t count) {
+  if (count > WIRE_BATCH_MAX) {
+    return 0;
+  }
+  size_t bodyLen = 1 + count * WIRE_SAMPLE_SIZE;
+  uint8_t* body = beginFrame(buf, size, WIRE_BATCH, bodyLen);
+  if (body == nullptr) {
+    return 0;
+  }
+  body[0] = (uint8_t)count;
+  for (size_t i = 0; i < count; i++) {
+    putSample(body + 1 + i * WIRE_SAMPLE_SIZE, records[i]);
+  }
+  return endFrame(buf, bodyLen);
+}
+
+size_t wireEncodeCommand(uint8_t* buf, size_t size, const AcCommand& command) {
+  uint8_t* body = beginFrame(buf, size, WIRE_AC_COMMAND, WIRE_COMMAND_SIZE);
+  if (body == nullptr) {
+    return 0;
+  }
+  body[0] = command.action;
+  putU32(body + 1, command.id);
+  putU64(body + 5, command.sentMs);
+  return endFrame(buf, WIRE_COMMAND_SIZE);
+}
+
+size_t wireEncodeCommandAck(uint8_t* buf, size_t size, const AcCommandAck& ack) {
+  uint8_t* body = beginFrame(buf, size, WIRE_AC_ACK, WIRE_COMMAND_ACK_SIZE);
+  if (body == nullptr) {
+    return 0;
+  }
+  putU32(body, ack.id);
+  body[4] = ack.action;
+  body[5] = ack.result;
+  putU64(body + 6, ack.sentMs);
+  putU64(body + 14, ack.receivedMs);
+  putU32(body + 22, ack.dispatchMs);
+  putU32(body + 26, ack.irAckMs);
+  return endFrame(buf, WIRE_COMMAND_ACK_SIZE);
+}
+
+size_t wireEncodeAck(uint8_t* buf, size_t size, uint32_t seq) {
+  uint8_t* body = beginFrame(buf, size, WIRE_ACK, 4);
+  if (body == nullptr) {
+    return 0;
+  }
+  putU32(body, seq);
+  return endFrame(buf, 4);
+}
+
+size_t wireEncodeScheduleUpdate(uint8_t* buf, size_t size, const AcScheduleUpdate& update) {
+  uint8_t count = update.hasRules ? update.ruleCount : 0;
+  size_t bodyLen = 2 + count * WIRE_RULE_SIZE;
+  uint8_t* body = beginFrame(buf, size, WIRE_SCHEDULE, bodyLen);
+  if (body == nullptr) {
+    return 0;
+  }
+  body[0] = (update.hasEnabled ? 0x01 : 0) | (update.enabled ? 0x02 : 0) | (update.hasRules ? 0x04 : 0);
+  body[1] = count;
+  for (uint8_t i = 0; i < count; i++) {
+    putRule(body + 2 + i * WIRE_RULE_SIZE, update.rules[i]);
+  }
+  return endFrame(buf, bodyLen);
+}
+
+size_t wireEncodeScheduleStatus(uint8_t* buf, size_t size, const AcSchedule& schedule,
+                                bool enabled, time_t nextDue) {
+  size_t bodyLen = 6 + schedule.size() * WIRE_RULE_SIZE;
+  uint8_t* body = beginFrame(buf, size, WIRE_SCHEDULE_STATUS, bodyLen);
+  if (body == nullptr) {
+    return 0;
+  }
+  body[0] = enabled ? 0x02 : 0;
+  putU32(body + 1, (uint32_t)nextDue);
+  body[5] = schedule.size();
+  for (uint8_t i = 0; i < schedule.size(); i++) {
+    putRule(body + 6 + i * WIRE_RULE_SIZE, schedule.rule(i));
+  }
+  return endFrame(buf, bodyLen);
+}
+
+// ========================== 解码 ==========================
+
+bool wireDecodeBatch(const uint8_t* payload, size_t length, TelemetryRecord* out, size_t maxCount, size_t& count) {
+  size_t bodyLen;
+  const uint8_t* body = openFrame(payload, length, WIRE_BATCH, bodyLen);
+  if (body == nullptr || bodyLen < 1 || bodyLen != 1 + (size_t)body[0] * WIRE_SAMPLE_SIZE || body[0] > maxCount) {
+    return false;
+  }
+  count = body[0];
+  for (size_t i = 0; i < count; i++) {
+    const uint8_t* p = body + 1 + i * WIRE_SAMPLE_SIZE;
+    out[i].seq = getU32(p);
+    out[i].timestamp = getU32(p + 4);
+    out[i].temperature = (int16_t)getU16(p + 8);
+    out[i].humidity = getU16(p + 10);
+  }
+  return true;
+}
+
+// 兼容只有 action 的旧版消息体（id 和发送时间为 0）
+bool wireDecodeCommand(const uint8_t* payload, size_t length, AcCommand& out) {
+  out.action = AC_ACTION_NONE;
+  size_t bodyLen;
+  const uint8_t* body = openFrame(payload, length, WIRE_AC_COMMAND, bodyLen);
+  if (body == nullptr || (bodyLen != 1 && bodyLen != WIRE_COMMAND_SIZE)) {
+    return false;
+  }
+  if (body[0] != AC_ACTION_ON && body[0] != AC_ACTION_OFF) {
+    return false;
+  }
+  out.action = (AcAction)body[0];
+  out.id = bodyLen == WIRE_COMMAND_SIZE ? getU32(body + 1) : 0;
+  out.sentMs = bodyLen == WIRE_COMMAND_SIZE ? getU64(body + 5) : 0;
+  return true;
+}
+
+bool wireDecodeCommandAck(const uint8_t* payload, size_t length, AcCommandAck& out) {
+  size_t bodyLen;
+  const uint8_t* body = openFrame(payload, length, WIRE_AC_ACK, bodyLen);
+  if (body == nullptr || bodyLen != WIRE_COMMAND_ACK_SIZE || body[5] > AC_RESULT_REJECTED) {
+    return false;
+  }
+  out.id = getU32(body);
+  out.action = (AcAction)body[4];
+  out.result = (AcCommandResult)body[5];
+  out.sentMs = getU64(body + 6);
+  out.receivedMs = getU64(body + 14);
+  out.dispatchMs = getU32(body + 22);
+  out.irAckMs = getU32(body + 26);
+  return true;
+}
+
+bool wireDecodeAck(const uint8_t* payload, size_t length, uint32_t& seq) {
+  size_t bodyLen;
+  const uint8_t* body = openFrame(payload, length, WIRE_ACK, bodyLen);
+  if (body == nullptr || bodyLen != 4) {
+    return false;
+  }
+  seq = getU32(body);
+  return true;
+}
+
+bool wireDecodeScheduleUpdate(const uint8_t* payload, size_t length, AcScheduleUpdate& out) {
+  size_t bodyLen;
+  const uint8_t* body = openFrame(payload, length, WIRE_SCHEDULE, bodyLen);
+  if (body == nullptr || bodyLen < 2 || bodyLen != 2 + (size_t)body[1] * WIRE_RULE_SIZE ||
+      body[1] > AC_SCHEDULE_MAX_RULES) {
+    return false;
+  }
+  out.hasEnabled = (body[0] & 0x01) != 0;
+  out.enabled = (body[0] & 0x02) != 0;
+  out.hasRules = (body[0] & 0x04) != 0;
+  out.ruleCount = 0;
+  if (!out.hasRules) {
+    return true;
+  }
+  for (uint8_t i = 0; i < body[1]; i++) {
+    if (!getRule(body + 2 + i * WIRE_RULE_SIZE, out.rules[i])) {
+      return false;
+    }
+    out.ruleCount++;
+  }
+  return true;
+}
@@ -0,0 +1,80 @@
+// ============================================================================
+// 紧凑二进制报文
+// 功能：遥测、空调指令及其应答、遥测应答和定时状态的定长小端二进制编码，与 JSON 并存：
+//         入站：按首字节区分（JSON 以 '{' 开头，二进制帧以 WIRE_MAGIC 开头），
+//               直接在 MQTT 接收缓冲区上解码，不复制、不分配
+//         出站：按主题协商，对端在配对主题上发来二进制后才改用二进制（见 WireFormat）
+//       不依赖网络和 ArduinoJson，主机构建可直接基准
+//
+// 帧格式：magic(0xE7) | version(1) | type | 消息体 | CRC-16/CCITT-FALSE（小端，覆盖之前所有字节）
+// 消息体（多字节字段均为小端）：
+//   SAMPLE          seq u32, t u32, temperature i16 (0.1°C), humidity u16 (0.1%)
+//   BATCH           count u8, count × SAMPLE 消息体
+//   AC_COMMAND      action u8（1=开 2=关）, id u32, sent u64（发送方 Unix 毫秒）；
+//                   只有 action 的 1 字节旧版消息体仍可解码
+//   AC_ACK          id u32, action u8, result u8（AcCommandResult）, sent u64, recv u64（Unix 毫秒）,
+//                   dispatch u32, ir_ack u32（相对 recv 的毫秒数，0xFFFFFFFF 为未发生）
+//   ACK             seq u32
+//   SCHEDULE        flags u8（bit0 含 enabled, bit1 enabled, bit2 含 rules）, count u8, count × RULE
+//   SCHEDULE_STATUS flags u8（bit1 enabled）, next u32, count u8, count × RULE
+//   RULE            weekdays u8, hour u8, minute u8, action u8, below i16（INT16_MAX 为无条件）
+// ============================================================================
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+#include <time.h>
+#include "telemetry_format.h"
+#include "ac_control.h"
+
+#define WIRE_MAGIC         0xE7
+#define WIRE_VERSION       1
+#define WIRE_OVERHEAD      5      // 3 字节帧头 + 2 字节 CRC
+#define WIRE_SAMPLE_SIZE   12
+#define WIRE_RULE_SIZE     6
+#define WIRE_COMMAND_SIZE  13
+#define WIRE_COMMAND_ACK_SIZE 30
+#define WIRE_BATCH_MAX     255
+#define WIRE_SCHEDULE_STATUS_MAX (WIRE_OVERHEAD + 6 + AC_SCHEDULE_MAX_RULES * WIRE_RULE_SIZE)
+#define WIRE_CAPABILITIES  "json,wire1"  // 设备在 <prefix>/codec 上发布的 retained 能力声明
+
+enum WireType : uint8_t {
+  WIRE_SAMPLE = 1,
+  WIRE_BATCH,
+  WIRE_AC_COMMAND,
+  WIRE_ACK,
+  WIRE_SCHEDULE,
+  WIRE_SCHEDULE_STATUS,
+  WIRE_AC_ACK,
+};
+
+// 出站主题使用的格式：默认 JSON，对端在配对主题上发来二进制帧后切换
+enum WireFormat : uint8_t {
+  WIRE_FORMAT_JSON = 0,
+  WIRE_FORMAT_BINARY,
+};
+
+// 是否为二进制帧（只看首字节，完整性由各解码函数检查）
+inline bool wireIsFrame(const uint8_t* payload, size_t length) {
+  return length > 0 && payload[0] == WIRE_MAGIC;
+}
+inline WireFormat wireFormatOf(const uint8_t* payload, size_t length) {
+  return wireIsFrame(payload, length) ? WIRE_FORMAT_BINARY : WIRE_FORMAT_JSON;
+}
+
+// 编码：返回帧长度，缓冲区不足时返回 0
+size_t wireEncodeSample(uint8_t* buf, size_t size, const TelemetryRecord& record);
+size_t wireEncodeBatch(uint8_t* buf, size_t size, const TelemetryRecord* records, size_t count);
+size_t wireEncodeCommand(uint8_t* buf, size_t size, const AcCommand& command);
+size_t wireEncodeCommandAck(uint8_t* buf, size_t size, const AcCommandAck& ack);
+size_t wireEncodeAck(uint8_t* buf, size_t size, uint32_t seq);
+size_t wireEncodeScheduleUpdate(uint8_t* buf, size_t size, const AcScheduleUpdate& update);
+size_t wireEncodeScheduleStatus(uint8_t* buf, size_t size, const AcSchedule& schedule,
+                                bool enabled, time_t nextDue);
+
+// 解码：帧头、版本、类型、长度或 CRC 不符时返回 false
+bool wireDecodeBatch(const uint8_t* payload, size_t length, TelemetryRecord* out, size_t maxCount, size_t& count);
+bool wireDecodeCommand(const uint8_t* payload, size_t length, AcCommand& out);
+bool wireDecodeCommandAck(const uint8_t* payload, size_t length, AcCommandAck& out);
+bool wireDecodeAck(const uint8_t* payload, size_t length, uint32_t& seq);
+bool wireDecodeScheduleUpdate(const uint8_t* payload, size_t length, AcScheduleUpdate& out);